@@ -22,17 +22,20 @@
 
 #include "blindhandler.h"
 
+#include <QHash>
+
 #include "yio-interface/entities/blindinterface.h"
 
 static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.blind");
 
 BlindHandler::BlindHandler(const QString &baseUrl, QObject *parent) : EntityHandler("switch", baseUrl, parent) {}
 
-WebhookRequest *BlindHandler::createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
-                                                   const QVariantMap &placeholders, const QVariant &param) const {
-    QString         feature;
-    QVariantMap     parameters(placeholders);
-    BlindInterface *blindInterface = static_cast<BlindInterface *>(entity->getSpecificInterface());
+WebhookRequest *BlindHandler::createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity,
+                                                   int command, const QVariantMap &placeholders,
+                                                   const QVariant &param) const {
+    const char       *feature;
+    PlaceholderValues values(&placeholders, placeholderMask(webhookEntity, command));
+    BlindInterface   *blindInterface = static_cast<BlindInterface *>(entity->getSpecificInterface());
 
     // get current entity values for request parameters
     int state = entity->state();
@@ -63,19 +66,26 @@ WebhookRequest *BlindHandler::createCommandRequest(const QString &entityId, Enti
 
     position = convertPosition(position);
 
-    setPlaceholderValues(&parameters, state, position);
+    setPlaceholderValues(&values, state, position);
+
+    return createRequest(webhookEntity, command, values);
+}
 
-    return createRequest(feature, entityId, parameters);
+int BlindHandler::featureToCommand(const QString &feature) const {
+    static const QHash<QString, int> commands{
+        {"OPEN", BlindDef::C_OPEN},
+        {"CLOSE", BlindDef::C_CLOSE},
+        {"STOP", BlindDef::C_STOP},
+        {"POSITION", BlindDef::C_POSITION},
+    };
+    return commands.value(feature, -1);
 }
 
-void BlindHandler::commandReply(int command, EntityInterface *entity, const QVariant &param,
-                                const WebhookRequest *request, QNetworkReply *reply) {
+UndoRecord BlindHandler::applyCommandState(int command, EntityInterface *entity, const QVariant &param) {
     BlindInterface *blindInterface = static_cast<BlindInterface *>(entity->getSpecificInterface());
 
     int state = -1;
     int position = -1;
-    int oldState = entity->state();
-    int oldPosition = blindInterface->position();
 
     switch (command) {
         case BlindDef::C_OPEN:
@@ -98,15 +108,16 @@ void BlindHandler::commandReply(int command, EntityInterface *entity, const QVar
             break;
     }
 
-    updateEntity(entity, state, position, false);  // no conversion of UI position!
-
-    if (reply->error() == QNetworkReply::NoError) {
-        handleResponseData(entity, request, reply);
-    } else {
-        // revert entity / UI state in case request failed
-        // TODO(zehnm) enhance EntityInterface with refresh() option to simplify entity state -> UI reset.
-        updateEntity(entity, oldState, oldPosition, false);
+    UndoRecord undo;
+    if (state >= 0) {
+        undo.state = entity->state();
+    }
+    if (position >= 0 && entity->isSupported(BlindDef::F_POSITION)) {
+        undo.saveAttribute(BlindDef::POSITION, blindInterface->position());
     }
+
+    updateEntity(entity, state, position, false);  // no conversion of UI position!
+    return undo;
 }
 
 const QLoggingCategory &BlindHandler::logCategory() const { return CLASS_LC(); }
@@ -127,11 +138,10 @@ int BlindHandler::convertPosition(int position) const {
     return 100 - position;
 }
 
-void BlindHandler::setPlaceholderValues(QVariantMap *placeholders, int state, int position) const {
-    // TODO(zehnm) define placeholder constants
-    placeholders->insert("state_bool", state == BlindDef::OPEN);
-    placeholders->insert("state_bin", state);
-    placeholders->insert("position_percent", position);
+void BlindHandler::setPlaceholderValues(PlaceholderValues *values, int state, int position) const {
+    values->set(Placeholder::STATE_BOOL, state == BlindDef::OPEN);
+    values->set(Placeholder::STATE_BIN, state);
+    values->set(Placeholder::POSITION_PERCENT, position);
 }
 
 void BlindHandler::updateEntity(EntityInterface *entity, const QVariantMap &placeholders) {
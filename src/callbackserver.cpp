@@ -0,0 +1,222 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "callbackserver.h"
+
+#include <QList>
+#include <QLoggingCategory>
+#include <QTimer>
+#include <QUrl>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.callback");
+
+// Device callbacks are small. Everything else is most likely garbage or an attack.
+static const int MAX_HEADER_SIZE = 8192;
+static const int MAX_BODY_SIZE = 65536;
+// Maximum time in ms to receive a complete request
+static const int REQUEST_TIMEOUT = 5000;
+
+CallbackServer::CallbackServer(QObject *parent) : QObject(parent) {
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, &CallbackServer::onNewConnection);
+}
+
+bool CallbackServer::listen(quint16 port) {
+    if (m_server.isListening()) {
+        return true;
+    }
+
+    if (!m_server.listen(QHostAddress::Any, port)) {
+        qCWarning(CLASS_LC) << "Failed to start callback server on port" << port << ":" << m_server.errorString();
+        return false;
+    }
+
+    qCInfo(CLASS_LC) << "Callback server listening on port" << m_server.serverPort();
+    return true;
+}
+
+void CallbackServer::close() {
+    m_server.close();
+
+    for (QTcpSocket *socket : m_buffers.keys()) {
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_buffers.clear();
+}
+
+void CallbackServer::addRoute(const QString &path, const RouteHandler &handler) { m_routes.insert(path, handler); }
+
+void CallbackServer::removeRoute(const QString &path) { m_routes.remove(path); }
+
+void CallbackServer::onNewConnection() {
+    while (m_server.hasPendingConnections()) {
+        QTcpSocket *socket = m_server.nextPendingConnection();
+        m_buffers.insert(socket, QByteArray());
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket] { readRequest(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        QTimer::singleShot(REQUEST_TIMEOUT, socket, [socket] { socket->abort(); });
+    }
+}
+
+void CallbackServer::readRequest(QTcpSocket *socket) {
+    auto iter = m_buffers.find(socket);
+    if (iter == m_buffers.end()) {
+        return;
+    }
+
+    QByteArray &buffer = iter.value();
+    buffer.append(socket->readAll());
+
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffer.size() > MAX_HEADER_SIZE) {
+            sendError(socket, 431);
+        }
+        return;
+    }
+
+    QByteArray header = buffer.left(headerEnd);
+    int        contentLength = 0;
+
+    for (const QByteArray &line : header.split('\n')) {
+        int separator = line.indexOf(':');
+        if (separator < 0) {
+            continue;
+        }
+        QByteArray name = line.left(separator).trimmed().toLower();
+        if (name == "content-length") {
+            bool ok;
+            contentLength = line.mid(separator + 1).trimmed().toInt(&ok);
+            if (!ok || contentLength < 0) {
+                sendError(socket, 400);
+                return;
+            }
+        } else if (name == "transfer-encoding") {
+            // chunked requests are not supported
+            sendError(socket, 411);
+            return;
+        }
+    }
+
+    if (contentLength > MAX_BODY_SIZE) {
+        sendError(socket, 413);
+        return;
+    }
+
+    int bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength) {
+        // wait for more data
+        return;
+    }
+
+    QByteArray body = buffer.mid(bodyStart, contentLength);
+    buffer.clear();
+
+    processRequest(socket, header, body);
+}
+
+void CallbackServer::processRequest(QTcpSocket *socket, const QByteArray &header, const QByteArray &body) {
+    QList<QByteArray> lines = header.split('\n');
+    QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 3) {
+        sendError(socket, 400);
+        return;
+    }
+
+    QUrl url(QString::fromUtf8(requestLine.at(1)));
+
+    CallbackRequest request;
+    request.method = requestLine.at(0).toUpper();
+    request.path = url.path();
+    request.query = QUrlQuery(url);
+    request.body = body;
+
+    for (const QByteArray &line : lines) {
+        int separator = line.indexOf(':');
+        if (separator > 0 && line.left(separator).trimmed().toLower() == "content-type") {
+            request.contentType = line.mid(separator + 1).trimmed();
+        }
+    }
+
+    qCDebug(CLASS_LC) << "Request:" << request.method << url.toString() << body.size() << "bytes";
+
+    auto route = m_routes.constFind(request.path);
+    if (route == m_routes.constEnd()) {
+        qCDebug(CLASS_LC) << "No route defined for:" << request.path;
+        sendError(socket, 404);
+        return;
+    }
+
+    CallbackResponse response;
+    route.value()(request, &response);
+    sendResponse(socket, response);
+}
+
+void CallbackServer::sendResponse(QTcpSocket *socket, const CallbackResponse &response) {
+    QByteArray data;
+    data.append("HTTP/1.1 ")
+        .append(QByteArray::number(response.status))
+        .append(' ')
+        .append(reasonPhrase(response.status))
+        .append("\r\n");
+    if (!response.contentType.isEmpty()) {
+        data.append("Content-Type: ").append(response.contentType).append("\r\n");
+    }
+    data.append("Content-Length: ").append(QByteArray::number(response.body.size())).append("\r\n");
+    data.append("Connection: close\r\n\r\n");
+    data.append(response.body);
+
+    socket->write(data);
+    socket->disconnectFromHost();
+}
+
+void CallbackServer::sendError(QTcpSocket *socket, int status) {
+    CallbackResponse response;
+    response.status = status;
+    sendResponse(socket, response);
+    m_buffers.remove(socket);
+}
+
+QByteArray CallbackServer::reasonPhrase(int status) {
+    switch (status) {
+        case 200:
+            return "OK";
+        case 204:
+            return "No Content";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 411:
+            return "Length Required";
+        case 413:
+            return "Payload Too Large";
+        case 431:
+            return "Request Header Fields Too Large";
+        default:
+            return "Error";
+    }
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrlQuery>
+
+/**
+ * @brief Received http request of the callback server.
+ */
+struct CallbackRequest {
+    QByteArray method;
+    QString    path;
+    QUrlQuery  query;
+    QByteArray contentType;
+    QByteArray body;
+};
+
+/**
+ * @brief Http response of a callback route handler.
+ */
+struct CallbackResponse {
+    CallbackResponse() : status(200) {}
+    int        status;
+    QByteArray contentType;
+    QByteArray body;
+};
+
+/**
+ * @brief Minimal embedded http server for device callbacks, e.g. action urls of Shelly or myStrom devices.
+ * @details Only simple requests with an optional Content-Length body are supported. Every connection is closed after
+ * the response.
+ */
+class CallbackServer : public QObject {
+    Q_OBJECT
+
+ public:
+    typedef std::function<void(const CallbackRequest&, CallbackResponse*)> RouteHandler;
+
+    explicit CallbackServer(QObject* parent = nullptr);
+
+    bool listen(quint16 port);
+    void close();
+
+    bool    isListening() const { return m_server.isListening(); }
+    quint16 port() const { return m_server.serverPort(); }
+
+    /**
+     * @brief Registers a handler for the given absolute url path. An existing handler of the same path is replaced.
+     */
+    void addRoute(const QString& path, const RouteHandler& handler);
+    void removeRoute(const QString& path);
+    bool hasRoute(const QString& path) const { return m_routes.contains(path); }
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onNewConnection();
+
+ private:
+    void readRequest(QTcpSocket* socket);
+    void processRequest(QTcpSocket* socket, const QByteArray& header, const QByteArray& body);
+    void sendResponse(QTcpSocket* socket, const CallbackResponse& response);
+    void sendError(QTcpSocket* socket, int status);
+
+    static QByteArray reasonPhrase(int status);
+
+    QTcpServer                     m_server;
+    QHash<QString, RouteHandler>   m_routes;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
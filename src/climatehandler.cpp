@@ -22,6 +22,8 @@
 
 #include "climatehandler.h"
 
+#include <QHash>
+
 #include "yio-interface/entities/climateinterface.h"
 
 static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.climate");
@@ -48,10 +50,11 @@ bool ClimateHandler::onWebhookEntityRead(const QVariantMap &entityCfgMap, Webhoo
     return true;
 }
 
-WebhookRequest *ClimateHandler::createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
-                                                     const QVariantMap &placeholders, const QVariant &param) const {
-    QString           feature;
-    QVariantMap       parameters(placeholders);
+WebhookRequest *ClimateHandler::createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity,
+                                                     int command, const QVariantMap &placeholders,
+                                                     const QVariant &param) const {
+    const char       *feature;
+    PlaceholderValues values(&placeholders, placeholderMask(webhookEntity, command));
     ClimateInterface *climateInterface = static_cast<ClimateInterface *>(entity->getSpecificInterface());
 
     // get current entity values for request parameters
@@ -87,23 +90,26 @@ WebhookRequest *ClimateHandler::createCommandRequest(const QString &entityId, En
 
     qCDebug(CLASS_LC()) << entity->friendly_name() << "command:" << feature << ", parameter:" << param;
 
-    setPlaceholderValues(&parameters, state, targetTemperature);
+    setPlaceholderValues(&values, state, targetTemperature);
+
+    return createRequest(webhookEntity, command, values);
+}
 
-    return createRequest(feature, entityId, parameters);
+int ClimateHandler::featureToCommand(const QString &feature) const {
+    static const QHash<QString, int> commands{
+        {"OFF", ClimateDef::C_OFF},
+        {"ON", ClimateDef::C_ON},
+        {"HEAT", ClimateDef::C_HEAT},
+        {"COOL", ClimateDef::C_COOL},
+        {"TARGET_TEMPERATURE", ClimateDef::C_TARGET_TEMPERATURE},
+    };
+    return commands.value(feature, -1);
 }
 
-void ClimateHandler::commandReply(int command, EntityInterface *entity, const QVariant &param,
-                                  const WebhookRequest *request, QNetworkReply *reply) {
+UndoRecord ClimateHandler::applyCommandState(int command, EntityInterface *entity, const QVariant &param) {
     ClimateInterface *climateInterface = static_cast<ClimateInterface *>(entity->getSpecificInterface());
 
     QVariantMap attributes;
-    QVariantMap oldAttributes;
-
-    oldAttributes.insert("state", entity->state());
-    oldAttributes.insert("current_temp", climateInterface->temperature());
-    oldAttributes.insert("target_temp", climateInterface->targetTemperature());
-    oldAttributes.insert("min_temp", climateInterface->temperatureMax());
-    oldAttributes.insert("max_temp", climateInterface->temperatureMin());
 
     switch (command) {
         case ClimateDef::C_OFF:
@@ -123,15 +129,16 @@ void ClimateHandler::commandReply(int command, EntityInterface *entity, const QV
             break;
     }
 
-    updateEntity(entity, attributes);
-
-    if (reply->error() == QNetworkReply::NoError) {
-        handleResponseData(entity, request, reply);
-    } else {
-        // revert entity / UI state in case request failed
-        // TODO(zehnm) enhance EntityInterface with refresh() option to simplify entity state -> UI reset.
-        updateEntity(entity, oldAttributes);
+    UndoRecord undo;
+    if (attributes.contains("state")) {
+        undo.state = entity->state();
+    }
+    if (attributes.contains("target_temp") && entity->isSupported(ClimateDef::F_TARGET_TEMPERATURE)) {
+        undo.saveAttribute(ClimateDef::TARGET_TEMPERATURE, climateInterface->targetTemperature());
     }
+
+    updateEntity(entity, attributes);
+    return undo;
 }
 
 const QLoggingCategory &ClimateHandler::logCategory() const { return CLASS_LC(); }
@@ -142,14 +149,13 @@ void ClimateHandler::updateEntity(EntityInterface *entity, const QVariantMap &at
     }
 
     if (attributes.contains("state")) {
-        // TODO(zehnm) user configurabel state mapping. Eg. "cooling", "off", "0", "1", ...
+        // device specific states like "cooling" or "off" are mapped with a map transform of the response mapping
         int state = attributes.value("state").toInt();
         entity->setState(state);
     }
 
-    // TODO(zehnm) Fahrenheit / Celsius conversion logic
-    // - Add configuration option for F / C of the called device
-    // - Check unit system of remote
+    // the temperature unit of the device is converted with a unit transform of the response mapping
+    // TODO(zehnm) Check unit system of remote
     // - Figure out temperature handling of the yio climate entity.
     //   Afaik it just displays the value received from the integration!
     // UnitSystem::Enum us = configObj->getUnitSystem();
@@ -168,9 +174,8 @@ void ClimateHandler::updateEntity(EntityInterface *entity, const QVariantMap &at
     }
 }
 
-void ClimateHandler::setPlaceholderValues(QVariantMap *placeholders, int state, double targetTemperature) const {
-    // TODO(zehnm) define placeholder constants
-    placeholders->insert("state", state);
+void ClimateHandler::setPlaceholderValues(PlaceholderValues *values, int state, double targetTemperature) const {
+    values->set(Placeholder::STATE, state);
     // TODO(zehnm) Fahrenheit / Celsius conversion?
-    placeholders->insert("target_temp", targetTemperature);
+    values->set(Placeholder::TARGET_TEMP, targetTemperature);
 }
@@ -32,11 +32,12 @@ class ClimateHandler : public EntityHandler {
 
     // EntityHandler interface
  public:
-    WebhookRequest *createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
+    WebhookRequest *createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity, int command,
                                          const QVariantMap &placeholders, const QVariant &param) const override;
 
-    void commandReply(int command, EntityInterface *entity, const QVariant &param, const WebhookRequest *request,
-                      QNetworkReply *reply) override;
+    int featureToCommand(const QString &feature) const override;
+
+    UndoRecord applyCommandState(int command, EntityInterface *entity, const QVariant &param) override;
 
  protected:
     const QLoggingCategory &logCategory() const override;
@@ -46,5 +47,5 @@ class ClimateHandler : public EntityHandler {
     void updateEntity(EntityInterface *entity, const QVariantMap &placeholders) override;
 
  private:
-    void setPlaceholderValues(QVariantMap *placeholders, int state, double targetTemperature) const;
+    void setPlaceholderValues(PlaceholderValues *values, int state, double targetTemperature) const;
 };
@@ -0,0 +1,220 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "compression.h"
+
+#include <zlib.h>
+
+#include <cstring>
+
+#include <QElapsedTimer>
+
+// inflate output buffer size per iteration
+static const int CHUNK_SIZE = 16384;
+
+// zlib window bits: +16 for a gzip wrapper, negative for a raw deflate stream without zlib wrapper
+static const int WINDOW_BITS_ZLIB = 15;
+static const int WINDOW_BITS_GZIP = 15 + 16;
+static const int WINDOW_BITS_RAW = -15;
+
+QByteArray Compression::gzip(const QByteArray &data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, WINDOW_BITS_GZIP, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return QByteArray();
+    }
+
+    QByteArray result;
+    result.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(data.size()))));
+
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(result.data());
+    stream.avail_out = static_cast<uInt>(result.size());
+
+    int ret = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+
+    if (ret != Z_STREAM_END) {
+        return QByteArray();
+    }
+
+    result.resize(static_cast<int>(stream.total_out));
+    return result;
+}
+
+InflateStream::InflateStream()
+    : m_encoding(IDENTITY),
+      m_stream(nullptr),
+      m_wireBytes(0),
+      m_decodeTime(0),
+      m_active(false),
+      m_error(false),
+      m_finished(false),
+      m_rawDeflateFallback(false) {}
+
+InflateStream::~InflateStream() { endStream(); }
+
+InflateStream::Encoding InflateStream::encodingFromHeader(const QByteArray &contentEncoding) {
+    QByteArray value = contentEncoding.trimmed().toLower();
+    if (value == "gzip" || value == "x-gzip") {
+        return GZIP;
+    }
+    if (value == "deflate") {
+        return DEFLATE;
+    }
+    return IDENTITY;
+}
+
+bool InflateStream::begin(Encoding encoding) {
+    endStream();
+
+    m_encoding = encoding;
+    m_data.clear();
+    m_wireBytes = 0;
+    m_decodeTime = 0;
+    m_active = true;
+    m_error = false;
+    m_finished = false;
+    m_rawDeflateFallback = false;
+
+    if (encoding == IDENTITY) {
+        return true;
+    }
+
+    return initStream(encoding == GZIP ? WINDOW_BITS_GZIP : WINDOW_BITS_ZLIB);
+}
+
+void InflateStream::reset() {
+    endStream();
+
+    m_encoding = IDENTITY;
+    m_data.clear();
+    m_wireBytes = 0;
+    m_decodeTime = 0;
+    m_active = false;
+    m_error = false;
+    m_finished = false;
+    m_rawDeflateFallback = false;
+}
+
+bool InflateStream::append(const QByteArray &chunk) {
+    if (!m_active || m_error) {
+        return false;
+    }
+    if (chunk.isEmpty()) {
+        return true;
+    }
+
+    m_wireBytes += chunk.size();
+
+    if (m_encoding == IDENTITY) {
+        m_data.append(chunk);
+        return true;
+    }
+
+    if (m_finished) {
+        // ignore trailing data after the end of the compressed stream
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = inflateChunk(chunk);
+    m_decodeTime += timer.nsecsElapsed();
+
+    if (!ok) {
+        m_error = true;
+        endStream();
+    }
+
+    return ok;
+}
+
+bool InflateStream::initStream(int windowBits) {
+    m_stream = new z_stream;
+    memset(m_stream, 0, sizeof(z_stream));
+
+    if (inflateInit2(m_stream, windowBits) != Z_OK) {
+        delete m_stream;
+        m_stream = nullptr;
+        m_error = true;
+        return false;
+    }
+
+    return true;
+}
+
+void InflateStream::endStream() {
+    if (m_stream) {
+        inflateEnd(m_stream);
+        delete m_stream;
+        m_stream = nullptr;
+    }
+}
+
+bool InflateStream::inflateChunk(const QByteArray &chunk) {
+    if (!m_stream) {
+        return false;
+    }
+
+    char buffer[CHUNK_SIZE];
+
+    m_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(chunk.constData()));
+    m_stream->avail_in = static_cast<uInt>(chunk.size());
+
+    do {
+        m_stream->next_out = reinterpret_cast<Bytef *>(buffer);
+        m_stream->avail_out = CHUNK_SIZE;
+
+        int ret = inflate(m_stream, Z_NO_FLUSH);
+
+        if (ret == Z_DATA_ERROR && m_encoding == DEFLATE && !m_rawDeflateFallback && m_data.isEmpty() &&
+            m_wireBytes == chunk.size()) {
+            // Some servers send a raw deflate stream without zlib wrapper. Retry first chunk in raw mode.
+            m_rawDeflateFallback = true;
+            endStream();
+            if (!initStream(WINDOW_BITS_RAW)) {
+                return false;
+            }
+            return inflateChunk(chunk);
+        }
+
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            return false;
+        }
+
+        m_data.append(buffer, CHUNK_SIZE - static_cast<int>(m_stream->avail_out));
+
+        if (ret == Z_STREAM_END) {
+            m_finished = true;
+            break;
+        }
+        if (ret == Z_BUF_ERROR) {
+            // no progress possible, more input required
+            break;
+        }
+    } while (m_stream->avail_out == 0 || m_stream->avail_in > 0);
+
+    return true;
+}
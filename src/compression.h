@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+struct z_stream_s;
+
+/**
+ * @brief Compression helpers for http request bodies.
+ */
+class Compression {
+ public:
+    /**
+     * @brief Compresses the given data in gzip format (RFC 1952) to be sent with "Content-Encoding: gzip".
+     * @return The compressed data or an empty array if compression failed.
+     */
+    static QByteArray gzip(const QByteArray& data);
+};
+
+/**
+ * @brief Incremental decoder for http response bodies with an optional gzip or deflate content encoding.
+ * @details Network data is decoded chunk by chunk as it arrives, only the decoded body is kept in memory.
+ * Uncompressed data is passed through as is.
+ */
+class InflateStream {
+ public:
+    enum Encoding { IDENTITY, GZIP, DEFLATE };
+
+    InflateStream();
+    ~InflateStream();
+
+    /**
+     * @brief Returns the encoding for the given Content-Encoding header value.
+     */
+    static Encoding encodingFromHeader(const QByteArray& contentEncoding);
+
+    /**
+     * @brief Resets the stream and starts decoding with the given encoding.
+     * @return false if the decoder could not be initialized.
+     */
+    bool begin(Encoding encoding);
+
+    /**
+     * @brief Resets the stream to the initial inactive state, e.g. to reuse a pooled request.
+     */
+    void reset();
+
+    /**
+     * @brief Decodes the next chunk of network data and appends it to the decoded body.
+     * @return false if the data could not be decoded. All further data is ignored.
+     */
+    bool append(const QByteArray& chunk);
+
+    bool              isActive() const { return m_active; }
+    bool              hasError() const { return m_error; }
+    Encoding          encoding() const { return m_encoding; }
+    const QByteArray& data() const { return m_data; }
+
+    /**
+     * @brief Number of received bytes on the wire, i.e. before decoding.
+     */
+    qint64 wireBytes() const { return m_wireBytes; }
+
+    /**
+     * @brief Accumulated decoding time in nanoseconds.
+     */
+    qint64 decodeTime() const { return m_decodeTime; }
+
+ private:
+    Q_DISABLE_COPY(InflateStream)
+
+    bool initStream(int windowBits);
+    void endStream();
+    bool inflateChunk(const QByteArray& chunk);
+
+    Encoding    m_encoding;
+    z_stream_s* m_stream;
+    QByteArray  m_data;
+    qint64      m_wireBytes;
+    qint64      m_decodeTime;
+    bool        m_active;
+    bool        m_error;
+    bool        m_finished;
+    bool        m_rawDeflateFallback;
+};
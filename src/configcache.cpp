@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "configcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QSaveFile>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.configcache");
+
+// "YWCC"
+const quint32 ConfigCache::MAGIC = 0x59574343;
+// increment for every change of the serialized data!
+const quint32 ConfigCache::FORMAT_VERSION = 4;
+const int     ConfigCache::STREAM_VERSION = QDataStream::Qt_5_12;
+
+ConfigCache::ConfigCache(const QString &fileName) : m_fileName(fileName), m_file(fileName), m_map(nullptr) {}
+
+ConfigCache::~ConfigCache() { close(); }
+
+QByteArray ConfigCache::key(const QVariantMap &data, const QByteArray &version) {
+    // QVariantMap keys are sorted: equal configurations result in the same json document
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QJsonDocument::fromVariant(data).toJson(QJsonDocument::Compact));
+    hash.addData(version);
+    return hash.result();
+}
+
+QDataStream *ConfigCache::open(const QByteArray &key) {
+    close();
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    m_map = m_file.map(0, m_file.size());
+    if (m_map) {
+        m_data = QByteArray::fromRawData(reinterpret_cast<const char *>(m_map), static_cast<int>(m_file.size()));
+    } else {
+        m_data = m_file.readAll();
+    }
+
+    m_stream.reset(new QDataStream(m_data));
+    m_stream->setVersion(STREAM_VERSION);
+
+    quint32    magic;
+    quint32    formatVersion;
+    QByteArray cacheKey;
+    *m_stream >> magic >> formatVersion >> cacheKey;
+    if (m_stream->status() != QDataStream::Ok || magic != MAGIC || formatVersion != FORMAT_VERSION ||
+        cacheKey != key) {
+        qCDebug(CLASS_LC) << "Config cache is outdated:" << m_fileName;
+        close();
+        return nullptr;
+    }
+
+    return m_stream.data();
+}
+
+void ConfigCache::close() {
+    m_stream.reset();
+    m_data.clear();
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+}
+
+bool ConfigCache::save(const QByteArray &key, const WriteFunction &write) {
+    close();
+
+    QDir().mkpath(QFileInfo(m_fileName).absolutePath());
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(CLASS_LC) << "Error writing config cache" << m_fileName << ":" << file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(STREAM_VERSION);
+    out << MAGIC << FORMAT_VERSION << key;
+    write(out);
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        qCWarning(CLASS_LC) << "Error writing config cache" << m_fileName << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
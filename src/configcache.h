@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QScopedPointer>
+#include <QString>
+#include <QVariantMap>
+
+/**
+ * @brief Memory-mapped on-disk cache of the compiled integration state.
+ * @details The cache is keyed by a hash of the integration configuration and the plugin version. A cache written for
+ * another key is ignored and rebuilt by the caller. The file is replaced atomically when saving.
+ */
+class ConfigCache {
+ public:
+    typedef std::function<void(QDataStream&)> WriteFunction;
+
+    explicit ConfigCache(const QString& fileName);
+    ~ConfigCache();
+
+    ConfigCache(const ConfigCache&) = delete;
+    ConfigCache& operator=(const ConfigCache&) = delete;
+
+    /**
+     * @brief Returns the cache key of the given integration configuration data section and plugin version.
+     */
+    static QByteArray key(const QVariantMap& data, const QByteArray& version);
+
+    const QString& fileName() const { return m_fileName; }
+
+    /**
+     * @brief Maps the cache file into memory and validates the cache header.
+     * @return The stream of the cached data, valid until close() is called. Null if the cache doesn't exist or has
+     * been written for another key.
+     */
+    QDataStream* open(const QByteArray& key);
+
+    /**
+     * @brief Releases the stream and unmaps the cache file.
+     */
+    void close();
+
+    /**
+     * @brief Writes the cache data with the given write function.
+     * @return false if the cache file could not be written.
+     */
+    bool save(const QByteArray& key, const WriteFunction& write);
+
+ private:
+    static const quint32 MAGIC;
+    static const quint32 FORMAT_VERSION;
+    static const int     STREAM_VERSION;
+
+    QString                     m_fileName;
+    QFile                       m_file;
+    uchar*                      m_map;
+    QByteArray                  m_data;
+    QScopedPointer<QDataStream> m_stream;
+};
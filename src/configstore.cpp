@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "configstore.h"
+
+QString ConfigStore::intern(const QString &text) {
+    if (text.isEmpty()) {
+        return QString();
+    }
+
+    auto iter = m_strings.constFind(text);
+    if (iter != m_strings.constEnd()) {
+        return *iter;
+    }
+    m_strings.insert(text);
+    return text;
+}
+
+QVariantMap ConfigStore::sharedHeaders(const QVariantMap &headers, const QVariantMap &placeholders) {
+    return m_headerBlocks.at(headerBlockIndex(headers, placeholders));
+}
+
+HeaderTemplates ConfigStore::sharedHeaderTemplates(const QVariantMap &headers, const QVariantMap &placeholders) {
+    return m_headerTemplates.at(headerBlockIndex(headers, placeholders));
+}
+
+int ConfigStore::headerBlockIndex(const QVariantMap &headers, const QVariantMap &placeholders) {
+    // there are only a few different header blocks: the global headers plus some command specific variations
+    int sameHeaders = -1;
+    for (int i = 0; i < m_headerBlocks.size(); i++) {
+        if (m_headerBlocks.at(i) == headers) {
+            // the templates are bound to the placeholders: a reload with changed placeholders needs new templates
+            if (m_headerPlaceholders.at(i) == placeholders) {
+                return i;
+            }
+            sameHeaders = i;
+        }
+    }
+    m_headerBlocks.append(sameHeaders < 0 ? headers : m_headerBlocks.at(sameHeaders));
+    m_headerPlaceholders.append(placeholders);
+
+    HeaderTemplates templates;
+    templates.reserve(headers.size());
+    for (auto iter = headers.cbegin(); iter != headers.cend(); ++iter) {
+        templates.append(qMakePair(iter.key().toUtf8(), TextTemplate(iter.value().toString()).bind(placeholders)));
+    }
+    m_headerTemplates.append(templates);
+    return m_headerBlocks.size() - 1;
+}
+
+MappingList ConfigStore::sharedMappings(const MappingList &mappings) {
+    if (mappings.isEmpty()) {
+        return MappingList();
+    }
+
+    auto iter = m_mappings.constFind(mappings);
+    if (iter != m_mappings.constEnd()) {
+        return *iter;
+    }
+
+    MappingList shared;
+    shared.reserve(mappings.size());
+    for (const auto &mapping : mappings) {
+        shared.append(qMakePair(intern(mapping.first), intern(mapping.second)));
+    }
+    m_mappings.insert(shared);
+    return shared;
+}
+
+TransformList ConfigStore::sharedTransforms(const TransformList &transforms) {
+    if (transforms.isEmpty()) {
+        return TransformList();
+    }
+
+    // only a few mappings use transforms, e.g. the brightness scaling of all lights of the same type
+    for (const TransformList &pooled : qAsConst(m_transforms)) {
+        if (pooled == transforms) {
+            return pooled;
+        }
+    }
+    m_transforms.append(transforms);
+    return transforms;
+}
+
+QVariantMap ConfigStore::poolStats() const {
+    QVariantMap stats;
+    stats.insert("entities", m_entities.size());
+    stats.insert("commands", m_commands.size());
+    stats.insert("strings", m_strings.size());
+    stats.insert("header_blocks", m_headerBlocks.size());
+    stats.insert("mapping_lists", m_mappings.size());
+    stats.insert("transform_lists", m_transforms.size());
+    return stats;
+}
+
+void ConfigStore::clear() {
+    m_entities.clear();
+    m_commands.clear();
+    m_strings.clear();
+    m_headerBlocks.clear();
+    m_headerPlaceholders.clear();
+    m_headerTemplates.clear();
+    m_mappings.clear();
+    m_transforms.clear();
+}
@@ -0,0 +1,153 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <new>
+
+#include <QSet>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include "webhookcommand.h"
+#include "webhookentity.h"
+
+/**
+ * @brief Append-only array of records, allocated in contiguous blocks.
+ * @details Records are never moved: pointers to them stay valid until clear() is called.
+ */
+template <typename T, int BlockSize = 64>
+class RecordArray {
+ public:
+    RecordArray() : m_size(0) {}
+    ~RecordArray() { clear(); }
+
+    RecordArray(const RecordArray &) = delete;
+    RecordArray &operator=(const RecordArray &) = delete;
+
+    /**
+     * @brief Appends a default constructed record and returns it.
+     */
+    T *append() {
+        int block = m_size / BlockSize;
+        if (block == m_blocks.size()) {
+            m_blocks.append(static_cast<T *>(::operator new(sizeof(T) * BlockSize)));
+        }
+        T *record = new (m_blocks.at(block) + m_size % BlockSize) T();
+        m_size++;
+        return record;
+    }
+
+    T *at(int index) const { return m_blocks.at(index / BlockSize) + index % BlockSize; }
+
+    int size() const { return m_size; }
+
+    /**
+     * @brief Destroys all records and releases the allocated blocks.
+     */
+    void clear() {
+        for (int i = 0; i < m_size; i++) {
+            at(i)->~T();
+        }
+        for (T *block : qAsConst(m_blocks)) {
+            ::operator delete(block);
+        }
+        m_blocks.clear();
+        m_size = 0;
+    }
+
+ private:
+    QVector<T *> m_blocks;
+    int          m_size;
+};
+
+/**
+ * @brief Flat storage of the entity and command definitions read from the configuration.
+ * @details Entities and commands are stored in contiguous record arrays instead of individual heap objects. Strings,
+ * header blocks and mapping lists are deduplicated: equal values share the same implicitly shared data, e.g. the global
+ * headers or the identical status mappings of hundreds of devices of the same type.
+ */
+class ConfigStore {
+ public:
+    ConfigStore() = default;
+
+    ConfigStore(const ConfigStore &) = delete;
+    ConfigStore &operator=(const ConfigStore &) = delete;
+
+    WebhookEntity  *createEntity() { return m_entities.append(); }
+    WebhookCommand *createCommand() { return m_commands.append(); }
+
+    int entityCount() const { return m_entities.size(); }
+    int commandCount() const { return m_commands.size(); }
+
+    /**
+     * @brief Returns the pooled instance of the given string.
+     */
+    QString intern(const QString &text);
+
+    /**
+     * @brief Returns the pooled instance of the given header block.
+     * @param placeholders Static placeholders bound to the compiled templates of the block.
+     */
+    QVariantMap sharedHeaders(const QVariantMap &headers, const QVariantMap &placeholders = QVariantMap());
+
+    /**
+     * @brief Returns the compiled templates of the pooled header block. The block is added if not yet pooled with the
+     * given placeholders.
+     * @param placeholders Static placeholders bound to the templates.
+     */
+    HeaderTemplates sharedHeaderTemplates(const QVariantMap &headers,
+                                          const QVariantMap &placeholders = QVariantMap());
+
+    /**
+     * @brief Returns the pooled instance of the given mapping list. Keys and values are interned.
+     */
+    MappingList sharedMappings(const MappingList &mappings);
+
+    /**
+     * @brief Returns the pooled instance of the given transform list.
+     */
+    TransformList sharedTransforms(const TransformList &transforms);
+
+    /**
+     * @brief Returns the number of pooled strings, header blocks, mapping lists and transform lists.
+     */
+    QVariantMap poolStats() const;
+
+    /**
+     * @brief Destroys all records and empties the pools. All record pointers become invalid!
+     */
+    void clear();
+
+ private:
+    int headerBlockIndex(const QVariantMap &headers, const QVariantMap &placeholders);
+
+    RecordArray<WebhookEntity>  m_entities;
+    RecordArray<WebhookCommand> m_commands;
+    QSet<QString>               m_strings;
+    QVector<QVariantMap>        m_headerBlocks;
+    QVector<QVariantMap>        m_headerPlaceholders;
+    QVector<HeaderTemplates>    m_headerTemplates;
+    QSet<MappingList>           m_mappings;
+    QVector<TransformList>      m_transforms;
+};
@@ -22,75 +22,382 @@
 
 #include "entityhandler.h"
 
-#include <math.h>
-
-#include <QRegularExpression>
+#include <QHash>
 
+#include "compression.h"
 #include "jsonpath.h"
 
 const QString EntityHandler::STATUS_COMMAND = "STATUS_POLLING";
+const QString EntityHandler::SUBSCRIBE_COMMAND = "STATUS_SUBSCRIBE";
+const int     EntityHandler::COMPRESS_BODY_MIN_SIZE = 256;
 
 EntityHandler::EntityHandler(const QString &entityType, const QString &baseUrl, QObject *parent)
-    : QObject(parent), m_entityType(entityType), m_baseUrl(baseUrl) {}
+    : QObject(parent),
+      m_entityType(entityType),
+      m_baseUrl(baseUrl),
+      m_baseUrlTemplate(baseUrl),
+      m_requestPool(nullptr),
+      m_metrics(nullptr),
+      m_watchdog(nullptr) {}
+
+void EntityHandler::setPlaceholders(const QVariantMap &placeholders) {
+    m_placeholders = placeholders;
+    m_baseUrlTemplate = TextTemplate(m_baseUrl).bind(placeholders);
+}
+
+void EntityHandler::setBaseUrl(const QString &baseUrl) {
+    m_baseUrl = baseUrl;
+    m_baseUrlTemplate = TextTemplate(baseUrl).bind(m_placeholders);
+}
 
 int EntityHandler::readEntities(const QVariantList &entityCfgList, const QVariantMap &headers) {
     int count = 0;
+    m_globalHeaders = m_configStore.sharedHeaders(headers, m_placeholders);
     for (const QVariant &entityCfg : entityCfgList) {
-        QVariantMap    entityCfgMap = entityCfg.toMap();
-        WebhookEntity *entity = new WebhookEntity(entityCfgMap.value("entity_id").toString(), entityType(),
-                                                  entityCfgMap.value("friendly_name").toString(),
-                                                  entityCfgMap.value("attributes").toMap(), this);
-
-        QMapIterator<QString, QVariant> iter(entityCfgMap.value("commands").toMap());
-        while (iter.hasNext()) {
-            iter.next();
-            QString  feature = iter.key();
-            QVariant featureCfg = iter.value();
-            if (feature != STATUS_COMMAND) {
-                entity->supportedFeatures.append(feature);
+        WebhookEntity *entity = m_configStore.createEntity();
+        if (readEntity(entityCfg.toMap(), entity)) {
+            count++;
+            m_webhookEntities.insert(entity->id, entity);
+        }
+    }
+
+    return count;
+}
+
+EntityHandler::ReloadResult EntityHandler::reloadEntities(const QVariantList &previousCfgList,
+                                                          const QVariantList &entityCfgList, const QVariantMap &headers,
+                                                          bool recompile) {
+    ReloadResult result;
+    m_globalHeaders = m_configStore.sharedHeaders(headers, m_placeholders);
+
+    QHash<QString, QVariantMap> previousCfg;
+    previousCfg.reserve(previousCfgList.size());
+    for (const QVariant &entityCfg : previousCfgList) {
+        QVariantMap entityCfgMap = entityCfg.toMap();
+        previousCfg.insert(entityCfgMap.value("entity_id").toString(), entityCfgMap);
+    }
+
+    QSet<QString> entityIds;
+    entityIds.reserve(entityCfgList.size());
+    for (const QVariant &entityCfg : entityCfgList) {
+        QVariantMap entityCfgMap = entityCfg.toMap();
+        QString     entityId = entityCfgMap.value("entity_id").toString();
+        entityIds.insert(entityId);
+
+        WebhookEntity *entity = m_webhookEntities.value(entityId);
+        if (!entity) {
+            entity = m_configStore.createEntity();
+            if (readEntity(entityCfgMap, entity)) {
+                m_webhookEntities.insert(entity->id, entity);
+                result.added.append(entity);
+                result.subscriptionsChanged |= entity->subscribeCommand != nullptr;
             }
+            continue;
+        }
+
+        // the configuration is usually implicitly shared with the app: comparing unchanged entities is cheap
+        QVariantMap previousCfgMap = previousCfg.value(entityId);
+        if (!recompile && previousCfgMap == entityCfgMap) {
+            result.unchanged++;
+            continue;
+        }
+
+        CommandTable    previousCommands = entity->commands;
+        WebhookCommand *previousSubscribe = entity->subscribeCommand;
+        entity->resetDefinition();
+        if (readEntity(entityCfgMap, entity, recompile ? nullptr : &previousCommands,
+                       previousCfgMap.value("commands").toMap())) {
+            result.updated.append(entity);
+            result.subscriptionsChanged |= entity->subscribeCommand != previousSubscribe;
+        } else {
+            m_webhookEntities.remove(entityId);
+            result.removed.append(entity);
+            result.subscriptionsChanged |= previousSubscribe != nullptr;
+        }
+    }
+
+    for (auto iter = m_webhookEntities.begin(); iter != m_webhookEntities.end();) {
+        if (entityIds.contains(iter.key())) {
+            ++iter;
+            continue;
+        }
+        result.removed.append(iter.value());
+        result.subscriptionsChanged |= iter.value()->subscribeCommand != nullptr;
+        iter = m_webhookEntities.erase(iter);
+    }
+
+    qCDebug(logCategory()) << "Reloaded entities:" << result.added.size() << "added," << result.updated.size()
+                           << "updated," << result.removed.size() << "removed," << result.unchanged << "unchanged";
+    return result;
+}
 
-            WebhookCommand *command = new WebhookCommand(this);
-            command->headers = headers;
-            if (featureCfg.type() == QVariant::String) {
-                // simple GET command without any options
-                command->url = featureCfg.toString();
-                command->method = HttpMethod::GET;
+bool EntityHandler::readEntity(const QVariantMap &entityCfgMap, WebhookEntity *entity,
+                               const CommandTable *previousCommands, const QVariantMap &previousCommandsCfg) {
+    entity->id = entityCfgMap.value("entity_id").toString();
+    entity->type = m_configStore.intern(entityType());
+    entity->friendlyName = entityCfgMap.value("friendly_name").toString();
+    entity->attributes = entityCfgMap.value("attributes").toMap();
+
+    QVariantMap commandsCfg = entityCfgMap.value("commands").toMap();
+    for (auto iter = commandsCfg.cbegin(); iter != commandsCfg.cend(); ++iter) {
+        QString feature = m_configStore.intern(iter.key());
+
+        // an unchanged command of a reloaded entity is reused, whether it has been materialized or not
+        WebhookCommand *previous = nullptr;
+        int             previousIndex = previousCommands ? previousCommands->indexOf(feature) : -1;
+        if (previousIndex >= 0 && previousCommandsCfg.value(feature) == iter.value()) {
+            previous = previousCommands->at(previousIndex);
+        }
+
+        if (feature == STATUS_COMMAND) {
+            entity->statusCommand = previous ? previous : readCommand(feature, iter.value());
+            entity->commands.insert(feature, QVariant(), entity->statusCommand);
+        } else if (feature == SUBSCRIBE_COMMAND) {
+            entity->subscribeCommand = previous ? previous : readCommand(feature, iter.value());
+            entity->commands.insert(feature, QVariant(), entity->subscribeCommand);
+        } else {
+            // entity commands are only materialized on first use. The configuration is implicitly shared.
+            entity->supportedFeatures.append(feature);
+            int index = entity->commands.insert(feature, previous ? QVariant() : iter.value(), previous);
+            entity->setCommandSlot(featureToCommand(feature), index);
+        }
+    }
+
+    if (entityCfgMap.contains("callback")) {
+        QVariantMap callbackCfg = entityCfgMap.value("callback").toMap();
+        entity->callbackPath = callbackCfg.value("path", "/" + entity->id).toString();
+        entity->pollInterval = callbackCfg.value("poll_interval", -1).toInt();
+        entity->callbackMappings = readMappings(callbackCfg.value("mappings").toMap(), &entity->callbackTransforms);
+    }
+
+    entity->commands.squeeze();
+
+    return onWebhookEntityRead(entityCfgMap, entity);
+}
+
+WebhookCommand *EntityHandler::readCommand(const QString &feature, const QVariant &featureCfg) const {
+    WebhookCommand *command = m_configStore.createCommand();
+    command->headers = m_globalHeaders;
+    if (featureCfg.type() == QVariant::String) {
+        // simple GET command without any options
+        command->url = m_configStore.intern(featureCfg.toString());
+        command->method = HttpMethod::GET;
+    } else {
+        // the full package
+        QVariantMap attrMap = featureCfg.toMap();
+
+        command->url = m_configStore.intern(attrMap.value("url").toString());
+        command->method = stringToEnum<HttpMethod::Enum>(attrMap.value("method").toString(), HttpMethod::GET);
+
+        if (feature == STATUS_COMMAND) {
+            command->interval = qMax(0, attrMap.value("interval", 0).toInt());
+        } else if (feature == SUBSCRIBE_COMMAND) {
+            command->transport = m_configStore.intern(attrMap.value("transport", "sse").toString());
+            command->body = attrMap.value("body");
+            command->eventFilter = readMappings(attrMap.value("filter").toMap());
+        }
+
+        if (command->isMqtt()) {
+            // MQTT commands always publish the body, the http method is ignored
+            command->body = attrMap.value("body");
+            command->qos = static_cast<quint8>(qBound(0, attrMap.value("qos", 0).toInt(), 2));
+            command->retain = attrMap.value("retain", false).toBool();
+        } else if (command->isSocket()) {
+            // socket commands always send the body, the http method is ignored
+            command->body = attrMap.value("body");
+            command->framing =
+                stringToEnum<SocketFraming::Enum>(attrMap.value("framing").toString().toUpper(), SocketFraming::NONE);
+        } else if (command->method != HttpMethod::GET) {
+            command->body = attrMap.value("body");
+            command->compressBody = attrMap.value("compress_body", false).toBool();
+            // Attention: QMap.unite inserts the same key multiple times instead of replacing it!
+            QMapIterator<QString, QVariant> iter(attrMap.value("headers").toMap());
+            while (iter.hasNext()) {
+                iter.next();
+                command->headers.insert(iter.key(), iter.value());
+            }
+            command->headers = m_configStore.sharedHeaders(command->headers, m_placeholders);
+        }
+
+        command->hexBody = attrMap.value("body_encoding").toString() == "hex";
+
+        if (attrMap.contains("response")) {
+            command->responseMappings = readMappings(attrMap.value("response").toMap().value("mappings").toMap(),
+                                                     &command->responseTransforms);
+        }
+    }
+    compileTemplates(command);
+    return command;
+}
+
+const WebhookCommand *EntityHandler::entityCommand(const WebhookEntity *entity, int command) const {
+    int index = entity->commandIndex(command);
+    return index < 0 ? nullptr : commandAt(entity, index);
+}
+
+const WebhookCommand *EntityHandler::commandAt(const WebhookEntity *entity, int index) const {
+    WebhookCommand *command = entity->commands.at(index);
+    if (!command) {
+        command = readCommand(entity->commands.nameAt(index), entity->commands.configAt(index));
+        entity->commands.setMaterialized(index, command);
+    }
+    return command;
+}
+
+void EntityHandler::compileTemplates(WebhookCommand *command) const {
+    // static placeholders are rendered once, only the dynamic entity values are rendered for every request
+    command->urlTemplate = TextTemplate(command->url).bind(m_placeholders);
+    if (command->body.type() == QVariant::Map) {
+        QJsonDocument jsonDoc = QJsonDocument::fromVariant(command->body);
+        command->bodyTemplate =
+            TextTemplate(QString::fromUtf8(jsonDoc.toJson(QJsonDocument::Compact))).bind(m_placeholders);
+    } else if (command->body.isValid()) {
+        command->bodyTemplate = TextTemplate(command->body.toString()).bind(m_placeholders);
+    }
+    command->headerTemplates = m_configStore.sharedHeaderTemplates(command->headers, m_placeholders);
+
+    // the base url is only rendered for a relative command url, but this isn't known before rendering
+    command->placeholderMask = m_baseUrlTemplate.placeholderMask() | command->urlTemplate.placeholderMask() |
+                               command->bodyTemplate.placeholderMask();
+    for (const auto &header : command->headerTemplates) {
+        command->placeholderMask |= header.second.placeholderMask();
+    }
+}
+
+void EntityHandler::writeCache(QDataStream &out) const {
+    out << static_cast<qint32>(m_webhookEntities.size());
+    for (const WebhookEntity *entity : m_webhookEntities) {
+        out << entity->id << entity->friendlyName << entity->attributes << entity->supportedFeatures
+            << entity->callbackPath << static_cast<qint32>(entity->pollInterval) << entity->callbackMappings
+            << entity->callbackTransforms;
+
+        // only the compiled commands are cached compiled: the others keep their configuration until first use
+        out << static_cast<qint32>(entity->commands.size());
+        for (int i = 0; i < entity->commands.size(); i++) {
+            const WebhookCommand *command = entity->commands.at(i);
+            out << entity->commands.nameAt(i) << (command != nullptr);
+            if (!command) {
+                out << entity->commands.configAt(i);
+                continue;
+            }
+            out << command->url << static_cast<qint32>(command->method) << command->headers << command->body
+                << command->responseMappings << command->compressBody << command->transport << command->eventFilter
+                << command->qos << command->retain << static_cast<qint32>(command->framing) << command->hexBody
+                << command->urlTemplate << command->bodyTemplate << command->placeholderMask
+                << static_cast<qint32>(command->interval) << command->responseTransforms;
+        }
+    }
+}
+
+bool EntityHandler::readCache(QDataStream &in) {
+    qint32 entityCount;
+    in >> entityCount;
+    for (qint32 i = 0; i < entityCount && in.status() == QDataStream::Ok; i++) {
+        WebhookEntity *entity = m_configStore.createEntity();
+        qint32         pollInterval;
+        qint32         commandCount;
+        MappingList    callbackMappings;
+        TransformList  callbackTransforms;
+        in >> entity->id >> entity->friendlyName >> entity->attributes >> entity->supportedFeatures >>
+            entity->callbackPath >> pollInterval >> callbackMappings >> callbackTransforms >> commandCount;
+        entity->type = m_configStore.intern(entityType());
+        entity->pollInterval = pollInterval;
+        entity->callbackMappings = m_configStore.sharedMappings(callbackMappings);
+        entity->callbackTransforms = m_configStore.sharedTransforms(callbackTransforms);
+
+        for (qint32 c = 0; c < commandCount && in.status() == QDataStream::Ok; c++) {
+            QString feature;
+            bool    compiled;
+            in >> feature >> compiled;
+            feature = m_configStore.intern(feature);
+
+            if (!compiled) {
+                QVariant featureCfg;
+                in >> featureCfg;
+                int index = entity->commands.insert(feature, featureCfg);
+                entity->setCommandSlot(featureToCommand(feature), index);
+                continue;
+            }
+
+            WebhookCommand *command = readCachedCommand(in);
+            int             index = entity->commands.insert(feature, QVariant(), command);
+            if (feature == STATUS_COMMAND) {
+                entity->statusCommand = command;
+            } else if (feature == SUBSCRIBE_COMMAND) {
+                entity->subscribeCommand = command;
             } else {
-                // the full package
-                QVariantMap attrMap = featureCfg.toMap();
-
-                command->url = attrMap.value("url").toString();
-                command->method = stringToEnum<HttpMethod::Enum>(attrMap.value("method").toString(), HttpMethod::GET);
-
-                if (command->method != HttpMethod::GET) {
-                    command->body = attrMap.value("body");
-                    // Attention: QMap.unite inserts the same key multiple times instead of replacing it!
-                    QMapIterator<QString, QVariant> iter(attrMap.value("headers").toMap());
-                    while (iter.hasNext()) {
-                        iter.next();
-                        command->headers.insert(iter.key(), iter.value());
-                    }
-                }
-
-                if (attrMap.contains("response")) {
-                    QMapIterator<QString, QVariant> iter(attrMap.value("response").toMap().value("mappings").toMap());
-                    while (iter.hasNext()) {
-                        iter.next();
-                        command->responseMappings.insert(iter.key(), iter.value().toString());
-                    }
-                }
+                entity->setCommandSlot(featureToCommand(feature), index);
             }
-            entity->commands.insert(feature, command);
         }
 
-        if (onWebhookEntityRead(entityCfgMap, entity)) {
-            count++;
-            m_webhookEntities.insert(entity->id, entity);
+        entity->commands.squeeze();
+        m_webhookEntities.insert(entity->id, entity);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qCWarning(logCategory()) << "Invalid config cache data";
+        m_webhookEntities.clear();
+        m_configStore.clear();
+        return false;
+    }
+    return true;
+}
+
+WebhookCommand *EntityHandler::readCachedCommand(QDataStream &in) {
+    WebhookCommand *command = m_configStore.createCommand();
+    QString         url, transport;
+    qint32          method, framing, interval;
+    QVariantMap     headers;
+    MappingList     responseMappings, eventFilter;
+    TransformList   responseTransforms;
+    in >> url >> method >> headers >> command->body >> responseMappings >> command->compressBody >> transport >>
+        eventFilter >> command->qos >> command->retain >> framing >> command->hexBody >> command->urlTemplate >>
+        command->bodyTemplate >> command->placeholderMask >> interval >> responseTransforms;
+
+    command->url = m_configStore.intern(url);
+    command->method = static_cast<HttpMethod::Enum>(method);
+    command->headers = m_configStore.sharedHeaders(headers, m_placeholders);
+    command->headerTemplates = m_configStore.sharedHeaderTemplates(command->headers, m_placeholders);
+    command->responseMappings = m_configStore.sharedMappings(responseMappings);
+    command->responseTransforms = m_configStore.sharedTransforms(responseTransforms);
+    command->transport = m_configStore.intern(transport);
+    command->eventFilter = m_configStore.sharedMappings(eventFilter);
+    command->framing = static_cast<SocketFraming::Enum>(framing);
+    command->interval = interval;
+    return command;
+}
+
+MappingList EntityHandler::readMappings(const QVariantMap &mappingsCfg, TransformList *transforms) const {
+    MappingList   mappings;
+    TransformList compiled;
+    bool          hasTransforms = false;
+    mappings.reserve(mappingsCfg.size());
+    compiled.reserve(mappingsCfg.size());
+    QMapIterator<QString, QVariant> iter(mappingsCfg);
+    while (iter.hasNext()) {
+        iter.next();
+        if (iter.value().type() != QVariant::Map) {
+            mappings.append(qMakePair(iter.key(), iter.value().toString()));
+            compiled.append(ValueTransform());
+            continue;
+        }
+
+        // mapping with a transform chain: { "path": "state.bri", "transform": [ { "scale": [0, 255, 0, 100] } ] }
+        QVariantMap    mappingCfg = iter.value().toMap();
+        QString        error;
+        ValueTransform transform = ValueTransform::compile(mappingCfg.value("transform"), &error);
+        if (!error.isEmpty()) {
+            qCWarning(logCategory()) << "Mapping" << iter.key() << error;
         }
+        mappings.append(qMakePair(iter.key(), mappingCfg.value("path").toString()));
+        compiled.append(transform);
+        hasTransforms = hasTransforms || !transform.isEmpty();
     }
 
-    return count;
+    if (transforms) {
+        *transforms = hasTransforms ? m_configStore.sharedTransforms(compiled) : TransformList();
+    }
+    return m_configStore.sharedMappings(mappings);
 }
 
 QMapIterator<QString, WebhookEntity *> EntityHandler::entityIter() const {
@@ -102,122 +409,233 @@ void EntityHandler::initialize(EntitiesInterface *entities) {
     QMapIterator<QString, WebhookEntity *> iter = entityIter();
     while (iter.hasNext()) {
         iter.next();
-        const WebhookEntity *webhook = iter.value();
+        initializeEntity(entities, iter.value());
+    }
+}
 
-        EntityInterface *entity = entities->getEntityInterface(webhook->id);
-        updateEntity(entity, webhook->attributes);
+void EntityHandler::initializeEntity(EntitiesInterface *entities, const WebhookEntity *webhookEntity) {
+    EntityInterface *entity = entities->getEntityInterface(webhookEntity->id);
+    if (entity) {
+        applyEntityValues(entity, webhookEntity->attributes);
     }
 }
 
-bool EntityHandler::hasStatusCommand(const QString &entityId) const {
-    WebhookEntity *entity = m_webhookEntities.value(entityId);
-    if (!entity) {
-        return false;
+QSet<QString> EntityHandler::commandHosts(const QVariantMap &placeholders) const {
+    return commandHosts(m_webhookEntities.values(), placeholders);
+}
+
+QSet<QString> EntityHandler::commandHosts(const QList<WebhookEntity *> &entities,
+                                          const QVariantMap &placeholders) const {
+    QSet<QString>     hosts;
+    PlaceholderValues values(&placeholders);
+
+    for (const WebhookEntity *entity : entities) {
+        for (int i = 0; i < entity->commands.size(); i++) {
+            // don't materialize the commands just for their host name
+            const WebhookCommand *command = entity->commands.at(i);
+            TextTemplate          urlTemplate =
+                command ? command->urlTemplate : TextTemplate(featureUrl(entity->commands.configAt(i)));
+            QUrl                  url = buildUrl(urlTemplate, values);
+            // skip hosts depending on dynamic entity variables
+            if (url.isValid() && !url.host().isEmpty() && !url.host().contains('$')) {
+                hosts.insert(url.host());
+            }
+        }
     }
-    return entity->commands.contains(STATUS_COMMAND);
+
+    return hosts;
 }
 
-WebhookRequest *EntityHandler::createStatusRequest(const QString &entityId, const QVariantMap &placeholders) const {
-    return createRequest(STATUS_COMMAND, entityId, placeholders);
+WebhookRequest *EntityHandler::createStatusRequest(const WebhookEntity *entity, const QVariantMap &placeholders) const {
+    if (!entity || !entity->statusCommand) {
+        return nullptr;
+    }
+    return createRequest(entity->statusCommand, PlaceholderValues(&placeholders));
 }
 
-void EntityHandler::statusReply(EntityInterface *entity, const WebhookRequest *request, QNetworkReply *reply) {
+WebhookRequest *EntityHandler::createSubscribeRequest(const WebhookEntity *entity,
+                                                      const QVariantMap &placeholders) const {
+    if (!entity || !entity->subscribeCommand) {
+        return nullptr;
+    }
+    return createRequest(entity->subscribeCommand, PlaceholderValues(&placeholders));
+}
+
+int EntityHandler::handleSubscriptionEvent(EntityInterface *entity, const WebhookCommand *command,
+                                           const QJsonDocument &jsonDoc) {
+    if (!entity || !command) {
+        return 0;
+    }
+
+    if (!command->eventFilter.isEmpty()) {
+        JsonPath jsonPath(jsonDoc);
+
+        for (const auto &filter : command->eventFilter) {
+            if (jsonPath.value(filter.first).toString() != filter.second) {
+                return 0;
+            }
+        }
+    }
+
+    return updateFromDocument(entity, jsonDoc, command->responseMappings, command->responseTransforms);
+}
+
+void EntityHandler::commandReply(int command, EntityInterface *entity, const QVariant &param,
+                                 const WebhookRequest *request, QNetworkReply *reply) {
+    // reflect intended state in entity. This is also required in case of a failed request!
+    UndoRecord undo = applyCommandState(command, entity, param);
+    commandFinished(entity, request, reply, &undo);
+}
+
+void EntityHandler::commandFinished(EntityInterface *entity, const WebhookRequest *request, QNetworkReply *reply,
+                                    const UndoRecord *undo) {
     if (reply->error() == QNetworkReply::NoError) {
         handleResponseData(entity, request, reply);
+    } else if (undo) {
+        // revert entity / UI state in case request failed
+        // TODO(zehnm) enhance EntityInterface with refresh() option to simplify entity state -> UI reset.
+        restoreEntity(entity, *undo);
     }
 }
 
-int EntityHandler::convertBrightnessToPercentage(float value) const {
-    // TODO(zehnm) implement scaling option
-    return static_cast<int>(round(value / 255 * 100));
+void EntityHandler::commandSent(WebhookEntity *webhookEntity, WebhookRequest *request) {
+    request->undo = applyCommandState(request->command, webhookEntity->entityInterface, request->param);
+    request->optimistic = true;
+
+    webhookEntity->commandSequence = request->sequence;
+    webhookEntity->pendingCommands++;
 }
 
-QString EntityHandler::resolveVariables(const QString &text, const QVariantMap &placeholders) const {
-    if (placeholders.isEmpty()) {
-        return text;
+bool EntityHandler::optimisticCommandFinished(WebhookEntity *webhookEntity, const WebhookRequest *request,
+                                              QNetworkReply *reply) {
+    webhookEntity->pendingCommands--;
+    if (request->sequence != webhookEntity->commandSequence) {
+        return false;
     }
 
-    QString resolved = text;
+    commandFinished(webhookEntity->entityInterface, request, reply, &request->undo);
+    return true;
+}
 
-    // Simplified c printf regex supporting decimal and hex only. Good enough for now :-)
-    // For strict parsing and supporting floats:
-    // "\\$\\{(\\w+)(:(%(?:\\d+\\$)?[+-]?(?:[ 0]|'.{1})?-?\\d*(?:\\.\\d+)?[dfFxX]))?\\}"
-    // http://www.cplusplus.com/reference/cstdio/printf/
-    QRegularExpression              markerRegEx("\\$\\{(\\w+)(:(%\\w*[dxX]))?\\}");
-    QRegularExpressionMatchIterator i = markerRegEx.globalMatch(text);
-    while (i.hasNext()) {
-        QRegularExpressionMatch match = i.next();
-        QString                 varName = match.captured(1);
-        QString                 format = match.captured(3);
+void EntityHandler::restoreEntity(EntityInterface *entity, const UndoRecord &undo) {
+    if (undo.state >= 0) {
+        entity->setState(undo.state);
+    }
+    for (const auto &attribute : undo.attributes) {
+        entity->updateAttrByIndex(attribute.first, attribute.second);
+    }
+}
 
-        if (placeholders.contains(varName)) {
-            if (format.isEmpty()) {
-                resolved.replace(match.captured(0), placeholders.value(varName).toString());
-            } else {
-                bool ok;
-                int  number = placeholders.value(varName).toInt(&ok);
-                if (!ok) {
-                    qCWarning(logCategory())
-                        << "Variable format only supports numbers! Value:" << placeholders.value(varName)
-                        << ", placeholder:" << match.captured(0);
-                } else {
-                    QString formattedValue = QString::asprintf(qPrintable(format), number);
-                    resolved.replace(match.captured(0), formattedValue);
-                }
-            }
+void EntityHandler::statusReply(EntityInterface *entity, const WebhookRequest *request, QNetworkReply *reply) {
+    if (reply->error() == QNetworkReply::NoError) {
+        handleResponseData(entity, request, reply);
+    }
+}
+
+int EntityHandler::updateFromDocument(EntityInterface *entity, const WebhookEntity *webhookEntity,
+                                      const QJsonDocument &jsonDoc) {
+    if (!entity || !webhookEntity) {
+        return 0;
+    }
+
+    if (!webhookEntity->callbackMappings.isEmpty()) {
+        return updateFromDocument(entity, jsonDoc, webhookEntity->callbackMappings, webhookEntity->callbackTransforms);
+    }
+    if (webhookEntity->statusCommand) {
+        return updateFromDocument(entity, jsonDoc, webhookEntity->statusCommand->responseMappings,
+                                  webhookEntity->statusCommand->responseTransforms);
+    }
+    return 0;
+}
+
+int EntityHandler::updateFromDocument(EntityInterface *entity, const QJsonDocument &jsonDoc,
+                                      const MappingList &mappings, const TransformList &transforms) {
+    QVariantMap values;
+    int         count = retrieveResponseValues(jsonDoc, mappings, transforms, &values);
+    if (count > 0) {
+        if (logCategory().isDebugEnabled()) {
+            qCDebug(logCategory()) << "Extracted pushed values:" << values;
         }
+        applyEntityValues(entity, values);
     }
 
-    return resolved;
+    return count;
+}
+
+QString EntityHandler::resolveVariables(const QString &text, const QVariantMap &placeholders) const {
+    if (placeholders.isEmpty()) {
+        return text;
+    }
+    return TextTemplate(text).render(PlaceholderValues(&placeholders));
+}
+
+QString EntityHandler::featureUrl(const QVariant &featureCfg) {
+    return featureCfg.type() == QVariant::String ? featureCfg.toString() : featureCfg.toMap().value("url").toString();
 }
 
 QUrl EntityHandler::buildUrl(const QVariant &commandUrl, const QVariantMap &placeholders) const {
-    QString baseUrl = resolveVariables(m_baseUrl, placeholders);
+    PlaceholderValues values(&placeholders);
     if (!commandUrl.isValid()) {
-        return baseUrl;
+        return m_baseUrlTemplate.render(values);
     }
+    return buildUrl(TextTemplate(commandUrl.toString()), values);
+}
 
-    QUrl url = resolveVariables(commandUrl.toString(), placeholders);
+QUrl EntityHandler::buildUrl(const TextTemplate &commandUrl, const PlaceholderValues &values) const {
+    QUrl url = commandUrl.render(values);
     if (url.isRelative()) {
-        return QUrl(baseUrl).resolved(url);
+        return QUrl(m_baseUrlTemplate.render(values)).resolved(url);
     }
     return url;
 }
 
-WebhookRequest *EntityHandler::createRequest(const QString &commandName, const QString &entityId,
-                                             const QVariantMap &placeholders) const {
-    if (!m_webhookEntities.contains(entityId)) {
-        qCWarning(logCategory()) << "Entity not found:" << entityId;
+WebhookRequest *EntityHandler::createRequest(const WebhookEntity *entity, int command,
+                                             const PlaceholderValues &values) const {
+    const WebhookCommand *webhookCommand = entityCommand(entity, command);
+    if (!webhookCommand) {
+        qCWarning(logCategory()) << "Command" << command << "not defined for entity:" << entity->id;
         return nullptr;
     }
+    return createRequest(webhookCommand, values);
+}
 
-    WebhookEntity *entity = m_webhookEntities.value(entityId);
-    if (!entity->commands.contains(commandName)) {
-        qCWarning(logCategory()) << "Command" << commandName << "not defined for entity:" << entityId;
-        return nullptr;
-    }
-    WebhookCommand *command = entity->commands.value(commandName);
+quint32 EntityHandler::placeholderMask(const WebhookEntity *entity, int command) const {
+    const WebhookCommand *webhookCommand = entityCommand(entity, command);
+    return webhookCommand ? webhookCommand->placeholderMask : 0;
+}
 
-    WebhookRequest *request = new WebhookRequest();
+WebhookRequest *EntityHandler::createRequest(const WebhookCommand *command, const PlaceholderValues &values) const {
+    WebhookRequest *request = m_requestPool ? m_requestPool->acquire() : new WebhookRequest();
     request->webhookCommand = command;
-    request->networkRequest.setUrl(buildUrl(command->url, placeholders));
+    request->networkRequest.setUrl(buildUrl(command->urlTemplate, values));
 
     if (command->body.isValid()) {
+        // a json body has already been serialized when compiling the template
+        request->body.append(command->bodyTemplate.render(values));
         if (command->body.type() == QVariant::Map) {
-            QJsonDocument jsonDoc = QJsonDocument::fromVariant(command->body);
-            request->body.append(resolveVariables(jsonDoc.toJson(QJsonDocument::Compact), placeholders));
             request->networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
         } else {
-            request->body.append(resolveVariables(command->body.toString(), placeholders));
             request->networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/text");
         }
+
+        if (command->hexBody) {
+            request->body = QByteArray::fromHex(request->body);
+            request->networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/octet-stream");
+        }
+
+        if (command->compressBody && request->body.size() >= COMPRESS_BODY_MIN_SIZE) {
+            QByteArray compressed = Compression::gzip(request->body);
+            if (!compressed.isEmpty()) {
+                qCDebug(logCategory()) << "Compressed request body from" << request->body.size() << "to"
+                                       << compressed.size() << "bytes";
+                request->body = compressed;
+                request->networkRequest.setRawHeader("Content-Encoding", "gzip");
+            }
+        }
     }
 
-    QMapIterator<QString, QVariant> iter(command->headers);
-    while (iter.hasNext()) {
-        iter.next();
-        QString headerValue = resolveVariables(command->headers.value(iter.key()).toString(), placeholders);
-        request->networkRequest.setRawHeader(iter.key().toUtf8(), headerValue.toUtf8());
+    for (const auto &header : command->headerTemplates) {
+        request->networkRequest.setRawHeader(header.first, header.second.render(values).toUtf8());
     }
 
     return request;
@@ -228,16 +646,27 @@ void EntityHandler::handleResponseData(EntityInterface *entity, const WebhookReq
         return;
     }
 
-    QVariantMap values;
-    if (retrieveResponseValues(reply, request->webhookCommand->responseMappings, &values) > 0) {
+    QVariantMap           values;
+    const WebhookCommand *command = request->webhookCommand;
+    if (retrieveResponseValues(request, reply, command->responseMappings, command->responseTransforms, &values) > 0) {
         if (logCategory().isDebugEnabled()) {
             qCDebug(logCategory()) << "Extracted response values:" << values;
         }
+        applyEntityValues(entity, values);
+    }
+}
+
+void EntityHandler::applyEntityValues(EntityInterface *entity, const QVariantMap &values) {
+    if (m_watchdog) {
+        StallTimer timer(m_watchdog, StallWatchdog::UPDATE_ENTITY, entity ? entity->entity_id() : QString());
+        updateEntity(entity, values);
+    } else {
         updateEntity(entity, values);
     }
 }
 
-int EntityHandler::retrieveResponseValues(QNetworkReply *reply, const QMap<QString, QString> &mappings,
+int EntityHandler::retrieveResponseValues(const WebhookRequest *request, QNetworkReply *reply,
+                                          const MappingList &mappings, const TransformList &transforms,
                                           QVariantMap *values) {
     // check optional Content-Length if body parsing can be skipped
     // https://www.w3.org/Protocols/rfc2616/rfc2616-sec14.html
@@ -248,11 +677,16 @@ int EntityHandler::retrieveResponseValues(QNetworkReply *reply, const QMap<QStri
 
     QString contentType = reply->header(QNetworkRequest::ContentTypeHeader).toString();
     if (contentType.startsWith("application/json")) {
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(reply->readAll());
-        if (jsonDoc.isNull() || jsonDoc.isEmpty()) {
-            return 0;
+        qint64 started = m_metrics ? Metrics::now() : 0;
+        // response body has already been read and decoded while receiving if compression has been negotiated
+        QJsonDocument jsonDoc = QJsonDocument::fromJson(request->response.isActive() ? request->response.data()
+                                                                                      : reply->readAll());
+        int count =
+            jsonDoc.isNull() || jsonDoc.isEmpty() ? 0 : retrieveResponseValues(jsonDoc, mappings, transforms, values);
+        if (m_metrics) {
+            m_metrics->parseTime().record((Metrics::now() - started) / 1000);
         }
-        return retrieveResponseValues(jsonDoc, mappings, values);
+        return count;
     }
 
     qCDebug(logCategory()) << "Response mapping not yet implemented for content type:" << contentType;
@@ -260,19 +694,20 @@ int EntityHandler::retrieveResponseValues(QNetworkReply *reply, const QMap<QStri
     return 0;
 }
 
-int EntityHandler::retrieveResponseValues(const QJsonDocument &jsonDoc, const QMap<QString, QString> &mappings,
-                                          QVariantMap *values) {
+int EntityHandler::retrieveResponseValues(const QJsonDocument &jsonDoc, const MappingList &mappings,
+                                          const TransformList &transforms, QVariantMap *values) {
     int      count = 0;
     JsonPath jsonPath(jsonDoc);
 
-    QMapIterator<QString, QString> iter(mappings);
-    while (iter.hasNext()) {
-        iter.next();
-
-        QVariant value = jsonPath.value(iter.value());
+    for (int i = 0; i < mappings.size(); i++) {
+        const auto &mapping = mappings.at(i);
+        // the transforms are applied on the Json value, only the result is converted
+        QVariant value = transforms.isEmpty() || transforms.at(i).isEmpty()
+                             ? jsonPath.value(mapping.second)
+                             : transforms.at(i).apply(jsonPath.jsonValue(mapping.second));
         if (value.isValid()) {
             count++;
-            values->insert(iter.key(), value);
+            values->insert(mapping.first, value);
         }
     }
 
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <QDataStream>
 #include <QJsonDocument>
 #include <QList>
 #include <QLoggingCategory>
@@ -30,10 +31,16 @@
 #include <QMetaEnum>
 #include <QNetworkReply>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QVariantList>
 #include <QVariantMap>
 
+#include "configstore.h"
+#include "metrics.h"
+#include "placeholders.h"
+#include "requestpool.h"
+#include "stallwatchdog.h"
 #include "webhookentity.h"
 #include "webhookrequest.h"
 #include "yio-interface/entities/entitiesinterface.h"
@@ -43,10 +50,60 @@ class EntityHandler : public QObject {
     Q_OBJECT
 
  public:
+    /**
+     * @brief Entities changed by reloadEntities().
+     */
+    struct ReloadResult {
+        ReloadResult() : unchanged(0), subscriptionsChanged(false) {}
+
+        QList<WebhookEntity*> added;
+        /**
+         * @brief Entities read again into their existing record. The runtime state of the entity is kept.
+         */
+        QList<WebhookEntity*> updated;
+        /**
+         * @brief Removed entities. The records stay valid for in-flight requests until the handler is destroyed.
+         */
+        QList<WebhookEntity*> removed;
+        int                   unchanged;
+        /**
+         * @brief true if a status subscription has been added, changed or removed.
+         */
+        bool subscriptionsChanged;
+    };
+
     explicit EntityHandler(const QString& entityType, const QString& baseUrl, QObject* parent = nullptr);
 
     QString entityType() { return m_entityType; }
 
+    /**
+     * @brief Sets the pool to acquire the created requests from.
+     * @details The caller must release the created requests to the pool instead of deleting them. Requests are
+     * allocated individually and must be deleted if no pool is set.
+     */
+    void setRequestPool(RequestPool* requestPool) { m_requestPool = requestPool; }
+
+    /**
+     * @brief Sets the optional metrics to record the response parsing time. Ownership is not transferred.
+     */
+    void setMetrics(Metrics* metrics) { m_metrics = metrics; }
+
+    /**
+     * @brief Sets the optional watchdog to measure the entity updates. Ownership is not transferred.
+     */
+    void setWatchdog(StallWatchdog* watchdog) { m_watchdog = watchdog; }
+
+    /**
+     * @brief Sets the static placeholders of the integration. They are rendered into the command templates when
+     * reading the entities and must be set before.
+     */
+    void setPlaceholders(const QVariantMap& placeholders);
+
+    /**
+     * @brief Sets the base url for relative command urls. Must be set before reading the entities.
+     */
+    void setBaseUrl(const QString& baseUrl);
+
     /**
      * @brief Reads all webhook entity definitions from the configuration structure.
      * All valid webhook entities can be retrieved afterwards with getEntities().
@@ -56,8 +113,50 @@ class EntityHandler : public QObject {
      */
     int readEntities(const QVariantList& entityCfgList, const QVariantMap& headers);
 
+    /**
+     * @brief Applies a changed configuration to the read entities without recreating them.
+     * @details Entities with an unchanged configuration are left alone. A changed entity is read again into its
+     * existing record, the unchanged commands of the entity are reused. Replaced commands are kept in the config store
+     * until the handler is destroyed, because in-flight requests may still reference them.
+     * @param previousCfgList Configuration structure the entities have been read from.
+     * @param entityCfgList New configuration structure.
+     * @param headers Global default http request headers applicable for all command requests.
+     * @param recompile Read all entities again, e.g. if the global headers or static placeholders have changed.
+     */
+    ReloadResult reloadEntities(const QVariantList& previousCfgList, const QVariantList& entityCfgList,
+                                const QVariantMap& headers, bool recompile);
+
+    /**
+     * @brief Writes the compiled entity definitions to the config cache.
+     * @details Commands which haven't been used yet are written with their configuration and stay lazily
+     * materialized when reading the cache.
+     */
+    void writeCache(QDataStream& out) const;
+
+    /**
+     * @brief Reads the entity and command definitions written with writeCache() instead of reading the
+     * configuration. The static placeholders must be set before.
+     * @return false if the cache data is invalid. No entities are loaded in this case.
+     */
+    bool readCache(QDataStream& in);
+
+    /**
+     * @brief Returns the storage of the created entity and command definitions.
+     */
+    const ConfigStore& configStore() const { return m_configStore; }
+
+    /**
+     * @brief Returns the command for the given entity specific command enum, or null if not defined by the entity.
+     * @details Entity commands are materialized from the configuration on first use.
+     */
+    const WebhookCommand* entityCommand(const WebhookEntity* entity, int command) const;
+
     QList<WebhookEntity*> getEntities() const { return m_webhookEntities.values(); }
 
+    bool hasEntity(const QString& entityId) const { return m_webhookEntities.contains(entityId); }
+
+    WebhookEntity* webhookEntity(const QString& entityId) const { return m_webhookEntities.value(entityId); }
+
     /**
      * @brief Returns a Java-style const iterator of the created webhook entities.
      */
@@ -71,16 +170,36 @@ class EntityHandler : public QObject {
     virtual void initialize(EntitiesInterface* entities);
 
     /**
-     * @brief Returns true if the given entity supports status requests.
+     * @brief Initializes a single entity, e.g. an entity added or changed with reloadEntities().
+     */
+    void initializeEntity(EntitiesInterface* entities, const WebhookEntity* webhookEntity);
+
+    /**
+     * @brief Returns the host names of all command urls which can be resolved with the given static placeholders.
+     */
+    QSet<QString> commandHosts(const QVariantMap& placeholders) const;
+    QSet<QString> commandHosts(const QList<WebhookEntity*>& entities, const QVariantMap& placeholders) const;
+
+    /**
+     * @brief Creates an internal status update request for the given entity.
+     * @return A newly created WebhookRequest object which must be released by the caller, or null if the entity does
+     * not support status requests.
+     */
+    WebhookRequest* createStatusRequest(const WebhookEntity* entity, const QVariantMap& placeholders) const;
+
+    /**
+     * @brief Creates the request of a status subscription for the given entity.
+     * @return A newly created WebhookRequest object which must be released by the caller, or null if the entity does
+     * not support status subscriptions.
      */
-    bool hasStatusCommand(const QString& entityId) const;
+    WebhookRequest* createSubscribeRequest(const WebhookEntity* entity, const QVariantMap& placeholders) const;
 
     /**
-     * @brief Creates an internal status update request for the given entity identifier.
-     * @return A newly created WebhookRequest object which must be deleted by the caller, or null if the entity does not
-     * support status requests.
+     * @brief Handles a received status subscription event.
+     * @details The event is ignored if it doesn't match the event filter of the subscription command.
+     * @return Number of extracted values.
      */
-    WebhookRequest* createStatusRequest(const QString& entityId, const QVariantMap& placeholders) const;
+    int handleSubscriptionEvent(EntityInterface* entity, const WebhookCommand* command, const QJsonDocument& jsonDoc);
 
     /**
      * @brief Handles the internal QNetworkReply from the given status request.
@@ -90,29 +209,89 @@ class EntityHandler : public QObject {
      */
     virtual void statusReply(EntityInterface* entity, const WebhookRequest* request, QNetworkReply* reply);
 
+    /**
+     * @brief Updates the entity with pushed data, e.g. from a device callback.
+     * @details The values are extracted with the callback mappings of the entity, or the status polling response
+     * mappings if not defined.
+     * @param entity The entity interface to update.
+     * @param webhookEntity The webhook entity definition.
+     * @param jsonDoc The pushed data.
+     * @return Number of extracted values.
+     */
+    int updateFromDocument(EntityInterface* entity, const WebhookEntity* webhookEntity, const QJsonDocument& jsonDoc);
+
     /**
      * @brief Creates a webhook request for the given entity command.
-     * @param entityId Entity identifier.
+     * @param webhookEntity The webhook entity definition.
      * @param entity The entity interface for retrieving and setting command specific information.
      * @param command Entity specific command sent from the app. See BlindDef, LightDef, SwitchDef, etc. enums
      * @param placeholders Webhook specific variable placeholders.
      * @param param Command specific parameter, provided from the app.
-     * @return A newly created WebhookRequest object which must be deleted by the caller, or null if the request could
+     * @return A newly created WebhookRequest object which must be released by the caller, or null if the request could
      * not be created.
      */
-    virtual WebhookRequest* createCommandRequest(const QString& entityId, EntityInterface* entity, int command,
-                                                 const QVariantMap& placeholders, const QVariant& param) const = 0;
+    virtual WebhookRequest* createCommandRequest(const WebhookEntity* webhookEntity, EntityInterface* entity,
+                                                 int command, const QVariantMap& placeholders,
+                                                 const QVariant& param) const = 0;
+
+    /**
+     * @brief Returns the entity specific command for the given command feature name, e.g. "ON", or -1 if the feature
+     * is not supported by the entity type.
+     */
+    virtual int featureToCommand(const QString& feature) const = 0;
+
+    /**
+     * @brief Applies the intended state of a command to the entity, e.g. the new brightness of a light.
+     * @param command Entity specific command sent from the app. See BlindDef, LightDef, SwitchDef, etc. enums
+     * @param entity The entity interface to update.
+     * @param param Command specific parameter, provided from the app.
+     * @return Undo record with the previous values of all changed entity values.
+     */
+    virtual UndoRecord applyCommandState(int command, EntityInterface* entity, const QVariant& param) = 0;
 
     /**
      * @brief Handles the QNetworkReply from the given webhook request.
+     * @details Applies the intended command state and reconciles it with the reply, see commandFinished().
      * @param command Original entity specific command sent from the app. See BlindDef, LightDef, SwitchDef, etc. enums
      * @param entity The entity interface for retrieving and setting command specific information.
      * @param param Original command specific parameter, provided from the app.
      * @param request The corresponding wehook command request.
      * @param reply The received reply from the webhook command request.
      */
-    virtual void commandReply(int command, EntityInterface* entity, const QVariant& param,
-                              const WebhookRequest* request, QNetworkReply* reply) = 0;
+    void commandReply(int command, EntityInterface* entity, const QVariant& param, const WebhookRequest* request,
+                      QNetworkReply* reply);
+
+    /**
+     * @brief Handles the QNetworkReply of a command whose intended state has already been applied.
+     * @details The entity is updated with the response data of a successful request, otherwise the undo record is
+     * restored.
+     * @param undo Previous entity values, or null to keep the intended state of a failed request.
+     */
+    void commandFinished(EntityInterface* entity, const WebhookRequest* request, QNetworkReply* reply,
+                         const UndoRecord* undo);
+
+    /**
+     * @brief Optimistically applies the intended state of a sent command to the entity.
+     * @details The previous entity values are kept in the undo record of the request. The command becomes the latest
+     * command of the entity.
+     */
+    void commandSent(WebhookEntity* webhookEntity, WebhookRequest* request);
+
+    /**
+     * @brief Handles the QNetworkReply of a command sent with commandSent().
+     * @details Only the reply of the latest command reconciles the entity, see commandFinished(): a newer command has
+     * already applied its intended state and will reconcile the entity.
+     * @return false if the reply has been ignored because the command has been superseded.
+     */
+    bool optimisticCommandFinished(WebhookEntity* webhookEntity, const WebhookRequest* request, QNetworkReply* reply);
+
+    /**
+     * @brief Returns true if the status reply of the given request may update the entity.
+     * @details An outdated status must not overwrite the intended state of pending or newer commands.
+     */
+    static bool acceptsStatus(const WebhookEntity* webhookEntity, const WebhookRequest* request) {
+        return webhookEntity->pendingCommands == 0 && request->sequence >= webhookEntity->commandSequence;
+    }
 
  protected:
     virtual const QLoggingCategory& logCategory() const = 0;
@@ -127,22 +306,90 @@ class EntityHandler : public QObject {
         return true;
     }
 
+    /**
+     * @brief Reads the definition of a single entity into the given record.
+     * @param previousCommands Command table of the previous definition of the entity: commands with an unchanged
+     * configuration are reused. Null to read all commands.
+     * @param previousCommandsCfg Command configuration of the previous definition.
+     * @return false if the entity has been filtered out by onWebhookEntityRead().
+     */
+    bool readEntity(const QVariantMap& entityCfgMap, WebhookEntity* entity,
+                    const CommandTable* previousCommands = nullptr,
+                    const QVariantMap&  previousCommandsCfg = QVariantMap());
+
+    /**
+     * @brief Converts a mapping configuration object to a shared mapping list.
+     * @details A mapping is either a JsonPath string, or an object with the JsonPath and a value transform chain.
+     * @param transforms Set to the compiled transforms of the mappings, empty if no mapping has a transform. Null to
+     * ignore the transforms.
+     */
+    MappingList readMappings(const QVariantMap& mappingsCfg, TransformList* transforms = nullptr) const;
+
+    /**
+     * @brief Creates the command definition from the command configuration.
+     */
+    WebhookCommand* readCommand(const QString& feature, const QVariant& featureCfg) const;
+
+    /**
+     * @brief Reads a compiled command written by writeCache().
+     */
+    WebhookCommand* readCachedCommand(QDataStream& in);
+
+    /**
+     * @brief Returns the command at the given command table index of the entity. Materializes the command if needed.
+     */
+    const WebhookCommand* commandAt(const WebhookEntity* entity, int index) const;
+
+    /**
+     * @brief Compiles the url, body and header templates of a command read from the configuration.
+     */
+    void compileTemplates(WebhookCommand* command) const;
+
+    /**
+     * @brief Returns the url of a command configuration without materializing the command.
+     */
+    static QString featureUrl(const QVariant& featureCfg);
+
     QUrl    buildUrl(const QVariant& commandUrl, const QVariantMap& placeholders) const;
-    int     convertBrightnessToPercentage(float value) const;
+    QUrl    buildUrl(const TextTemplate& commandUrl, const PlaceholderValues& values) const;
     QString resolveVariables(const QString& text, const QVariantMap& placeholders) const;
 
-    WebhookRequest* createRequest(const QString& commandName, const QString& entityId,
-                                  const QVariantMap& placeholders) const;
+    /**
+     * @brief Creates the request of the given entity specific command enum with the command lookup table.
+     * @param values Dynamic placeholder values of the command, layered over the static placeholders.
+     */
+    WebhookRequest* createRequest(const WebhookEntity* entity, int command, const PlaceholderValues& values) const;
+
+    /**
+     * @brief Returns the mask of the dynamic placeholders referenced by the given entity command, 0 if the command is
+     * not defined. Only these placeholder values need to be calculated for the request.
+     */
+    quint32 placeholderMask(const WebhookEntity* entity, int command) const;
+    WebhookRequest* createRequest(const WebhookCommand* command, const PlaceholderValues& values) const;
+
+    int updateFromDocument(EntityInterface* entity, const QJsonDocument& jsonDoc, const MappingList& mappings,
+                           const TransformList& transforms);
 
     virtual void handleResponseData(EntityInterface* entity, const WebhookRequest* request, QNetworkReply* reply);
 
-    int retrieveResponseValues(QNetworkReply* reply, const QMap<QString, QString>& mappings, QVariantMap* values);
+    /**
+     * @brief Restores the previous entity values of a failed command.
+     */
+    virtual void restoreEntity(EntityInterface* entity, const UndoRecord& undo);
+
+    int retrieveResponseValues(const WebhookRequest* request, QNetworkReply* reply, const MappingList& mappings,
+                               const TransformList& transforms, QVariantMap* values);
 
-    int retrieveResponseValues(const QJsonDocument& jsonDoc, const QMap<QString, QString>& mappings,
-                               QVariantMap* values);
+    int retrieveResponseValues(const QJsonDocument& jsonDoc, const MappingList& mappings,
+                               const TransformList& transforms, QVariantMap* values);
 
     virtual void updateEntity(EntityInterface* entity, const QVariantMap& placeholders) = 0;
 
+    /**
+     * @brief Calls updateEntity and reports its duration to the watchdog if set.
+     */
+    void applyEntityValues(EntityInterface* entity, const QVariantMap& values);
+
     template <class EnumClass>
     EnumClass stringToEnum(const QString& enumString, const EnumClass& defaultValue) const {
         const auto metaEnum = QMetaEnum::fromType<EnumClass>();
@@ -157,8 +404,29 @@ class EntityHandler : public QObject {
      */
     static const QString STATUS_COMMAND;
 
-    QString m_entityType;
-    QString m_baseUrl;
+    /**
+     * @brief Internal status subscription command identifier
+     */
+    static const QString SUBSCRIBE_COMMAND;
 
+    /**
+     * @brief Minimal request body size in bytes for gzip compression if enabled with `compress_body`.
+     */
+    static const int COMPRESS_BODY_MIN_SIZE;
+
+    QString        m_entityType;
+    QString        m_baseUrl;
+    TextTemplate   m_baseUrlTemplate;
+    RequestPool*   m_requestPool;
+    Metrics*       m_metrics;
+    StallWatchdog* m_watchdog;
+
+    /**
+     * @brief Owns all entity and command records. Cleared when the handler is destroyed.
+     * @details Mutable because entity commands are materialized lazily in const request creation.
+     */
+    mutable ConfigStore           m_configStore;
+    QVariantMap                   m_globalHeaders;
+    QVariantMap                   m_placeholders;
     QMap<QString, WebhookEntity*> m_webhookEntities;
 };
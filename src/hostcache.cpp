@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "hostcache.h"
+
+#include <QAbstractSocket>
+#include <QLoggingCategory>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.dns");
+
+HostCache::HostCache(int ttl, QObject *parent)
+    : QObject(parent),
+      m_ttl(qMax(ttl, 10)),
+      m_hits(0),
+      m_misses(0),
+      m_lookups(0),
+      m_failures(0),
+      m_lookupTimeTotal(0),
+      m_lookupTimeMax(0) {
+    m_clock.start();
+
+    // check 10 times per TTL period to refresh entries in the last 20% of their lifetime
+    m_refreshTimer.setInterval(m_ttl * 100);
+    QObject::connect(&m_refreshTimer, &QTimer::timeout, this, &HostCache::onRefreshTimer);
+    m_refreshTimer.start();
+}
+
+void HostCache::addHost(const QString &host) {
+    if (host.isEmpty() || m_entries.contains(host) || !QHostAddress(host).isNull()) {
+        return;
+    }
+
+    m_entries.insert(host, Entry());
+    startLookup(host);
+}
+
+QHostAddress HostCache::lookup(const QString &host) {
+    auto iter = m_entries.find(host);
+    if (iter == m_entries.end()) {
+        if (!QHostAddress(host).isNull()) {
+            // nothing to resolve
+            return QHostAddress();
+        }
+        m_misses++;
+        addHost(host);
+        return QHostAddress();
+    }
+
+    if (iter->address.isNull()) {
+        m_misses++;
+        return QHostAddress();
+    }
+
+    // serve stale entries while refreshing, e.g. when waking up from standby
+    if (!iter->pending && m_clock.elapsed() >= iter->expires) {
+        startLookup(host);
+    }
+
+    m_hits++;
+    return iter->address;
+}
+
+void HostCache::invalidate(const QString &host) {
+    auto iter = m_entries.find(host);
+    if (iter == m_entries.end() || iter->address.isNull()) {
+        return;
+    }
+
+    qCDebug(CLASS_LC) << "Invalidating cached address of" << host << ":" << iter->address.toString();
+    iter->address.clear();
+    if (!iter->pending) {
+        startLookup(host);
+    }
+}
+
+void HostCache::setRefreshEnabled(bool enabled) {
+    if (enabled) {
+        m_refreshTimer.start();
+        onRefreshTimer();
+    } else {
+        m_refreshTimer.stop();
+    }
+}
+
+QVariantMap HostCache::stats() const {
+    QVariantMap stats;
+    quint64     requests = m_hits + m_misses;
+
+    stats.insert("hosts", m_entries.size());
+    stats.insert("hits", m_hits);
+    stats.insert("misses", m_misses);
+    stats.insert("hit_rate", requests > 0 ? static_cast<double>(m_hits) / requests : 0.0);
+    stats.insert("lookups", m_lookups);
+    stats.insert("failures", m_failures);
+    stats.insert("lookup_avg_ms", m_lookups > 0 ? static_cast<double>(m_lookupTimeTotal) / m_lookups : 0.0);
+    stats.insert("lookup_max_ms", m_lookupTimeMax);
+    return stats;
+}
+
+void HostCache::onRefreshTimer() {
+    qint64 refreshTime = m_clock.elapsed() + m_ttl * 200;
+
+    for (auto iter = m_entries.begin(); iter != m_entries.end(); ++iter) {
+        if (!iter->pending && iter->expires <= refreshTime) {
+            startLookup(iter.key());
+        }
+    }
+}
+
+void HostCache::startLookup(const QString &host) {
+    Entry &entry = m_entries[host];
+    entry.pending = true;
+    entry.lookupStart = m_clock.elapsed();
+    m_lookups++;
+
+    QHostInfo::lookupHost(host, this, [this, host](const QHostInfo &info) { onLookupFinished(host, info); });
+}
+
+void HostCache::onLookupFinished(const QString &host, const QHostInfo &info) {
+    auto iter = m_entries.find(host);
+    if (iter == m_entries.end()) {
+        return;
+    }
+
+    qint64 duration = m_clock.elapsed() - iter->lookupStart;
+    m_lookupTimeTotal += duration;
+    m_lookupTimeMax = qMax(m_lookupTimeMax, duration);
+    iter->pending = false;
+
+    if (info.error() != QHostInfo::NoError || info.addresses().isEmpty()) {
+        m_failures++;
+        qCWarning(CLASS_LC) << "Resolving" << host << "failed:" << info.errorString();
+        // keep a previous address and retry with the next refresh
+        iter->expires = m_clock.elapsed();
+        return;
+    }
+
+    // prefer IPv4 addresses, most devices on the LAN are not reachable with IPv6
+    QHostAddress address = info.addresses().first();
+    for (const QHostAddress &candidate : info.addresses()) {
+        if (candidate.protocol() == QAbstractSocket::IPv4Protocol) {
+            address = candidate;
+            break;
+        }
+    }
+
+    qCDebug(CLASS_LC) << "Resolved" << host << "to" << address.toString() << "in" << duration << "ms";
+
+    iter->address = address;
+    iter->expires = m_clock.elapsed() + m_ttl * 1000;
+
+    emit hostResolved(host, address);
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QVariantMap>
+
+/**
+ * @brief Host name resolution cache with background refresh.
+ * @details Resolving mDNS .local names may take hundreds of milliseconds. Registered hosts are resolved in advance and
+ * refreshed in the background before their time to live expires. An expired address is still returned while it is
+ * being refreshed, only an invalidated entry results in a cache miss.
+ */
+class HostCache : public QObject {
+    Q_OBJECT
+
+ public:
+    /**
+     * @param ttl Time to live in seconds of a resolved address.
+     */
+    explicit HostCache(int ttl, QObject* parent = nullptr);
+
+    /**
+     * @brief Registers the given host name and starts resolving it, if not already cached. IP addresses are ignored.
+     */
+    void addHost(const QString& host);
+
+    /**
+     * @brief Returns the cached address of the given host name, or a null address if it is not available.
+     * @details An unknown host name is registered for background resolution.
+     */
+    QHostAddress lookup(const QString& host);
+
+    /**
+     * @brief Removes the cached address of the given host, e.g. after a connection failure, and resolves it again.
+     */
+    void invalidate(const QString& host);
+
+    /**
+     * @brief Enables or disables the background refresh. Expired entries are refreshed when enabled again.
+     */
+    void setRefreshEnabled(bool enabled);
+
+    /**
+     * @brief Returns the resolution statistics: hits, misses, hit rate, lookups, failures and lookup latencies.
+     */
+    QVariantMap stats() const;
+
+ signals:
+    void hostResolved(const QString& host, const QHostAddress& address);
+
+ private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
+    void onRefreshTimer();
+
+ private:
+    struct Entry {
+        Entry() : expires(0), lookupStart(0), pending(false) {}
+        QHostAddress address;
+        qint64       expires;
+        qint64       lookupStart;
+        bool         pending;
+    };
+
+    void startLookup(const QString& host);
+    void onLookupFinished(const QString& host, const QHostInfo& info);
+
+    QHash<QString, Entry> m_entries;
+    QTimer                m_refreshTimer;
+    QElapsedTimer         m_clock;
+    int                   m_ttl;
+
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_lookups;
+    quint64 m_failures;
+    qint64  m_lookupTimeTotal;
+    qint64  m_lookupTimeMax;
+};
@@ -35,13 +35,17 @@ JsonPath::JsonPath(const QJsonDocument &jsonDoc, QObject *parent) : QObject(pare
 }
 
 QVariant JsonPath::value(const QString &path, QVariant defaultValue) const {
+    QJsonValue node = jsonValue(path);
+    return node.isUndefined() ? defaultValue : node.toVariant();
+}
+
+QJsonValue JsonPath::jsonValue(const QString &path) const {
     if (m_root.isUndefined() || m_root.isNull()) {
-        return defaultValue;
+        return QJsonValue::Undefined;
     }
 
     QStringList segments = path.split('.', QString::SkipEmptyParts);
     QJsonValue  currNode = m_root;
-    bool        error = false;
 
     QRegularExpression arrayRegEx("(\\w*)\\[(\\d+)\\]$");
 
@@ -52,31 +56,31 @@ QVariant JsonPath::value(const QString &path, QVariant defaultValue) const {
             if (!objectName.isEmpty()) {
                 currNode = nextObjectSegment(currNode, objectName);
                 if (currNode == QJsonValue::Undefined) {
-                    return defaultValue;
+                    return QJsonValue::Undefined;
                 }
             }
 
             bool ok = false;
             int  index = match.captured(2).toInt(&ok);
             if (!ok || !currNode.isArray()) {
-                return defaultValue;
+                return QJsonValue::Undefined;
             }
 
             QJsonArray arrayNode = currNode.toArray();
             if (index < arrayNode.size()) {
                 currNode = arrayNode.at(index);
             } else {
-                return defaultValue;
+                return QJsonValue::Undefined;
             }
         } else {
             currNode = nextObjectSegment(currNode, segment);
             if (currNode == QJsonValue::Undefined) {
-                return defaultValue;
+                return QJsonValue::Undefined;
             }
         }
     }
 
-    return (!error ? currNode.toVariant() : defaultValue);
+    return currNode;
 }
 
 QJsonValue JsonPath::nextObjectSegment(const QJsonValue &currNode, const QString &key) const {
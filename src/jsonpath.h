@@ -37,6 +37,11 @@ class JsonPath : public QObject {
 
     QVariant value(const QString &path, QVariant defaultValue = QVariant()) const;
 
+    /**
+     * @brief Returns the Json value of the path without converting it, or QJsonValue::Undefined if not found.
+     */
+    QJsonValue jsonValue(const QString &path) const;
+
  private:
     QJsonValue nextObjectSegment(const QJsonValue &currNode, const QString &key) const;
 
@@ -22,17 +22,20 @@
 
 #include "lighthandler.h"
 
+#include <QHash>
+
 #include "yio-interface/entities/lightinterface.h"
 
 static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.light");
 
 LightHandler::LightHandler(const QString &baseUrl, QObject *parent) : EntityHandler("light", baseUrl, parent) {}
 
-WebhookRequest *LightHandler::createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
-                                                   const QVariantMap &placeholders, const QVariant &param) const {
-    QString         feature;
-    QVariantMap     parameters(placeholders);
-    LightInterface *lightInterface = static_cast<LightInterface *>(entity->getSpecificInterface());
+WebhookRequest *LightHandler::createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity,
+                                                   int command, const QVariantMap &placeholders,
+                                                   const QVariant &param) const {
+    const char       *feature;
+    PlaceholderValues values(&placeholders, placeholderMask(webhookEntity, command));
+    LightInterface   *lightInterface = static_cast<LightInterface *>(entity->getSpecificInterface());
 
     // get current entity values for request parameters
     int    state = entity->state();
@@ -73,71 +76,89 @@ WebhookRequest *LightHandler::createCommandRequest(const QString &entityId, Enti
 
     qCDebug(CLASS_LC()) << entity->friendly_name() << "command:" << feature << ", parameter:" << param;
 
-    setPlaceholderValues(&parameters, state, color, brightness, colorTemp);
+    setPlaceholderValues(&values, state, color, brightness, colorTemp);
+
+    return createRequest(webhookEntity, command, values);
+}
 
-    return createRequest(feature, entityId, parameters);
+int LightHandler::featureToCommand(const QString &feature) const {
+    static const QHash<QString, int> commands{
+        {"ON", LightDef::C_ON},
+        {"OFF", LightDef::C_OFF},
+        {"TOGGLE", LightDef::C_TOGGLE},
+        {"BRIGHTNESS", LightDef::C_BRIGHTNESS},
+        {"COLOR", LightDef::C_COLOR},
+        {"COLORTEMP", LightDef::C_COLORTEMP},
+    };
+    return commands.value(feature, -1);
 }
 
-void LightHandler::commandReply(int command, EntityInterface *entity, const QVariant &param,
-                                const WebhookRequest *request, QNetworkReply *reply) {
+UndoRecord LightHandler::applyCommandState(int command, EntityInterface *entity, const QVariant &param) {
     LightInterface *lightInterface = static_cast<LightInterface *>(entity->getSpecificInterface());
 
-    // reflect intended state in entity. This is also required in case of a failed request!
-    int      state = LightDef::OFF;
+    int      state = LightDef::ON;
     int      brightness = -1;
     int      colorTemp = -1;
     QVariant color;
-    int      oldState = entity->state();
-    int      oldBrightness = lightInterface->brightness();
-    int      oldColorTemp = lightInterface->colorTemp();
-    QVariant oldColor = lightInterface->color();
 
     switch (command) {
         case LightDef::C_ON:
-            state = LightDef::ON;
             break;
         case LightDef::C_OFF:
             state = LightDef::OFF;
             break;
+        case LightDef::C_TOGGLE:
+            state = entity->state() == LightDef::ON ? LightDef::OFF : LightDef::ON;
+            break;
         case LightDef::C_BRIGHTNESS:
-            state = LightDef::ON;
             brightness = param.toInt();
             break;
         case LightDef::C_COLOR:
-            state = LightDef::ON;
             color = param;
             break;
         case LightDef::C_COLORTEMP:
-            state = LightDef::ON;
+            colorTemp = param.toInt();
             break;
+        default:
+            return UndoRecord();
     }
 
-    updateEntity(entity, state, color, brightness, colorTemp);
-
-    if (reply->error() == QNetworkReply::NoError) {
-        handleResponseData(entity, request, reply);
-    } else {
-        // revert entity / UI state in case request failed
-        // TODO(zehnm) enhance EntityInterface with refresh() option to simplify entity state -> UI reset.
-        updateEntity(entity, oldState, oldColor, oldBrightness, oldColorTemp);
+    UndoRecord undo;
+    undo.state = entity->state();
+    if (brightness >= 0 && entity->isSupported(LightDef::F_BRIGHTNESS)) {
+        undo.saveAttribute(LightDef::BRIGHTNESS, lightInterface->brightness());
+    }
+    if (color.isValid() && entity->isSupported(LightDef::F_COLOR)) {
+        undo.saveAttribute(LightDef::COLOR, lightInterface->color());
     }
+    if (colorTemp >= 0 && entity->isSupported(LightDef::F_COLORTEMP)) {
+        undo.saveAttribute(LightDef::COLORTEMP, lightInterface->colorTemp());
+    }
+
+    updateEntity(entity, state, color, brightness, colorTemp);
+    return undo;
 }
 
 const QLoggingCategory &LightHandler::logCategory() const { return CLASS_LC(); }
 
-void LightHandler::setPlaceholderValues(QVariantMap *placeholders, int state, const QColor &color, int brightness,
+void LightHandler::setPlaceholderValues(PlaceholderValues *values, int state, const QColor &color, int brightness,
                                         int colorTemp) const {
-    // TODO(zehnm) define placeholder constants
-    placeholders->insert("state_bool", state == LightDef::ON);
-    placeholders->insert("state_bin", state);
-    placeholders->insert("brightness_percent", brightness);
-    placeholders->insert("color_temp", colorTemp);
-    placeholders->insert("color_r", color.red());
-    placeholders->insert("color_g", color.green());
-    placeholders->insert("color_b", color.blue());
-    placeholders->insert("color_h", color.hue());
-    placeholders->insert("color_s", color.saturation());
-    placeholders->insert("color_v", color.value());
+    values->set(Placeholder::STATE_BOOL, state == LightDef::ON);
+    values->set(Placeholder::STATE_BIN, state);
+    values->set(Placeholder::BRIGHTNESS_PERCENT, brightness);
+    values->set(Placeholder::COLOR_TEMP, colorTemp);
+    values->set(Placeholder::COLOR_R, color.red());
+    values->set(Placeholder::COLOR_G, color.green());
+    values->set(Placeholder::COLOR_B, color.blue());
+
+    // skip the HSV conversion if not used, e.g. for every event of a color wheel drag with a RGB command
+    if (values->isUsed(Placeholder::COLOR_H) || values->isUsed(Placeholder::COLOR_S) ||
+        values->isUsed(Placeholder::COLOR_V)) {
+        QColor hsv = color.toHsv();
+        values->set(Placeholder::COLOR_H, hsv.hue());
+        values->set(Placeholder::COLOR_S, hsv.saturation());
+        values->set(Placeholder::COLOR_V, hsv.value());
+    }
 }
 
 void LightHandler::updateEntity(EntityInterface *entity, const QVariantMap &placeholders) {
@@ -170,6 +191,9 @@ void LightHandler::updateEntity(EntityInterface *entity, const QVariantMap &plac
     } else if (placeholders.contains("color_h")) {
         color.setHsv(placeholders.value("color_h").toInt(), placeholders.value("color_s").toInt(),
                      placeholders.value("color_v").toInt());
+    } else if (placeholders.contains("color")) {
+        // color string, e.g. normalized to #rrggbb with the color transform of the response mapping
+        color.setNamedColor(placeholders.value("color").toString());
     }
 
     updateEntity(entity, state, color, brightness, colorTemp);
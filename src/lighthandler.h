@@ -34,11 +34,12 @@ class LightHandler : public EntityHandler {
 
     // EntityHandler interface
  public:
-    WebhookRequest *createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
+    WebhookRequest *createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity, int command,
                                          const QVariantMap &placeholders, const QVariant &param) const override;
 
-    void commandReply(int command, EntityInterface *entity, const QVariant &param, const WebhookRequest *request,
-                      QNetworkReply *reply) override;
+    int featureToCommand(const QString &feature) const override;
+
+    UndoRecord applyCommandState(int command, EntityInterface *entity, const QVariant &param) override;
 
  protected:
     const QLoggingCategory &logCategory() const override;
@@ -46,7 +47,7 @@ class LightHandler : public EntityHandler {
     void updateEntity(EntityInterface *entity, const QVariantMap &placeholders) override;
 
  private:
-    void setPlaceholderValues(QVariantMap *placeholders, int state, const QColor &color, int brightness,
+    void setPlaceholderValues(PlaceholderValues *values, int state, const QColor &color, int brightness,
                               int colorTemp) const;
 
     void updateEntity(EntityInterface *entity, int state, const QVariant &color, int brightness, int colorTemp);
@@ -0,0 +1,311 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "metrics.h"
+
+#include <QStringList>
+
+// 100 us .. 10 s in 1, 2.5, 5 steps
+const qint64 LatencyHistogram::BOUNDS[BUCKETS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+
+HistogramSnapshot::HistogramSnapshot() : buckets(LatencyHistogram::BUCKETS, 0), count(0), sum(0) {}
+
+void HistogramSnapshot::add(const HistogramSnapshot &other) {
+    for (int i = 0; i < buckets.size(); i++) {
+        buckets[i] += other.buckets.at(i);
+    }
+    count += other.count;
+    sum += other.sum;
+}
+
+double HistogramSnapshot::percentile(double p) const {
+    if (count == 0) {
+        return 0.0;
+    }
+
+    quint64 rank = static_cast<quint64>(p / 100.0 * count + 0.5);
+    quint64 cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKETS - 1; i++) {
+        cumulative += buckets.at(i);
+        if (cumulative >= rank) {
+            return LatencyHistogram::BOUNDS[i] / 1000.0;
+        }
+    }
+    // beyond the last bound
+    return LatencyHistogram::BOUNDS[LatencyHistogram::BUCKETS - 2] / 1000.0;
+}
+
+QVariantMap HistogramSnapshot::toVariant() const {
+    QVariantMap map;
+    map.insert("count", count);
+    map.insert("avg_ms", count > 0 ? static_cast<double>(sum) / count / 1000.0 : 0.0);
+    map.insert("p50_ms", percentile(50));
+    map.insert("p95_ms", percentile(95));
+    map.insert("p99_ms", percentile(99));
+    return map;
+}
+
+LatencyHistogram::LatencyHistogram() {}
+
+void LatencyHistogram::record(qint64 us) {
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && us > BOUNDS[bucket]) {
+        bucket++;
+    }
+    m_buckets[bucket].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_sum.fetchAndAddRelaxed(static_cast<quint64>(qMax(us, qint64(0))));
+}
+
+HistogramSnapshot LatencyHistogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    for (int i = 0; i < BUCKETS; i++) {
+        snapshot.buckets[i] = m_buckets[i].load();
+    }
+    snapshot.count = m_count.load();
+    snapshot.sum = m_sum.load();
+    return snapshot;
+}
+
+void RequestSnapshot::add(const RequestSnapshot &other) {
+    sent += other.sent;
+    inFlight += other.inFlight;
+    completed += other.completed;
+    failed += other.failed;
+    timedOut += other.timedOut;
+    bytesOut += other.bytesOut;
+    bytesIn += other.bytesIn;
+    firstByte.add(other.firstByte);
+    total.add(other.total);
+}
+
+QVariantMap RequestSnapshot::toVariant() const {
+    QVariantMap map;
+    map.insert("sent", sent);
+    map.insert("in_flight", inFlight);
+    map.insert("completed", completed);
+    map.insert("failed", failed);
+    map.insert("timed_out", timedOut);
+    map.insert("error_rate", sent > 0 ? static_cast<double>(failed + timedOut) / sent : 0.0);
+    map.insert("bytes_out", bytesOut);
+    map.insert("bytes_in", bytesIn);
+    map.insert("first_byte", firstByte.toVariant());
+    map.insert("total", total.toVariant());
+    return map;
+}
+
+RequestSnapshot RequestMetrics::snapshot() const {
+    RequestSnapshot snapshot;
+    snapshot.sent = sent.load();
+    snapshot.inFlight = inFlight.load();
+    snapshot.completed = completed.load();
+    snapshot.failed = failed.load();
+    snapshot.timedOut = timedOut.load();
+    snapshot.bytesOut = bytesOut.load();
+    snapshot.bytesIn = bytesIn.load();
+    snapshot.firstByte = firstByte.snapshot();
+    snapshot.total = total.snapshot();
+    return snapshot;
+}
+
+Metrics::Metrics() : m_entitySeries(true) {}
+
+Metrics::~Metrics() {
+    qDeleteAll(m_hosts);
+    qDeleteAll(m_entities);
+}
+
+RequestMetrics *Metrics::series(const QString &host, RequestType type) { return series(&m_hosts, host, type); }
+
+RequestMetrics *Metrics::entitySeries(const QString &entityId, RequestType type) {
+    return m_entitySeries ? series(&m_entities, entityId, type) : nullptr;
+}
+
+RequestMetrics *Metrics::series(SeriesMap *seriesMap, const QString &key, RequestType type) {
+    auto iter = seriesMap->find(key);
+    if (iter == seriesMap->end()) {
+        iter = seriesMap->insert(key, new TypeSeries());
+    }
+    return &iter.value()->types[type];
+}
+
+QString Metrics::typeName(RequestType type) {
+    switch (type) {
+        case COMMAND:
+            return QStringLiteral("command");
+        case STATUS:
+            return QStringLiteral("status");
+        default:
+            return QString();
+    }
+}
+
+QVariantMap Metrics::seriesVariant(const SeriesMap &seriesMap, RequestSnapshot *types) {
+    QVariantMap map;
+    for (auto iter = seriesMap.constBegin(); iter != seriesMap.constEnd(); ++iter) {
+        QVariantMap     series;
+        RequestSnapshot total;
+        for (int type = 0; type < REQUEST_TYPES; type++) {
+            RequestSnapshot snapshot = iter.value()->types[type].snapshot();
+            if (snapshot.sent > 0) {
+                series.insert(typeName(static_cast<RequestType>(type)), snapshot.toVariant());
+            }
+            total.add(snapshot);
+            if (types) {
+                types[type].add(snapshot);
+            }
+        }
+        series.insert("all", total.toVariant());
+        map.insert(iter.key(), series);
+    }
+    return map;
+}
+
+QVariantMap Metrics::toVariant() const {
+    RequestSnapshot types[REQUEST_TYPES];
+    QVariantMap     map;
+    // the entity series are a breakdown of the host series: only the hosts are added to the totals
+    map.insert("hosts", seriesVariant(m_hosts, types));
+    if (m_entitySeries) {
+        map.insert("entities", seriesVariant(m_entities, nullptr));
+    }
+
+    QVariantMap typeMap;
+    for (int type = 0; type < REQUEST_TYPES; type++) {
+        typeMap.insert(typeName(static_cast<RequestType>(type)), types[type].toVariant());
+    }
+
+    map.insert("types", typeMap);
+    map.insert("parse_time", m_parseTime.snapshot().toVariant());
+    return map;
+}
+
+/**
+ * @brief Escapes a Prometheus label value.
+ */
+static QString labelValue(const QString &value) {
+    QString escaped = value;
+    escaped.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
+    return escaped;
+}
+
+static void writeHeader(QByteArray *out, const QByteArray &name, const char *type, const char *help) {
+    out->append("# HELP ").append(name).append(' ').append(help).append('\n');
+    out->append("# TYPE ").append(name).append(' ').append(type).append('\n');
+}
+
+static void writeHistogram(QByteArray *out, const QByteArray &name, const QByteArray &labels,
+                           const HistogramSnapshot &histogram) {
+    QByteArray prefix = labels.isEmpty() ? QByteArray("{") : "{" + labels + ',';
+    quint64    cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKETS; i++) {
+        cumulative += histogram.buckets.at(i);
+        QByteArray le = i < LatencyHistogram::BUCKETS - 1 ? QByteArray::number(LatencyHistogram::BOUNDS[i] / 1e6)
+                                                           : QByteArray("+Inf");
+        out->append(name).append("_bucket").append(prefix).append("le=\"").append(le).append("\"} ");
+        out->append(QByteArray::number(cumulative)).append('\n');
+    }
+    QByteArray suffix = labels.isEmpty() ? QByteArray() : "{" + labels + '}';
+    out->append(name).append("_sum").append(suffix).append(' ');
+    out->append(QByteArray::number(histogram.sum / 1e6)).append('\n');
+    out->append(name).append("_count").append(suffix).append(' ');
+    out->append(QByteArray::number(histogram.count)).append('\n');
+}
+
+void Metrics::writeSeries(QByteArray *out, const char *prefix, const char *keyLabel, const SeriesMap &seriesMap) {
+    // sorted by key for a stable output
+    QStringList keys = seriesMap.keys();
+    keys.sort();
+
+    QVector<QByteArray>      labels;
+    QVector<RequestSnapshot> snapshots;
+    for (const QString &key : keys) {
+        for (int type = 0; type < REQUEST_TYPES; type++) {
+            RequestSnapshot snapshot = seriesMap.value(key)->types[type].snapshot();
+            if (snapshot.sent == 0) {
+                continue;
+            }
+            labels.append(QString("%1=\"%2\",type=\"%3\"")
+                              .arg(keyLabel, labelValue(key), typeName(static_cast<RequestType>(type)))
+                              .toUtf8());
+            snapshots.append(snapshot);
+        }
+    }
+
+    struct Counter {
+        const char *name;
+        const char *type;
+        const char *help;
+        qint64 (*value)(const RequestSnapshot &);
+    };
+    static const Counter counters[] = {
+        {"requests_sent_total", "counter", "Sent requests.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.sent); }},
+        {"requests_in_flight", "gauge", "Requests waiting for their response.",
+         [](const RequestSnapshot &s) { return s.inFlight; }},
+        {"requests_completed_total", "counter", "Successfully completed requests.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.completed); }},
+        {"requests_failed_total", "counter", "Failed requests, excluding timeouts.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.failed); }},
+        {"requests_timed_out_total", "counter", "Requests aborted after the request timeout.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.timedOut); }},
+        {"request_bytes_total", "counter", "Sent request body bytes.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.bytesOut); }},
+        {"response_bytes_total", "counter", "Received response body bytes on the wire.",
+         [](const RequestSnapshot &s) { return static_cast<qint64>(s.bytesIn); }}};
+
+    for (const Counter &counter : counters) {
+        QByteArray name = QByteArray(prefix) + counter.name;
+        writeHeader(out, name, counter.type, counter.help);
+        for (int i = 0; i < snapshots.size(); i++) {
+            out->append(name).append('{').append(labels.at(i)).append("} ");
+            out->append(QByteArray::number(counter.value(snapshots.at(i)))).append('\n');
+        }
+    }
+
+    QByteArray firstByteName = QByteArray(prefix) + "response_first_byte_seconds";
+    writeHeader(out, firstByteName, "histogram", "Time to the response headers.");
+    for (int i = 0; i < snapshots.size(); i++) {
+        writeHistogram(out, firstByteName, labels.at(i), snapshots.at(i).firstByte);
+    }
+
+    QByteArray durationName = QByteArray(prefix) + "request_duration_seconds";
+    writeHeader(out, durationName, "histogram", "Time to the complete response.");
+    for (int i = 0; i < snapshots.size(); i++) {
+        writeHistogram(out, durationName, labels.at(i), snapshots.at(i).total);
+    }
+}
+
+QByteArray Metrics::toPrometheus() const {
+    QByteArray out;
+    writeSeries(&out, "webhook_", "host", m_hosts);
+    // separate metric names: summing a metric over all its series must not count a request twice
+    if (m_entitySeries) {
+        writeSeries(&out, "webhook_entity_", "entity", m_entities);
+    }
+
+    writeHeader(&out, "webhook_response_parse_seconds", "histogram", "Response body parsing and mapping time.");
+    writeHistogram(&out, "webhook_response_parse_seconds", QByteArray(), m_parseTime.snapshot());
+
+    return out;
+}
@@ -0,0 +1,212 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <chrono>
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * @brief Non-atomic copy of a LatencyHistogram, used to aggregate and export the recorded values.
+ */
+struct HistogramSnapshot {
+    HistogramSnapshot();
+
+    void add(const HistogramSnapshot& other);
+
+    /**
+     * @brief Estimates the percentile in ms from the bucket upper bounds.
+     */
+    double percentile(double p) const;
+
+    QVariantMap toVariant() const;
+
+    QVector<quint64> buckets;
+    quint64          count;
+    quint64          sum;
+};
+
+/**
+ * @brief Fixed-bucket latency histogram from 100 us to 10 s.
+ * @details Recording is a linear search in the bucket bounds and two relaxed atomic increments: it is lock-free and
+ * may be read from another thread while recording.
+ */
+class LatencyHistogram {
+ public:
+    static const int BUCKETS = 17;
+
+    /**
+     * @brief Bucket upper bounds in us. The last bucket has no upper bound.
+     */
+    static const qint64 BOUNDS[BUCKETS - 1];
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(qint64 us);
+
+    HistogramSnapshot snapshot() const;
+
+ private:
+    QAtomicInteger<quint64> m_buckets[BUCKETS];
+    QAtomicInteger<quint64> m_count;
+    QAtomicInteger<quint64> m_sum;
+};
+
+/**
+ * @brief Non-atomic copy of the RequestMetrics of a series.
+ */
+struct RequestSnapshot {
+    RequestSnapshot() : sent(0), inFlight(0), completed(0), failed(0), timedOut(0), bytesOut(0), bytesIn(0) {}
+
+    void        add(const RequestSnapshot& other);
+    QVariantMap toVariant() const;
+
+    quint64           sent;
+    qint64            inFlight;
+    quint64           completed;
+    quint64           failed;
+    quint64           timedOut;
+    quint64           bytesOut;
+    quint64           bytesIn;
+    HistogramSnapshot firstByte;
+    HistogramSnapshot total;
+};
+
+/**
+ * @brief Request counters and latency histograms of one host or entity and request type.
+ */
+struct RequestMetrics {
+    RequestMetrics() {}
+    RequestMetrics(const RequestMetrics&) = delete;
+    RequestMetrics& operator=(const RequestMetrics&) = delete;
+
+    RequestSnapshot snapshot() const;
+
+    QAtomicInteger<quint64> sent;
+    QAtomicInteger<qint64>  inFlight;
+    QAtomicInteger<quint64> completed;
+    QAtomicInteger<quint64> failed;
+    QAtomicInteger<quint64> timedOut;
+    QAtomicInteger<quint64> bytesOut;
+    QAtomicInteger<quint64> bytesIn;
+    /**
+     * @brief Time to the response headers.
+     */
+    LatencyHistogram firstByte;
+    /**
+     * @brief Time to the complete response.
+     */
+    LatencyHistogram total;
+};
+
+/**
+ * @brief Request metrics of the integration per host, entity and request type, exported as JSON or Prometheus text.
+ * @details Recording only uses relaxed atomic operations and is cheap enough to be always enabled. The series of a
+ * host or entity is created on its first request and lives until the Metrics object is destroyed: series are created
+ * and exported in the integration thread, the values may be read from any thread.
+ */
+class Metrics {
+ public:
+    enum RequestType { COMMAND, STATUS, REQUEST_TYPES };
+
+    Metrics();
+    ~Metrics();
+
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    /**
+     * @brief Returns the metrics of the given host and request type, created on first use.
+     */
+    RequestMetrics* series(const QString& host, RequestType type);
+
+    /**
+     * @brief Enables the series per entity, in addition to the series per host. Enabled by default.
+     */
+    void setEntitySeries(bool enabled) { m_entitySeries = enabled; }
+    bool hasEntitySeries() const { return m_entitySeries; }
+
+    /**
+     * @brief Returns the metrics of the given entity and request type, created on first use. Null if the entity series
+     * are disabled.
+     */
+    RequestMetrics* entitySeries(const QString& entityId, RequestType type);
+
+    /**
+     * @brief Response body parsing and mapping time.
+     */
+    LatencyHistogram& parseTime() { return m_parseTime; }
+
+    /**
+     * @brief Monotonic timestamp in ns for request timings, shared with the Tracer.
+     */
+    static qint64 now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    /**
+     * @brief Returns all series with the aggregated values per host, per entity and per request type.
+     */
+    QVariantMap toVariant() const;
+
+    /**
+     * @brief Returns all series in the Prometheus text exposition format.
+     */
+    QByteArray toPrometheus() const;
+
+    static QString typeName(RequestType type);
+
+ private:
+    struct TypeSeries {
+        RequestMetrics types[REQUEST_TYPES];
+    };
+    typedef QHash<QString, TypeSeries*> SeriesMap;
+
+    static RequestMetrics* series(SeriesMap* seriesMap, const QString& key, RequestType type);
+
+    /**
+     * @brief Returns the series of each key per request type and all request types, and adds them to the types totals
+     * if not null.
+     */
+    static QVariantMap seriesVariant(const SeriesMap& seriesMap, RequestSnapshot* types);
+
+    /**
+     * @brief Writes the counters and histograms of all series with the given metric name prefix and key label.
+     */
+    static void writeSeries(QByteArray* out, const char* prefix, const char* keyLabel, const SeriesMap& seriesMap);
+
+    SeriesMap        m_hosts;
+    SeriesMap        m_entities;
+    bool             m_entitySeries;
+    LatencyHistogram m_parseTime;
+};
@@ -0,0 +1,232 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "mqtttransport.h"
+
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QtMqtt/QMqttMessage>
+#include <QtMqtt/QMqttTopicFilter>
+#include <QtMqtt/QMqttTopicName>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.mqtt");
+
+// reconnect backoff in ms
+static const int BACKOFF_MIN = 1000;
+static const int BACKOFF_MAX = 60000;
+// maximum number of messages queued while connecting to the broker
+static const int MAX_PENDING_MESSAGES = 32;
+
+MqttTransport::MqttTransport(const QVariantMap &config, QObject *parent)
+    : QObject(parent), m_ssl(config.value("ssl", false).toBool()), m_active(false), m_backoff(BACKOFF_MIN) {
+    m_client.setHostname(config.value("host", "localhost").toString());
+    m_client.setPort(static_cast<quint16>(config.value("port", m_ssl ? 8883 : 1883).toUInt()));
+    m_client.setKeepAlive(static_cast<quint16>(config.value("keep_alive", 60).toUInt()));
+    if (config.contains("client_id")) {
+        m_client.setClientId(config.value("client_id").toString());
+    }
+    if (config.contains("username")) {
+        m_client.setUsername(config.value("username").toString());
+        m_client.setPassword(config.value("password").toString());
+    }
+
+    m_reconnectTimer.setSingleShot(true);
+    QObject::connect(&m_reconnectTimer, &QTimer::timeout, this, &MqttTransport::connectToBroker);
+
+    QObject::connect(&m_client, &QMqttClient::connected, this, &MqttTransport::onConnected);
+    QObject::connect(&m_client, &QMqttClient::disconnected, this, &MqttTransport::onDisconnected);
+    QObject::connect(&m_client, &QMqttClient::messageSent, this, &MqttTransport::onMessageSent);
+    QObject::connect(&m_client, &QMqttClient::errorChanged, this, [this](QMqttClient::ClientError error) {
+        if (error != QMqttClient::NoError) {
+            qCWarning(CLASS_LC) << "MQTT broker error:" << m_client.hostname() << error;
+        }
+    });
+}
+
+QString MqttTransport::topicFromUrl(const QUrl &url) {
+    QString topic = url.path(QUrl::FullyDecoded);
+    // the multi-level wildcard is parsed as url fragment
+    if (url.hasFragment()) {
+        topic.append('#').append(url.fragment(QUrl::FullyDecoded));
+    }
+    return topic;
+}
+
+void MqttTransport::connectToBroker() {
+    m_active = true;
+    if (m_client.state() != QMqttClient::Disconnected) {
+        return;
+    }
+
+    qCDebug(CLASS_LC) << "Connecting to MQTT broker:" << m_client.hostname() << m_client.port();
+    if (m_ssl) {
+        m_client.connectToHostEncrypted();
+    } else {
+        m_client.connectToHost();
+    }
+}
+
+void MqttTransport::disconnectFromBroker() {
+    m_active = false;
+    m_reconnectTimer.stop();
+    m_backoff = BACKOFF_MIN;
+
+    failPendingMessages("MQTT broker disconnected");
+    if (m_client.state() != QMqttClient::Disconnected) {
+        m_client.disconnectFromHost();
+    }
+}
+
+QNetworkReply *MqttTransport::publish(const QNetworkRequest &request, const QByteArray &payload, quint8 qos,
+                                      bool retain) {
+    TransportReply *reply = new TransportReply(request);
+    PendingMessage  message{reply, topicFromUrl(request.url()), payload, qos, retain};
+
+    if (!QMqttTopicName(message.topic).isValid()) {
+        reply->finishWithError(QNetworkReply::ProtocolInvalidOperationError, "Invalid MQTT topic: " + message.topic);
+    } else if (isConnected()) {
+        sendMessage(message);
+    } else if (!m_active) {
+        reply->finishWithError(QNetworkReply::UnknownNetworkError, "MQTT broker not connected");
+    } else if (m_pendingMessages.size() >= MAX_PENDING_MESSAGES) {
+        reply->finishWithError(QNetworkReply::UnknownNetworkError, "Too many pending MQTT messages");
+    } else {
+        m_pendingMessages.append(message);
+    }
+
+    return reply;
+}
+
+void MqttTransport::subscribe(const QString &topicFilter, quint8 qos) {
+    if (m_topicFilters.contains(topicFilter)) {
+        return;
+    }
+
+    m_topicFilters.insert(topicFilter, qos);
+    if (isConnected()) {
+        subscribeTopic(topicFilter, qos);
+    }
+}
+
+void MqttTransport::unsubscribeAll() {
+    for (auto iter = m_subscriptions.cbegin(); iter != m_subscriptions.cend(); ++iter) {
+        iter.value()->disconnect(this);
+        if (isConnected()) {
+            m_client.unsubscribe(QMqttTopicFilter(iter.key()));
+        }
+    }
+    m_subscriptions.clear();
+    m_topicFilters.clear();
+}
+
+void MqttTransport::onConnected() {
+    qCDebug(CLASS_LC) << "Connected to MQTT broker:" << m_client.hostname();
+    m_backoff = BACKOFF_MIN;
+
+    // subscriptions of a clean session must be renewed after every reconnect
+    for (auto iter = m_topicFilters.cbegin(); iter != m_topicFilters.cend(); ++iter) {
+        subscribeTopic(iter.key(), iter.value());
+    }
+
+    QVector<PendingMessage> pending;
+    pending.swap(m_pendingMessages);
+    for (const PendingMessage &message : qAsConst(pending)) {
+        if (message.reply) {
+            sendMessage(message);
+        }
+    }
+}
+
+void MqttTransport::onDisconnected() {
+    qCDebug(CLASS_LC) << "Disconnected from MQTT broker:" << m_client.hostname();
+
+    // the client releases its subscription objects on disconnect, they are not reused
+    for (QMqttSubscription *subscription : qAsConst(m_subscriptions)) {
+        subscription->disconnect(this);
+    }
+    m_subscriptions.clear();
+
+    for (const QPointer<TransportReply> &reply : qAsConst(m_unacknowledged)) {
+        if (reply) {
+            reply->finishWithError(QNetworkReply::RemoteHostClosedError, "MQTT broker connection lost");
+        }
+    }
+    m_unacknowledged.clear();
+
+    scheduleReconnect();
+}
+
+void MqttTransport::onMessageSent(qint32 id) {
+    QPointer<TransportReply> reply = m_unacknowledged.take(id);
+    if (reply) {
+        reply->finish();
+    }
+}
+
+void MqttTransport::subscribeTopic(const QString &topicFilter, quint8 qos) {
+    QMqttSubscription *subscription = m_client.subscribe(QMqttTopicFilter(topicFilter), qos);
+    if (!subscription) {
+        qCWarning(CLASS_LC) << "Subscribing to MQTT topic failed:" << topicFilter;
+        return;
+    }
+    if (m_subscriptions.value(topicFilter) == subscription) {
+        return;
+    }
+
+    QObject::connect(subscription, &QMqttSubscription::messageReceived, this,
+                     [this, topicFilter](const QMqttMessage &message) {
+                         emit messageReceived(topicFilter, message.payload());
+                     });
+    m_subscriptions.insert(topicFilter, subscription);
+}
+
+void MqttTransport::sendMessage(const PendingMessage &message) {
+    qint32 id = m_client.publish(QMqttTopicName(message.topic), message.payload, message.qos, message.retain);
+    if (id < 0) {
+        message.reply->finishWithError(QNetworkReply::ProtocolFailure, "Publishing MQTT message failed");
+    } else if (message.qos == 0) {
+        message.reply->finish();
+    } else {
+        m_unacknowledged.insert(id, message.reply);
+    }
+}
+
+void MqttTransport::failPendingMessages(const QString &errorString) {
+    for (const PendingMessage &message : qAsConst(m_pendingMessages)) {
+        if (message.reply) {
+            message.reply->finishWithError(QNetworkReply::UnknownNetworkError, errorString);
+        }
+    }
+    m_pendingMessages.clear();
+}
+
+void MqttTransport::scheduleReconnect() {
+    if (!m_active || m_reconnectTimer.isActive()) {
+        return;
+    }
+
+    int delay = m_backoff + static_cast<int>(QRandomGenerator::global()->bounded(m_backoff / 5 + 1));
+    qCDebug(CLASS_LC) << "Reconnecting to MQTT broker in" << delay << "ms";
+
+    m_backoff = qMin(m_backoff * 2, BACKOFF_MAX);
+    m_reconnectTimer.start(delay);
+}
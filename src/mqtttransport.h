@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+#include <QUrl>
+#include <QVariantMap>
+#include <QVector>
+#include <QtMqtt/QMqttClient>
+#include <QtMqtt/QMqttSubscription>
+
+#include "transportreply.h"
+
+/**
+ * @brief Shared MQTT broker connection of an integration.
+ * @details Commands are published with publish() and return a TransportReply, which is finished as soon as the message
+ * has been sent (QoS 0) or acknowledged by the broker (QoS 1 & 2). Topic subscriptions are kept across reconnects and
+ * every received message is emitted with messageReceived(). Retained messages are delivered right after subscribing.
+ */
+class MqttTransport : public QObject {
+    Q_OBJECT
+
+ public:
+    /**
+     * @param config Broker configuration: host, port, username, password, client_id, keep_alive, ssl.
+     */
+    explicit MqttTransport(const QVariantMap& config, QObject* parent = nullptr);
+
+    /**
+     * @brief Returns the topic or topic filter of a "mqtt:" url.
+     */
+    static QString topicFromUrl(const QUrl& url);
+
+    bool isConnected() const { return m_client.state() == QMqttClient::Connected; }
+
+    void connectToBroker();
+    void disconnectFromBroker();
+
+    /**
+     * @brief Publishes the payload to the topic of the request url.
+     * @details Messages published while the broker connection is being established are queued.
+     * @return The reply which is finished when the message has been delivered. Ownership is passed to the caller.
+     */
+    QNetworkReply* publish(const QNetworkRequest& request, const QByteArray& payload, quint8 qos, bool retain);
+
+    /**
+     * @brief Subscribes to the given topic filter. Subscribing to the same filter multiple times has no effect.
+     */
+    void subscribe(const QString& topicFilter, quint8 qos = 0);
+    void unsubscribeAll();
+
+ signals:
+    void messageReceived(const QString& topicFilter, const QByteArray& payload);
+
+ private:
+    struct PendingMessage {
+        QPointer<TransportReply> reply;
+        QString                  topic;
+        QByteArray               payload;
+        quint8                   qos;
+        bool                     retain;
+    };
+
+    void onConnected();
+    void onDisconnected();
+    void onMessageSent(qint32 id);
+    void subscribeTopic(const QString& topicFilter, quint8 qos);
+    void sendMessage(const PendingMessage& message);
+    void failPendingMessages(const QString& errorString);
+    void scheduleReconnect();
+
+    QMqttClient                             m_client;
+    bool                                    m_ssl;
+    bool                                    m_active;
+    QTimer                                  m_reconnectTimer;
+    int                                     m_backoff;
+    QHash<QString, quint8>                  m_topicFilters;
+    QHash<QString, QMqttSubscription*>      m_subscriptions;
+    QVector<PendingMessage>                 m_pendingMessages;
+    QHash<qint32, QPointer<TransportReply>> m_unacknowledged;
+};
@@ -0,0 +1,197 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "placeholders.h"
+
+#include <QHash>
+#include <QLoggingCategory>
+#include <QRegularExpression>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.template");
+
+static_assert(Placeholder::COUNT <= 32, "Placeholder mask is limited to 32 placeholders");
+
+static const char* const PLACEHOLDER_NAMES[Placeholder::COUNT] = {
+    "state_bool", "state_bin", "state",   "brightness_percent", "color_temp",       "color_r",     "color_g",
+    "color_b",    "color_h",   "color_s", "color_v",            "position_percent", "target_temp",
+};
+
+int Placeholder::fromName(const QString &name) {
+    static const QHash<QString, int> ids = [] {
+        QHash<QString, int> hash;
+        for (int i = 0; i < COUNT; i++) {
+            hash.insert(QLatin1String(PLACEHOLDER_NAMES[i]), i);
+        }
+        return hash;
+    }();
+    return ids.value(name, -1);
+}
+
+QString Placeholder::name(Enum id) { return id >= 0 && id < COUNT ? QLatin1String(PLACEHOLDER_NAMES[id]) : QString(); }
+
+const QVariant *PlaceholderValues::find(int id, const QString &name) const {
+    if (id >= 0 && m_values[id].isValid()) {
+        return &m_values[id];
+    }
+    if (m_placeholders) {
+        auto iter = m_placeholders->constFind(name);
+        if (iter != m_placeholders->constEnd()) {
+            return &iter.value();
+        }
+    }
+    return nullptr;
+}
+
+TextTemplate::TextTemplate(const QString &text) : m_text(text), m_placeholderMask(0) {
+    if (!text.contains(QLatin1String("${"))) {
+        return;
+    }
+
+    // Simplified c printf regex supporting decimal and hex only. Good enough for now :-)
+    // For strict parsing and supporting floats:
+    // "\\$\\{(\\w+)(:(%(?:\\d+\\$)?[+-]?(?:[ 0]|'.{1})?-?\\d*(?:\\.\\d+)?[dfFxX]))?\\}"
+    // http://www.cplusplus.com/reference/cstdio/printf/
+    static const QRegularExpression markerRegEx("\\$\\{(\\w+)(:(%\\w*[dxX]))?\\}");
+
+    QRegularExpressionMatchIterator i = markerRegEx.globalMatch(text);
+    while (i.hasNext()) {
+        QRegularExpressionMatch match = i.next();
+        Marker                  marker;
+        marker.start = match.capturedStart(0);
+        marker.length = match.capturedLength(0);
+        marker.name = match.captured(1);
+        marker.id = Placeholder::fromName(marker.name);
+        marker.format = match.captured(3).toLatin1();
+        m_markers.append(marker);
+        if (marker.id >= 0) {
+            m_placeholderMask |= Placeholder::bit(static_cast<Placeholder::Enum>(marker.id));
+        }
+    }
+    m_markers.squeeze();
+}
+
+QString TextTemplate::render(const PlaceholderValues &values) const {
+    if (m_markers.isEmpty()) {
+        return m_text;
+    }
+
+    QString resolved;
+    resolved.reserve(m_text.size() + 8 * m_markers.size());
+
+    int pos = 0;
+    for (const Marker &marker : m_markers) {
+        resolved.append(m_text.midRef(pos, marker.start - pos));
+        pos = marker.start + marker.length;
+
+        if (!appendValue(marker, values, &resolved)) {
+            resolved.append(m_text.midRef(marker.start, marker.length));
+        }
+    }
+    resolved.append(m_text.midRef(pos));
+
+    return resolved;
+}
+
+TextTemplate TextTemplate::bind(const QVariantMap &placeholders) const {
+    if (m_markers.isEmpty() || placeholders.isEmpty()) {
+        return *this;
+    }
+
+    PlaceholderValues values(&placeholders);
+    TextTemplate      bound;
+    bound.m_placeholderMask = m_placeholderMask;
+
+    int pos = 0;
+    for (const Marker &marker : m_markers) {
+        bound.m_text.append(m_text.midRef(pos, marker.start - pos));
+        pos = marker.start + marker.length;
+
+        // dynamic placeholders are always rendered per request, even if there's a static placeholder with that name
+        if (marker.id < 0 && appendValue(marker, values, &bound.m_text)) {
+            continue;
+        }
+        Marker unbound = marker;
+        unbound.start = bound.m_text.size();
+        bound.m_text.append(m_text.midRef(marker.start, marker.length));
+        bound.m_markers.append(unbound);
+    }
+    bound.m_text.append(m_text.midRef(pos));
+    bound.m_markers.squeeze();
+
+    return bound;
+}
+
+bool TextTemplate::appendValue(const Marker &marker, const PlaceholderValues &values, QString *text) const {
+    const QVariant *value = values.find(marker.id, marker.name);
+    if (!value) {
+        return false;
+    }
+
+    if (marker.format.isEmpty()) {
+        text->append(value->toString());
+        return true;
+    }
+
+    bool ok;
+    int  number = value->toInt(&ok);
+    if (!ok) {
+        qCWarning(CLASS_LC) << "Variable format only supports numbers! Value:" << *value
+                            << ", placeholder:" << m_text.midRef(marker.start, marker.length);
+        return false;
+    }
+    text->append(QString::asprintf(marker.format.constData(), number));
+    return true;
+}
+
+QDataStream &operator<<(QDataStream &out, const TextTemplate &text) {
+    out << text.m_text << text.m_placeholderMask << static_cast<qint32>(text.m_markers.size());
+    for (const TextTemplate::Marker &marker : text.m_markers) {
+        out << static_cast<qint32>(marker.start) << static_cast<qint32>(marker.length) << static_cast<qint32>(marker.id)
+            << marker.name << marker.format;
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, TextTemplate &text) {
+    qint32 count;
+    in >> text.m_text >> text.m_placeholderMask >> count;
+    text.m_markers.clear();
+    if (count < 0 || count > text.m_text.size()) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    text.m_markers.reserve(count);
+    for (qint32 i = 0; i < count; i++) {
+        qint32               start, length, id;
+        TextTemplate::Marker marker;
+        in >> start >> length >> id >> marker.name >> marker.format;
+        if (start < 0 || length <= 0 || start + length > text.m_text.size() || id >= Placeholder::COUNT) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            return in;
+        }
+        marker.start = start;
+        marker.length = length;
+        marker.id = id < 0 ? -1 : id;
+        text.m_markers.append(marker);
+    }
+    return in;
+}
@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+/**
+ * @brief Dynamic placeholders of the entity command values, e.g. ${brightness_percent}.
+ * @details The placeholder names are interned to these ids when the command templates are compiled at config load.
+ */
+class Placeholder {
+ public:
+    enum Enum {
+        STATE_BOOL,
+        STATE_BIN,
+        STATE,
+        BRIGHTNESS_PERCENT,
+        COLOR_TEMP,
+        COLOR_R,
+        COLOR_G,
+        COLOR_B,
+        COLOR_H,
+        COLOR_S,
+        COLOR_V,
+        POSITION_PERCENT,
+        TARGET_TEMP,
+        COUNT
+    };
+
+    /**
+     * @brief Returns the id of the given dynamic placeholder name, or -1 for a static placeholder.
+     */
+    static int fromName(const QString& name);
+
+    static QString name(Enum id);
+
+    /**
+     * @brief Returns the bit of the given placeholder in a placeholder mask.
+     */
+    static quint32 bit(Enum id) { return 1u << id; }
+
+    /**
+     * @brief Mask of all dynamic placeholders.
+     */
+    static const quint32 ALL = (1u << COUNT) - 1;
+};
+
+/**
+ * @brief Placeholder values of a request: a fixed slot per dynamic placeholder, layered over the static
+ * placeholders of the integration.
+ * @details The static placeholders are referenced, not copied. A dynamic value takes precedence over a static
+ * placeholder with the same name.
+ */
+class PlaceholderValues {
+ public:
+    /**
+     * @param placeholders Static placeholders of the integration.
+     * @param usedMask Placeholder mask of the dynamic placeholders referenced by the rendered templates. Values of
+     * other placeholders are ignored.
+     */
+    explicit PlaceholderValues(const QVariantMap* placeholders = nullptr, quint32 usedMask = Placeholder::ALL)
+        : m_placeholders(placeholders), m_usedMask(usedMask) {}
+
+    /**
+     * @brief Returns true if the given dynamic placeholder is referenced. Allows to skip expensive value calculations.
+     */
+    bool isUsed(Placeholder::Enum id) const { return m_usedMask & Placeholder::bit(id); }
+
+    void set(Placeholder::Enum id, const QVariant& value) {
+        if (isUsed(id)) {
+            m_values[id] = value;
+        }
+    }
+
+    /**
+     * @brief Returns the value of the given placeholder, or null if it is not defined.
+     * @param id Dynamic placeholder id, or -1 for a static placeholder.
+     * @param name Placeholder name for the static placeholder lookup.
+     */
+    const QVariant* find(int id, const QString& name) const;
+
+ private:
+    QVariant           m_values[Placeholder::COUNT];
+    const QVariantMap* m_placeholders;
+    quint32            m_usedMask;
+};
+
+/**
+ * @brief Text with ${name} or ${name:%format} placeholders, compiled once at config load.
+ * @details The text is split into literal parts and placeholder markers with the interned placeholder id. Rendering
+ * appends the parts without any parsing or regular expression matching. Supported number formats are decimal and hex,
+ * e.g. ${color_r:%02X}. Undefined placeholders are kept as is.
+ */
+class TextTemplate {
+ public:
+    TextTemplate() : m_placeholderMask(0) {}
+    explicit TextTemplate(const QString& text);
+
+    const QString& text() const { return m_text; }
+    bool           hasPlaceholders() const { return !m_markers.isEmpty(); }
+
+    /**
+     * @brief Returns the placeholder mask of the referenced dynamic placeholders.
+     */
+    quint32 placeholderMask() const { return m_placeholderMask; }
+
+    QString render(const PlaceholderValues& values) const;
+
+    /**
+     * @brief Returns the template with the static placeholders rendered into the text.
+     * @details The static placeholders of the integration are immutable: they only have to be rendered once when
+     * reading the configuration. Undefined placeholders and dynamic placeholders remain in the returned template.
+     */
+    TextTemplate bind(const QVariantMap& placeholders) const;
+
+    friend QDataStream& operator<<(QDataStream& out, const TextTemplate& text);
+    friend QDataStream& operator>>(QDataStream& in, TextTemplate& text);
+
+ private:
+    struct Marker {
+        int        start;
+        int        length;
+        int        id;
+        QString    name;
+        QByteArray format;
+    };
+
+    bool appendValue(const Marker& marker, const PlaceholderValues& values, QString* text) const;
+
+    QString         m_text;
+    QVector<Marker> m_markers;
+    quint32         m_placeholderMask;
+};
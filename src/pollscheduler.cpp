@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "pollscheduler.h"
+
+PollScheduler::PollScheduler()
+    : m_interval(0), m_hiddenInterval(300), m_recentPeriod(300), m_visibilityReported(false) {}
+
+void PollScheduler::setPriority(int hiddenInterval, int recentPeriod) {
+    m_hiddenInterval = qMax(0, hiddenInterval);
+    m_recentPeriod = qMax(0, recentPeriod);
+}
+
+void PollScheduler::addEntity(WebhookEntity *entity) {
+    Q_ASSERT(entity->index >= 0);
+    if (entity->index >= m_entities.size()) {
+        m_entities.resize(entity->index + 1);
+    }
+    m_entities[entity->index] = entity;
+}
+
+void PollScheduler::removeEntity(int index) {
+    if (index >= 0 && index < m_entities.size()) {
+        m_entities[index] = nullptr;
+    }
+    m_wheel.cancel(index);
+}
+
+void PollScheduler::scheduleAll() {
+    for (int index = 0; index < m_entities.size(); index++) {
+        if (hasPolling(m_entities.at(index)) && !m_wheel.isScheduled(index)) {
+            m_wheel.schedule(index, 1);
+        }
+    }
+}
+
+bool PollScheduler::isPriorityEntity(const WebhookEntity *entity, qint64 now) const {
+    return !m_visibilityReported || entity->visible || now - entity->lastUsed < m_recentPeriod * 1000LL;
+}
+
+int PollScheduler::pollPeriod(const WebhookEntity *entity, bool priority) const {
+    int period = entity->statusCommand->interval > 0 ? entity->statusCommand->interval : m_interval;
+    // entities with pushed state updates may have a throttled status polling
+    period = qMax(period, entity->pollInterval);
+    return priority ? period : qMax(period, m_hiddenInterval);
+}
+
+void PollScheduler::advance(qint64 now, QVector<WebhookEntity *> *poll) {
+    // only the entities due in this tick are touched
+    m_due.clear();
+    m_wheel.advance(&m_due);
+
+    // the requests of visible and recently used entities are queued first, hidden entities are polled lazily
+    for (int pass = 0; pass < 2 && !m_due.isEmpty(); pass++) {
+        bool priority = pass == 0;
+        for (int index : qAsConst(m_due)) {
+            WebhookEntity *entity = m_entities.at(index);
+
+            // removed entities and entities without status polling are not scheduled again
+            if (!hasPolling(entity) || isPriorityEntity(entity, now) != priority) {
+                continue;
+            }
+
+            // pushed state updates and a changed visibility postpone the poll. Half a tick compensates the timer jitter
+            qint64 remaining = pollPeriod(entity, priority) * 1000LL - (now - entity->lastUpdate);
+            if (remaining > 500) {
+                m_wheel.schedule(index, ticks(remaining));
+                continue;
+            }
+
+            appendPoll(entity, now, poll);
+        }
+    }
+}
+
+void PollScheduler::setVisibleEntities(const QSet<int> &visible, qint64 now, bool polling,
+                                       QVector<WebhookEntity *> *poll) {
+    m_visibilityReported = true;
+
+    for (WebhookEntity *entity : qAsConst(m_entities)) {
+        if (!entity) {
+            continue;
+        }
+
+        bool wasVisible = entity->visible;
+        entity->visible = visible.contains(entity->index);
+        if (!polling || !entity->visible || wasVisible || !hasPolling(entity)) {
+            continue;
+        }
+
+        // a newly visible entity is polled at its priority period, right away if that has already elapsed
+        qint64 remaining = pollPeriod(entity, true) * 1000LL - (now - entity->lastUpdate);
+        if (remaining > 0) {
+            m_wheel.schedule(entity->index, ticks(remaining));
+        } else {
+            appendPoll(entity, now, poll);
+        }
+    }
+}
+
+void PollScheduler::refreshPriorityEntities(qint64 now, QVector<WebhookEntity *> *poll) {
+    for (WebhookEntity *entity : qAsConst(m_entities)) {
+        if (!hasPolling(entity) || !isPriorityEntity(entity, now) ||
+            (entity->pollInterval > 0 && now - entity->lastUpdate < entity->pollInterval * 1000LL)) {
+            continue;
+        }
+        appendPoll(entity, now, poll);
+    }
+}
+
+void PollScheduler::appendPoll(WebhookEntity *entity, qint64 now, QVector<WebhookEntity *> *poll) {
+    entity->lastUpdate = now;
+    m_wheel.schedule(entity->index, static_cast<quint64>(pollPeriod(entity, isPriorityEntity(entity, now))));
+    poll->append(entity);
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QSet>
+#include <QVector>
+
+#include "timingwheel.h"
+#include "webhookentity.h"
+
+/**
+ * @brief Status polling schedule of the entities on a timing wheel with a tick per second.
+ * @details Entities are identified by their dense entity index. Entities shown on the current page of the app and
+ * entities with a recent command are polled at their polling interval and queued first. Once the app has reported the
+ * visible entities, hidden entities are polled every hidden interval at most. The scheduler only decides which
+ * entities are due, sending the status requests is up to the caller.
+ */
+class PollScheduler {
+ public:
+    PollScheduler();
+
+    /**
+     * @brief Sets the default polling interval in seconds of status commands without an own interval.
+     */
+    void setInterval(int seconds) { m_interval = seconds; }
+    int  interval() const { return m_interval; }
+
+    /**
+     * @param hiddenInterval Minimum polling interval in seconds of hidden entities.
+     * @param recentPeriod Entities with a command in the given number of seconds are polled like visible entities.
+     */
+    void setPriority(int hiddenInterval, int recentPeriod);
+
+    /**
+     * @brief Adds a registered entity with its entity index. The entity is scheduled with scheduleAll().
+     */
+    void addEntity(WebhookEntity* entity);
+
+    /**
+     * @brief Removes the entity with the given index from the schedule.
+     */
+    void removeEntity(int index);
+
+    /**
+     * @brief Schedules all entities with status polling which aren't scheduled yet with the next tick.
+     */
+    void scheduleAll();
+
+    /**
+     * @brief Cancels the schedule of all entities.
+     */
+    void clear() { m_wheel.clear(); }
+
+    bool isScheduled(int index) const { return m_wheel.isScheduled(index); }
+
+    /**
+     * @brief Returns the number of ticks until the scheduled entity is due.
+     */
+    quint64 dueIn(int index) const { return m_wheel.expires(index) - m_wheel.now(); }
+
+    /**
+     * @brief Returns true if the entity is polled at its polling interval: all entities until the visible entities
+     * have been set, visible entities and entities with a recent command.
+     */
+    bool isPriorityEntity(const WebhookEntity* entity, qint64 now) const;
+
+    /**
+     * @brief Returns the polling period of the entity in seconds.
+     */
+    int pollPeriod(const WebhookEntity* entity, bool priority) const;
+
+    /**
+     * @brief Advances the schedule by one tick and appends the entities to poll now: priority entities first.
+     * @details Due entities whose polling period hasn't elapsed, e.g. after a pushed state update, are scheduled again.
+     * An appended entity is marked as updated and scheduled with its next polling period.
+     */
+    void advance(qint64 now, QVector<WebhookEntity*>* poll);
+
+    /**
+     * @brief Sets the entities shown on the current page of the app.
+     * @details A newly visible entity is scheduled at its priority polling period, or appended to poll right away if
+     * the period has already elapsed.
+     * @param visible Entity indexes of the visible entities.
+     * @param polling false if status polling isn't running: only the visibility is updated.
+     */
+    void setVisibleEntities(const QSet<int>& visible, qint64 now, bool polling, QVector<WebhookEntity*>* poll);
+
+    /**
+     * @brief Appends all priority entities to poll right away, e.g. after waking up from standby. Entities with a
+     * throttled polling updated within their poll_interval are skipped.
+     */
+    void refreshPriorityEntities(qint64 now, QVector<WebhookEntity*>* poll);
+
+ private:
+    static bool hasPolling(const WebhookEntity* entity) {
+        return entity && entity->statusCommand && entity->pollInterval != 0;
+    }
+
+    /**
+     * @brief Returns the number of ticks of the given time in ms, rounded up.
+     */
+    static quint64 ticks(qint64 ms) { return static_cast<quint64>((ms + 999) / 1000); }
+
+    void appendPoll(WebhookEntity* entity, qint64 now, QVector<WebhookEntity*>* poll);
+
+    QVector<WebhookEntity*> m_entities;
+    TimingWheel             m_wheel;
+    QVector<int>            m_due;
+    int                     m_interval;
+    int                     m_hiddenInterval;
+    int                     m_recentPeriod;
+    bool                    m_visibilityReported;
+};
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "requestbatch.h"
+
+#include <QLoggingCategory>
+#include <QTimer>
+#include <QVariantMap>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.batch");
+
+RequestBatch::RequestBatch(int maxPerHost, QObject *parent)
+    : QObject(parent), m_maxPerHost(qMax(1, maxPerHost)), m_running(false), m_pending(0) {}
+
+void RequestBatch::add(const QString &id, const QString &host, StartFunction start, ReplyFunction onReply) {
+    if (m_running) {
+        qCWarning(CLASS_LC) << "Cannot add request to a running batch:" << id;
+        return;
+    }
+
+    int index = m_results.size();
+    m_results.append({id, false, QString(), -1});
+    m_hosts[host].queue.enqueue({index, start, onReply});
+    m_pending++;
+}
+
+void RequestBatch::addFailed(const QString &id, const QString &error) {
+    m_results.append({id, false, error, 0});
+}
+
+int RequestBatch::successCount() const {
+    int count = 0;
+    for (const Result &result : m_results) {
+        if (result.success) {
+            count++;
+        }
+    }
+    return count;
+}
+
+QVariantList RequestBatch::resultList() const {
+    QVariantList list;
+    for (const Result &result : m_results) {
+        QVariantMap map;
+        map.insert("id", result.id);
+        map.insert("success", result.success);
+        map.insert("error", result.error);
+        map.insert("elapsed", result.elapsed);
+        list.append(map);
+    }
+    return list;
+}
+
+void RequestBatch::start() {
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_timer.start();
+
+    if (m_pending == 0) {
+        QTimer::singleShot(0, this, [this] {
+            m_running = false;
+            emit finished();
+        });
+        return;
+    }
+
+    for (auto iter = m_hosts.begin(); iter != m_hosts.end(); ++iter) {
+        startNext(&iter.value());
+    }
+}
+
+void RequestBatch::startNext(Host *host) {
+    while (host->inFlight < m_maxPerHost && !host->queue.isEmpty()) {
+        Item           item = host->queue.dequeue();
+        QNetworkReply *reply = item.start();
+        if (!reply) {
+            finishItem(item.index, false, "Request could not be sent");
+            continue;
+        }
+
+        host->inFlight++;
+        QObject::connect(reply, &QNetworkReply::finished, this,
+                         [this, host, item, reply] { onReplyFinished(host, item, reply); });
+    }
+}
+
+void RequestBatch::onReplyFinished(Host *host, const Item &item, QNetworkReply *reply) {
+    reply->deleteLater();
+    host->inFlight--;
+
+    if (item.onReply) {
+        item.onReply(reply);
+    }
+
+    bool success = reply->error() == QNetworkReply::NoError;
+    finishItem(item.index, success, success ? QString() : reply->errorString());
+
+    if (m_running) {
+        startNext(host);
+    }
+}
+
+void RequestBatch::finishItem(int index, bool success, const QString &error) {
+    Result &result = m_results[index];
+    result.success = success;
+    result.error = error;
+    result.elapsed = m_timer.elapsed();
+
+    if (--m_pending == 0) {
+        qCDebug(CLASS_LC) << "Batch finished in" << m_timer.elapsed() << "ms:" << successCount() << "of"
+                          << m_results.size() << "requests successful";
+        m_running = false;
+        emit finished();
+    }
+}
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+/**
+ * @brief Concurrent execution of a batch of requests with a bounded number of parallel requests per host.
+ * @details All hosts are served in parallel, requests to the same host are limited to maxPerHost concurrent requests.
+ * The finished signal is emitted once all requests have finished.
+ */
+class RequestBatch : public QObject {
+    Q_OBJECT
+
+ public:
+    /**
+     * @brief Starts the request and returns its reply, or null if the request could not be sent.
+     */
+    typedef std::function<QNetworkReply*()> StartFunction;
+    /**
+     * @brief Handles the finished reply. The reply is deleted afterwards.
+     */
+    typedef std::function<void(QNetworkReply*)> ReplyFunction;
+
+    struct Result {
+        QString id;
+        bool    success;
+        QString error;
+        qint64  elapsed;  // ms
+    };
+
+    explicit RequestBatch(int maxPerHost, QObject* parent = nullptr);
+
+    /**
+     * @brief Adds a request to the batch. Must be called before start().
+     * @param id Request identifier for the result.
+     * @param host Host key for the fan-out limit.
+     */
+    void add(const QString& id, const QString& host, StartFunction start, ReplyFunction onReply = nullptr);
+
+    /**
+     * @brief Adds an already failed request, e.g. if the request could not be created.
+     */
+    void addFailed(const QString& id, const QString& error);
+
+    void start();
+
+    bool isRunning() const { return m_running; }
+    int  size() const { return m_results.size(); }
+    int  successCount() const;
+
+    QVector<Result> results() const { return m_results; }
+
+    /**
+     * @brief Returns the results as list of maps with keys id, success, error and elapsed.
+     */
+    QVariantList resultList() const;
+
+ signals:
+    void finished();
+
+ private:
+    struct Item {
+        int           index;
+        StartFunction start;
+        ReplyFunction onReply;
+    };
+
+    struct Host {
+        QQueue<Item> queue;
+        int          inFlight = 0;
+    };
+
+    void startNext(Host* host);
+    void onReplyFinished(Host* host, const Item& item, QNetworkReply* reply);
+    void finishItem(int index, bool success, const QString& error);
+
+    int                  m_maxPerHost;
+    bool                 m_running;
+    int                  m_pending;
+    QElapsedTimer        m_timer;
+    QHash<QString, Host> m_hosts;
+    QVector<Result>      m_results;
+};
@@ -0,0 +1,444 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "requestdispatcher.h"
+
+#include <QHostAddress>
+#include <QLoggingCategory>
+#include <QTimer>
+
+#include "webhookentity.h"
+
+#ifdef WEBHOOK_MQTT
+#include "mqtttransport.h"
+#endif
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.request");
+
+RequestDispatcher::RequestDispatcher(QNetworkAccessManager *networkManager, QObject *parent)
+    : QObject(parent),
+      m_networkManager(networkManager),
+      m_hostCache(nullptr),
+      m_socketTransport(nullptr),
+      m_mqtt(nullptr),
+      m_metrics(nullptr),
+      m_tracing(false),
+      m_acceptCompression(true),
+      m_requestSequence(0),
+      m_responseWireBytes(0),
+      m_responseDecodedBytes(0),
+      m_responseDecodeTime(0),
+      m_requestTimeout(10000),
+      m_maxPollsPerHost(2),
+      m_maxQueuedPolls(256),
+      m_queuedPolls(0),
+      m_laneSent{0, 0},
+      m_laneDropped{0, 0} {
+    Q_ASSERT(networkManager);
+}
+
+QNetworkReply *RequestDispatcher::send(WebhookRequest *request) {
+    if (!request) {
+        return nullptr;
+    }
+    Q_ASSERT(request->webhookCommand);
+
+    qint64         sentAt = m_metrics || m_tracing ? Metrics::now() : 0;
+    QNetworkReply *reply = sendRequest(request);
+    if (sentAt > 0) {
+        recordSent(request, reply, sentAt);
+    }
+
+    // the command lane has no queue: commands are never deferred by the dispatcher
+    if (reply && !request->poll && isHttp(request)) {
+        m_hosts[laneHost(request)].commands++;
+        m_laneSent[COMMAND_LANE]++;
+        m_laneWait[COMMAND_LANE].record(0);
+    }
+    return reply;
+}
+
+void RequestDispatcher::sendPoll(WebhookRequest *request, const SentFunction &sent) {
+    if (!request || !isHttp(request)) {
+        sent(send(request));
+        return;
+    }
+
+    qint64     queuedAt = Metrics::now();
+    QString    host = laneHost(request);
+    HostLanes &lanes = m_hosts[host];
+    if (lanes.queue.isEmpty() && lanes.commands == 0 && lanes.polls < m_maxPollsPerHost) {
+        startPoll(request, sent, queuedAt);
+        return;
+    }
+
+    // a queued poll of the same entity will return the same state
+    bool duplicate = false;
+    for (const QueuedPoll &queued : qAsConst(lanes.queue)) {
+        if (request->webhookEntity && queued.request->webhookEntity == request->webhookEntity) {
+            duplicate = true;
+            break;
+        }
+    }
+    if (duplicate || m_queuedPolls >= m_maxQueuedPolls) {
+        qCDebug(CLASS_LC) << "Dropping status poll of busy host" << host << "with" << lanes.queue.size()
+                          << "queued polls";
+        m_laneDropped[POLL_LANE]++;
+        sent(nullptr);
+        return;
+    }
+
+    lanes.queue.enqueue(QueuedPoll{request, sent, queuedAt});
+    m_queuedPolls++;
+}
+
+void RequestDispatcher::startPoll(WebhookRequest *request, const SentFunction &sent, qint64 queuedAt) {
+    request->poll = true;
+    QNetworkReply *reply = send(request);
+    if (reply) {
+        m_hosts[laneHost(request)].polls++;
+        m_laneSent[POLL_LANE]++;
+        m_laneWait[POLL_LANE].record((Metrics::now() - queuedAt) / 1000);
+    }
+    sent(reply);
+}
+
+void RequestDispatcher::sendQueuedPolls(const QString &host) {
+    for (;;) {
+        auto iter = m_hosts.find(host);
+        if (iter == m_hosts.end()) {
+            return;
+        }
+
+        HostLanes &lanes = iter.value();
+        if (lanes.queue.isEmpty()) {
+            if (lanes.commands == 0 && lanes.polls == 0) {
+                m_hosts.erase(iter);
+            }
+            return;
+        }
+        if (lanes.commands > 0 || lanes.polls >= m_maxPollsPerHost) {
+            return;
+        }
+
+        // the lanes must be looked up again after sending, the callback may queue new requests
+        QueuedPoll poll = lanes.queue.dequeue();
+        m_queuedPolls--;
+        startPoll(poll.request, poll.sent, poll.queuedAt);
+    }
+}
+
+void RequestDispatcher::dropQueuedPolls() {
+    QList<QueuedPoll> dropped;
+    for (auto iter = m_hosts.begin(); iter != m_hosts.end(); ++iter) {
+        while (!iter.value().queue.isEmpty()) {
+            dropped.append(iter.value().queue.dequeue());
+        }
+    }
+    m_queuedPolls = 0;
+    m_laneDropped[POLL_LANE] += static_cast<quint64>(dropped.size());
+
+    for (const QueuedPoll &poll : qAsConst(dropped)) {
+        poll.sent(nullptr);
+    }
+}
+
+bool RequestDispatcher::isHttp(const WebhookRequest *request) {
+    return !request->webhookCommand->isMqtt() && !request->webhookCommand->isSocket();
+}
+
+QString RequestDispatcher::laneHost(const WebhookRequest *request) {
+    // same key as the connection pool of QNetworkAccessManager. The url host is replaced when sending with a cached
+    // host address
+    QUrl    url = request->networkRequest.url();
+    QString host = request->cachedHost.isEmpty() ? url.host() : request->cachedHost;
+    return url.port() > 0 ? host + ':' + QString::number(url.port()) : host;
+}
+
+QNetworkReply *RequestDispatcher::sendRequest(WebhookRequest *request) {
+    request->sequence = ++m_requestSequence;
+
+    if (request->webhookCommand->isMqtt()) {
+        return publishMqttMessage(request);
+    }
+    if (request->webhookCommand->isSocket()) {
+        if (!m_socketTransport) {
+            qCWarning(CLASS_LC) << "Socket transport not available, ignoring command:"
+                                << request->networkRequest.url().toString();
+            return nullptr;
+        }
+        return m_socketTransport->send(request->networkRequest, request->body, request->webhookCommand->framing);
+    }
+
+    if (m_hostCache) {
+        useCachedHostAddress(request);
+    }
+
+    if (m_acceptCompression) {
+        // Setting the header explicitly disables the transparent decompression of QNetworkAccessManager, which only
+        // decompresses after the full body has been received. We decode it ourself while the data is arriving.
+        request->networkRequest.setRawHeader("Accept-Encoding", "gzip, deflate");
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    // the request may be reused from the pool: always set the current timeout
+    request->networkRequest.setTransferTimeout(m_requestTimeout);
+#endif
+
+    QNetworkReply *reply;
+    switch (request->webhookCommand->method) {
+        case HttpMethod::POST:
+            reply = m_networkManager->post(request->networkRequest, request->body);
+            break;
+        case HttpMethod::PUT:
+            reply = m_networkManager->put(request->networkRequest, request->body);
+            break;
+        case HttpMethod::DELETE:
+            reply = m_networkManager->deleteResource(request->networkRequest);
+            break;
+        default:
+            reply = m_networkManager->get(request->networkRequest);
+    }
+
+    if (m_acceptCompression && reply) {
+        QObject::connect(reply, &QNetworkReply::readyRead, this,
+                         [this, request, reply] { readResponseData(request, reply); });
+    }
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
+    if (m_requestTimeout > 0 && reply) {
+        // the timer is deleted with the reply
+        QTimer *timer = new QTimer(reply);
+        timer->setSingleShot(true);
+        QObject::connect(timer, &QTimer::timeout, reply, &QNetworkReply::abort);
+        QObject::connect(reply, &QNetworkReply::finished, timer, &QTimer::stop);
+        timer->start(m_requestTimeout);
+    }
+#endif
+
+    return reply;
+}
+
+void RequestDispatcher::finish(WebhookRequest *request, QNetworkReply *reply) {
+    readResponseData(request, reply);
+    checkConnectionError(request, reply);
+    recordFinished(request, reply);
+
+    if (isHttp(request)) {
+        QString host = laneHost(request);
+        auto    iter = m_hosts.find(host);
+        if (iter != m_hosts.end()) {
+            int &inFlight = request->poll ? iter.value().polls : iter.value().commands;
+            inFlight = qMax(0, inFlight - 1);
+        }
+        sendQueuedPolls(host);
+    }
+}
+
+QVariantMap RequestDispatcher::laneStats() const {
+    QVariantMap stats;
+    for (int lane = 0; lane < LANES; lane++) {
+        QVariantMap laneStats;
+        laneStats.insert("sent", m_laneSent[lane]);
+        laneStats.insert("dropped", m_laneDropped[lane]);
+        laneStats.insert("queued", lane == POLL_LANE ? m_queuedPolls : 0);
+        laneStats.insert("queue_wait", m_laneWait[lane].snapshot().toVariant());
+        stats.insert(lane == POLL_LANE ? "poll" : "command", laneStats);
+    }
+    return stats;
+}
+
+QVariantMap RequestDispatcher::compressionStats() const {
+    QVariantMap stats;
+    stats.insert("wire_bytes", m_responseWireBytes);
+    stats.insert("decoded_bytes", m_responseDecodedBytes);
+    stats.insert("decode_time_us", m_responseDecodeTime / 1000);
+    return stats;
+}
+
+void RequestDispatcher::readResponseData(WebhookRequest *request, QNetworkReply *reply) {
+    if (!m_acceptCompression) {
+        return;
+    }
+
+    if (!request->response.isActive()) {
+        request->response.begin(InflateStream::encodingFromHeader(reply->rawHeader("Content-Encoding")));
+    }
+
+    if (reply->bytesAvailable() > 0 && !request->response.append(reply->readAll())) {
+        qCWarning(CLASS_LC) << "Error decoding response body:" << reply->url().url();
+    }
+
+    if (reply->isFinished()) {
+        m_responseWireBytes += request->response.wireBytes();
+        m_responseDecodedBytes += request->response.data().size();
+        m_responseDecodeTime += request->response.decodeTime();
+
+        if (request->response.encoding() != InflateStream::IDENTITY) {
+            qCDebug(CLASS_LC) << "Decoded response:" << request->response.wireBytes() << "bytes on the wire,"
+                              << request->response.data().size() << "bytes decoded in"
+                              << request->response.decodeTime() / 1000 << "us";
+        }
+    }
+}
+
+void RequestDispatcher::useCachedHostAddress(WebhookRequest *request) {
+    QUrl    url = request->networkRequest.url();
+    QString host = url.host();
+
+    QHostAddress address = m_hostCache->lookup(host);
+    if (address.isNull()) {
+        return;
+    }
+
+    if (url.scheme() == "https") {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        // certificate verification and TLS SNI must use the original host name
+        request->networkRequest.setPeerVerifyName(host);
+#else
+        // the TLS peer name cannot be set independently of the url
+        return;
+#endif
+    }
+
+    // QNetworkAccessManager doesn't overwrite a user defined Host header
+    QByteArray hostHeader = url.port() > 0 ? QString("%1:%2").arg(host).arg(url.port()).toUtf8() : host.toUtf8();
+    request->networkRequest.setRawHeader("Host", hostHeader);
+
+    url.setHost(address.toString());
+    request->networkRequest.setUrl(url);
+    request->cachedHost = host;
+}
+
+void RequestDispatcher::checkConnectionError(const WebhookRequest *request, QNetworkReply *reply) {
+    if (request->cachedHost.isEmpty() || !m_hostCache) {
+        return;
+    }
+
+    switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::HostNotFoundError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::UnknownNetworkError:
+            // the device might have a new address
+            m_hostCache->invalidate(request->cachedHost);
+            break;
+        default:
+            break;
+    }
+}
+
+QNetworkReply *RequestDispatcher::publishMqttMessage(WebhookRequest *request) {
+#ifdef WEBHOOK_MQTT
+    if (m_mqtt) {
+        return m_mqtt->publish(request->networkRequest, request->body, request->webhookCommand->qos,
+                               request->webhookCommand->retain);
+    }
+#endif
+    qCWarning(CLASS_LC) << "MQTT broker not configured, ignoring command:"
+                        << request->networkRequest.url().toString();
+    return nullptr;
+}
+
+RequestMetrics *RequestDispatcher::metricsSeries(const WebhookRequest *request) const {
+    // the original host name is used for cached host addresses, MQTT messages share the broker connection
+    QString host = request->cachedHost;
+    if (host.isEmpty()) {
+        QUrl url = request->networkRequest.url();
+        host = url.host().isEmpty() ? url.scheme() : url.host();
+    }
+    return m_metrics->series(host, requestType(request));
+}
+
+RequestMetrics *RequestDispatcher::entityMetricsSeries(const WebhookRequest *request) const {
+    return request->webhookEntity ? m_metrics->entitySeries(request->webhookEntity->id, requestType(request))
+                                  : nullptr;
+}
+
+Metrics::RequestType RequestDispatcher::requestType(const WebhookRequest *request) {
+    return request->command < 0 ? Metrics::STATUS : Metrics::COMMAND;
+}
+
+void RequestDispatcher::recordSent(WebhookRequest *request, QNetworkReply *reply, qint64 sentAt) {
+    if (m_metrics) {
+        RequestMetrics *seriesList[] = {metricsSeries(request), entityMetricsSeries(request)};
+        for (RequestMetrics *series : seriesList) {
+            if (!series) {
+                continue;
+            }
+            series->sent.fetchAndAddRelaxed(1);
+            series->bytesOut.fetchAndAddRelaxed(static_cast<quint64>(request->body.size()));
+            if (reply) {
+                series->inFlight.fetchAndAddRelaxed(1);
+            } else {
+                series->failed.fetchAndAddRelaxed(1);
+            }
+        }
+    }
+    if (!reply) {
+        return;
+    }
+
+    request->sentAt = sentAt;
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, this, [request] {
+        if (request->firstByteAt == 0) {
+            request->firstByteAt = Metrics::now();
+        }
+    });
+}
+
+void RequestDispatcher::recordFinished(const WebhookRequest *request, QNetworkReply *reply) {
+    if (!m_metrics || request->sentAt == 0) {
+        return;
+    }
+
+    qint64 finishedAt = Metrics::now();
+    // the body has either been read while receiving or is still available in the reply
+    qint64 bytesIn = request->response.isActive() ? request->response.wireBytes() : reply->bytesAvailable();
+
+    RequestMetrics *seriesList[] = {metricsSeries(request), entityMetricsSeries(request)};
+    for (RequestMetrics *series : seriesList) {
+        if (!series) {
+            continue;
+        }
+        series->inFlight.fetchAndSubRelaxed(1);
+        series->total.record((finishedAt - request->sentAt) / 1000);
+        if (request->firstByteAt > 0) {
+            series->firstByte.record((request->firstByteAt - request->sentAt) / 1000);
+        }
+        series->bytesIn.fetchAndAddRelaxed(static_cast<quint64>(qMax(bytesIn, qint64(0))));
+
+        switch (reply->error()) {
+            case QNetworkReply::NoError:
+                series->completed.fetchAndAddRelaxed(1);
+                break;
+            // an HTTP request aborted after the request timeout, or a timed out socket or MQTT request
+            case QNetworkReply::TimeoutError:
+            case QNetworkReply::OperationCanceledError:
+                series->timedOut.fetchAndAddRelaxed(1);
+                break;
+            default:
+                series->failed.fetchAndAddRelaxed(1);
+        }
+    }
+}
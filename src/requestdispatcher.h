@@ -0,0 +1,204 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QVariantMap>
+
+#include <functional>
+
+#include "hostcache.h"
+#include "metrics.h"
+#include "sockettransport.h"
+#include "webhookrequest.h"
+
+class MqttTransport;
+
+/**
+ * @brief Sends webhook requests with the transport of the command: HTTP, MQTT or a raw socket.
+ * @details Shared by command, status and scene requests. Each request gets a sequence number, HTTP requests use the
+ * cached host address and the response body is decoded while it is arriving if compression is accepted.
+ *
+ * HTTP requests are sent in two lanes: commands are sent immediately, status polls are queued per host and only sent
+ * while no command to the same host is in flight. The polls in flight per host are limited, so a command always finds
+ * a free connection of QNetworkAccessManager instead of waiting behind a poll burst.
+ */
+class RequestDispatcher : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Lane { COMMAND_LANE, POLL_LANE, LANES };
+
+    /**
+     * @brief Called with the reply when a queued poll has been sent, or with null if it could not be sent or has been
+     * dropped. The caller must release the request in this case.
+     */
+    typedef std::function<void(QNetworkReply*)> SentFunction;
+
+    explicit RequestDispatcher(QNetworkAccessManager* networkManager, QObject* parent = nullptr);
+
+    void setAcceptCompression(bool enabled) { m_acceptCompression = enabled; }
+    bool acceptCompression() const { return m_acceptCompression; }
+
+    /**
+     * @brief Sets the optional host name resolution cache. Ownership is not transferred.
+     */
+    void setHostCache(HostCache* hostCache) { m_hostCache = hostCache; }
+    void setSocketTransport(SocketTransport* socketTransport) { m_socketTransport = socketTransport; }
+    void setMqttTransport(MqttTransport* mqtt) { m_mqtt = mqtt; }
+
+    /**
+     * @brief Sets the optional request metrics. Ownership is not transferred.
+     */
+    void setMetrics(Metrics* metrics) { m_metrics = metrics; }
+
+    /**
+     * @brief Records the send and response header timestamps of the requests for tracing, also if metrics are
+     * disabled.
+     */
+    void setTracing(bool enabled) { m_tracing = enabled; }
+
+    /**
+     * @brief Sets the maximum number of polls in flight per host. Should be less than the 6 connections per host of
+     * QNetworkAccessManager to keep a connection free for commands.
+     */
+    void setMaxPollsPerHost(int max) { m_maxPollsPerHost = qMax(1, max); }
+
+    /**
+     * @brief Sets the maximum number of queued polls of all hosts. Further polls are dropped.
+     */
+    void setMaxQueuedPolls(int max) { m_maxQueuedPolls = qMax(0, max); }
+
+    /**
+     * @brief Sets the timeout of HTTP requests in milliseconds, 0 disables the timeout.
+     * @details A request without a response within the timeout is aborted and finishes with OperationCanceledError,
+     * so a hung device doesn't block the lanes of its host. Uses the transfer timeout of QNetworkRequest with Qt 5.15
+     * or newer, where the timeout restarts whenever data is transferred.
+     */
+    void setRequestTimeout(int msec) { m_requestTimeout = qMax(0, msec); }
+    int  requestTimeout() const { return m_requestTimeout; }
+
+    /**
+     * @brief Sends the request and assigns its sequence number.
+     * @return The reply, or null if the request is null or cannot be sent. Ownership is passed to the caller.
+     */
+    QNetworkReply* send(WebhookRequest* request);
+
+    /**
+     * @brief Sends the request in the poll lane: immediately if the host has no command and less than the maximum
+     * number of polls in flight, otherwise when the host becomes idle.
+     * @details A poll is dropped if a poll of the same entity is already queued or the queue is full. MQTT and socket
+     * requests are sent immediately.
+     */
+    void sendPoll(WebhookRequest* request, const SentFunction& sent);
+
+    /**
+     * @brief Drops all queued polls, e.g. when entering standby.
+     */
+    void dropQueuedPolls();
+
+    /**
+     * @brief Completes the response of a finished reply: reads the remaining data, invalidates the cached host
+     * address on connection errors and records the metrics. Must be called once before the reply is handled.
+     */
+    void finish(WebhookRequest* request, QNetworkReply* reply);
+
+    /**
+     * @brief Sequence number of the last sent request.
+     */
+    quint64 sequence() const { return m_requestSequence; }
+
+    /**
+     * @brief Returns the accumulated response compression statistics: bytes on the wire, decoded bytes and decoding
+     * time.
+     */
+    QVariantMap compressionStats() const;
+
+    /**
+     * @brief Returns the statistics per lane: sent and dropped requests, queued polls and the queue wait time.
+     */
+    QVariantMap laneStats() const;
+
+ private:
+    struct QueuedPoll {
+        WebhookRequest* request;
+        SentFunction    sent;
+        qint64          queuedAt;
+    };
+
+    /**
+     * @brief Requests in flight and queued polls of a host.
+     */
+    struct HostLanes {
+        HostLanes() : commands(0), polls(0) {}
+
+        int                commands;
+        int                polls;
+        QQueue<QueuedPoll> queue;
+    };
+
+    static bool    isHttp(const WebhookRequest* request);
+    static QString laneHost(const WebhookRequest* request);
+    void           sendQueuedPolls(const QString& host);
+    void           startPoll(WebhookRequest* request, const SentFunction& sent, qint64 queuedAt);
+
+ private:
+    QNetworkReply*  sendRequest(WebhookRequest* request);
+    void            useCachedHostAddress(WebhookRequest* request);
+    void            readResponseData(WebhookRequest* request, QNetworkReply* reply);
+    void            checkConnectionError(const WebhookRequest* request, QNetworkReply* reply);
+    QNetworkReply*  publishMqttMessage(WebhookRequest* request);
+    RequestMetrics* metricsSeries(const WebhookRequest* request) const;
+    RequestMetrics* entityMetricsSeries(const WebhookRequest* request) const;
+    void            recordSent(WebhookRequest* request, QNetworkReply* reply, qint64 sentAt);
+    void            recordFinished(const WebhookRequest* request, QNetworkReply* reply);
+
+    static Metrics::RequestType requestType(const WebhookRequest* request);
+
+ private:
+    QNetworkAccessManager* m_networkManager;
+    HostCache*             m_hostCache;
+    SocketTransport*       m_socketTransport;
+    MqttTransport*         m_mqtt;
+    Metrics*               m_metrics;
+    bool                   m_tracing;
+    bool                   m_acceptCompression;
+    quint64                m_requestSequence;
+    qint64                 m_responseWireBytes;
+    qint64                 m_responseDecodedBytes;
+    qint64                 m_responseDecodeTime;
+
+    int                       m_requestTimeout;
+    int                       m_maxPollsPerHost;
+    int                       m_maxQueuedPolls;
+    int                       m_queuedPolls;
+    QHash<QString, HostLanes> m_hosts;
+    quint64                   m_laneSent[LANES];
+    quint64                   m_laneDropped[LANES];
+    LatencyHistogram          m_laneWait[LANES];
+};
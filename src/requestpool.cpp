@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "requestpool.h"
+
+RequestPool::RequestPool(int maxFree)
+    : m_maxFree(qMax(0, maxFree)), m_inUse(0), m_highWaterMark(0), m_allocations(0), m_reuses(0) {
+    m_free.reserve(m_maxFree);
+}
+
+RequestPool::~RequestPool() { qDeleteAll(m_free); }
+
+WebhookRequest *RequestPool::acquire() {
+    WebhookRequest *request;
+    if (m_free.isEmpty()) {
+        request = new WebhookRequest();
+        m_allocations++;
+    } else {
+        request = m_free.takeLast();
+        m_reuses++;
+    }
+
+    m_inUse++;
+    m_highWaterMark = qMax(m_highWaterMark, m_inUse);
+    return request;
+}
+
+void RequestPool::release(WebhookRequest *request) {
+    if (!request) {
+        return;
+    }
+
+    m_inUse--;
+    if (m_free.size() >= m_maxFree) {
+        delete request;
+        return;
+    }
+
+    request->reset();
+    m_free.append(request);
+}
+
+void RequestPool::setMaxFree(int maxFree) {
+    m_maxFree = qMax(0, maxFree);
+    while (m_free.size() > m_maxFree) {
+        delete m_free.takeLast();
+    }
+}
+
+QVariantMap RequestPool::stats() const {
+    QVariantMap stats;
+    stats.insert("size", m_free.size());
+    stats.insert("in_use", m_inUse);
+    stats.insert("high_water_mark", m_highWaterMark);
+    stats.insert("allocations", m_allocations);
+    stats.insert("reuses", m_reuses);
+    return stats;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QVariantMap>
+#include <QVector>
+
+#include "webhookrequest.h"
+
+/**
+ * @brief Free-list of WebhookRequest objects, reused for command, status and subscription requests.
+ * @details Requests are released directly when the reply has been handled instead of a deferred deletion. Up to
+ * maxFree released requests are kept for reuse, additional ones are deleted.
+ */
+class RequestPool {
+ public:
+    explicit RequestPool(int maxFree = 64);
+    ~RequestPool();
+
+    RequestPool(const RequestPool&) = delete;
+    RequestPool& operator=(const RequestPool&) = delete;
+
+    /**
+     * @brief Returns a reset request from the free-list, or a newly allocated request if the list is empty.
+     */
+    WebhookRequest* acquire();
+
+    /**
+     * @brief Returns the request to the free-list. The request must not be used afterwards.
+     */
+    void release(WebhookRequest* request);
+
+    void setMaxFree(int maxFree);
+
+    /**
+     * @brief Number of requests available in the free-list.
+     */
+    int size() const { return m_free.size(); }
+
+    /**
+     * @brief Number of acquired requests which have not been released yet.
+     */
+    int inUse() const { return m_inUse; }
+
+    /**
+     * @brief Maximum number of requests in use at the same time.
+     */
+    int highWaterMark() const { return m_highWaterMark; }
+
+    /**
+     * @brief Returns the pool statistics: size, in use, high-water mark, allocations and reuses.
+     */
+    QVariantMap stats() const;
+
+ private:
+    QVector<WebhookRequest*> m_free;
+    int                      m_maxFree;
+    int                      m_inUse;
+    int                      m_highWaterMark;
+    qint64                   m_allocations;
+    qint64                   m_reuses;
+};
@@ -0,0 +1,255 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "sockettransport.h"
+
+#include <QHostInfo>
+#include <QLoggingCategory>
+#include <QtEndian>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.socket");
+
+// default timeout in ms waiting for a framed tcp response
+static const int RESPONSE_TIMEOUT = 5000;
+// maximum size of a framed tcp response
+static const int MAX_FRAME_SIZE = 1024 * 1024;
+
+SocketTransport::SocketTransport(QObject *parent) : QObject(parent), m_responseTimeout(RESPONSE_TIMEOUT) {}
+
+SocketTransport::~SocketTransport() { closeAll(); }
+
+bool SocketTransport::isSocketUrl(const QUrl &url) { return url.scheme() == "udp" || url.scheme() == "tcp"; }
+
+QNetworkReply *SocketTransport::send(const QNetworkRequest &request, const QByteArray &payload,
+                                     SocketFraming::Enum framing) {
+    TransportReply *reply = new TransportReply(request);
+    QUrl            url = request.url();
+
+    if (url.host().isEmpty() || url.port() <= 0) {
+        reply->finishWithError(QNetworkReply::ProtocolInvalidOperationError,
+                               "Host and port required in socket url: " + url.toString());
+    } else if (url.scheme() == "udp") {
+        sendDatagram(reply, url, payload);
+    } else {
+        Connection *conn = connection(url);
+        conn->queue.enqueue({reply, payload, framing});
+        if (conn->socket->state() == QAbstractSocket::ConnectedState) {
+            writeNext(conn);
+        }
+    }
+
+    return reply;
+}
+
+void SocketTransport::closeAll() {
+    const QList<Connection *> connections = m_connections.values();
+    for (Connection *conn : connections) {
+        closeConnection(conn, QNetworkReply::OperationCanceledError, "Connection closed");
+    }
+}
+
+void SocketTransport::sendDatagram(TransportReply *reply, const QUrl &url, const QByteArray &payload) {
+    QString      host = url.host();
+    quint16      port = static_cast<quint16>(url.port());
+    QHostAddress address(host);
+    if (address.isNull()) {
+        address = m_addresses.value(host);
+    }
+
+    if (!address.isNull()) {
+        if (m_udpSocket.writeDatagram(payload, address, port) < 0) {
+            reply->finishWithError(QNetworkReply::UnknownNetworkError, m_udpSocket.errorString());
+        } else {
+            reply->finish();
+        }
+        return;
+    }
+
+    // resolve the host name once, datagrams require an address
+    QPointer<TransportReply> replyPtr(reply);
+    QHostInfo::lookupHost(host, this, [this, replyPtr, url, payload](const QHostInfo &hostInfo) {
+        if (!replyPtr) {
+            return;
+        }
+        if (hostInfo.error() != QHostInfo::NoError || hostInfo.addresses().isEmpty()) {
+            replyPtr->finishWithError(QNetworkReply::HostNotFoundError, hostInfo.errorString());
+            return;
+        }
+        m_addresses.insert(url.host(), hostInfo.addresses().first());
+        sendDatagram(replyPtr, url, payload);
+    });
+}
+
+SocketTransport::Connection *SocketTransport::connection(const QUrl &url) {
+    QString     key = QString("%1:%2").arg(url.host()).arg(url.port());
+    Connection *conn = m_connections.value(key);
+    if (conn) {
+        return conn;
+    }
+
+    conn = new Connection{key, new QTcpSocket(this), new QTimer(this), QByteArray(), {}, false};
+    conn->responseTimer->setSingleShot(true);
+    m_connections.insert(key, conn);
+
+    QObject::connect(conn->responseTimer, &QTimer::timeout, this, [this, conn] {
+        closeConnection(conn, QNetworkReply::TimeoutError, "Timeout waiting for response");
+    });
+    QObject::connect(conn->socket, &QTcpSocket::connected, this, [this, conn] {
+        qCDebug(CLASS_LC) << "Connected to" << conn->key;
+        // send commands immediately, don't wait for a full segment
+        conn->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        writeNext(conn);
+    });
+    QObject::connect(conn->socket, &QTcpSocket::readyRead, this, [this, conn] { readResponse(conn); });
+    QObject::connect(conn->socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+                     [this, conn](QAbstractSocket::SocketError socketError) {
+                         QNetworkReply::NetworkError error;
+                         switch (socketError) {
+                             case QAbstractSocket::ConnectionRefusedError:
+                                 error = QNetworkReply::ConnectionRefusedError;
+                                 break;
+                             case QAbstractSocket::RemoteHostClosedError:
+                                 error = QNetworkReply::RemoteHostClosedError;
+                                 break;
+                             case QAbstractSocket::HostNotFoundError:
+                                 error = QNetworkReply::HostNotFoundError;
+                                 break;
+                             case QAbstractSocket::SocketTimeoutError:
+                                 error = QNetworkReply::TimeoutError;
+                                 break;
+                             default:
+                                 error = QNetworkReply::UnknownNetworkError;
+                         }
+                         closeConnection(conn, error, conn->socket->errorString());
+                     });
+
+    qCDebug(CLASS_LC) << "Connecting to" << key;
+    conn->socket->connectToHost(url.host(), static_cast<quint16>(url.port()));
+    return conn;
+}
+
+// Returns false if the connection has been closed because of a write error.
+bool SocketTransport::writeNext(Connection *conn) {
+    while (!conn->awaitingResponse && !conn->queue.isEmpty()) {
+        if (!conn->queue.head().reply) {
+            // reply has already been deleted
+            conn->queue.dequeue();
+            continue;
+        }
+
+        const PendingCommand &command = conn->queue.head();
+        if (conn->socket->write(command.payload) < 0) {
+            closeConnection(conn, QNetworkReply::UnknownNetworkError, conn->socket->errorString());
+            return false;
+        }
+
+        if (command.framing == SocketFraming::NONE) {
+            conn->queue.dequeue().reply->finish();
+        } else {
+            conn->awaitingResponse = true;
+            conn->responseTimer->start(m_responseTimeout);
+        }
+    }
+    return true;
+}
+
+void SocketTransport::readResponse(Connection *conn) {
+    conn->buffer.append(conn->socket->readAll());
+
+    while (conn->awaitingResponse) {
+        QByteArray frame;
+        if (!takeFrame(conn->queue.head().framing, &conn->buffer, &frame)) {
+            if (conn->buffer.size() > MAX_FRAME_SIZE) {
+                closeConnection(conn, QNetworkReply::ProtocolFailure, "Response frame too large");
+            }
+            return;
+        }
+
+        conn->awaitingResponse = false;
+        conn->responseTimer->stop();
+
+        PendingCommand command = conn->queue.dequeue();
+        if (command.reply) {
+            command.reply->setResponseData(frame);
+            command.reply->finish();
+        }
+        if (!writeNext(conn)) {
+            return;
+        }
+    }
+
+    if (!conn->buffer.isEmpty()) {
+        qCDebug(CLASS_LC) << "Ignoring unsolicited data from" << conn->key << ":" << conn->buffer.size() << "bytes";
+        conn->buffer.clear();
+    }
+}
+
+bool SocketTransport::takeFrame(SocketFraming::Enum framing, QByteArray *buffer, QByteArray *frame) {
+    if (framing == SocketFraming::LINE) {
+        int end = buffer->indexOf('\n');
+        if (end < 0) {
+            return false;
+        }
+        *frame = buffer->left(end);
+        if (frame->endsWith('\r')) {
+            frame->chop(1);
+        }
+        buffer->remove(0, end + 1);
+        return true;
+    }
+
+    if (framing == SocketFraming::LENGTH) {
+        if (buffer->size() < 4) {
+            return false;
+        }
+        quint32 length = qFromBigEndian<quint32>(buffer->constData());
+        // an oversized frame is never complete and fails once the buffer exceeds the maximum frame size
+        if (length > static_cast<quint32>(MAX_FRAME_SIZE) || static_cast<quint32>(buffer->size()) < 4 + length) {
+            return false;
+        }
+        *frame = buffer->mid(4, static_cast<int>(length));
+        buffer->remove(0, 4 + static_cast<int>(length));
+        return true;
+    }
+
+    return false;
+}
+
+void SocketTransport::closeConnection(Connection *conn, QNetworkReply::NetworkError error,
+                                      const QString &errorString) {
+    qCDebug(CLASS_LC) << "Closing connection" << conn->key << ":" << errorString;
+    m_connections.remove(conn->key);
+
+    conn->socket->disconnect(this);
+    conn->socket->abort();
+    conn->socket->deleteLater();
+    conn->responseTimer->disconnect(this);
+    conn->responseTimer->deleteLater();
+
+    for (const PendingCommand &command : qAsConst(conn->queue)) {
+        if (command.reply) {
+            command.reply->finishWithError(error, errorString);
+        }
+    }
+
+    delete conn;
+}
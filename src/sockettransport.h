@@ -0,0 +1,101 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QUrl>
+
+#include "socketframing.h"
+#include "transportreply.h"
+
+/**
+ * @brief Raw socket command transport for udp:// and tcp:// command urls.
+ * @details UDP payloads are sent as single fire-and-forget datagrams. TCP commands use one persistent connection per
+ * host and port. Commands on the same connection are sent in order; a command with response framing waits for the
+ * framed response before the next command is sent.
+ */
+class SocketTransport : public QObject {
+    Q_OBJECT
+
+ public:
+    explicit SocketTransport(QObject* parent = nullptr);
+    ~SocketTransport() override;
+
+    /**
+     * @brief Returns true if the url is a udp:// or tcp:// url.
+     */
+    static bool isSocketUrl(const QUrl& url);
+
+    /**
+     * @brief Sends the payload to the host and port of the request url.
+     * @return The reply which is finished when the payload has been sent, or the framed response has been received.
+     * Ownership is passed to the caller.
+     */
+    QNetworkReply* send(const QNetworkRequest& request, const QByteArray& payload, SocketFraming::Enum framing);
+
+    /**
+     * @brief Closes all persistent tcp connections. Pending commands are finished with an error.
+     */
+    void closeAll();
+
+    void setResponseTimeout(int msec) { m_responseTimeout = msec; }
+
+ private:
+    struct PendingCommand {
+        QPointer<TransportReply> reply;
+        QByteArray               payload;
+        SocketFraming::Enum      framing;
+    };
+
+    struct Connection {
+        QString                key;
+        QTcpSocket*            socket;
+        QTimer*                responseTimer;
+        QByteArray             buffer;
+        QQueue<PendingCommand> queue;
+        bool                   awaitingResponse;
+    };
+
+    void        sendDatagram(TransportReply* reply, const QUrl& url, const QByteArray& payload);
+    Connection* connection(const QUrl& url);
+    bool        writeNext(Connection* connection);
+    void        readResponse(Connection* connection);
+    bool        takeFrame(SocketFraming::Enum framing, QByteArray* buffer, QByteArray* frame);
+    void        closeConnection(Connection* connection, QNetworkReply::NetworkError error, const QString& errorString);
+
+    QUdpSocket                   m_udpSocket;
+    QHash<QString, QHostAddress> m_addresses;
+    QHash<QString, Connection*>  m_connections;
+    int                          m_responseTimeout;
+};
@@ -1,6 +1,6 @@
 TEMPLATE  = lib
 CONFIG   += c++14 plugin
-QT       += core quick
+QT       += core quick websockets
 
 # Plugin VERSION
 GIT_HASH = "$$system(git log -1 --format="%H")"
@@ -62,24 +62,80 @@ QMAKE_SUBSTITUTES += webhook.json.in ../version.txt.in
 INCLUDEPATH += $$OUT_PWD
 HEADERS  += webhook.h \
     blindhandler.h \
+    callbackserver.h \
     climatehandler.h \
+    compression.h \
+    configcache.h \
+    configstore.h \
     entityhandler.h \
+    hostcache.h \
     httpmethod.h \
     jsonpath.h \
     lighthandler.h \
+    metrics.h \
+    placeholders.h \
+    pollscheduler.h \
+    requestbatch.h \
+    requestdispatcher.h \
+    requestpool.h \
+    socketframing.h \
+    sockettransport.h \
+    stallwatchdog.h \
+    statussubscription.h \
+    timingwheel.h \
+    tracer.h \
     switchhandler.h \
+    transportreply.h \
+    undorecord.h \
+    valuetransform.h \
     webhookcommand.h \
     webhookentity.h \
     webhookrequest.h
 SOURCES  += webhook.cpp \
     blindhandler.cpp \
+    callbackserver.cpp \
     climatehandler.cpp \
+    compression.cpp \
+    configcache.cpp \
+    configstore.cpp \
     entityhandler.cpp \
+    hostcache.cpp \
     jsonpath.cpp \
     lighthandler.cpp \
-    switchhandler.cpp
+    metrics.cpp \
+    placeholders.cpp \
+    pollscheduler.cpp \
+    requestbatch.cpp \
+    requestdispatcher.cpp \
+    requestpool.cpp \
+    sockettransport.cpp \
+    stallwatchdog.cpp \
+    statussubscription.cpp \
+    timingwheel.cpp \
+    tracer.cpp \
+    switchhandler.cpp \
+    transportreply.cpp \
+    valuetransform.cpp
 TARGET    = webhook
 
+# zlib for incremental response decoding and request body compression
+win32 {
+    # use the zlib bundled with Qt
+    INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+} else {
+    LIBS += -lz
+}
+
+# optional MQTT transport
+qtHaveModule(mqtt) {
+    QT += mqtt
+    DEFINES += WEBHOOK_MQTT
+    HEADERS += mqtttransport.h
+    SOURCES += mqtttransport.cpp
+} else {
+    warning("Qt MQTT module not found: MQTT transport will NOT be available!")
+}
+
 # Configure destination path. DESTDIR is set in qmake-destination-path.pri
 DESTDIR = $$DESTDIR/plugins
 OBJECTS_DIR = $$PWD/build/$$DESTINATION_PATH/obj
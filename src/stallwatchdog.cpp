@@ -0,0 +1,135 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "stallwatchdog.h"
+
+#include <QLoggingCategory>
+#include <algorithm>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.watchdog");
+
+StallWatchdog::StallWatchdog(qint64 budget, qint64 warningInterval, int window)
+    : m_budget(budget), m_warningInterval(warningInterval), m_windowSize(qMax(window, 1)), m_sections(SECTIONS) {}
+
+void StallWatchdog::record(Section section, qint64 duration, const QString &entityId) {
+    SectionStats *stats = &m_sections[section];
+
+    if (stats->window.size() < m_windowSize) {
+        stats->window.append(duration);
+    } else {
+        stats->window[stats->next] = duration;
+    }
+    stats->next = (stats->next + 1) % m_windowSize;
+    stats->count++;
+
+    if (duration > stats->max) {
+        stats->max = duration;
+        stats->maxEntity = entityId;
+    }
+
+    if (duration <= m_budget * 1000) {
+        return;
+    }
+
+    stats->overBudget++;
+    if (duration > stats->slowest) {
+        stats->slowest = duration;
+        stats->slowestEntity = entityId;
+    }
+
+    qint64 now = Metrics::now() / 1000000;
+    if (stats->lastWarning == 0 || now - stats->lastWarning >= m_warningInterval) {
+        warn(section, stats, now);
+    } else {
+        stats->suppressed++;
+    }
+}
+
+void StallWatchdog::warn(Section section, SectionStats *stats, qint64 now) {
+    QString entity;
+    if (!stats->slowestEntity.isEmpty()) {
+        entity = QStringLiteral(" in entity %1").arg(stats->slowestEntity);
+    }
+    qCWarning(CLASS_LC).noquote() << QStringLiteral("Event loop blocked for %1 ms by %2%3 (budget: %4 ms, %5 runs over "
+                                                   "budget since the last warning)")
+                                         .arg(stats->slowest / 1000000.0, 0, 'f', 1)
+                                         .arg(sectionName(section), entity)
+                                         .arg(m_budget / 1000.0)
+                                         .arg(stats->suppressed + 1);
+
+    stats->lastWarning = now;
+    stats->slowest = 0;
+    stats->slowestEntity.clear();
+    stats->suppressed = 0;
+}
+
+QVariantMap StallWatchdog::stats() const {
+    QVariantMap map;
+    map.insert("budget_ms", m_budget / 1000.0);
+
+    for (int i = 0; i < SECTIONS; i++) {
+        const SectionStats &stats = m_sections.at(i);
+
+        // percentiles are only calculated on request, recording must stay cheap
+        QVector<qint64> sorted = stats.window;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](int p) {
+            if (sorted.isEmpty()) {
+                return 0.0;
+            }
+            int rank = qMin((p * sorted.size() + 99) / 100, sorted.size());
+            return sorted.at(qMax(rank - 1, 0)) / 1000000.0;
+        };
+
+        QVariantMap section;
+        section.insert("count", stats.count);
+        section.insert("over_budget", stats.overBudget);
+        section.insert("max_ms", stats.max / 1000000.0);
+        if (!stats.maxEntity.isEmpty()) {
+            section.insert("max_entity", stats.maxEntity);
+        }
+        section.insert("p50_ms", percentile(50));
+        section.insert("p95_ms", percentile(95));
+        section.insert("p99_ms", percentile(99));
+        section.insert("window_max_ms", sorted.isEmpty() ? 0.0 : sorted.last() / 1000000.0);
+        map.insert(sectionName(static_cast<Section>(i)), section);
+    }
+
+    return map;
+}
+
+QString StallWatchdog::sectionName(Section section) {
+    switch (section) {
+        case STATUS_UPDATE:
+            return QStringLiteral("status_update");
+        case COMMAND_REPLY:
+            return QStringLiteral("command_reply");
+        case STATUS_REPLY:
+            return QStringLiteral("status_reply");
+        case CALLBACK:
+            return QStringLiteral("callback");
+        case UPDATE_ENTITY:
+            return QStringLiteral("update_entity");
+        default:
+            return QString();
+    }
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include "metrics.h"
+
+/**
+ * @brief Measures the time spent in the event loop by polling, reply handling and entity updates.
+ * @details Every section keeps the durations of the last `window` runs for rolling percentiles. If a run exceeds the
+ * budget, a warning with the slowest entity since the last warning is logged at most once per warning interval and
+ * section. Sections are recorded in the integration thread.
+ */
+class StallWatchdog {
+ public:
+    enum Section { STATUS_UPDATE, COMMAND_REPLY, STATUS_REPLY, CALLBACK, UPDATE_ENTITY, SECTIONS };
+
+    /**
+     * @param budget Budget per event loop slice in us.
+     * @param warningInterval Minimal interval between two warnings of the same section in ms.
+     * @param window Number of runs per section for the rolling statistics.
+     */
+    StallWatchdog(qint64 budget, qint64 warningInterval, int window = 256);
+
+    StallWatchdog(const StallWatchdog&) = delete;
+    StallWatchdog& operator=(const StallWatchdog&) = delete;
+
+    qint64 budget() const { return m_budget; }
+
+    /**
+     * @brief Records a run of the section.
+     * @param duration Duration in ns.
+     * @param entityId Entity of the run, empty if the run is not entity specific.
+     */
+    void record(Section section, qint64 duration, const QString& entityId = QString());
+
+    /**
+     * @brief Number of runs of the section exceeding the budget.
+     */
+    quint64 overBudget(Section section) const { return m_sections.at(section).overBudget; }
+
+    /**
+     * @brief Returns the statistics per section: runs, runs over budget, maximum and the rolling percentiles.
+     */
+    QVariantMap stats() const;
+
+    static QString sectionName(Section section);
+
+ private:
+    struct SectionStats {
+        SectionStats() : next(0), count(0), overBudget(0), max(0), lastWarning(0), slowest(0), suppressed(0) {}
+
+        QVector<qint64> window;
+        int             next;
+        quint64         count;
+        quint64         overBudget;
+        qint64          max;
+        QString         maxEntity;
+        qint64          lastWarning;
+        /**
+         * @brief Slowest run over budget since the last warning.
+         */
+        qint64  slowest;
+        QString slowestEntity;
+        int     suppressed;
+    };
+
+    void warn(Section section, SectionStats* stats, qint64 now);
+
+    qint64                m_budget;
+    qint64                m_warningInterval;
+    int                   m_windowSize;
+    QVector<SectionStats> m_sections;
+};
+
+/**
+ * @brief Records the lifetime of the scope as a run of a StallWatchdog section. Does nothing if the watchdog is null.
+ */
+class StallTimer {
+ public:
+    StallTimer(StallWatchdog* watchdog, StallWatchdog::Section section, const QString& entityId = QString())
+        : m_watchdog(watchdog), m_section(section), m_started(watchdog ? Metrics::now() : 0) {
+        if (watchdog) {
+            m_entityId = entityId;
+        }
+    }
+
+    ~StallTimer() {
+        if (m_watchdog) {
+            m_watchdog->record(m_section, Metrics::now() - m_started, m_entityId);
+        }
+    }
+
+    StallTimer(const StallTimer&) = delete;
+    StallTimer& operator=(const StallTimer&) = delete;
+
+ private:
+    StallWatchdog*         m_watchdog;
+    StallWatchdog::Section m_section;
+    qint64                 m_started;
+    QString                m_entityId;
+};
@@ -0,0 +1,288 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "statussubscription.h"
+
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+
+static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.subscription");
+
+// reconnect backoff in ms
+static const int BACKOFF_MIN = 1000;
+static const int BACKOFF_MAX = 60000;
+// a long-poll reply returned faster than this in ms didn't hold: the next poll is delayed by LONG_POLL_MIN_DELAY
+static const int LONG_POLL_MIN_HOLD = 1000;
+static const int LONG_POLL_MIN_DELAY = 1000;
+
+StatusSubscription::StatusSubscription(Transport transport, const QNetworkRequest &request, const QByteArray &message,
+                                       QNetworkAccessManager *networkManager, QObject *parent)
+    : QObject(parent),
+      m_transport(transport),
+      m_request(request),
+      m_message(message),
+      m_networkManager(networkManager),
+      m_reply(nullptr),
+      m_webSocket(nullptr),
+      m_backoff(BACKOFF_MIN),
+      m_active(false) {
+    m_reconnectTimer.setSingleShot(true);
+    QObject::connect(&m_reconnectTimer, &QTimer::timeout, this, &StatusSubscription::open);
+
+    if (m_transport == SSE) {
+        m_request.setRawHeader("Accept", "text/event-stream");
+        m_request.setRawHeader("Cache-Control", "no-cache");
+    }
+}
+
+StatusSubscription::~StatusSubscription() { stop(); }
+
+StatusSubscription::Transport StatusSubscription::transportFromString(const QString &transport, bool *ok) {
+    if (ok) {
+        *ok = true;
+    }
+
+    QString value = transport.toLower();
+    if (value == "sse") {
+        return SSE;
+    }
+    if (value == "long_poll") {
+        return LONG_POLL;
+    }
+    if (value == "websocket") {
+        return WEBSOCKET;
+    }
+
+    if (ok) {
+        *ok = false;
+    }
+    return SSE;
+}
+
+void StatusSubscription::start() {
+    if (m_active) {
+        return;
+    }
+
+    m_active = true;
+    m_backoff = BACKOFF_MIN;
+    open();
+}
+
+void StatusSubscription::stop() {
+    m_active = false;
+    m_reconnectTimer.stop();
+    closeConnection();
+}
+
+void StatusSubscription::open() {
+    if (!m_active) {
+        return;
+    }
+
+    qCDebug(CLASS_LC) << "Connecting subscription:" << m_request.url().toString();
+
+    if (m_transport == WEBSOCKET) {
+        openWebSocket();
+    } else {
+        openHttp();
+    }
+}
+
+void StatusSubscription::openHttp() {
+    m_sseBuffer.clear();
+    m_sseData.clear();
+
+    QNetworkRequest request(m_request);
+    if (m_transport == SSE && !m_sseLastEventId.isEmpty()) {
+        request.setRawHeader("Last-Event-ID", m_sseLastEventId);
+    }
+
+    if (m_message.isEmpty()) {
+        m_reply = m_networkManager->get(request);
+    } else {
+        m_reply = m_networkManager->post(request, m_message);
+    }
+    m_requestTimer.start();
+
+    QNetworkReply *reply = m_reply;
+    if (m_transport == SSE) {
+        QObject::connect(reply, &QNetworkReply::metaDataChanged, this, &StatusSubscription::onConnected);
+        QObject::connect(reply, &QNetworkReply::readyRead, this, &StatusSubscription::onHttpData);
+    }
+    QObject::connect(reply, &QNetworkReply::finished, this, &StatusSubscription::onHttpFinished);
+}
+
+void StatusSubscription::openWebSocket() {
+    if (!m_webSocket) {
+        m_webSocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+        QObject::connect(m_webSocket, &QWebSocket::connected, this, &StatusSubscription::onConnected);
+        QObject::connect(m_webSocket, &QWebSocket::disconnected, this, &StatusSubscription::scheduleReconnect);
+        // disconnected isn't emitted if the connection can't be established, e.g. refused or a TLS error
+        QObject::connect(m_webSocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this,
+                         &StatusSubscription::scheduleReconnect);
+        QObject::connect(m_webSocket, &QWebSocket::textMessageReceived, this,
+                         [this](const QString &message) { emit eventReceived(message.toUtf8()); });
+        QObject::connect(m_webSocket, &QWebSocket::binaryMessageReceived, this, &StatusSubscription::eventReceived);
+    }
+
+    m_webSocket->open(m_request);
+}
+
+void StatusSubscription::closeConnection() {
+    if (m_reply) {
+        QNetworkReply *reply = m_reply;
+        m_reply = nullptr;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+
+    if (m_webSocket) {
+        m_webSocket->disconnect(this);
+        m_webSocket->abort();
+        m_webSocket->deleteLater();
+        m_webSocket = nullptr;
+    }
+}
+
+void StatusSubscription::onConnected() {
+    if (m_reply && m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 300) {
+        return;
+    }
+
+    qCDebug(CLASS_LC) << "Subscription connected:" << m_request.url().toString();
+    m_backoff = BACKOFF_MIN;
+
+    if (m_transport == WEBSOCKET && !m_message.isEmpty()) {
+        m_webSocket->sendTextMessage(QString::fromUtf8(m_message));
+    }
+}
+
+void StatusSubscription::onHttpData() {
+    if (!m_reply) {
+        return;
+    }
+
+    m_sseBuffer.append(m_reply->readAll());
+
+    int start = 0;
+    int end;
+    while ((end = m_sseBuffer.indexOf('\n', start)) >= 0) {
+        QByteArray line = m_sseBuffer.mid(start, end - start);
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        parseSseLine(line);
+        start = end + 1;
+    }
+    m_sseBuffer.remove(0, start);
+}
+
+void StatusSubscription::parseSseLine(const QByteArray &line) {
+    // https://html.spec.whatwg.org/multipage/server-sent-events.html#event-stream-interpretation
+    if (line.isEmpty()) {
+        if (!m_sseData.isEmpty()) {
+            // remove trailing line feed of the last data line
+            m_sseData.chop(1);
+            emit eventReceived(m_sseData);
+            m_sseData.clear();
+        }
+        return;
+    }
+
+    if (line.startsWith(':')) {
+        // comment, e.g. keep-alive ping
+        return;
+    }
+
+    int        separator = line.indexOf(':');
+    QByteArray field = separator < 0 ? line : line.left(separator);
+    QByteArray value = separator < 0 ? QByteArray() : line.mid(separator + 1);
+    if (value.startsWith(' ')) {
+        value.remove(0, 1);
+    }
+
+    if (field == "data") {
+        m_sseData.append(value).append('\n');
+    } else if (field == "id") {
+        m_sseLastEventId = value;
+    } else if (field == "retry") {
+        bool ok;
+        int  retry = value.toInt(&ok);
+        if (ok && retry > 0) {
+            m_backoff = qBound(BACKOFF_MIN, retry, BACKOFF_MAX);
+        }
+    }
+}
+
+void StatusSubscription::onHttpFinished() {
+    QNetworkReply *reply = m_reply;
+    if (!reply) {
+        return;
+    }
+    m_reply = nullptr;
+    reply->deleteLater();
+
+    if (!m_active) {
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qCWarning(CLASS_LC) << "Subscription failed:" << m_request.url().toString() << "/" << reply->error() << "/"
+                            << reply->errorString();
+        scheduleReconnect();
+        return;
+    }
+
+    if (m_transport == LONG_POLL) {
+        m_backoff = BACKOFF_MIN;
+        QByteArray data = reply->readAll();
+        if (!data.isEmpty()) {
+            emit eventReceived(data);
+        }
+        if (data.isEmpty() || m_requestTimer.elapsed() < LONG_POLL_MIN_HOLD) {
+            // the device doesn't hold the request: don't hammer it in a tight request loop
+            m_reconnectTimer.start(LONG_POLL_MIN_DELAY);
+        } else {
+            // immediately wait for the next event
+            open();
+        }
+        return;
+    }
+
+    // server closed the event stream
+    scheduleReconnect();
+}
+
+void StatusSubscription::scheduleReconnect() {
+    if (!m_active || m_reconnectTimer.isActive()) {
+        return;
+    }
+
+    // add some jitter to avoid reconnecting all subscriptions at the same time
+    int delay = m_backoff + static_cast<int>(QRandomGenerator::global()->bounded(m_backoff / 5 + 1));
+    qCDebug(CLASS_LC) << "Reconnecting subscription in" << delay << "ms:" << m_request.url().toString();
+
+    m_backoff = qMin(m_backoff * 2, BACKOFF_MAX);
+    m_reconnectTimer.start(delay);
+}
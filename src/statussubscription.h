@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <QWebSocket>
+
+/**
+ * @brief Persistent status subscription over a single long-lived connection.
+ * @details Supported transports are Server-Sent Events, http long-polling and WebSocket. Every received event is
+ * emitted with eventReceived(). The connection is automatically re-established with an exponential backoff.
+ */
+class StatusSubscription : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Transport { SSE, LONG_POLL, WEBSOCKET };
+
+    /**
+     * @param transport Subscription transport.
+     * @param request Subscription request with url and headers.
+     * @param message Optional message: request body for long-polling, subscription message for WebSocket.
+     * @param networkManager Network access manager for http based transports.
+     */
+    StatusSubscription(Transport transport, const QNetworkRequest& request, const QByteArray& message,
+                       QNetworkAccessManager* networkManager, QObject* parent = nullptr);
+    ~StatusSubscription() override;
+
+    /**
+     * @brief Returns the transport for the given configuration value: "sse", "long_poll" or "websocket".
+     * @param ok Set to false if the transport is unknown.
+     */
+    static Transport transportFromString(const QString& transport, bool* ok = nullptr);
+
+    Transport transport() const { return m_transport; }
+    QUrl      url() const { return m_request.url(); }
+    bool      isActive() const { return m_active; }
+
+    void start();
+    void stop();
+
+ signals:
+    void eventReceived(const QByteArray& data);
+
+ private:
+    void open();
+    void openHttp();
+    void openWebSocket();
+    void closeConnection();
+
+    void onHttpData();
+    void onHttpFinished();
+    void onConnected();
+    void scheduleReconnect();
+
+    void parseSseLine(const QByteArray& line);
+
+    Transport              m_transport;
+    QNetworkRequest        m_request;
+    QByteArray             m_message;
+    QNetworkAccessManager* m_networkManager;
+    QNetworkReply*         m_reply;
+    QWebSocket*            m_webSocket;
+    QTimer                 m_reconnectTimer;
+    QElapsedTimer          m_requestTimer;
+    int                    m_backoff;
+    bool                   m_active;
+
+    // Server-Sent Events parser state
+    QByteArray m_sseBuffer;
+    QByteArray m_sseData;
+    QByteArray m_sseLastEventId;
+};
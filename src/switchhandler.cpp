@@ -22,24 +22,25 @@
 
 #include "switchhandler.h"
 
+#include <QHash>
+
 #include "yio-interface/entities/switchinterface.h"
 
 static Q_LOGGING_CATEGORY(CLASS_LC, "yio.intg.webhook.switch");
 
 SwitchHandler::SwitchHandler(const QString &baseUrl, QObject *parent) : EntityHandler("switch", baseUrl, parent) {}
 
-WebhookRequest *SwitchHandler::createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
-                                                    const QVariantMap &placeholders, const QVariant &param) const {
+WebhookRequest *SwitchHandler::createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity,
+                                                    int command, const QVariantMap &placeholders,
+                                                    const QVariant &param) const {
     Q_UNUSED(entity)
     Q_UNUSED(param)
 
     switch (command) {
         case SwitchDef::C_ON:
-            return createRequest("ON", entityId, placeholders);
         case SwitchDef::C_OFF:
-            return createRequest("OFF", entityId, placeholders);
         case SwitchDef::C_TOGGLE:
-            return createRequest("TOGGLE", entityId, placeholders);
+            return createRequest(webhookEntity, command, PlaceholderValues(&placeholders));
         default:
             qCWarning(CLASS_LC) << "Unsupported command:" << command;
     }
@@ -47,22 +48,24 @@ WebhookRequest *SwitchHandler::createCommandRequest(const QString &entityId, Ent
     return nullptr;
 }
 
-void SwitchHandler::commandReply(int command, EntityInterface *entity, const QVariant &param,
-                                 const WebhookRequest *request, QNetworkReply *reply) {
-    Q_UNUSED(param)
+int SwitchHandler::featureToCommand(const QString &feature) const {
+    static const QHash<QString, int> commands{
+        {"ON", SwitchDef::C_ON},
+        {"OFF", SwitchDef::C_OFF},
+        {"TOGGLE", SwitchDef::C_TOGGLE},
+    };
+    return commands.value(feature, -1);
+}
 
-    int oldState = entity->state();
+UndoRecord SwitchHandler::applyCommandState(int command, EntityInterface *entity, const QVariant &param) {
+    Q_UNUSED(param)
 
-    if ((command == SwitchDef::C_ON || command == SwitchDef::C_OFF)) {
+    UndoRecord undo;
+    if (command == SwitchDef::C_ON || command == SwitchDef::C_OFF) {
+        undo.state = entity->state();
         entity->setState(command == SwitchDef::C_ON ? SwitchDef::ON : SwitchDef::OFF);
     }
-
-    if (reply->error() == QNetworkReply::NoError) {
-        handleResponseData(entity, request, reply);
-    } else {
-        // revert entity / UI state in case request failed
-        entity->setState(oldState);
-    }
+    return undo;
 }
 
 const QLoggingCategory &SwitchHandler::logCategory() const { return CLASS_LC(); }
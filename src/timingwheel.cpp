@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "timingwheel.h"
+
+const quint64 TimingWheel::MAX_DELAY = (Q_UINT64_C(1) << (BITS * LEVELS)) - 1;
+
+TimingWheel::TimingWheel() : m_now(0), m_size(0), m_slots(SLOTS * LEVELS, -1) {}
+
+void TimingWheel::schedule(int id, quint64 ticks) {
+    Q_ASSERT(id >= 0);
+    if (id >= m_nodes.size()) {
+        m_nodes.resize(id + 1);
+    }
+    if (m_nodes.at(id).slot >= 0) {
+        unlink(id);
+    }
+
+    m_nodes[id].expires = m_now + qBound(Q_UINT64_C(1), ticks, MAX_DELAY);
+    insert(id);
+}
+
+void TimingWheel::cancel(int id) {
+    if (isScheduled(id)) {
+        unlink(id);
+    }
+}
+
+void TimingWheel::advance(QVector<int> *due) {
+    m_now++;
+
+    // when a level wraps around, the current slot of the next level is distributed to the lower levels. The highest
+    // affected level is cascaded first, so its ids can be cascaded further down in the same tick
+    int level = 0;
+    while (level < LEVELS - 1 && ((m_now >> (level * BITS)) & (SLOTS - 1)) == 0) {
+        level++;
+    }
+    for (; level > 0; level--) {
+        cascade(level);
+    }
+
+    int slot = static_cast<int>(m_now & (SLOTS - 1));
+    while (m_slots.at(slot) >= 0) {
+        int id = m_slots.at(slot);
+        unlink(id);
+        due->append(id);
+    }
+}
+
+void TimingWheel::clear() {
+    m_slots.fill(-1);
+    for (Node &node : m_nodes) {
+        node = Node();
+    }
+    m_size = 0;
+}
+
+void TimingWheel::insert(int id) {
+    Node   &node = m_nodes[id];
+    quint64 delta = node.expires - m_now;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (Q_UINT64_C(1) << ((level + 1) * BITS))) {
+        level++;
+    }
+    int slot = level * SLOTS + static_cast<int>((node.expires >> (level * BITS)) & (SLOTS - 1));
+
+    node.slot = slot;
+    node.prev = -1;
+    node.next = m_slots.at(slot);
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = id;
+    }
+    m_slots[slot] = id;
+    m_size++;
+}
+
+void TimingWheel::unlink(int id) {
+    Node &node = m_nodes[id];
+    if (node.prev >= 0) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_slots[node.slot] = node.next;
+    }
+    if (node.next >= 0) {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.prev = -1;
+    node.next = -1;
+    node.slot = -1;
+    m_size--;
+}
+
+void TimingWheel::cascade(int level) {
+    int slot = level * SLOTS + static_cast<int>((m_now >> (level * BITS)) & (SLOTS - 1));
+    int id = m_slots.at(slot);
+    m_slots[slot] = -1;
+
+    while (id >= 0) {
+        Node &node = m_nodes[id];
+        int   next = node.next;
+        node.slot = -1;
+        m_size--;
+        insert(id);
+        id = next;
+    }
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QVector>
+
+/**
+ * @brief Hierarchical timing wheel scheduling integer ids, e.g. the dense entity index, in ticks.
+ * @details Four levels of 64 slots cover 64^4 ticks, longer delays are clamped. Scheduling and cancelling are O(1),
+ * advancing a tick only touches the due ids and occasionally cascades one slot of a higher level. Ids are stored in
+ * intrusive lists indexed by id, so the wheel doesn't allocate once all ids have been scheduled.
+ */
+class TimingWheel {
+ public:
+    static const int     BITS = 6;
+    static const int     SLOTS = 1 << BITS;
+    static const int     LEVELS = 4;
+    static const quint64 MAX_DELAY;
+
+    TimingWheel();
+
+    /**
+     * @brief Schedules the id to be due after the given number of ticks from now. A scheduled id is moved.
+     * @param ticks Delay in ticks: 1 = due with the next call of advance(). Clamped to 1..MAX_DELAY.
+     */
+    void schedule(int id, quint64 ticks);
+
+    void cancel(int id);
+
+    bool isScheduled(int id) const { return id >= 0 && id < m_nodes.size() && m_nodes.at(id).slot >= 0; }
+
+    /**
+     * @brief Returns the tick of a scheduled id.
+     */
+    quint64 expires(int id) const { return m_nodes.at(id).expires; }
+
+    /**
+     * @brief Advances the wheel by one tick and appends the due ids to the list. Due ids are no longer scheduled.
+     */
+    void advance(QVector<int>* due);
+
+    /**
+     * @brief Number of ticks since the wheel has been created.
+     */
+    quint64 now() const { return m_now; }
+
+    /**
+     * @brief Number of scheduled ids.
+     */
+    int size() const { return m_size; }
+
+    /**
+     * @brief Cancels all ids.
+     */
+    void clear();
+
+ private:
+    struct Node {
+        Node() : prev(-1), next(-1), slot(-1), expires(0) {}
+
+        int     prev;
+        int     next;
+        int     slot;
+        quint64 expires;
+    };
+
+    void insert(int id);
+    void unlink(int id);
+    void cascade(int level);
+
+    quint64       m_now;
+    int           m_size;
+    QVector<int>  m_slots;
+    QVector<Node> m_nodes;
+};
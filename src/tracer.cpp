@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "tracer.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+Tracer::Tracer(int capacity) : m_spans(qMax(capacity, 1)), m_next(0), m_size(0), m_dropped(0) {}
+
+void Tracer::addSpan(const char *category, const char *name, quint64 id, qint64 start, qint64 end,
+                     const Args &args) {
+    if (start <= 0 || end < start) {
+        return;
+    }
+
+    Span &span = m_spans[m_next];
+    span.category = category;
+    span.name = name;
+    span.id = id;
+    span.start = start;
+    span.end = end;
+    span.args = args;
+
+    m_next = (m_next + 1) % m_spans.size();
+    if (m_size < m_spans.size()) {
+        m_size++;
+    } else {
+        m_dropped++;
+    }
+}
+
+void Tracer::clear() {
+    for (Span &span : m_spans) {
+        span = Span();
+    }
+    m_next = 0;
+    m_size = 0;
+    m_dropped = 0;
+}
+
+QByteArray Tracer::toChromeTrace() const {
+    QJsonArray events;
+
+    int first = (m_next - m_size + m_spans.size()) % m_spans.size();
+    for (int i = 0; i < m_size; i++) {
+        const Span &span = m_spans.at((first + i) % m_spans.size());
+
+        QJsonObject args;
+        if (!span.args.entityId.isEmpty()) {
+            args.insert("entity_id", span.args.entityId);
+        }
+        if (!span.args.command.isEmpty()) {
+            args.insert("command", span.args.command);
+        }
+        if (!span.args.url.isEmpty()) {
+            args.insert("url", span.args.url);
+        }
+        if (span.args.status != 0) {
+            args.insert("status", span.args.status);
+        }
+
+        // nestable async begin and end events: the stages of a request are shown on one track
+        QJsonObject begin;
+        begin.insert("name", QString::fromLatin1(span.name));
+        begin.insert("cat", QString::fromLatin1(span.category));
+        begin.insert("ph", "b");
+        begin.insert("id", QString::number(span.id));
+        begin.insert("ts", span.start / 1000.0);
+        begin.insert("pid", 1);
+        begin.insert("tid", 1);
+        begin.insert("args", args);
+        events.append(begin);
+
+        QJsonObject end = begin;
+        end.insert("ph", "e");
+        end.insert("ts", span.end / 1000.0);
+        end.remove("args");
+        events.append(end);
+    }
+
+    QJsonObject trace;
+    trace.insert("traceEvents", events);
+    trace.insert("displayTimeUnit", "ms");
+    return QJsonDocument(trace).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief Records the stages of command and status requests as spans in a preallocated ring buffer.
+ * @details The spans are exported in the Chrome trace event format and can be opened in Perfetto or chrome://tracing.
+ * All spans of a request share the async track of the request sequence number. The oldest spans are overwritten when
+ * the buffer is full. Spans are recorded and exported in the integration thread.
+ *
+ * Tracing is optional: callers hold a null Tracer pointer if disabled, so the overhead is a single branch.
+ */
+class Tracer {
+ public:
+    /**
+     * @brief Tags of a span.
+     */
+    struct Args {
+        Args() : status(0) {}
+
+        QString entityId;
+        QString command;
+        QString url;
+        /**
+         * @brief Http status code of the reply, or the negative network error if no response has been received.
+         */
+        int status;
+    };
+
+    explicit Tracer(int capacity = 10000);
+
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    /**
+     * @brief Adds a span. Empty spans with an unset start or end time are ignored.
+     * @param category Static string, e.g. "command" or "poll".
+     * @param name Static string of the stage.
+     * @param id Async track id, e.g. the request sequence number.
+     * @param start Start timestamp of Metrics::now() in ns.
+     * @param end End timestamp of Metrics::now() in ns.
+     */
+    void addSpan(const char* category, const char* name, quint64 id, qint64 start, qint64 end, const Args& args);
+
+    /**
+     * @brief Number of spans in the buffer.
+     */
+    int size() const { return m_size; }
+    int capacity() const { return m_spans.size(); }
+
+    /**
+     * @brief Number of overwritten spans since the last clear().
+     */
+    quint64 dropped() const { return m_dropped; }
+
+    void clear();
+
+    /**
+     * @brief Returns the spans in the Chrome trace event JSON format, oldest first.
+     */
+    QByteArray toChromeTrace() const;
+
+ private:
+    struct Span {
+        Span() : category(nullptr), name(nullptr), id(0), start(0), end(0) {}
+
+        const char* category;
+        const char* name;
+        quint64     id;
+        qint64      start;
+        qint64      end;
+        Args        args;
+    };
+
+    QVector<Span> m_spans;
+    int           m_next;
+    int           m_size;
+    quint64       m_dropped;
+};
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "transportreply.h"
+
+#include <cstring>
+
+#include <QTimer>
+
+TransportReply::TransportReply(const QNetworkRequest &request, QObject *parent)
+    : QNetworkReply(parent), m_offset(0) {
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::CustomOperation);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+QByteArray TransportReply::contentTypeOf(const QByteArray &data) {
+    QByteArray trimmed = data.trimmed();
+    if (trimmed.startsWith('{') || trimmed.startsWith('[')) {
+        return "application/json";
+    }
+    return "text/plain";
+}
+
+void TransportReply::setResponseData(const QByteArray &data, const QByteArray &contentType) {
+    m_data = data;
+    m_offset = 0;
+    setHeader(QNetworkRequest::ContentTypeHeader, contentType.isEmpty() ? contentTypeOf(data) : contentType);
+    setHeader(QNetworkRequest::ContentLengthHeader, data.size());
+}
+
+void TransportReply::finish() {
+    if (isFinished()) {
+        return;
+    }
+    if (m_data.isEmpty()) {
+        setHeader(QNetworkRequest::ContentLengthHeader, 0);
+    }
+    setFinished(true);
+    QTimer::singleShot(0, this, &TransportReply::emitFinished);
+}
+
+void TransportReply::finishWithError(QNetworkReply::NetworkError error, const QString &errorString) {
+    if (isFinished()) {
+        return;
+    }
+    setError(error, errorString);
+    setFinished(true);
+    QTimer::singleShot(0, this, [this, error] {
+        emit this->error(error);
+        emitFinished();
+    });
+}
+
+void TransportReply::abort() { finishWithError(QNetworkReply::OperationCanceledError, "Operation canceled"); }
+
+qint64 TransportReply::bytesAvailable() const { return m_data.size() - m_offset + QIODevice::bytesAvailable(); }
+
+qint64 TransportReply::readData(char *data, qint64 maxSize) {
+    if (m_offset >= m_data.size()) {
+        return isFinished() ? -1 : 0;
+    }
+
+    qint64 count = qMin(maxSize, m_data.size() - m_offset);
+    memcpy(data, m_data.constData() + m_offset, static_cast<size_t>(count));
+    m_offset += count;
+    return count;
+}
+
+void TransportReply::emitFinished() {
+    if (bytesAvailable() > 0) {
+        emit readyRead();
+    }
+    emit finished();
+}
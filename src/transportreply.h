@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QString>
+
+/**
+ * @brief Network reply of a non-http command transport, e.g. MQTT, UDP or TCP.
+ * @details Allows to handle all command transports the same way as http requests: the reply is finished
+ * asynchronously with finish() or finishWithError() and the optional response data is passed to the response mappings.
+ */
+class TransportReply : public QNetworkReply {
+    Q_OBJECT
+
+ public:
+    explicit TransportReply(const QNetworkRequest& request, QObject* parent = nullptr);
+
+    /**
+     * @brief Guesses the content type of the given payload: application/json for a JSON object or array, otherwise
+     * text/plain.
+     */
+    static QByteArray contentTypeOf(const QByteArray& data);
+
+    /**
+     * @brief Sets the response data. The content type is guessed if not specified.
+     */
+    void setResponseData(const QByteArray& data, const QByteArray& contentType = QByteArray());
+
+    /**
+     * @brief Finishes the reply successfully. The finished signal is emitted from the event loop.
+     */
+    void finish();
+
+    /**
+     * @brief Finishes the reply with the given error. The finished signal is emitted from the event loop.
+     */
+    void finishWithError(QNetworkReply::NetworkError error, const QString& errorString);
+
+    // QNetworkReply interface
+ public:
+    void   abort() override;
+    qint64 bytesAvailable() const override;
+    bool   isSequential() const override { return true; }
+
+ protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+ private:
+    void emitFinished();
+
+    QByteArray m_data;
+    qint64     m_offset;
+};
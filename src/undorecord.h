@@ -0,0 +1,46 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QPair>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Compact record of the entity values changed by an optimistically applied command.
+ * @details Only the state and the changed attributes are stored, identified by their entity specific attribute index.
+ */
+struct UndoRecord {
+    /**
+     * @brief Previous entity state, or -1 if the state is not changed.
+     */
+    int state = -1;
+    /**
+     * @brief Previous attribute values: attribute index -> value.
+     */
+    QVector<QPair<int, QVariant>> attributes;
+
+    bool isEmpty() const { return state < 0 && attributes.isEmpty(); }
+
+    void saveAttribute(int index, const QVariant &value) { attributes.append(qMakePair(index, value)); }
+};
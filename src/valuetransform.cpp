@@ -0,0 +1,421 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#include "valuetransform.h"
+
+#include <QStringRef>
+#include <climits>
+#include <cmath>
+
+static bool toNumbers(const QVariant &config, int count, double *numbers) {
+    QVariantList list = config.toList();
+    if (list.size() != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        bool ok = false;
+        numbers[i] = list.at(i).toDouble(&ok);
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+ValueTransform ValueTransform::compile(const QVariant &config, QString *error) {
+    ValueTransform transform;
+    if (!config.isValid()) {
+        return transform;
+    }
+
+    const QVariantList opsCfg = config.type() == QVariant::List ? config.toList() : QVariantList{config};
+    for (const QVariant &opCfg : opsCfg) {
+        if (opCfg.type() != QVariant::Map) {
+            if (error) {
+                *error = QStringLiteral("invalid transform operation: %1").arg(opCfg.toString());
+            }
+            continue;
+        }
+        transform.compileOp(opCfg.toMap(), error);
+    }
+
+    transform.m_ops.squeeze();
+    transform.m_tables.squeeze();
+    return transform;
+}
+
+bool ValueTransform::compileOp(const QVariantMap &opCfg, QString *error) {
+    QString  name;
+    QVariant operand;
+    for (auto iter = opCfg.cbegin(); iter != opCfg.cend(); ++iter) {
+        // the default value is an option of the map operation
+        if (iter.key() != "default") {
+            name = iter.key();
+            operand = iter.value();
+            break;
+        }
+    }
+
+    double numbers[4];
+    bool   ok = false;
+    if (name == "scale") {
+        if (operand.type() == QVariant::List) {
+            ok = toNumbers(operand, 4, numbers) && numbers[0] != numbers[1];
+            if (ok) {
+                double factor = (numbers[3] - numbers[2]) / (numbers[1] - numbers[0]);
+                appendLinear(factor, numbers[2] - numbers[0] * factor);
+            }
+        } else {
+            numbers[0] = operand.toDouble(&ok);
+            if (ok) {
+                appendLinear(numbers[0], 0);
+            }
+        }
+    } else if (name == "offset") {
+        numbers[0] = operand.toDouble(&ok);
+        if (ok) {
+            appendLinear(1, numbers[0]);
+        }
+    } else if (name == "clamp") {
+        ok = toNumbers(operand, 2, numbers) && numbers[0] <= numbers[1];
+        if (ok) {
+            m_ops.append(Op{CLAMP, numbers[0], numbers[1]});
+        }
+    } else if (name == "round") {
+        int decimals = operand.toInt(&ok);
+        ok = ok && decimals >= 0 && decimals <= 9;
+        if (ok) {
+            m_ops.append(Op{ROUND, std::pow(10.0, decimals), 0});
+        }
+    } else if (name == "invert") {
+        if (operand.type() == QVariant::Bool) {
+            ok = true;
+            if (operand.toBool()) {
+                m_ops.append(Op{INVERT, 100, 0});
+            }
+        } else {
+            ok = toNumbers(operand, 2, numbers);
+            if (ok) {
+                m_ops.append(Op{INVERT, numbers[0] + numbers[1], 0});
+            }
+        }
+    } else if (name == "map") {
+        ok = operand.type() == QVariant::Map;
+        if (ok) {
+            LookupTable       table;
+            const QVariantMap values = operand.toMap();
+            for (auto iter = values.cbegin(); iter != values.cend(); ++iter) {
+                table.keys.append(iter.key());
+                table.values.append(fromJson(QJsonValue::fromVariant(iter.value())));
+            }
+            table.defaultValue = fromJson(QJsonValue::fromVariant(opCfg.value("default")));
+            m_ops.append(Op{LOOKUP, static_cast<double>(m_tables.size()), 0});
+            m_tables.append(table);
+        }
+    } else if (name == "unit") {
+        QVariantList units = operand.toList();
+        double       fromFactor, fromOffset, toFactor, toOffset;
+        ok = units.size() == 2 && toCelsius(units.at(0).toString(), &fromFactor, &fromOffset) &&
+             toCelsius(units.at(1).toString(), &toFactor, &toOffset);
+        if (ok) {
+            // convert to celsius, then with the inverse conversion of the target unit
+            appendLinear(fromFactor, fromOffset);
+            appendLinear(1 / toFactor, -toOffset / toFactor);
+        }
+    } else if (name == "color") {
+        ok = true;
+        m_ops.append(Op{COLOR, 0, 0});
+    }
+
+    if (!ok && error) {
+        *error = QStringLiteral("invalid transform operation: %1").arg(name.isEmpty() ? "{}" : name);
+    }
+    return ok;
+}
+
+void ValueTransform::appendLinear(double factor, double offset) {
+    // consecutive linear operations are folded into one: f2 * (f1 * x + o1) + o2
+    if (!m_ops.isEmpty() && m_ops.last().type == LINEAR) {
+        Op &last = m_ops.last();
+        last.a *= factor;
+        last.b = last.b * factor + offset;
+        return;
+    }
+    m_ops.append(Op{LINEAR, factor, offset});
+}
+
+QVariant ValueTransform::apply(const QJsonValue &json) const {
+    Value value = fromJson(json);
+    if (value.type == Value::INVALID) {
+        return QVariant();
+    }
+
+    for (const Op &op : m_ops) {
+        switch (op.type) {
+            case LINEAR:
+                if (!toNumber(&value)) {
+                    return QVariant();
+                }
+                value.number = value.number * op.a + op.b;
+                break;
+            case CLAMP:
+                if (!toNumber(&value)) {
+                    return QVariant();
+                }
+                value.number = qBound(op.a, value.number, op.b);
+                break;
+            case ROUND:
+                if (!toNumber(&value)) {
+                    return QVariant();
+                }
+                value.number = std::round(value.number * op.a) / op.a;
+                break;
+            case INVERT:
+                if (value.type == Value::BOOL) {
+                    value.number = value.number != 0 ? 0 : 1;
+                } else if (toNumber(&value)) {
+                    value.number = op.a - value.number;
+                } else {
+                    return QVariant();
+                }
+                break;
+            case LOOKUP: {
+                const LookupTable &table = m_tables.at(static_cast<int>(op.a));
+                int                index = table.keys.indexOf(toKey(value));
+                if (index >= 0) {
+                    value = table.values.at(index);
+                } else if (table.defaultValue.type != Value::INVALID) {
+                    value = table.defaultValue;
+                }
+                break;
+            }
+            case COLOR:
+                if (!parseColor(value, &value)) {
+                    return QVariant();
+                }
+                break;
+            case OP_TYPES:
+                break;
+        }
+    }
+
+    return toVariant(value);
+}
+
+ValueTransform::Value ValueTransform::fromJson(const QJsonValue &json) {
+    Value value;
+    switch (json.type()) {
+        case QJsonValue::Bool:
+            value.type = Value::BOOL;
+            value.number = json.toBool() ? 1 : 0;
+            break;
+        case QJsonValue::Double:
+            value.type = Value::NUMBER;
+            value.number = json.toDouble();
+            break;
+        case QJsonValue::String:
+            value.type = Value::STRING;
+            value.text = json.toString();
+            break;
+        default:
+            break;
+    }
+    return value;
+}
+
+QVariant ValueTransform::toVariant(const Value &value) {
+    switch (value.type) {
+        case Value::BOOL:
+            return value.number != 0;
+        case Value::NUMBER:
+            // integral results are returned as int, e.g. a scaled brightness value
+            if (value.number == std::floor(value.number) && std::fabs(value.number) <= INT_MAX) {
+                return static_cast<int>(value.number);
+            }
+            return value.number;
+        case Value::STRING:
+            return value.text;
+        default:
+            return QVariant();
+    }
+}
+
+bool ValueTransform::toNumber(Value *value) {
+    if (value->type == Value::STRING) {
+        bool ok = false;
+        value->number = value->text.trimmed().toDouble(&ok);
+        if (!ok) {
+            return false;
+        }
+        value->text.clear();
+    }
+    if (value->type == Value::INVALID) {
+        return false;
+    }
+    value->type = Value::NUMBER;
+    return true;
+}
+
+QString ValueTransform::toKey(const Value &value) {
+    switch (value.type) {
+        case Value::BOOL:
+            return value.number != 0 ? QStringLiteral("true") : QStringLiteral("false");
+        case Value::NUMBER:
+            return QString::number(value.number, 'g', 15);
+        default:
+            return value.text;
+    }
+}
+
+bool ValueTransform::parseColor(const Value &value, Value *color) {
+    quint32 rgb = 0;
+    bool    ok = false;
+
+    if (value.type == Value::NUMBER) {
+        ok = value.number >= 0 && value.number <= 0xFFFFFF;
+        rgb = static_cast<quint32>(value.number);
+    } else if (value.type == Value::STRING) {
+        QStringRef text = QStringRef(&value.text).trimmed();
+        if (text.startsWith(QLatin1String("rgb("), Qt::CaseInsensitive) && text.endsWith(')')) {
+            text = text.mid(4, text.size() - 5);
+        }
+        if (text.contains(',')) {
+            QVector<QStringRef> components = text.split(',');
+            ok = components.size() == 3;
+            for (int i = 0; ok && i < components.size(); i++) {
+                int component = components.at(i).trimmed().toInt(&ok);
+                ok = ok && component >= 0 && component <= 255;
+                rgb = (rgb << 8) | static_cast<quint32>(component);
+            }
+        } else {
+            if (text.startsWith('#')) {
+                text = text.mid(1);
+            }
+            ok = text.size() == 6;
+            rgb = ok ? text.toUInt(&ok, 16) : 0;
+        }
+    }
+
+    if (!ok) {
+        return false;
+    }
+    color->type = Value::STRING;
+    color->text = QStringLiteral("#%1").arg(rgb, 6, 16, QLatin1Char('0'));
+    return true;
+}
+
+bool ValueTransform::toCelsius(const QString &unit, double *factor, double *offset) {
+    QString name = unit.toLower();
+    if (name == "celsius" || name == "c") {
+        *factor = 1;
+        *offset = 0;
+    } else if (name == "fahrenheit" || name == "f") {
+        *factor = 5.0 / 9.0;
+        *offset = -32 * 5.0 / 9.0;
+    } else if (name == "kelvin" || name == "k") {
+        *factor = 1;
+        *offset = -273.15;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ValueTransform::writeValue(QDataStream *out, const Value &value) {
+    *out << static_cast<qint32>(value.type) << value.number << value.text;
+}
+
+void ValueTransform::readValue(QDataStream *in, Value *value) {
+    qint32 type;
+    *in >> type >> value->number >> value->text;
+    if (type < Value::INVALID || type > Value::STRING) {
+        in->setStatus(QDataStream::ReadCorruptData);
+        return;
+    }
+    value->type = static_cast<Value::Type>(type);
+}
+
+QDataStream &operator<<(QDataStream &out, const ValueTransform &transform) {
+    out << static_cast<qint32>(transform.m_ops.size());
+    for (const ValueTransform::Op &op : transform.m_ops) {
+        out << static_cast<qint32>(op.type) << op.a << op.b;
+    }
+
+    out << static_cast<qint32>(transform.m_tables.size());
+    for (const ValueTransform::LookupTable &table : transform.m_tables) {
+        out << table.keys;
+        for (const ValueTransform::Value &value : table.values) {
+            ValueTransform::writeValue(&out, value);
+        }
+        ValueTransform::writeValue(&out, table.defaultValue);
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, ValueTransform &transform) {
+    qint32 opCount;
+    in >> opCount;
+    transform.m_ops.clear();
+    transform.m_tables.clear();
+    if (opCount < 0 || opCount > 0xFFFF) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    transform.m_ops.reserve(opCount);
+    for (qint32 i = 0; i < opCount && in.status() == QDataStream::Ok; i++) {
+        qint32             type;
+        ValueTransform::Op op;
+        in >> type >> op.a >> op.b;
+        if (type < 0 || type >= ValueTransform::OP_TYPES) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            return in;
+        }
+        op.type = static_cast<ValueTransform::OpType>(type);
+        transform.m_ops.append(op);
+    }
+
+    qint32 tableCount;
+    in >> tableCount;
+    if (tableCount < 0 || tableCount > opCount) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    for (qint32 i = 0; i < tableCount && in.status() == QDataStream::Ok; i++) {
+        ValueTransform::LookupTable table;
+        in >> table.keys;
+        table.values.resize(table.keys.size());
+        for (ValueTransform::Value &value : table.values) {
+            ValueTransform::readValue(&in, &value);
+        }
+        ValueTransform::readValue(&in, &table.defaultValue);
+        transform.m_tables.append(table);
+    }
+
+    // the lookup table index of a corrupt stream must not be trusted
+    for (const ValueTransform::Op &op : qAsConst(transform.m_ops)) {
+        if (op.type == ValueTransform::LOOKUP && (op.a < 0 || op.a >= tableCount)) {
+            in.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+    }
+    return in;
+}
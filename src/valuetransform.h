@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ * Copyright (C) 2020 Markus Zehnder <business@markuszehnder.ch>
+ *
+ * This file is part of the YIO-Remote software project.
+ *
+ * YIO-Remote software is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * YIO-Remote software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with YIO-Remote software. If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *****************************************************************************/
+
+#pragma once
+
+#include <QDataStream>
+#include <QJsonValue>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Value transform chain of a response mapping, compiled once at config load.
+ * @details The configured operations are compiled into a flat list of typed ops: scaling, offsets and unit
+ * conversions are folded into a single linear op. The ops are applied on the extracted Json value without any QVariant
+ * conversion, only the result is converted for the entity update. Supported operations, applied in the configured
+ * order:
+ * - `{"scale": 2.55}`: multiply. `{"scale": [0, 255, 0, 100]}`: map the input range linearly to the output range.
+ * - `{"offset": -1}`: add a constant.
+ * - `{"clamp": [0, 100]}`: limit to the range.
+ * - `{"round": 1}`: round to the number of decimals.
+ * - `{"invert": true}`: negate a boolean, or mirror a number within 0..100. `{"invert": [min, max]}`: other range.
+ * - `{"map": {"on": true, "off": false}, "default": false}`: lookup table, unmatched values are kept without default.
+ * - `{"unit": ["fahrenheit", "celsius"]}`: temperature conversion between celsius, fahrenheit and kelvin.
+ * - `{"color": "rgb"}`: parses a `#RRGGBB`, `RRGGBB`, `r,g,b` or `rgb(r,g,b)` string or a 0xRRGGBB number into a
+ *   `#rrggbb` color string.
+ */
+class ValueTransform {
+ public:
+    ValueTransform() = default;
+
+    /**
+     * @brief Compiles a single operation object or an array of operation objects.
+     * @param error Set to the description of an invalid operation. Invalid operations are skipped.
+     */
+    static ValueTransform compile(const QVariant& config, QString* error = nullptr);
+
+    bool isEmpty() const { return m_ops.isEmpty(); }
+    int  size() const { return m_ops.size(); }
+
+    /**
+     * @brief Applies the ops on the extracted value.
+     * @return The transformed value, or an invalid QVariant if the value can't be transformed, e.g. a non-numeric
+     * string with a scale op.
+     */
+    QVariant apply(const QJsonValue& value) const;
+
+    bool operator==(const ValueTransform& other) const { return m_ops == other.m_ops && m_tables == other.m_tables; }
+    bool operator!=(const ValueTransform& other) const { return !(*this == other); }
+
+    friend QDataStream& operator<<(QDataStream& out, const ValueTransform& transform);
+    friend QDataStream& operator>>(QDataStream& in, ValueTransform& transform);
+
+ private:
+    enum OpType { LINEAR, CLAMP, ROUND, INVERT, LOOKUP, COLOR, OP_TYPES };
+
+    /**
+     * @brief Compiled op with its operands: LINEAR factor and offset, CLAMP min and max, ROUND 10^decimals, INVERT
+     * min + max, LOOKUP table index.
+     */
+    struct Op {
+        OpType type;
+        double a;
+        double b;
+
+        bool operator==(const Op& other) const { return type == other.type && a == other.a && b == other.b; }
+    };
+
+    /**
+     * @brief Typed intermediate value of the op chain. A boolean is stored as 0 or 1.
+     */
+    struct Value {
+        enum Type { INVALID, BOOL, NUMBER, STRING };
+
+        Value() : type(INVALID), number(0) {}
+
+        Type    type;
+        double  number;
+        QString text;
+
+        bool operator==(const Value& other) const {
+            return type == other.type && number == other.number && text == other.text;
+        }
+    };
+
+    struct LookupTable {
+        QVector<QString> keys;
+        QVector<Value>   values;
+        Value            defaultValue;
+
+        bool operator==(const LookupTable& other) const {
+            return keys == other.keys && values == other.values && defaultValue == other.defaultValue;
+        }
+    };
+
+    bool compileOp(const QVariantMap& opCfg, QString* error);
+    void appendLinear(double factor, double offset);
+
+    static Value    fromJson(const QJsonValue& json);
+    static QVariant toVariant(const Value& value);
+    static bool     toNumber(Value* value);
+    static QString  toKey(const Value& value);
+    static bool     parseColor(const Value& value, Value* color);
+    static bool     toCelsius(const QString& unit, double* factor, double* offset);
+    static void     writeValue(QDataStream* out, const Value& value);
+    static void     readValue(QDataStream* in, Value* value);
+
+    QVector<Op>          m_ops;
+    QVector<LookupTable> m_tables;
+};
+
+/**
+ * @brief Transforms of a mapping list, index aligned with the mappings. Empty if no mapping has a transform.
+ */
+typedef QVector<ValueTransform> TransformList;
@@ -22,13 +22,26 @@
 
 #include "webhook.h"
 
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonParseError>
 #include <QNetworkProxy>
+#include <QScopedPointer>
+#include <QSet>
+#include <QStandardPaths>
+#include <QUrlQuery>
 #include <QtDebug>
 
 #include "blindhandler.h"
 #include "climatehandler.h"
 #include "lighthandler.h"
 #include "switchhandler.h"
+#include "yio-interface/entities/switchinterface.h"
+
+#ifdef WEBHOOK_MQTT
+#include "mqtttransport.h"
+#endif
 
 WebhookPlugin::WebhookPlugin() : Plugin("yio.plugin.webhook", USE_WORKER_THREAD) {}
 
@@ -42,7 +55,16 @@ Integration *WebhookPlugin::createIntegration(const QVariantMap &config, Entitie
 
 Webhook::Webhook(const QVariantMap &config, EntitiesInterface *entities, NotificationsInterface *notifications,
                  YioAPIInterface *api, ConfigInterface *configObj, Plugin *plugin)
-    : Integration(config, entities, notifications, api, configObj, plugin), m_statusTimer(nullptr) {
+    : Integration(config, entities, notifications, api, configObj, plugin),
+      m_dispatcher(&m_networkManager),
+      m_optimisticUpdates(true),
+      m_hostCache(nullptr),
+      m_callbackServer(nullptr),
+      m_callbackPort(0),
+      m_statusTimer(nullptr),
+      m_mqtt(nullptr),
+      m_socketTransport(new SocketTransport(this)),
+      m_sceneMaxPerHost(2) {
     if (!config.contains(Integration::OBJ_DATA)) {
         qCCritical(m_logCategory) << "Missing configuration key" << Integration::OBJ_DATA;
         return;
@@ -53,12 +75,14 @@ Webhook::Webhook(const QVariantMap &config, EntitiesInterface *entities, Notific
     bool        ignoreSsl = map.value(Integration::KEY_DATA_SSL_IGNORE, false).toBool();
     QVariantMap headers = map.value("headers").toMap();
 
+    m_configData = map;
     m_placeholders = map.value("placeholders").toMap();
+    m_dispatcher.setAcceptCompression(map.value("accept_compression", true).toBool());
+    m_dispatcher.setRequestTimeout(map.value("request_timeout", 10).toInt() * 1000);
+    m_dispatcher.setSocketTransport(m_socketTransport);
+    m_optimisticUpdates = map.value("optimistic_updates", true).toBool();
 
-    m_handlers.insert("blind", new BlindHandler(baseUrl, this));
-    m_handlers.insert("climate", new ClimateHandler(baseUrl, this));
-    m_handlers.insert("light", new LightHandler(baseUrl, this));
-    m_handlers.insert("switch", new SwitchHandler(baseUrl, this));
+    m_requestPool.setMaxFree(map.value("request_pool_size", 64).toInt());
 
     m_networkManager.setRedirectPolicy(QNetworkRequest::NoLessSafeRedirectPolicy);
     if (ignoreSsl) {
@@ -70,51 +94,450 @@ Webhook::Webhook(const QVariantMap &config, EntitiesInterface *entities, Notific
         configureProxy(map.value("proxy").toMap());
     }
 
-    QVariantMap entitiesCfg = map.value("entities").toMap();
-    for (auto iter = entitiesCfg.cbegin(); iter != entitiesCfg.cend(); ++iter) {
-        EntityHandler *entityHandler = m_handlers.value(iter.key());
-        if (entityHandler) {
-            entityHandler->readEntities(iter.value().toList(), headers);
-        } else {
-            qCWarning(m_logCategory) << "TODO implement handler for" << iter.key();
+    QVariantMap dnsCacheCfg = map.value("dns_cache").toMap();
+    if (map.contains("dns_cache") && dnsCacheCfg.value("enabled", true).toBool()) {
+        m_hostCache = new HostCache(dnsCacheCfg.value("ttl", 300).toInt(), this);
+        m_dispatcher.setHostCache(m_hostCache);
+    }
+
+    // request metrics are cheap enough to be always enabled
+    QVariantMap metricsCfg = map.value("metrics").toMap();
+    if (metricsCfg.value("enabled", true).toBool()) {
+        m_metrics.reset(new Metrics());
+        m_metrics->setEntitySeries(metricsCfg.value("entities", true).toBool());
+        m_dispatcher.setMetrics(m_metrics.data());
+    }
+
+    QVariantMap tracingCfg = map.value("tracing").toMap();
+    if (tracingCfg.value("enabled", false).toBool()) {
+        m_tracer.reset(new Tracer(tracingCfg.value("capacity", 10000).toInt()));
+        m_dispatcher.setTracing(true);
+    }
+
+    // two clock reads per measured section, cheap enough to be always enabled
+    QVariantMap watchdogCfg = map.value("watchdog").toMap();
+    if (watchdogCfg.value("enabled", true).toBool()) {
+        m_watchdog.reset(new StallWatchdog(qRound64(watchdogCfg.value("budget_ms", 4).toDouble() * 1000),
+                                           watchdogCfg.value("warning_interval", 60).toInt() * 1000LL));
+    }
+
+    if (map.contains("mqtt")) {
+#ifdef WEBHOOK_MQTT
+        m_mqtt = new MqttTransport(map.value("mqtt").toMap(), this);
+        m_dispatcher.setMqttTransport(m_mqtt);
+        QObject::connect(m_mqtt, &MqttTransport::messageReceived, this,
+                         [this](const QString &topicFilter, const QByteArray &payload) {
+                             dispatchSubscriptionEvent("mqtt " + topicFilter, payload);
+                         });
+#else
+        qCWarning(m_logCategory) << "MQTT is not supported in this build: Qt MQTT module was not available";
+#endif
+    }
+
+    // the compiled entities are loaded from the config cache if the configuration hasn't changed
+    QScopedPointer<ConfigCache> configCache;
+    QByteArray                  configCacheKey;
+    if (map.value("config_cache", false).toBool()) {
+        configCache.reset(new ConfigCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+                                          "/webhook-" + integrationId() + ".cache"));
+        configCacheKey = ConfigCache::key(map, PLUGIN_VERSION);
+    }
+
+    if (!configCache || !readConfigCache(configCache.data(), configCacheKey, baseUrl)) {
+        QVariantMap entitiesCfg = map.value("entities").toMap();
+        for (auto iter = entitiesCfg.cbegin(); iter != entitiesCfg.cend(); ++iter) {
+            // only the handlers of the configured entity types are created
+            EntityHandler *entityHandler = createEntityHandler(iter.key(), baseUrl);
+            if (entityHandler) {
+                entityHandler->readEntities(iter.value().toList(), headers);
+            } else {
+                qCWarning(m_logCategory) << "TODO implement handler for" << iter.key();
+            }
+        }
+
+        if (configCache) {
+            writeConfigCache(configCache.data(), configCacheKey);
         }
     }
 
-    for (const EntityHandler *entityHandler : qAsConst(m_handlers)) {
+    for (EntityHandler *entityHandler : qAsConst(m_handlers)) {
         auto iter = entityHandler->entityIter();
         while (iter.hasNext()) {
             iter.next();
-            const WebhookEntity *e = iter.value();
-            addAvailableEntity(e->id, e->type, integrationId(), e->friendlyName, e->supportedFeatures);
+            registerEntity(entityHandler, iter.value());
+        }
+    }
+
+    m_sceneMaxPerHost = qMax(1, map.value("scene_max_per_host", 2).toInt());
+    readScenes(map.value("scenes").toList());
+
+    QVariantMap callbackCfg = map.value("callback_server").toMap();
+    if (map.contains("callback_server") && callbackCfg.value("enabled", true).toBool()) {
+        m_callbackServer = new CallbackServer(this);
+        m_callbackPort = static_cast<quint16>(callbackCfg.value("port", 8080).toUInt());
+
+        // the callback server isn't authenticated: only expose metrics and traces if explicitly configured
+        if (m_metrics && metricsCfg.value("serve", metricsCfg.contains("path")).toBool()) {
+            addMetricsRoute(metricsCfg.value("path", "/metrics").toString());
+        }
+        if (m_tracer && tracingCfg.value("serve", tracingCfg.contains("path")).toBool()) {
+            addTraceRoute(tracingCfg.value("path", "/trace").toString());
+        }
+
+        for (EntityHandler *entityHandler : qAsConst(m_handlers)) {
+            auto iter = entityHandler->entityIter();
+            while (iter.hasNext()) {
+                iter.next();
+                addCallbackRoute(entityHandler, iter.value());
+            }
+        }
+    }
+
+    setStatusPolling(map.value("status_polling", 30).toInt());
+    setPollingPriority(map.value("polling_priority").toMap());
+
+    qCDebug(m_logCategory) << "Created webhook for:" << baseUrl << ", ignoreSSL:" << ignoreSsl
+                           << ", statusPolling:" << m_pollScheduler.interval()
+                           << ", compression:" << m_dispatcher.acceptCompression();
+}
+
+bool Webhook::reloadConfig(const QVariantMap &config) {
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!config.contains(Integration::OBJ_DATA)) {
+        qCCritical(m_logCategory) << "Missing configuration key" << Integration::OBJ_DATA;
+        return false;
+    }
+    QVariantMap map = config.value(Integration::OBJ_DATA).toMap();
+
+    // connection settings are only applied when creating the integration
+    static const QStringList RESTART_KEYS{Integration::KEY_DATA_SSL_IGNORE, "proxy", "dns_cache", "mqtt",
+                                          "callback_server", "metrics",
+                                          "tracing", "watchdog"};
+    for (const QString &key : RESTART_KEYS) {
+        if (map.value(key) != m_configData.value(key)) {
+            qCInfo(m_logCategory) << "Changed setting" << key << "requires recreating the integration";
+            return false;
+        }
+    }
+
+    QString     baseUrl = map.value("base_url").toString();
+    QVariantMap headers = map.value("headers").toMap();
+    QVariantMap placeholders = map.value("placeholders").toMap();
+    // all commands are compiled with the base url, the global headers and the static placeholders
+    bool recompile = baseUrl != m_configData.value("base_url").toString() ||
+                     headers != m_configData.value("headers").toMap() || placeholders != m_placeholders;
+
+    m_placeholders = placeholders;
+    m_dispatcher.setAcceptCompression(map.value("accept_compression", true).toBool());
+    m_dispatcher.setRequestTimeout(map.value("request_timeout", 10).toInt() * 1000);
+    m_optimisticUpdates = map.value("optimistic_updates", true).toBool();
+    m_requestPool.setMaxFree(map.value("request_pool_size", 64).toInt());
+    m_sceneMaxPerHost = qMax(1, map.value("scene_max_per_host", 2).toInt());
+
+    if (map.value("status_polling", 30) != m_configData.value("status_polling", 30)) {
+        bool polling = m_statusTimer ? m_statusTimer->isActive() : state() == CONNECTED;
+        setStatusPolling(map.value("status_polling", 30).toInt());
+        if (m_statusTimer && polling) {
+            m_statusTimer->start();
+        }
+    }
+    setPollingPriority(map.value("polling_priority").toMap());
+
+    QVariantMap   previousEntitiesCfg = m_configData.value("entities").toMap();
+    QVariantMap   entitiesCfg = map.value("entities").toMap();
+    QSet<QString> entityTypes;
+    for (auto iter = previousEntitiesCfg.cbegin(); iter != previousEntitiesCfg.cend(); ++iter) {
+        entityTypes.insert(iter.key());
+    }
+    for (auto iter = entitiesCfg.cbegin(); iter != entitiesCfg.cend(); ++iter) {
+        entityTypes.insert(iter.key());
+    }
+
+    QVector<QPair<EntityHandler *, EntityHandler::ReloadResult>> results;
+    for (const QString &entityType : qAsConst(entityTypes)) {
+        QVariantList previousCfgList = previousEntitiesCfg.value(entityType).toList();
+        QVariantList entityCfgList = entitiesCfg.value(entityType).toList();
+        if (!recompile && previousCfgList == entityCfgList) {
+            continue;
+        }
+
+        EntityHandler *entityHandler = m_handlers.value(entityType);
+        if (entityHandler) {
+            entityHandler->setPlaceholders(m_placeholders);
+            entityHandler->setBaseUrl(baseUrl);
+        } else {
+            entityHandler = createEntityHandler(entityType, baseUrl);
+            if (!entityHandler) {
+                qCWarning(m_logCategory) << "TODO implement handler for" << entityType;
+                continue;
+            }
+        }
+        EntityHandler::ReloadResult result =
+            entityHandler->reloadEntities(previousCfgList, entityCfgList, headers, recompile);
+        results.append(qMakePair(entityHandler, result));
+    }
+
+    // removed entity ids may be reused by added entities of another type
+    QSet<WebhookEntity *> changed;
+    bool                  subscriptionsChanged = false;
+    for (const auto &result : qAsConst(results)) {
+        for (WebhookEntity *entity : result.second.removed) {
+            unregisterEntity(entity);
+            changed.insert(entity);
+        }
+        for (WebhookEntity *entity : result.second.updated) {
+            changed.insert(entity);
+        }
+        subscriptionsChanged |= result.second.subscriptionsChanged;
+    }
+
+    if (m_callbackServer) {
+        for (auto iter = m_callbackRoutes.begin(); iter != m_callbackRoutes.end();) {
+            if (changed.contains(iter.value())) {
+                m_callbackServer->removeRoute(iter.key());
+                iter = m_callbackRoutes.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    bool connected = state() == CONNECTED;
+    for (const auto &result : qAsConst(results)) {
+        EntityHandler *entityHandler = result.first;
+        for (WebhookEntity *entity : result.second.added) {
+            registerEntity(entityHandler, entity);
+        }
+        for (WebhookEntity *entity : result.second.updated) {
+            if (isRegistered(entity)) {
+                // the friendly name or the supported features may have changed
+                m_entities->removeAvailableEntity(entity->id);
+                addAvailableEntity(entity->id, entity->type, integrationId(), entity->friendlyName,
+                                   entity->supportedFeatures);
+            }
+        }
+
+        QList<WebhookEntity *> entities = result.second.added + result.second.updated;
+        for (WebhookEntity *entity : qAsConst(entities)) {
+            if (m_callbackServer) {
+                addCallbackRoute(entityHandler, entity);
+            }
+            if (connected && isRegistered(entity)) {
+                entityHandler->initializeEntity(m_entities, entity);
+            }
         }
+        if (connected && m_hostCache) {
+            for (const QString &host : entityHandler->commandHosts(entities, m_placeholders)) {
+                m_hostCache->addHost(host);
+            }
+        }
+    }
+
+    if (subscriptionsChanged && connected) {
+        // entities with the same subscription url share a connection: all subscriptions are set up again
+        stopSubscriptions();
+        startSubscriptions();
+    }
+
+    if (map.value("scenes") != m_configData.value("scenes")) {
+        reloadScenes(map.value("scenes").toList());
+    }
+
+    // added entities and entities with a new status polling command are due with the next tick
+    if (m_statusTimer) {
+        m_pollScheduler.scheduleAll();
     }
 
-    int statusPolling = map.value("status_polling", 30).toInt();
-    if (statusPolling > 1000) {
+    m_configData = map;
+
+    qCInfo(m_logCategory) << "Reloaded configuration in" << timer.elapsed() << "ms";
+    return true;
+}
+
+void Webhook::setStatusPolling(int seconds) {
+    if (seconds > 1000) {
         qCWarning(m_logCategory) << "Status polling interval is in seconds, but has a value > 1000!";
-    } else if (statusPolling < 0) {
-        statusPolling = 0;
+    } else if (seconds < 0) {
+        seconds = 0;
+    }
+
+    m_pollScheduler.setInterval(seconds);
+
+    if (seconds == 0) {
+        if (m_statusTimer) {
+            m_statusTimer->stop();
+            m_statusTimer->deleteLater();
+            m_statusTimer = nullptr;
+        }
+        m_pollScheduler.clear();
+        return;
     }
 
-    if (statusPolling > 0) {
+    // the timer only advances the polling schedule, the entities are due after their own polling interval
+    if (!m_statusTimer) {
         m_statusTimer = new QTimer(this);
-        m_statusTimer->setInterval(statusPolling * 1000);
+        m_statusTimer->setInterval(1000);
         QObject::connect(m_statusTimer, &QTimer::timeout, this, &Webhook::statusUpdate);
     }
+}
 
-    qCDebug(m_logCategory) << "Created webhook for:" << baseUrl << ", ignoreSSL:" << ignoreSsl
-                           << ", statusPolling:" << statusPolling * 1000;
+void Webhook::setPollingPriority(const QVariantMap &priorityCfg) {
+    m_pollScheduler.setPriority(priorityCfg.value("hidden_interval", 300).toInt(),
+                                priorityCfg.value("recent_period", 300).toInt());
+    m_dispatcher.setMaxPollsPerHost(priorityCfg.value("max_polls_per_host", 2).toInt());
+    m_dispatcher.setMaxQueuedPolls(priorityCfg.value("max_queued_polls", 256).toInt());
+}
+
+bool Webhook::registerEntity(EntityHandler *entityHandler, WebhookEntity *entity) {
+    if (m_entityIndex.contains(entity->id) || m_scenes.contains(entity->id)) {
+        qCWarning(m_logCategory) << "Ignoring duplicate entity_id:" << entity->id;
+        return false;
+    }
+    entity->index = m_entityRefs.size();
+    m_entityRefs.append({entityHandler, entity});
+    m_entityIndex.insert(entity->id, entity->index);
+    m_pollScheduler.addEntity(entity);
+    addAvailableEntity(entity->id, entity->type, integrationId(), entity->friendlyName, entity->supportedFeatures);
+    return true;
+}
+
+void Webhook::unregisterEntity(WebhookEntity *entity) {
+    if (!isRegistered(entity)) {
+        return;
+    }
+    // the handle is kept for in-flight requests of the entity, their replies are ignored
+    m_entityRefs[entity->index].entity = nullptr;
+    m_pollScheduler.removeEntity(entity->index);
+    m_entityIndex.remove(entity->id);
+    m_entities->removeAvailableEntity(entity->id);
+    entity->entityInterface = nullptr;
+}
+
+bool Webhook::isRegistered(const WebhookEntity *entity) const {
+    return entity->index >= 0 && m_entityRefs.at(entity->index).entity == entity;
+}
+
+void Webhook::addCallbackRoute(EntityHandler *entityHandler, WebhookEntity *entity) {
+    if (entity->callbackPath.isEmpty()) {
+        return;
+    }
+    if (m_callbackServer->hasRoute(entity->callbackPath)) {
+        qCWarning(m_logCategory) << "Ignoring duplicate callback path" << entity->callbackPath << "of entity"
+                                 << entity->id;
+        return;
+    }
+    m_callbackServer->addRoute(entity->callbackPath, [this, entityHandler, entity](const CallbackRequest &request,
+                                                                                   CallbackResponse *response) {
+        handleCallback(entityHandler, entity, request, response);
+    });
+    m_callbackRoutes.insert(entity->callbackPath, entity);
+}
+
+EntityHandler *Webhook::createEntityHandler(const QString &entityType, const QString &baseUrl) {
+    EntityHandler *entityHandler = m_handlers.value(entityType);
+    if (entityHandler) {
+        return entityHandler;
+    }
+
+    if (entityType == "blind") {
+        entityHandler = new BlindHandler(baseUrl, this);
+    } else if (entityType == "climate") {
+        entityHandler = new ClimateHandler(baseUrl, this);
+    } else if (entityType == "light") {
+        entityHandler = new LightHandler(baseUrl, this);
+    } else if (entityType == "switch") {
+        entityHandler = new SwitchHandler(baseUrl, this);
+    } else {
+        return nullptr;
+    }
+
+    entityHandler->setRequestPool(&m_requestPool);
+    entityHandler->setMetrics(m_metrics.data());
+    entityHandler->setWatchdog(m_watchdog.data());
+    entityHandler->setPlaceholders(m_placeholders);
+    m_handlers.insert(entityType, entityHandler);
+    return entityHandler;
+}
+
+bool Webhook::readConfigCache(ConfigCache *cache, const QByteArray &key, const QString &baseUrl) {
+    QElapsedTimer timer;
+    timer.start();
+
+    QDataStream *in = cache->open(key);
+    if (!in) {
+        return false;
+    }
+
+    qint32 handlerCount;
+    *in >> handlerCount;
+    for (qint32 i = 0; i < handlerCount && in->status() == QDataStream::Ok; i++) {
+        QString entityType;
+        *in >> entityType;
+        EntityHandler *entityHandler = createEntityHandler(entityType, baseUrl);
+        if (!entityHandler || !entityHandler->readCache(*in)) {
+            in->setStatus(QDataStream::ReadCorruptData);
+        }
+    }
+
+    if (in->status() != QDataStream::Ok) {
+        qCWarning(m_logCategory) << "Ignoring invalid config cache:" << cache->fileName();
+        qDeleteAll(m_handlers);
+        m_handlers.clear();
+        cache->close();
+        return false;
+    }
+    cache->close();
+
+    qCInfo(m_logCategory) << "Loaded entities from config cache in" << timer.elapsed() << "ms";
+    return true;
+}
+
+void Webhook::writeConfigCache(ConfigCache *cache, const QByteArray &key) {
+    cache->save(key, [this](QDataStream &out) {
+        out << static_cast<qint32>(m_handlers.size());
+        for (auto iter = m_handlers.cbegin(); iter != m_handlers.cend(); ++iter) {
+            out << iter.key();
+            iter.value()->writeCache(out);
+        }
+    });
 }
 
 void Webhook::connect() {
     setState(CONNECTING);
 
+    // resolve the entity interfaces once instead of looking them up for every command and status update
+    for (const EntityRef &ref : qAsConst(m_entityRefs)) {
+        if (ref.entity) {
+            ref.entity->entityInterface = m_entities->getEntityInterface(ref.entity->id);
+        }
+    }
+
     for (EntityHandler *entityHandler : qAsConst(m_handlers)) {
         entityHandler->initialize(m_entities);
+        if (m_hostCache) {
+            for (const QString &host : entityHandler->commandHosts(m_placeholders)) {
+                m_hostCache->addHost(host);
+            }
+        }
+    }
+
+    if (m_callbackServer) {
+        m_callbackServer->listen(m_callbackPort);
+    }
+#ifdef WEBHOOK_MQTT
+    if (m_mqtt) {
+        m_mqtt->connectToBroker();
     }
+#endif
+
+    startSubscriptions();
 
     if (m_statusTimer) {
         // update immediately
+        m_pollScheduler.clear();
+        m_pollScheduler.scheduleAll();
         QTimer::singleShot(0, this, &Webhook::statusUpdate);
         // and periodically
         m_statusTimer->start();
@@ -127,6 +550,18 @@ void Webhook::disconnect() {
     if (m_statusTimer) {
         m_statusTimer->stop();
     }
+    m_dispatcher.dropQueuedPolls();
+    if (m_callbackServer) {
+        m_callbackServer->close();
+    }
+
+    stopSubscriptions();
+    m_socketTransport->closeAll();
+#ifdef WEBHOOK_MQTT
+    if (m_mqtt) {
+        m_mqtt->disconnectFromBroker();
+    }
+#endif
 
     setState(DISCONNECTED);
 }
@@ -135,14 +570,42 @@ void Webhook::enterStandby() {
     if (m_statusTimer) {
         m_statusTimer->stop();
     }
+    m_dispatcher.dropQueuedPolls();
+    if (m_hostCache) {
+        m_hostCache->setRefreshEnabled(false);
+    }
 }
 
 void Webhook::leaveStandby() {
+    if (m_hostCache) {
+        m_hostCache->setRefreshEnabled(true);
+    }
     if (m_statusTimer) {
+        // the app shows the state of the visible entities right after waking up: don't wait for the next polling run
+        if (state() == CONNECTED) {
+            m_pollEntities.clear();
+            m_pollScheduler.refreshPriorityEntities(QDateTime::currentMSecsSinceEpoch(), &m_pollEntities);
+            pollEntities();
+        }
         m_statusTimer->start();
     }
 }
 
+void Webhook::setVisibleEntities(const QStringList &entityIds) {
+    QSet<int> visible;
+    for (const QString &entityId : entityIds) {
+        const EntityRef *ref = entityRef(entityId);
+        if (ref) {
+            visible.insert(ref->entity->index);
+        }
+    }
+
+    m_pollEntities.clear();
+    m_pollScheduler.setVisibleEntities(visible, QDateTime::currentMSecsSinceEpoch(),
+                                       m_statusTimer && m_statusTimer->isActive(), &m_pollEntities);
+    pollEntities();
+}
+
 void Webhook::configureProxy(const QVariantMap &proxyCfg) {
     QNetworkProxy::ProxyType proxyType = QNetworkProxy::DefaultProxy;
 
@@ -161,57 +624,461 @@ void Webhook::configureProxy(const QVariantMap &proxyCfg) {
 }
 
 void Webhook::sendCommand(const QString &type, const QString &entityId, int command, const QVariant &param) {
-    EntityInterface *entity = m_entities->getEntityInterface(entityId);
+    Q_UNUSED(type)
+
+    // single hash lookup: the entity handle provides the handler, the command table and the entity interface
+    const EntityRef *ref = entityRef(entityId);
+    if (!ref) {
+        if (m_scenes.contains(entityId)) {
+            if (command == SwitchDef::C_ON || command == SwitchDef::C_TOGGLE) {
+                runScene(&m_scenes[entityId]);
+            }
+        } else {
+            qCWarning(m_logCategory) << "Entity not found:" << entityId;
+        }
+        return;
+    }
+
+    EntityInterface *entity = cachedEntityInterface(ref->entity);
     if (!entity) {
         qCWarning(m_logCategory) << "Entity not found:" << entityId;
         return;
     }
 
-    EntityHandler *entityHandler = m_handlers.value(type);
-    if (!entityHandler) {
-        qCWarning(m_logCategory) << "No EntityHandler found for type:" << entity->type();
+    ref->entity->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    WebhookRequest *request = createCommandRequest(*ref, entity, command, param);
+
+    QNetworkReply *reply = sendCommandRequest(request);
+    if (reply == nullptr) {
+        m_requestPool.release(request);
         return;
     }
 
-    WebhookRequest *request = entityHandler->createCommandRequest(entityId, entity, command, m_placeholders, param);
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, request, reply] {
+        reply->deleteLater();
+        handleCommandReply(request, reply);
+    });
+}
 
-    QNetworkReply *reply = sendWebhookRequest(request);
-    if (reply == nullptr) {
+WebhookRequest *Webhook::createCommandRequest(const EntityRef &ref, EntityInterface *entity, int command,
+                                              const QVariant &param) {
+    qint64          createdAt = m_tracer ? Metrics::now() : 0;
+    WebhookRequest *request = ref.handler->createCommandRequest(ref.entity, entity, command, m_placeholders, param);
+    if (request) {
+        // the reply context is stored in the pooled request instead of the reply handler
+        request->webhookEntity = ref.entity;
+        request->command = command;
+        request->param = param;
+        if (createdAt > 0) {
+            request->createdAt = createdAt;
+            request->queuedAt = Metrics::now();
+        }
+    }
+    return request;
+}
+
+const Webhook::EntityRef *Webhook::entityRef(const QString &entityId) const {
+    auto iter = m_entityIndex.constFind(entityId);
+    return iter == m_entityIndex.constEnd() ? nullptr : &m_entityRefs.at(iter.value());
+}
+
+EntityInterface *Webhook::cachedEntityInterface(WebhookEntity *webhookEntity) {
+    if (!webhookEntity->entityInterface) {
+        webhookEntity->entityInterface = m_entities->getEntityInterface(webhookEntity->id);
+    }
+    return webhookEntity->entityInterface;
+}
+
+void Webhook::handleCommandReply(WebhookRequest *request, QNetworkReply *reply) {
+    WebhookEntity   *webhookEntity = request->webhookEntity;
+    EntityHandler   *handler = m_entityRefs.at(webhookEntity->index).handler;
+    EntityInterface *entity = webhookEntity->entityInterface;
+    qint64           replyAt = m_tracer ? Metrics::now() : 0;
+    StallTimer       timer(m_watchdog.data(), StallWatchdog::COMMAND_REPLY, webhookEntity->id);
+
+    m_dispatcher.finish(request, reply);
+
+    if (!isRegistered(webhookEntity)) {
+        qCDebug(m_logCategory) << "Ignoring reply of removed entity:" << webhookEntity->id;
+        m_requestPool.release(request);
         return;
     }
 
-    QObject::connect(
-        reply, &QNetworkReply::finished, this, [this, entityHandler, command, entity, param, request, reply] {
-            request->deleteLater();
-            reply->deleteLater();
+    if (reply->error() == QNetworkReply::NoError) {
+        qCDebug(m_logCategory) << "Request finished successfully:" << request->webhookCommand->method
+                               << reply->url().url();
+    } else {
+        qCWarning(m_logCategory) << "Request failed:" << request->webhookCommand->method << reply->url().url() << "/"
+                                 << reply->error() << "/" << reply->errorString();
+    }
+
+    if (!request->optimistic) {
+        handler->commandReply(request->command, entity, request->param, request, reply);
+    } else if (!handler->optimisticCommandFinished(webhookEntity, request, reply)) {
+        // a newer command has already been applied and will reconcile the entity
+        qCDebug(m_logCategory) << "Ignoring reply of superseded command:" << reply->url().url();
+    }
+
+    if (m_tracer) {
+        traceRequest(request, reply, "command", replyAt);
+    }
+    m_requestPool.release(request);
+}
+
+QNetworkReply *Webhook::sendCommandRequest(WebhookRequest *request) {
+    QNetworkReply *reply = m_dispatcher.send(request);
+    if (!reply || !m_optimisticUpdates) {
+        return reply;
+    }
+
+    // show the intended state immediately instead of waiting for the device round-trip
+    WebhookEntity *webhookEntity = request->webhookEntity;
+    m_entityRefs.at(webhookEntity->index).handler->commandSent(webhookEntity, request);
+
+    return reply;
+}
+
+QVariantMap Webhook::compressionStats() const { return m_dispatcher.compressionStats(); }
+
+QVariantMap Webhook::metrics() const {
+    QVariantMap metrics = m_metrics ? m_metrics->toVariant() : QVariantMap();
+    metrics.insert("compression", compressionStats());
+    metrics.insert("lanes", m_dispatcher.laneStats());
+    metrics.insert("request_pool", requestPoolStats());
+    if (m_hostCache) {
+        metrics.insert("dns_cache", hostCacheStats());
+    }
+    if (m_watchdog) {
+        metrics.insert("event_loop", watchdogStats());
+    }
+    return metrics;
+}
+
+QVariantMap Webhook::watchdogStats() const { return m_watchdog ? m_watchdog->stats() : QVariantMap(); }
+
+QByteArray Webhook::chromeTrace() const { return m_tracer ? m_tracer->toChromeTrace() : QByteArray(); }
+
+void Webhook::traceRequest(const WebhookRequest *request, QNetworkReply *reply, const char *category, qint64 replyAt) {
+    const WebhookEntity *entity = request->webhookEntity;
+
+    Tracer::Args args;
+    // the trace is served over http: never record credentials or query parameters like an api key
+    args.url = request->networkRequest.url().toString(QUrl::RemoveUserInfo | QUrl::RemoveQuery);
+    QVariant httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    args.status = httpStatus.isValid() ? httpStatus.toInt() : -static_cast<int>(reply->error());
+    if (entity) {
+        args.entityId = entity->id;
+        if (request->command < 0) {
+            args.command = QStringLiteral("STATUS_POLLING");
+        } else {
+            int index = entity->commandIndex(request->command);
+            args.command = index < 0 ? QString::number(request->command) : entity->commands.nameAt(index);
+        }
+    }
+
+    // the device stage includes the host name resolution and connection setup of QNetworkAccessManager
+    quint64 id = request->sequence;
+    qint64  firstByteAt = request->firstByteAt > 0 ? request->firstByteAt : replyAt;
+    m_tracer->addSpan(category, "create", id, request->createdAt, request->queuedAt, args);
+    m_tracer->addSpan(category, "queue", id, request->queuedAt, request->sentAt, args);
+    m_tracer->addSpan(category, "device", id, request->sentAt, firstByteAt, args);
+    m_tracer->addSpan(category, "response", id, firstByteAt, replyAt, args);
+    m_tracer->addSpan(category, "reply", id, replyAt, Metrics::now(), args);
+}
+
+void Webhook::addTraceRoute(const QString &path) {
+    m_callbackServer->addRoute(path, [this](const CallbackRequest &request, CallbackResponse *response) {
+        Q_UNUSED(request)
+        response->contentType = "application/json";
+        response->body = chromeTrace();
+    });
+}
+
+QByteArray Webhook::prometheusMetrics() const { return m_metrics ? m_metrics->toPrometheus() : QByteArray(); }
+
+void Webhook::addMetricsRoute(const QString &path) {
+    m_callbackServer->addRoute(path, [this](const CallbackRequest &request, CallbackResponse *response) {
+        if (request.query.queryItemValue("format") == "json") {
+            response->contentType = "application/json";
+            response->body = QJsonDocument::fromVariant(metrics()).toJson(QJsonDocument::Compact);
+        } else {
+            response->contentType = "text/plain; version=0.0.4";
+            response->body = prometheusMetrics();
+        }
+    });
+}
+
+QVariantMap Webhook::requestPoolStats() const { return m_requestPool.stats(); }
+
+QVariantMap Webhook::hostCacheStats() const { return m_hostCache ? m_hostCache->stats() : QVariantMap(); }
+
+QVariantList Webhook::sceneResult(const QString &sceneId) const { return m_scenes.value(sceneId).lastResult; }
+
+void Webhook::readScenes(const QVariantList &scenesCfg) {
+    for (const QVariant &sceneCfg : scenesCfg) {
+        QVariantMap sceneCfgMap = sceneCfg.toMap();
+        Scene       scene;
+        scene.id = sceneCfgMap.value("entity_id").toString();
+        scene.friendlyName = sceneCfgMap.value("friendly_name", scene.id).toString();
+        scene.batch = nullptr;
+
+        if (scene.id.isEmpty() || m_scenes.contains(scene.id) || m_entityIndex.contains(scene.id)) {
+            qCWarning(m_logCategory) << "Ignoring scene with missing or duplicate entity_id:" << scene.id;
+            continue;
+        }
+
+        for (const QVariant &itemCfg : sceneCfgMap.value("items").toList()) {
+            QVariantMap itemCfgMap = itemCfg.toMap();
+            scene.items.append(
+                {itemCfgMap.value("entity_id").toString(), itemCfgMap.value("command").toString().toUpper(),
+                 itemCfgMap.value("param")});
+        }
+
+        m_scenes.insert(scene.id, scene);
+        addAvailableEntity(scene.id, "switch", integrationId(), scene.friendlyName, QStringList());
+    }
+}
+
+void Webhook::reloadScenes(const QVariantList &scenesCfg) {
+    QMap<QString, Scene> previous = m_scenes;
+    m_scenes.clear();
+    for (const Scene &scene : qAsConst(previous)) {
+        m_entities->removeAvailableEntity(scene.id);
+    }
+
+    readScenes(scenesCfg);
+
+    // a running scene reports its result to the new definition
+    for (auto iter = m_scenes.begin(); iter != m_scenes.end(); ++iter) {
+        auto previousScene = previous.constFind(iter.key());
+        if (previousScene != previous.constEnd()) {
+            iter->batch = previousScene->batch;
+            iter->lastResult = previousScene->lastResult;
+        }
+    }
+}
+
+void Webhook::runScene(Scene *scene) {
+    if (scene->batch) {
+        qCDebug(m_logCategory) << "Scene is already running:" << scene->id;
+        return;
+    }
+
+    EntityInterface *sceneEntity = m_entities->getEntityInterface(scene->id);
+    if (sceneEntity) {
+        sceneEntity->setState(SwitchDef::ON);
+    }
+
+    scene->batch = new RequestBatch(m_sceneMaxPerHost, this);
+
+    for (const SceneItem &item : qAsConst(scene->items)) {
+        QString          itemId = item.entityId + " " + item.command;
+        const EntityRef *ref = entityRef(item.entityId);
+        EntityInterface *entity = ref ? cachedEntityInterface(ref->entity) : nullptr;
+        int              command = ref ? ref->handler->featureToCommand(item.command) : -1;
+        if (!entity || command < 0) {
+            scene->batch->addFailed(itemId, "Unknown entity or command");
+            continue;
+        }
+
+        WebhookRequest *request = createCommandRequest(*ref, entity, command, item.param);
+        if (!request) {
+            scene->batch->addFailed(itemId, "Request could not be created");
+            continue;
+        }
+
+        // requests are limited per device, MQTT messages share the broker connection
+        QUrl    url = request->networkRequest.url();
+        QString host = url.host().isEmpty() ? url.scheme() : url.host();
+        scene->batch->add(
+            itemId, host,
+            [this, request]() -> QNetworkReply * {
+                QNetworkReply *reply = sendCommandRequest(request);
+                if (!reply) {
+                    m_requestPool.release(request);
+                }
+                return reply;
+            },
+            [this, request](QNetworkReply *reply) { handleCommandReply(request, reply); });
+    }
+
+    QString       sceneId = scene->id;
+    RequestBatch *batch = scene->batch;
+    QObject::connect(batch, &RequestBatch::finished, this, [this, sceneId, batch] {
+        qCInfo(m_logCategory) << "Scene" << sceneId << "finished:" << batch->successCount() << "of" << batch->size()
+                              << "commands successful";
+        for (const RequestBatch::Result &result : batch->results()) {
+            if (!result.success) {
+                qCWarning(m_logCategory) << "Scene" << sceneId << "command failed:" << result.id << result.error;
+            }
+        }
+        batch->deleteLater();
+
+        auto iter = m_scenes.find(sceneId);
+        if (iter == m_scenes.end() || iter->batch != batch) {
+            // removed by a configuration reload
+            return;
+        }
+        iter->lastResult = batch->resultList();
+        iter->batch = nullptr;
+
+        // a scene is stateless: reset the switch
+        EntityInterface *sceneEntity = m_entities->getEntityInterface(sceneId);
+        if (sceneEntity) {
+            sceneEntity->setState(SwitchDef::OFF);
+        }
+    });
+
+    qCDebug(m_logCategory) << "Running scene" << scene->id << "with" << scene->items.size() << "commands";
+    scene->batch->start();
+}
+
+/**
+ * @brief Creates a JSON document from a callback request for the response mappings.
+ * @details A JSON body is used as is, url query parameters and form data are added as string values to the root object.
+ */
+static QJsonDocument callbackDocument(const CallbackRequest &request) {
+    QJsonObject object;
+
+    if (!request.body.isEmpty()) {
+        if (request.contentType.startsWith("application/json")) {
+            QJsonDocument jsonDoc = QJsonDocument::fromJson(request.body);
+            if (!jsonDoc.isObject()) {
+                return jsonDoc;
+            }
+            object = jsonDoc.object();
+        } else if (request.contentType.startsWith("application/x-www-form-urlencoded")) {
+            QUrlQuery formData(QString::fromUtf8(request.body));
+            for (const auto &item : formData.queryItems(QUrl::FullyDecoded)) {
+                object.insert(item.first, item.second);
+            }
+        }
+    }
+
+    for (const auto &item : request.query.queryItems(QUrl::FullyDecoded)) {
+        if (!object.contains(item.first)) {
+            object.insert(item.first, item.second);
+        }
+    }
+
+    return QJsonDocument(object);
+}
+
+void Webhook::handleCallback(EntityHandler *handler, WebhookEntity *entity, const CallbackRequest &request,
+                             CallbackResponse *response) {
+    StallTimer       timer(m_watchdog.data(), StallWatchdog::CALLBACK, entity->id);
+    EntityInterface *entityInterface = cachedEntityInterface(entity);
+    if (!entityInterface) {
+        response->status = 404;
+        return;
+    }
+
+    int count = handler->updateFromDocument(entityInterface, entity, callbackDocument(request));
+    qCDebug(m_logCategory) << "Callback" << request.path << "updated" << count << "values of" << entity->id;
+
+    if (count > 0) {
+        entity->lastUpdate = QDateTime::currentMSecsSinceEpoch();
+    } else if (isRegistered(entity)) {
+        // a bare action callback without mappable values only signals a change: fetch the state right away
+        pollEntity(m_entityRefs.at(entity->index));
+    }
+}
+
+void Webhook::startSubscriptions() {
+    for (EntityHandler *entityHandler : qAsConst(m_handlers)) {
+        auto iter = entityHandler->entityIter();
+        while (iter.hasNext()) {
+            iter.next();
+            WebhookEntity *entity = iter.value();
+            WebhookRequest *request = entityHandler->createSubscribeRequest(entity, m_placeholders);
+            if (!request) {
+                continue;
+            }
 
-            if (reply->error() == QNetworkReply::NoError) {
-                qCDebug(m_logCategory) << "Request finished successfully:" << request->webhookCommand->method
-                                       << reply->url().url();
+            QString key;
+            if (request->webhookCommand->isMqtt()) {
+                if (!subscribeMqttTopic(request, &key)) {
+                    qCWarning(m_logCategory) << "MQTT broker not configured, ignoring subscription of entity"
+                                             << entity->id;
+                    m_requestPool.release(request);
+                    continue;
+                }
             } else {
-                qCWarning(m_logCategory) << "Request failed:" << request->webhookCommand->method << reply->url().url()
-                                         << "/" << reply->error() << "/" << reply->errorString();
+                bool                          ok;
+                StatusSubscription::Transport transport =
+                    StatusSubscription::transportFromString(request->webhookCommand->transport, &ok);
+                if (!ok) {
+                    qCWarning(m_logCategory) << "Invalid subscription transport" << request->webhookCommand->transport
+                                             << "of entity" << entity->id;
+                    m_requestPool.release(request);
+                    continue;
+                }
+
+                // entities with the same subscription url share a single connection
+                key = request->webhookCommand->transport + " " + request->networkRequest.url().url();
+                if (!m_subscriptions.contains(key)) {
+                    StatusSubscription *subscription = new StatusSubscription(
+                        transport, request->networkRequest, request->body, &m_networkManager, this);
+                    QObject::connect(subscription, &StatusSubscription::eventReceived, this,
+                                     [this, key](const QByteArray &data) { dispatchSubscriptionEvent(key, data); });
+                    m_subscriptions.insert(key, subscription);
+                }
             }
 
-            entityHandler->commandReply(command, entity, param, request, reply);
-        });
+            m_subscribers[key].append({entityHandler, entity, request->webhookCommand});
+            m_requestPool.release(request);
+        }
+    }
+
+    for (StatusSubscription *subscription : qAsConst(m_subscriptions)) {
+        subscription->start();
+    }
 }
 
-QNetworkReply *Webhook::sendWebhookRequest(WebhookRequest *request) {
-    if (!request) {
-        return nullptr;
+void Webhook::stopSubscriptions() {
+    for (StatusSubscription *subscription : qAsConst(m_subscriptions)) {
+        subscription->stop();
+        subscription->deleteLater();
     }
-    Q_ASSERT(request->webhookCommand);
+    m_subscriptions.clear();
+    m_subscribers.clear();
+#ifdef WEBHOOK_MQTT
+    if (m_mqtt) {
+        m_mqtt->unsubscribeAll();
+    }
+#endif
+}
+
+bool Webhook::subscribeMqttTopic(const WebhookRequest *request, QString *key) {
+#ifdef WEBHOOK_MQTT
+    if (m_mqtt) {
+        // all entities share the broker connection, messages are dispatched by topic filter
+        QString topicFilter = MqttTransport::topicFromUrl(request->networkRequest.url());
+        m_mqtt->subscribe(topicFilter, request->webhookCommand->qos);
+        *key = "mqtt " + topicFilter;
+        return true;
+    }
+#else
+    Q_UNUSED(request)
+    Q_UNUSED(key)
+#endif
+    return false;
+}
 
-    switch (request->webhookCommand->method) {
-        case HttpMethod::POST:
-            return m_networkManager.post(request->networkRequest, request->body);
-        case HttpMethod::PUT:
-            return m_networkManager.put(request->networkRequest, request->body);
-        case HttpMethod::DELETE:
-            return m_networkManager.deleteResource(request->networkRequest);
-        default:
-            return m_networkManager.get(request->networkRequest);
+void Webhook::dispatchSubscriptionEvent(const QString &key, const QByteArray &data) {
+    QJsonParseError parseError;
+    QJsonDocument   jsonDoc = QJsonDocument::fromJson(data, &parseError);
+    if (jsonDoc.isNull()) {
+        qCDebug(m_logCategory) << "Ignoring subscription event:" << parseError.errorString();
+        return;
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const Subscriber &subscriber : m_subscribers.value(key)) {
+        EntityInterface *entity = cachedEntityInterface(subscriber.entity);
+        if (subscriber.handler->handleSubscriptionEvent(entity, subscriber.command, jsonDoc) > 0) {
+            subscriber.entity->lastUpdate = now;
+        }
     }
 }
 
@@ -221,33 +1088,70 @@ void Webhook::ignoreSslErrors(QNetworkReply *reply, const QList<QSslError> &erro
 }
 
 void Webhook::statusUpdate() {
-    // Proof of concept only! Verify if this blocks the main thread for too long. Otherwise use a processing thread.
-    for (EntityHandler *handler : qAsConst(m_handlers)) {
-        QMapIterator<QString, WebhookEntity *> entityIter = handler->entityIter();
-        while (entityIter.hasNext()) {
-            entityIter.next();
-            const WebhookEntity *entity = entityIter.value();
-            if (handler->hasStatusCommand(entity->id)) {
-                WebhookRequest *statusRequest = handler->createStatusRequest(entity->id, m_placeholders);
-
-                QNetworkReply *reply = sendWebhookRequest(statusRequest);
-                if (reply == nullptr) {
-                    return;
-                }
+    // runs in the main thread: the time per run is reported by the watchdog
+    StallTimer timer(m_watchdog.data(), StallWatchdog::STATUS_UPDATE);
 
-                QObject::connect(reply, &QNetworkReply::finished, this, [this, handler, entity, statusRequest, reply] {
-                    statusRequest->deleteLater();
-                    reply->deleteLater();
+    m_pollEntities.clear();
+    m_pollScheduler.advance(QDateTime::currentMSecsSinceEpoch(), &m_pollEntities);
+    pollEntities();
+}
 
-                    if (reply->error() != QNetworkReply::NoError) {
-                        qCWarning(m_logCategory)
-                            << "Status request failed:" << entity->friendlyName << reply->url().url() << "/"
-                            << reply->error() << "/" << reply->errorString();
-                    }
+void Webhook::pollEntities() {
+    for (WebhookEntity *entity : qAsConst(m_pollEntities)) {
+        pollEntity(m_entityRefs.at(entity->index));
+    }
+}
 
-                    handler->statusReply(m_entities->getEntityInterface(entity->id), statusRequest, reply);
-                });
-            }
+void Webhook::pollEntity(const EntityRef &ref) {
+    WebhookEntity *entity = ref.entity;
+
+    qint64          createdAt = m_tracer ? Metrics::now() : 0;
+    WebhookRequest *statusRequest = ref.handler->createStatusRequest(entity, m_placeholders);
+    if (!statusRequest) {
+        return;
+    }
+    if (createdAt > 0) {
+        statusRequest->createdAt = createdAt;
+        statusRequest->queuedAt = Metrics::now();
+    }
+
+    // polls are deferred while commands to the same host are in flight and may be dropped if the host is busy
+    statusRequest->webhookEntity = entity;
+    m_dispatcher.sendPoll(statusRequest, [this, statusRequest](QNetworkReply *reply) {
+        if (reply == nullptr) {
+            m_requestPool.release(statusRequest);
+            return;
         }
+        QObject::connect(reply, &QNetworkReply::finished, this, [this, statusRequest, reply] {
+            reply->deleteLater();
+            handleStatusReply(statusRequest, reply);
+        });
+    });
+}
+
+void Webhook::handleStatusReply(WebhookRequest *request, QNetworkReply *reply) {
+    WebhookEntity *entity = request->webhookEntity;
+    qint64         replyAt = m_tracer ? Metrics::now() : 0;
+    StallTimer     timer(m_watchdog.data(), StallWatchdog::STATUS_REPLY, entity->id);
+
+    m_dispatcher.finish(request, reply);
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qCWarning(m_logCategory) << "Status request failed:" << entity->friendlyName << reply->url().url() << "/"
+                                 << reply->error() << "/" << reply->errorString();
+    }
+
+    // don't overwrite the intended state of pending or newer commands with an outdated status
+    if (!isRegistered(entity)) {
+        qCDebug(m_logCategory) << "Ignoring status of removed entity:" << entity->id;
+    } else if (!EntityHandler::acceptsStatus(entity, request)) {
+        qCDebug(m_logCategory) << "Ignoring outdated status of" << entity->id;
+    } else {
+        m_entityRefs.at(entity->index).handler->statusReply(cachedEntityInterface(entity), request, reply);
+    }
+
+    if (m_tracer) {
+        traceRequest(request, reply, "poll", replyAt);
     }
+    m_requestPool.release(request);
 }
@@ -22,17 +22,33 @@
 
 #pragma once
 
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QScopedPointer>
 #include <QSslError>
 #include <QString>
+#include <QStringList>
 #include <QTimer>
 #include <QVariantMap>
+#include <QVector>
 
+#include "callbackserver.h"
+#include "configcache.h"
 #include "entityhandler.h"
+#include "hostcache.h"
+#include "metrics.h"
+#include "pollscheduler.h"
+#include "requestbatch.h"
+#include "requestdispatcher.h"
+#include "requestpool.h"
+#include "sockettransport.h"
+#include "stallwatchdog.h"
+#include "statussubscription.h"
+#include "tracer.h"
 #include "webhookentity.h"
 #include "yio-interface/configinterface.h"
 #include "yio-interface/entities/entitiesinterface.h"
@@ -44,6 +60,8 @@
 
 const bool USE_WORKER_THREAD = false;
 
+class MqttTransport;
+
 class WebhookPlugin : public Plugin {
     Q_OBJECT
     Q_INTERFACES(PluginInterface)
@@ -72,16 +90,155 @@ class Webhook : public Integration {
  public:
     void sendCommand(const QString& type, const QString& entityId, int command, const QVariant& param) override;
 
+    /**
+     * @brief Returns the accumulated response compression statistics: bytes on the wire, decoded bytes and decoding
+     * time.
+     */
+    QVariantMap compressionStats() const;
+
+    /**
+     * @brief Returns the host name resolution cache statistics, or an empty map if the cache is disabled.
+     */
+    QVariantMap hostCacheStats() const;
+
+    /**
+     * @brief Returns the request pool statistics: free-list size, requests in use, high-water mark, allocations and
+     * reuses.
+     */
+    QVariantMap requestPoolStats() const;
+
+    /**
+     * @brief Returns the request metrics per host and request type together with the compression, request lane, request
+     * pool, host cache and event loop statistics.
+     */
+    QVariantMap metrics() const;
+
+    /**
+     * @brief Returns the event loop time per section: runs, runs over budget and the rolling maximum and percentiles,
+     * or an empty map if the watchdog is disabled.
+     */
+    QVariantMap watchdogStats() const;
+
+    /**
+     * @brief Returns the request metrics in the Prometheus text exposition format, or an empty text if disabled.
+     */
+    QByteArray prometheusMetrics() const;
+
+    /**
+     * @brief Returns the recorded request stages in the Chrome trace event format, or an empty text if tracing is
+     * disabled.
+     */
+    QByteArray chromeTrace() const;
+
+    /**
+     * @brief Returns the per-item results of the last execution of the given scene.
+     */
+    QVariantList sceneResult(const QString& sceneId) const;
+
+    /**
+     * @brief Applies a changed integration configuration without recreating the integration.
+     * @details Only added, changed and removed entities are processed: unchanged entities keep their commands,
+     * in-flight requests and polling schedule. Changed entities are updated in place and announced again.
+     * @param config Integration configuration with the same structure as the constructor configuration.
+     * @return false if a changed connection setting like the proxy, MQTT broker or callback server requires recreating
+     * the integration. Nothing has been changed in this case.
+     */
+    bool reloadConfig(const QVariantMap& config);
+
  public slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
     void connect() override;
     void disconnect() override;
     void enterStandby() override;
     void leaveStandby() override;
 
+    /**
+     * @brief Sets the entities shown on the current page of the app. Visible and recently used entities are polled
+     * first and at the status polling interval, hidden entities only at the `hidden_interval` of `polling_priority`.
+     * @details All entities are polled alike until the visible entities have been set. Newly visible entities with a
+     * state older than the status polling interval are refreshed immediately.
+     */
+    void setVisibleEntities(const QStringList& entityIds);
+
  private:
     void           addAvailableEntities(const QList<WebhookEntity*>& entities);
+    EntityHandler* createEntityHandler(const QString& entityType, const QString& baseUrl);
+    bool           readConfigCache(ConfigCache* cache, const QByteArray& key, const QString& baseUrl);
+    void           writeConfigCache(ConfigCache* cache, const QByteArray& key);
+    void           setStatusPolling(int seconds);
+    void           setPollingPriority(const QVariantMap& priorityCfg);
+    bool           registerEntity(EntityHandler* entityHandler, WebhookEntity* entity);
+    void           unregisterEntity(WebhookEntity* entity);
+    bool           isRegistered(const WebhookEntity* entity) const;
+    void           addCallbackRoute(EntityHandler* entityHandler, WebhookEntity* entity);
+    void           addMetricsRoute(const QString& path);
+    void           addTraceRoute(const QString& path);
     void           configureProxy(const QVariantMap& proxyCfg);
-    QNetworkReply* sendWebhookRequest(WebhookRequest* request);
+    QNetworkReply* sendCommandRequest(WebhookRequest* request);
+    void           handleCommandReply(WebhookRequest* request, QNetworkReply* reply);
+    void           handleStatusReply(WebhookRequest* request, QNetworkReply* reply);
+    void           traceRequest(const WebhookRequest* request, QNetworkReply* reply, const char* category,
+                                qint64 replyAt);
+    void           handleCallback(EntityHandler* handler, WebhookEntity* entity, const CallbackRequest& request,
+                                  CallbackResponse* response);
+
+ private:
+    /**
+     * @brief Integer entity handle, resolved once when reading the configuration.
+     * @details The dense index is stored in WebhookEntity::index. Commands are looked up with the command enum in the
+     * command table of the entity, the entity interface is cached at connect(). The entity of a handle is null after it
+     * has been removed with a configuration reload.
+     */
+    struct EntityRef {
+        EntityHandler* handler;
+        WebhookEntity* entity;
+    };
+
+    const EntityRef* entityRef(const QString& entityId) const;
+    EntityInterface* cachedEntityInterface(WebhookEntity* webhookEntity);
+    WebhookRequest*  createCommandRequest(const EntityRef& ref, EntityInterface* entity, int command,
+                                          const QVariant& param);
+    void             pollEntity(const EntityRef& ref);
+    void             pollEntities();
+
+ private:
+    /**
+     * @brief Entity subscribed to the events of a status subscription.
+     */
+    struct Subscriber {
+        EntityHandler*        handler;
+        WebhookEntity*        entity;
+        const WebhookCommand* command;
+    };
+
+    void startSubscriptions();
+    void stopSubscriptions();
+    bool subscribeMqttTopic(const WebhookRequest* request, QString* key);
+    void dispatchSubscriptionEvent(const QString& key, const QByteArray& data);
+
+ private:
+    /**
+     * @brief Entity command of a scene.
+     */
+    struct SceneItem {
+        QString  entityId;
+        QString  command;
+        QVariant param;
+    };
+
+    /**
+     * @brief Scene definition, exposed as a switch entity. Turning the switch on executes all scene commands.
+     */
+    struct Scene {
+        QString            id;
+        QString            friendlyName;
+        QVector<SceneItem> items;
+        RequestBatch*      batch;
+        QVariantList       lastResult;
+    };
+
+    void readScenes(const QVariantList& scenesCfg);
+    void reloadScenes(const QVariantList& scenesCfg);
+    void runScene(Scene* scene);
 
  private slots:  // NOLINT open issue: https://github.com/cpplint/cpplint/pull/99
     void ignoreSslErrors(QNetworkReply* reply, const QList<QSslError>& errors);
@@ -89,7 +246,34 @@ class Webhook : public Integration {
 
  private:
     QNetworkAccessManager         m_networkManager;
+    RequestDispatcher             m_dispatcher;
+    RequestPool                   m_requestPool;
     QMap<QString, EntityHandler*> m_handlers;
+    QVector<EntityRef>            m_entityRefs;
+    QHash<QString, int>           m_entityIndex;
+    QVariantMap                   m_configData;
     QVariantMap                   m_placeholders;
+    bool                          m_optimisticUpdates;
+    HostCache*                    m_hostCache;
+    QScopedPointer<Metrics>       m_metrics;
+    QScopedPointer<Tracer>        m_tracer;
+    QScopedPointer<StallWatchdog> m_watchdog;
+    CallbackServer*               m_callbackServer;
+    quint16                       m_callbackPort;
     QTimer*                       m_statusTimer;
+    /**
+     * @brief Polling schedule of the entities, advanced every second by the status timer.
+     */
+    PollScheduler                 m_pollScheduler;
+    QVector<WebhookEntity*>       m_pollEntities;
+    MqttTransport*                m_mqtt;
+    SocketTransport*              m_socketTransport;
+
+    QHash<QString, WebhookEntity*> m_callbackRoutes;
+
+    QMap<QString, StatusSubscription*>  m_subscriptions;
+    QHash<QString, QVector<Subscriber>> m_subscribers;
+
+    QMap<QString, Scene> m_scenes;
+    int                  m_sceneMaxPerHost;
 };
@@ -22,18 +22,43 @@
 
 #pragma once
 
-#include <QObject>
+#include <QPair>
 #include <QString>
 #include <QVariantMap>
+#include <QVector>
 
 #include "httpmethod.h"
+#include "placeholders.h"
+#include "socketframing.h"
+#include "valuetransform.h"
+
+/**
+ * @brief Ordered list of key -> value mappings, e.g. entity attribute -> JsonPath of a response mapping.
+ * @details Equal lists are shared between all commands and entities by the ConfigStore.
+ */
+typedef QVector<QPair<QString, QString>> MappingList;
+
+/**
+ * @brief Ordered list of compiled request header name -> value templates.
+ * @details Equal header blocks are shared between all commands by the ConfigStore.
+ */
+typedef QVector<QPair<QByteArray, TextTemplate>> HeaderTemplates;
 
 /**
  * @brief Webhook raw command data, read from the configuration.
+ * @details Plain record stored in the ConfigStore of the EntityHandler.
  */
-class WebhookCommand : public QObject {
+class WebhookCommand {
  public:
-    explicit WebhookCommand(QObject* parent = nullptr) : QObject(parent), method(HttpMethod::GET) {}
+    WebhookCommand()
+        : method(HttpMethod::GET),
+          compressBody(false),
+          qos(0),
+          retain(false),
+          framing(SocketFraming::NONE),
+          hexBody(false),
+          interval(0),
+          placeholderMask(0) {}
 
  public:
     QString                command;
@@ -41,5 +66,59 @@ class WebhookCommand : public QObject {
     HttpMethod::Enum       method;
     QVariantMap            headers;
     QVariant               body;
-    QMap<QString, QString> responseMappings;
+    MappingList            responseMappings;
+    bool                   compressBody;
+    /**
+     * @brief Compiled value transforms of the response mappings.
+     */
+    TransformList responseTransforms;
+    /**
+     * @brief Subscription transport of a status subscription command: sse, long_poll, websocket, mqtt.
+     */
+    QString transport;
+    /**
+     * @brief Optional JsonPath -> value filter of subscription events. All values must match to process an event.
+     */
+    MappingList eventFilter;
+    /**
+     * @brief MQTT quality of service level of a published command or status subscription: 0, 1 or 2.
+     */
+    quint8 qos;
+    /**
+     * @brief Publish a MQTT command as retained message.
+     */
+    bool retain;
+    /**
+     * @brief Response framing of a tcp command.
+     */
+    SocketFraming::Enum framing;
+    /**
+     * @brief The rendered body is a hex string and sent as binary data, e.g. a Wake-on-LAN magic packet.
+     */
+    bool hexBody;
+    /**
+     * @brief Polling interval in seconds of a status polling command, 0 = status_polling interval of the integration.
+     */
+    int interval;
+
+    /**
+     * @brief Compiled url, body and header templates, rendered with the placeholder values of every request.
+     */
+    TextTemplate    urlTemplate;
+    TextTemplate    bodyTemplate;
+    HeaderTemplates headerTemplates;
+    /**
+     * @brief Placeholder mask of the dynamic placeholders referenced by the url, body and header templates.
+     */
+    quint32 placeholderMask;
+
+    /**
+     * @brief Returns true if the command is published to a MQTT topic instead of sending a http request.
+     */
+    bool isMqtt() const { return url.startsWith("mqtt:"); }
+
+    /**
+     * @brief Returns true if the command is sent over a raw udp or tcp socket instead of sending a http request.
+     */
+    bool isSocket() const { return url.startsWith("udp://") || url.startsWith("tcp://"); }
 };
@@ -22,18 +22,154 @@
 
 #pragma once
 
-#include <QMap>
+#include <QPair>
 #include <QString>
 #include <QStringList>
+#include <QVariant>
+#include <QVector>
 
 #include "webhookcommand.h"
 
-class WebhookEntity : public QObject {
+class EntityInterface;
+
+/**
+ * @brief Command name -> command lookup table of an entity.
+ * @details An entity only defines a handful of commands: a linear search in a contiguous array is faster and much
+ * smaller than a map. The commands are owned by the ConfigStore.
+ *
+ * Commands are materialized lazily: the table keeps the shared command configuration until the EntityHandler creates
+ * the command on first use.
+ */
+class CommandTable {
+ public:
+    /**
+     * @brief Adds or replaces the command with the given name.
+     * @param config Command configuration if the command is materialized on first use.
+     * @param command Already materialized command, or null.
+     * @return Table index of the command.
+     */
+    int insert(const QString &name, const QVariant &config, WebhookCommand *command = nullptr) {
+        int index = indexOf(name);
+        if (index < 0) {
+            index = m_commands.size();
+            m_commands.append(Entry());
+        }
+        Entry &entry = m_commands[index];
+        entry.name = name;
+        entry.config = config;
+        entry.command = command;
+        return index;
+    }
+
+    int indexOf(const QString &name) const {
+        for (int i = 0; i < m_commands.size(); i++) {
+            if (m_commands.at(i).name == name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Returns the command with the given name, or null if not defined or not yet materialized.
+     */
+    WebhookCommand *value(const QString &name) const {
+        int index = indexOf(name);
+        return index < 0 ? nullptr : m_commands.at(index).command;
+    }
+
+    bool contains(const QString &name) const { return indexOf(name) >= 0; }
+
+    int             size() const { return m_commands.size(); }
+    bool            isEmpty() const { return m_commands.isEmpty(); }
+    const QString  &nameAt(int index) const { return m_commands.at(index).name; }
+    const QVariant &configAt(int index) const { return m_commands.at(index).config; }
+    WebhookCommand *at(int index) const { return m_commands.at(index).command; }
+
+    /**
+     * @brief Stores the materialized command and releases its configuration.
+     * @details The table is a cache of the configuration: materializing a command doesn't change the logical state
+     * of the entity.
+     */
+    void setMaterialized(int index, WebhookCommand *command) const {
+        const Entry &entry = m_commands.at(index);
+        entry.command = command;
+        entry.config = QVariant();
+    }
+
+    /**
+     * @brief Releases the unused capacity after all commands have been inserted.
+     */
+    void squeeze() { m_commands.squeeze(); }
+
+ private:
+    struct Entry {
+        Entry() : command(nullptr) {}
+
+        QString                 name;
+        mutable QVariant        config;
+        mutable WebhookCommand *command;
+    };
+
+    QVector<Entry> m_commands;
+};
+
+/**
+ * @brief Webhook entity definition, read from the configuration.
+ * @details Plain record stored in the ConfigStore of the EntityHandler.
+ */
+class WebhookEntity {
  public:
-    explicit WebhookEntity(QObject *parent = nullptr) : QObject(parent) {}
-    explicit WebhookEntity(const QString &id, const QString &type, const QString &friendlyName,
-                           const QVariantMap &attributes, QObject *parent = nullptr)
-        : QObject(parent), id(id), type(type), friendlyName(friendlyName), attributes(attributes) {}
+    WebhookEntity()
+        : statusCommand(nullptr),
+          subscribeCommand(nullptr),
+          pollInterval(-1),
+          lastUpdate(0),
+          lastUsed(0),
+          visible(false),
+          commandSequence(0),
+          pendingCommands(0),
+          index(-1),
+          entityInterface(nullptr) {}
+
+    /**
+     * @brief Returns the command table index for the given entity specific command enum, e.g. LightDef::C_ON, or -1 if
+     * not defined.
+     */
+    int commandIndex(int command) const {
+        return command >= 0 && command < commandSlots.size() ? commandSlots.at(command) : -1;
+    }
+
+    /**
+     * @brief Adds the command table index to the command enum lookup table.
+     */
+    void setCommandSlot(int command, int index) {
+        if (command < 0) {
+            return;
+        }
+        if (command >= commandSlots.size()) {
+            commandSlots.insert(commandSlots.size(), command + 1 - commandSlots.size(), -1);
+        }
+        commandSlots[command] = index;
+    }
+
+    /**
+     * @brief Clears the definition read from the configuration before it is read again. The runtime state like the
+     * last update, pending commands and the entity index is kept.
+     */
+    void resetDefinition() {
+        friendlyName.clear();
+        attributes.clear();
+        supportedFeatures.clear();
+        commands = CommandTable();
+        commandSlots.clear();
+        statusCommand = nullptr;
+        subscribeCommand = nullptr;
+        callbackPath.clear();
+        callbackMappings.clear();
+        callbackTransforms.clear();
+        pollInterval = -1;
+    }
 
  public:
     QString     id;
@@ -42,5 +178,57 @@ class WebhookEntity : public QObject {
     QVariantMap attributes;
     QStringList supportedFeatures;
 
-    QMap<QString, WebhookCommand *> commands;
+    CommandTable commands;
+    /**
+     * @brief Command table index lookup table indexed by the entity specific command enum. Built once when reading
+     * the configuration.
+     */
+    QVector<int> commandSlots;
+    /**
+     * @brief Status polling and subscription commands are materialized when reading the configuration.
+     */
+    WebhookCommand *statusCommand;
+    WebhookCommand *subscribeCommand;
+
+    /**
+     * @brief Url path of the callback server for pushed state updates. Empty if not enabled.
+     */
+    QString callbackPath;
+    /**
+     * @brief Response mappings of pushed state updates. The status polling mappings are used if empty.
+     */
+    MappingList   callbackMappings;
+    TransformList callbackTransforms;
+    /**
+     * @brief Minimal status polling interval in seconds since the last update: -1 = polling interval, 0 = disabled.
+     */
+    int pollInterval;
+    /**
+     * @brief Timestamp in ms since epoch of the last pushed state update or status request.
+     */
+    qint64 lastUpdate;
+    /**
+     * @brief Timestamp in ms since epoch of the last command sent to the entity.
+     */
+    qint64 lastUsed;
+    /**
+     * @brief Entity is shown on the current page of the app. Set with Webhook::setVisibleEntities.
+     */
+    bool visible;
+    /**
+     * @brief Request sequence number of the last optimistically applied command.
+     */
+    quint64 commandSequence;
+    /**
+     * @brief Number of optimistically applied commands waiting for their reply.
+     */
+    int pendingCommands;
+    /**
+     * @brief Dense entity index of the integration, -1 if the entity has not been registered.
+     */
+    int index;
+    /**
+     * @brief Cached entity interface of the app, resolved at connect().
+     */
+    EntityInterface *entityInterface;
 };
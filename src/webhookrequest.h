@@ -24,19 +24,97 @@
 
 #include <QByteArray>
 #include <QNetworkRequest>
-#include <QObject>
+#include <QString>
+#include <QVariant>
 
+#include "compression.h"
+#include "undorecord.h"
 #include "webhookcommand.h"
 
+class WebhookEntity;
+
 /**
  * @brief Webhook request, prepared from the configuration to create a network request.
  */
-class WebhookRequest : public QObject {
+class WebhookRequest {
  public:
-    explicit WebhookRequest(QObject* parent = nullptr) : QObject(parent), webhookCommand(nullptr) {}
+    WebhookRequest()
+        : webhookCommand(nullptr),
+          sequence(0),
+          createdAt(0),
+          queuedAt(0),
+          sentAt(0),
+          firstByteAt(0),
+          optimistic(false),
+          poll(false),
+          webhookEntity(nullptr),
+          command(-1) {}
+
+    /**
+     * @brief Resets all request data to reuse the object from the RequestPool.
+     */
+    void reset() {
+        webhookCommand = nullptr;
+        networkRequest = QNetworkRequest();
+        body.clear();
+        response.reset();
+        cachedHost.clear();
+        sequence = 0;
+        createdAt = 0;
+        queuedAt = 0;
+        sentAt = 0;
+        firstByteAt = 0;
+        optimistic = false;
+        poll = false;
+        undo = UndoRecord();
+        webhookEntity = nullptr;
+        command = -1;
+        param.clear();
+    }
 
  public:
     const WebhookCommand* webhookCommand;
     QNetworkRequest       networkRequest;
     QByteArray            body;
+    InflateStream         response;
+    /**
+     * @brief Original host name if the url host has been replaced with a cached address.
+     */
+    QString cachedHost;
+    /**
+     * @brief Sequence number in sending order.
+     */
+    quint64 sequence;
+    /**
+     * @brief Metrics::now() timestamps in ns for metrics and tracing, 0 if not recorded: creation started, request
+     * created and waiting to be sent, request sent and response headers received.
+     */
+    qint64 createdAt;
+    qint64 queuedAt;
+    qint64 sentAt;
+    qint64 firstByteAt;
+    /**
+     * @brief True if the intended entity state has been applied when the command was sent.
+     */
+    bool optimistic;
+    /**
+     * @brief True if the request has been sent in the poll lane of the RequestDispatcher.
+     */
+    bool poll;
+    /**
+     * @brief Previous entity values of an optimistically applied command.
+     */
+    UndoRecord undo;
+    /**
+     * @brief Reply context: the requesting entity.
+     */
+    WebhookEntity* webhookEntity;
+    /**
+     * @brief Reply context: the entity specific command of a command request, -1 for other requests.
+     */
+    int command;
+    /**
+     * @brief Reply context: the command parameter provided from the app.
+     */
+    QVariant param;
 };
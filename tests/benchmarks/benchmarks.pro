@@ -0,0 +1,14 @@
+# Micro-benchmarks are not part of `make check`. Run them manually, e.g.:
+# ./tst_dispatchbenchmark -o result.xml,xml
+# or run all of them with the XML results written to an output directory:
+# run-benchmarks.sh <benchmarks build directory> [output directory]
+# The end-to-end load test runs a local mock device fleet and is configured with LOADTEST_* environment variables:
+# LOADTEST_DEVICES=200 LOADTEST_LATENCY_MS=50 ./tst_loadtest
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    dispatchbenchmark \
+    hotpathbenchmark \
+    loadtest \
+    requestpoolbenchmark \
+    startupbenchmark
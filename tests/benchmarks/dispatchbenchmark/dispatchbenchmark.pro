@@ -0,0 +1,29 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_dispatchbenchmark
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file" )
+}
+
+include($$PWD/../../webhook-core.pri)
+
+HEADERS += \
+    $$INCDIR/switchhandler.h
+
+SOURCES += \
+    tst_dispatchbenchmark.cpp \
+    $$INCDIR/switchhandler.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
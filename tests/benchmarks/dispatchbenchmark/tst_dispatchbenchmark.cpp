@@ -0,0 +1,123 @@
+#include <QHash>
+#include <QMap>
+#include <QtTest>
+
+#include "switchhandler.h"
+#include "yio-interface/entities/switchinterface.h"
+
+/**
+ * @brief Compares the former string keyed command dispatch with the integer entity handles and command tables.
+ */
+class DispatchBenchmark : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void benchmarkStringLookup();
+    void benchmarkIndexedLookup();
+    void benchmarkCreateCommandRequest();
+
+ private:
+    static const int ENTITY_COUNT = 500;
+
+    SwitchHandler*                m_handler = nullptr;
+    QMap<QString, EntityHandler*> m_handlers;
+    QStringList                   m_entityIds;
+    QVector<WebhookEntity*>       m_entityRefs;
+    QHash<QString, int>           m_entityIndex;
+};
+
+void DispatchBenchmark::initTestCase() {
+    QVariantList entities;
+    for (int i = 0; i < ENTITY_COUNT; i++) {
+        QString     host = QString("http://10.0.%1.%2").arg(i / 250).arg(i % 250 + 1);
+        QVariantMap commands;
+        commands.insert("ON", host + "/relay/0?turn=on");
+        commands.insert("OFF", host + "/relay/0?turn=off");
+        commands.insert("TOGGLE", host + "/relay/0?turn=toggle");
+        commands.insert("STATUS_POLLING", host + "/status");
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entities.append(entity);
+    }
+
+    m_handler = new SwitchHandler("");
+    QCOMPARE(m_handler->readEntities(entities, QVariantMap()), ENTITY_COUNT);
+    m_handlers.insert("blind", nullptr);
+    m_handlers.insert("climate", nullptr);
+    m_handlers.insert("light", nullptr);
+    m_handlers.insert("switch", m_handler);
+
+    // dense entity index like Webhook::m_entityRefs
+    auto iter = m_handler->entityIter();
+    while (iter.hasNext()) {
+        iter.next();
+        m_entityIndex.insert(iter.key(), m_entityRefs.size());
+        m_entityRefs.append(iter.value());
+        m_entityIds.append(iter.key());
+    }
+}
+
+void DispatchBenchmark::cleanupTestCase() { delete m_handler; }
+
+void DispatchBenchmark::benchmarkStringLookup() {
+    QString type = "switch";
+    int     command = SwitchDef::C_TOGGLE;
+    int     found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (const QString& entityId : qAsConst(m_entityIds)) {
+            // handler by type name, entity by id, command by the feature name of the command enum
+            EntityHandler* handler = m_handlers.value(type);
+            WebhookEntity* entity = handler->webhookEntity(entityId);
+            QString        feature;
+            switch (command) {
+                case SwitchDef::C_TOGGLE:
+                    feature = "TOGGLE";
+                    break;
+                default:
+                    feature = "ON";
+            }
+            if (entity && entity->commands.contains(feature)) {
+                found++;
+            }
+        }
+    }
+    QCOMPARE(found, ENTITY_COUNT);
+}
+
+void DispatchBenchmark::benchmarkIndexedLookup() {
+    int command = SwitchDef::C_TOGGLE;
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (const QString& entityId : qAsConst(m_entityIds)) {
+            int index = m_entityIndex.value(entityId, -1);
+            if (index >= 0 && m_entityRefs.at(index)->commandIndex(command) >= 0) {
+                found++;
+            }
+        }
+    }
+    QCOMPARE(found, ENTITY_COUNT);
+}
+
+void DispatchBenchmark::benchmarkCreateCommandRequest() {
+    WebhookEntity* entity = m_entityRefs.at(m_entityIndex.value("switch.device_42"));
+    QVariantMap    placeholders;
+
+    QBENCHMARK {
+        WebhookRequest* request =
+            m_handler->createCommandRequest(entity, nullptr, SwitchDef::C_TOGGLE, placeholders, QVariant());
+        QVERIFY(request);
+        delete request;
+    }
+}
+
+QTEST_GUILESS_MAIN(DispatchBenchmark)
+
+#include "tst_dispatchbenchmark.moc"
@@ -0,0 +1,39 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_hotpathbenchmark
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file" )
+}
+
+include($$PWD/../../webhook-core.pri)
+INCLUDEPATH += $$PWD/../../entityhandlertest
+
+HEADERS += \
+    $$PWD/../../entityhandlertest/entityhandlerimpl.h \
+    $$INCDIR/timingwheel.h
+
+SOURCES += \
+    tst_hotpathbenchmark.cpp \
+    $$INCDIR/timingwheel.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+DISTFILES += \
+    testdata/shelly1-status-response.json
+
+# myStrom responses are shared with the JsonPath unit test
+RESOURCES += \
+    testfiles.qrc \
+    $$PWD/../../jsonpathtest/testfiles.qrc
@@ -0,0 +1,296 @@
+#include <QFile>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include "entityhandlerimpl.h"
+#include "jsonpath.h"
+#include "timingwheel.h"
+
+/**
+ * @brief Exposes the protected request and response functions of the entity handler.
+ * @details The entity update is null-safe: the mapped values are only counted, no EntityInterface is required.
+ */
+class BenchmarkHandler : public EntityHandlerImpl {
+ public:
+    explicit BenchmarkHandler(const QString& baseUrl) : EntityHandlerImpl("switch", baseUrl), updatedValues(0) {}
+
+    using EntityHandler::buildUrl;
+    using EntityHandler::createRequest;
+    using EntityHandler::readCommand;
+    using EntityHandler::readMappings;
+    using EntityHandler::resolveVariables;
+    using EntityHandler::retrieveResponseValues;
+    using EntityHandler::updateFromDocument;
+
+    int updatedValues;
+
+ protected:
+    void updateEntity(EntityInterface* entity, const QVariantMap& placeholders) override {
+        Q_UNUSED(entity)
+        updatedValues = placeholders.size();
+    }
+};
+
+/**
+ * @brief Micro-benchmarks of the command request and status response hot paths.
+ * @details Write the results in a machine-readable format with `-o result.xml,xml` or `-csv`.
+ */
+class HotPathBenchmark : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+
+    void benchmarkResolveVariables_data();
+    void benchmarkResolveVariables();
+
+    void benchmarkBuildUrl_data();
+    void benchmarkBuildUrl();
+
+    void benchmarkCreateRequest_data();
+    void benchmarkCreateRequest();
+
+    void benchmarkJsonPathValue_data();
+    void benchmarkJsonPathValue();
+
+    void benchmarkRetrieveResponseValues_data();
+    void benchmarkRetrieveResponseValues();
+
+    void benchmarkUpdateFromDocument_data();
+    void benchmarkUpdateFromDocument();
+
+    void benchmarkPollingTick_data();
+    void benchmarkPollingTick();
+
+ private:
+    static QByteArray load(const QString& resource);
+
+    QVariantMap m_placeholders;
+};
+
+QByteArray HotPathBenchmark::load(const QString& resource) {
+    QFile file(resource);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Error opening" << resource;
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void HotPathBenchmark::initTestCase() {
+    m_placeholders.insert("HOST", "192.168.1.50");
+    m_placeholders.insert("PORT", 8080);
+    m_placeholders.insert("TOKEN", "b1946ac92492d2347c6235b4d2611184");
+    m_placeholders.insert("ROOT", "api/v1");
+    m_placeholders.insert("RED", 8);
+    m_placeholders.insert("GREEN", 15);
+    m_placeholders.insert("BLUE", 240);
+}
+
+void HotPathBenchmark::benchmarkResolveVariables_data() {
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("plain") << "http://192.168.1.50/api/v1/relay?state=1";
+    QTest::newRow("formatted") << "#${RED:%02X}${GREEN:%02X}${BLUE:%02X}";
+    QTest::newRow("many variables") << "http://${HOST}:${PORT}/${ROOT}/relay?token=${TOKEN}&r=${RED}&g=${GREEN}"
+                                       "&b=${BLUE}&r2=${RED:%03d}&g2=${GREEN:%03d}&b2=${BLUE:%03d}";
+}
+
+void HotPathBenchmark::benchmarkResolveVariables() {
+    QFETCH(QString, text);
+
+    BenchmarkHandler handler("");
+    QString          result;
+    QBENCHMARK { result = handler.resolveVariables(text, m_placeholders); }
+    QVERIFY(!result.contains("${"));
+}
+
+void HotPathBenchmark::benchmarkBuildUrl_data() {
+    QTest::addColumn<QString>("baseUrl");
+    QTest::addColumn<QString>("commandUrl");
+
+    QTest::newRow("absolute") << "" << "http://192.168.1.50/relay?state=1";
+    QTest::newRow("relative") << "http://192.168.1.50/api" << "relay?state=1";
+    QTest::newRow("placeholders") << "http://${HOST}:${PORT}/${ROOT}" << "relay?token=${TOKEN}";
+}
+
+void HotPathBenchmark::benchmarkBuildUrl() {
+    QFETCH(QString, baseUrl);
+    QFETCH(QString, commandUrl);
+
+    BenchmarkHandler handler(baseUrl);
+    QVariant         url(commandUrl);
+    QUrl             result;
+    QBENCHMARK { result = handler.buildUrl(url, m_placeholders); }
+    QVERIFY(result.isValid());
+}
+
+void HotPathBenchmark::benchmarkCreateRequest_data() {
+    QTest::addColumn<QVariant>("commandCfg");
+
+    QTest::newRow("GET") << QVariant("http://${HOST}/relay?state=${state_bin}");
+
+    QVariantMap jsonBody;
+    jsonBody.insert("state", "${state_bool}");
+    jsonBody.insert("brightness", "${brightness_percent}");
+    jsonBody.insert("token", "${TOKEN}");
+    QVariantMap jsonCmd;
+    jsonCmd.insert("url", "http://${HOST}/api/light");
+    jsonCmd.insert("method", "POST");
+    jsonCmd.insert("body", jsonBody);
+    QTest::newRow("JSON body") << QVariant(jsonCmd);
+
+    QVariantMap textHeaders;
+    textHeaders.insert("Content-Type", "text/plain");
+    QVariantMap textCmd;
+    textCmd.insert("url", "http://${HOST}/api/light");
+    textCmd.insert("method", "PUT");
+    textCmd.insert("headers", textHeaders);
+    textCmd.insert("body", "state=${state_bin}&brightness=${brightness_percent}");
+    QTest::newRow("text body") << QVariant(textCmd);
+}
+
+void HotPathBenchmark::benchmarkCreateRequest() {
+    QFETCH(QVariant, commandCfg);
+
+    BenchmarkHandler handler("");
+    handler.setPlaceholders(m_placeholders);
+    const WebhookCommand* command = handler.readCommand("ON", commandCfg);
+
+    QBENCHMARK {
+        PlaceholderValues values(&m_placeholders, command->placeholderMask);
+        values.set(Placeholder::STATE_BOOL, true);
+        values.set(Placeholder::STATE_BIN, 1);
+        values.set(Placeholder::BRIGHTNESS_PERCENT, 80);
+        WebhookRequest* request = handler.createRequest(command, values);
+        QVERIFY(request);
+        delete request;
+    }
+}
+
+void HotPathBenchmark::benchmarkJsonPathValue_data() {
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("depth 1") << "store";
+    QTest::newRow("depth 2") << "store.snack";
+    QTest::newRow("depth 3") << "store.snack.price";
+    QTest::newRow("array index") << "store.electronics[1].title";
+}
+
+void HotPathBenchmark::benchmarkJsonPathValue() {
+    QFETCH(QString, path);
+
+    JsonPath jsonPath(QJsonDocument::fromJson(load(":/testdata/JsonPath.json")));
+    QVariant result;
+    QBENCHMARK { result = jsonPath.value(path); }
+    QVERIFY(result.isValid());
+}
+
+void HotPathBenchmark::benchmarkRetrieveResponseValues_data() {
+    QTest::addColumn<QString>("resource");
+    QTest::addColumn<QVariantMap>("mappingsCfg");
+
+    QVariantMap myStromSwitch;
+    myStromSwitch.insert("state_bool", "relay");
+    myStromSwitch.insert("power", "power");
+    myStromSwitch.insert("temperature", "temperature");
+    QTest::newRow("myStrom switch") << ":/testdata/myStrom-switch-report-response.json" << myStromSwitch;
+
+    QVariantMap myStromBulb;
+    myStromBulb.insert("state_bool", "6001942C4FDD.on");
+    myStromBulb.insert("color", "6001942C4FDD.color");
+    myStromBulb.insert("mode", "6001942C4FDD.mode");
+    QTest::newRow("myStrom bulb") << ":/testdata/myStrom-bulb-setcolor-response.json" << myStromBulb;
+
+    QVariantMap shelly;
+    shelly.insert("state_bool", "relays[0].ison");
+    shelly.insert("power", "meters[0].power");
+    shelly.insert("total", "meters[0].total");
+    shelly.insert("rssi", "wifi_sta.rssi");
+    QTest::newRow("Shelly 1") << ":/testdata/shelly1-status-response.json" << shelly;
+
+    // compiled value transforms applied on the extracted values
+    QVariantMap transforms = shelly;
+    transforms.insert("power", QVariantMap{{"path", "meters[0].power"},
+                                           {"transform", QVariantList{QVariantMap{{"scale", 0.001}},
+                                                                      QVariantMap{{"round", 2}}}}});
+    transforms.insert("rssi", QVariantMap{{"path", "wifi_sta.rssi"},
+                                          {"transform", QVariantMap{{"scale", QVariantList{-100, -50, 0, 100}}}}});
+    transforms.insert("total", QVariantMap{{"path", "meters[0].total"},
+                                           {"transform", QVariantMap{{"clamp", QVariantList{0, 1000000}}}}});
+    QTest::newRow("Shelly 1 transforms") << ":/testdata/shelly1-status-response.json" << transforms;
+}
+
+void HotPathBenchmark::benchmarkRetrieveResponseValues() {
+    QFETCH(QString, resource);
+    QFETCH(QVariantMap, mappingsCfg);
+
+    BenchmarkHandler handler("");
+    TransformList    transforms;
+    MappingList      mappings = handler.readMappings(mappingsCfg, &transforms);
+    QByteArray       data = load(resource);
+    QVERIFY(!data.isEmpty());
+
+    // a status reply is parsed and mapped for every poll
+    int count = 0;
+    QBENCHMARK {
+        QVariantMap values;
+        count = handler.retrieveResponseValues(QJsonDocument::fromJson(data), mappings, transforms, &values);
+    }
+    QCOMPARE(count, mappings.size());
+}
+
+void HotPathBenchmark::benchmarkUpdateFromDocument_data() { benchmarkRetrieveResponseValues_data(); }
+
+void HotPathBenchmark::benchmarkUpdateFromDocument() {
+    QFETCH(QString, resource);
+    QFETCH(QVariantMap, mappingsCfg);
+
+    BenchmarkHandler handler("");
+    TransformList    transforms;
+    MappingList      mappings = handler.readMappings(mappingsCfg, &transforms);
+    QByteArray       data = load(resource);
+    QVERIFY(!data.isEmpty());
+
+    // a pushed callback body or status reply: parse, map and hand the values to the handler's entity update
+    int count = 0;
+    QBENCHMARK { count = handler.updateFromDocument(nullptr, QJsonDocument::fromJson(data), mappings, transforms); }
+    QCOMPARE(count, mappings.size());
+    QCOMPARE(handler.updatedValues, mappings.size());
+}
+
+void HotPathBenchmark::benchmarkPollingTick_data() {
+    QTest::addColumn<int>("entities");
+
+    QTest::newRow("100 entities") << 100;
+    QTest::newRow("1000 entities") << 1000;
+    QTest::newRow("10000 entities") << 10000;
+}
+
+void HotPathBenchmark::benchmarkPollingTick() {
+    QFETCH(int, entities);
+
+    // mixed polling intervals of 5 s .. 10 min: the cost per tick depends on the due entities, not the entity count
+    TimingWheel      wheel;
+    QVector<int>     intervals(entities);
+    QRandomGenerator random(42);
+    for (int id = 0; id < entities; id++) {
+        intervals[id] = static_cast<int>(random.bounded(5, 600));
+        wheel.schedule(id, static_cast<quint64>(intervals.at(id)));
+    }
+
+    QVector<int> due;
+    QBENCHMARK {
+        due.clear();
+        wheel.advance(&due);
+        for (int id : qAsConst(due)) {
+            wheel.schedule(id, static_cast<quint64>(intervals.at(id)));
+        }
+    }
+    QCOMPARE(wheel.size(), entities);
+}
+
+QTEST_GUILESS_MAIN(HotPathBenchmark)
+
+#include "tst_hotpathbenchmark.moc"
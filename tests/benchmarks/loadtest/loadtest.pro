@@ -0,0 +1,44 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_loadtest
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file" )
+}
+
+include($$PWD/../../webhook-core.pri)
+INCLUDEPATH += $$PWD/../../entityhandlertest
+
+HEADERS += \
+    mockdevicefleet.h \
+    $$PWD/../../entityhandlertest/entityhandlerimpl.h \
+    $$INCDIR/hostcache.h \
+    $$INCDIR/requestdispatcher.h \
+    $$INCDIR/sockettransport.h \
+    $$INCDIR/transportreply.h
+
+SOURCES += \
+    mockdevicefleet.cpp \
+    tst_loadtest.cpp \
+    $$INCDIR/hostcache.cpp \
+    $$INCDIR/requestdispatcher.cpp \
+    $$INCDIR/sockettransport.cpp \
+    $$INCDIR/transportreply.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+# device payloads are the myStrom and Shelly response fixtures
+RESOURCES += \
+    $$PWD/../../jsonpathtest/testfiles.qrc \
+    $$PWD/../hotpathbenchmark/testfiles.qrc
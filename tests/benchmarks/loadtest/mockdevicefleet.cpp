@@ -0,0 +1,233 @@
+#include "mockdevicefleet.h"
+
+#include <QFile>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QtDebug>
+
+#include "compression.h"
+
+static QJsonObject loadFixture(const QString& resource) {
+    QFile file(resource);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Error opening" << resource;
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+MockDevice::MockDevice(Type type, const MockDeviceProfile& profile, quint32 seed, QObject* parent)
+    : QObject(parent), m_type(type), m_profile(profile), m_random(seed), m_relay(0), m_requests(0), m_errors(0) {
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, &MockDevice::onNewConnection);
+}
+
+bool MockDevice::listen() { return m_server.listen(QHostAddress::LocalHost, 0); }
+
+void MockDevice::onNewConnection() {
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        socket->setParent(this);
+        m_buffers.insert(socket, QByteArray());
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket] { onReadyRead(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockDevice::onReadyRead(QTcpSocket* socket) {
+    QByteArray& buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+
+    // a keep-alive connection may contain more than one request
+    for (;;) {
+        int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        int               contentLength = 0;
+        bool              acceptGzip = false;
+        for (int i = 1; i < lines.size(); i++) {
+            int        colon = lines.at(i).indexOf(':');
+            QByteArray name = lines.at(i).left(colon).trimmed().toLower();
+            QByteArray value = lines.at(i).mid(colon + 1).trimmed();
+            if (name == "content-length") {
+                contentLength = value.toInt();
+            } else if (name == "accept-encoding") {
+                acceptGzip = value.contains("gzip");
+            }
+        }
+
+        if (buffer.size() < headerEnd + 4 + contentLength) {
+            return;
+        }
+        buffer.remove(0, headerEnd + 4 + contentLength);
+
+        m_requests.fetchAndAddRelaxed(1);
+        Response response = requestLine.size() < 2 ? Response{400, QByteArray()}
+                                                    : handleRequest(requestLine.at(0), requestLine.at(1));
+
+        int delay = m_profile.latency;
+        if (m_profile.jitter > 0) {
+            delay += static_cast<int>(m_random.bounded(m_profile.jitter + 1));
+        }
+        if (delay > 0) {
+            // the response is dropped if the client closes the connection in the meantime
+            QTimer::singleShot(delay, socket,
+                               [this, socket, response, acceptGzip] { sendResponse(socket, response, acceptGzip); });
+        } else {
+            sendResponse(socket, response, acceptGzip);
+        }
+    }
+}
+
+MockDevice::Response MockDevice::handleRequest(const QByteArray& method, const QByteArray& target) {
+    if (m_profile.errorRate > 0.0 && m_random.generateDouble() < m_profile.errorRate) {
+        m_errors.fetchAndAddRelaxed(1);
+        return Response{500, QByteArray()};
+    }
+
+    QUrl      url(QString::fromLatin1(target));
+    QUrlQuery query(url);
+    QString   path = url.path();
+
+    if (method != "GET") {
+        return Response{405, QByteArray()};
+    }
+
+    if (m_type == MYSTROM_SWITCH) {
+        if (path == "/report") {
+            return Response{200, statusBody()};
+        }
+        if (path == "/relay") {
+            m_relay.storeRelease(query.queryItemValue("state") == "1" ? 1 : 0);
+            return Response{200, QByteArray()};
+        }
+        if (path == "/toggle") {
+            m_relay.storeRelease(relay() ? 0 : 1);
+            return Response{200, QJsonDocument(QJsonObject{{"relay", relay()}}).toJson(QJsonDocument::Compact)};
+        }
+    } else {
+        if (path == "/status") {
+            return Response{200, statusBody()};
+        }
+        if (path == "/relay/0") {
+            QString turn = query.queryItemValue("turn");
+            if (turn == "toggle") {
+                m_relay.storeRelease(relay() ? 0 : 1);
+            } else {
+                m_relay.storeRelease(turn == "on" ? 1 : 0);
+            }
+            QJsonObject body{{"ison", relay()}, {"has_timer", false}, {"source", "http"}};
+            return Response{200, QJsonDocument(body).toJson(QJsonDocument::Compact)};
+        }
+    }
+
+    return Response{404, QByteArray()};
+}
+
+QByteArray MockDevice::statusBody() const {
+    // the fixtures are static, only the relay state is patched
+    static const QJsonObject myStrom = loadFixture(":/testdata/myStrom-switch-report-response.json");
+    static const QJsonObject shelly = loadFixture(":/testdata/shelly1-status-response.json");
+
+    QJsonObject status;
+    if (m_type == MYSTROM_SWITCH) {
+        status = myStrom;
+        status.insert("relay", relay());
+    } else {
+        status = shelly;
+        QJsonArray  relays = status.value("relays").toArray();
+        QJsonObject relay0 = relays.at(0).toObject();
+        relay0.insert("ison", relay());
+        relays.replace(0, relay0);
+        status.insert("relays", relays);
+    }
+    return QJsonDocument(status).toJson(QJsonDocument::Compact);
+}
+
+void MockDevice::sendResponse(QTcpSocket* socket, const Response& response, bool acceptGzip) {
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        return;
+    }
+
+    QByteArray body = response.body;
+    QByteArray headers;
+    if (!body.isEmpty()) {
+        headers.append("Content-Type: application/json\r\n");
+        if (acceptGzip && m_profile.gzip) {
+            body = Compression::gzip(body);
+            headers.append("Content-Encoding: gzip\r\n");
+        }
+    }
+
+    QByteArray reason = response.status == 200 ? "OK" : "Error";
+    socket->write("HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reason + "\r\n" + headers +
+                  "Content-Length: " + QByteArray::number(body.size()) + "\r\nConnection: keep-alive\r\n\r\n" + body);
+}
+
+MockDeviceFleet::MockDeviceFleet() : m_context(nullptr) {}
+
+MockDeviceFleet::~MockDeviceFleet() { stop(); }
+
+bool MockDeviceFleet::start(int count, const MockDeviceProfile& profile, quint32 seed) {
+    stop();
+
+    m_thread.start();
+    m_context = new QObject();
+    m_context->moveToThread(&m_thread);
+
+    // the servers must be created in the thread serving their connections
+    bool listening = true;
+    QMetaObject::invokeMethod(
+        m_context,
+        [this, count, profile, seed, &listening] {
+            for (int i = 0; i < count; i++) {
+                auto device = new MockDevice(i % 2 == 0 ? MockDevice::MYSTROM_SWITCH : MockDevice::SHELLY_1, profile,
+                                             seed + static_cast<quint32>(i), m_context);
+                listening = device->listen() && listening;
+                m_devices.append(device);
+            }
+        },
+        Qt::BlockingQueuedConnection);
+
+    return listening;
+}
+
+void MockDeviceFleet::stop() {
+    if (!m_thread.isRunning()) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(
+        m_context, [this] { delete m_context; }, Qt::BlockingQueuedConnection);
+    m_context = nullptr;
+    m_devices.clear();
+
+    m_thread.quit();
+    m_thread.wait();
+}
+
+int MockDeviceFleet::requestCount() const {
+    int count = 0;
+    for (const MockDevice* device : m_devices) {
+        count += device->requestCount();
+    }
+    return count;
+}
+
+int MockDeviceFleet::errorCount() const {
+    int count = 0;
+    for (const MockDevice* device : m_devices) {
+        count += device->errorCount();
+    }
+    return count;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QVector>
+
+/**
+ * @brief Simulated response behaviour of a mock device.
+ */
+struct MockDeviceProfile {
+    MockDeviceProfile() : latency(0), jitter(0), errorRate(0.0), gzip(false) {}
+
+    /**
+     * @brief Minimal response delay in ms.
+     */
+    int latency;
+    /**
+     * @brief Additional random response delay in ms: 0..jitter.
+     */
+    int jitter;
+    /**
+     * @brief Probability of answering a request with 500 Internal Server Error: 0.0..1.0.
+     */
+    double errorRate;
+    /**
+     * @brief Compress response bodies if the request accepts gzip.
+     */
+    bool gzip;
+};
+
+/**
+ * @brief Minimal HTTP/1.1 server on 127.0.0.1 simulating the REST API of a myStrom or Shelly switch.
+ * @details Connections are kept alive and responses are sent after the configured latency. Commands change the relay
+ * state which is reported in the status response.
+ *
+ * myStrom switch: `GET /report`, `GET /relay?state=0|1`, `GET /toggle`
+ * Shelly 1: `GET /status`, `GET /relay/0?turn=on|off|toggle`
+ */
+class MockDevice : public QObject {
+    Q_OBJECT
+
+ public:
+    enum Type { MYSTROM_SWITCH, SHELLY_1 };
+
+    MockDevice(Type type, const MockDeviceProfile& profile, quint32 seed, QObject* parent = nullptr);
+
+    bool    listen();
+    quint16 port() const { return m_server.serverPort(); }
+    Type    type() const { return m_type; }
+
+    // thread-safe accessors, the device is running in the thread of the fleet
+    bool relay() const { return m_relay.loadAcquire() != 0; }
+    int  requestCount() const { return m_requests.loadAcquire(); }
+    int  errorCount() const { return m_errors.loadAcquire(); }
+
+ private:
+    struct Response {
+        int        status;
+        QByteArray body;
+    };
+
+    void     onNewConnection();
+    void     onReadyRead(QTcpSocket* socket);
+    Response handleRequest(const QByteArray& method, const QByteArray& target);
+    void     sendResponse(QTcpSocket* socket, const Response& response, bool acceptGzip);
+    QByteArray statusBody() const;
+
+ private:
+    Type                           m_type;
+    MockDeviceProfile              m_profile;
+    QRandomGenerator               m_random;
+    QTcpServer                     m_server;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+    QAtomicInt                     m_relay;
+    QAtomicInt                     m_requests;
+    QAtomicInt                     m_errors;
+};
+
+/**
+ * @brief Fleet of mock devices served from a separate thread, so the measured event loop only runs the client side.
+ */
+class MockDeviceFleet {
+ public:
+    MockDeviceFleet();
+    ~MockDeviceFleet();
+
+    MockDeviceFleet(const MockDeviceFleet&) = delete;
+    MockDeviceFleet& operator=(const MockDeviceFleet&) = delete;
+
+    /**
+     * @brief Starts the given number of devices alternating between myStrom and Shelly devices.
+     * @param seed Seed of the latency, jitter and error generators to make runs reproducible.
+     * @return false if a device server could not be started.
+     */
+    bool start(int count, const MockDeviceProfile& profile, quint32 seed);
+
+    void stop();
+
+    const QList<MockDevice*>& devices() const { return m_devices; }
+
+    int requestCount() const;
+    int errorCount() const;
+
+ private:
+    QThread            m_thread;
+    QObject*           m_context;
+    QList<MockDevice*> m_devices;
+};
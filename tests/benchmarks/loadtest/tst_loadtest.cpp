@@ -0,0 +1,444 @@
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkProxy>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QtTest>
+
+#include <algorithm>
+
+#include "entityhandlerimpl.h"
+#include "mockdevicefleet.h"
+#include "requestdispatcher.h"
+#include "requestpool.h"
+
+/**
+ * @brief Counts the entity updates of the mapped status responses.
+ */
+class LoadHandler : public EntityHandlerImpl {
+ public:
+    LoadHandler() : EntityHandlerImpl("switch", ""), m_updates(0) {}
+
+    using EntityHandler::createRequest;
+
+    int updates() const { return m_updates; }
+
+ protected:
+    void updateEntity(EntityInterface* entity, const QVariantMap& placeholders) override {
+        Q_UNUSED(entity)
+        Q_UNUSED(placeholders)
+        m_updates++;
+    }
+
+ private:
+    int m_updates;
+};
+
+/**
+ * @brief Request latency samples in us.
+ */
+class LatencyStats {
+ public:
+    void add(qint64 us) { m_samples.append(us); }
+    int  count() const { return m_samples.size(); }
+
+    /**
+     * @brief Nearest-rank percentile in ms.
+     */
+    double percentile(double p) {
+        if (m_samples.isEmpty()) {
+            return 0.0;
+        }
+        std::sort(m_samples.begin(), m_samples.end());
+        int rank = qBound(0, static_cast<int>(p / 100.0 * m_samples.size() + 0.5) - 1, m_samples.size() - 1);
+        return m_samples.at(rank) / 1000.0;
+    }
+
+    QJsonObject report() {
+        return QJsonObject{{"count", count()},
+                           {"p50_ms", percentile(50)},
+                           {"p95_ms", percentile(95)},
+                           {"p99_ms", percentile(99)},
+                           {"max_ms", percentile(100)}};
+    }
+
+ private:
+    QVector<qint64> m_samples;
+};
+
+/**
+ * @brief Measures event loop stalls with the lateness of a periodic timer.
+ */
+class StallProbe : public QObject {
+ public:
+    explicit StallProbe(int interval = 5) : m_interval(interval), m_last(0), m_total(0), m_max(0), m_stalls(0) {
+        m_timer.setTimerType(Qt::PreciseTimer);
+        m_timer.setInterval(interval);
+        QObject::connect(&m_timer, &QTimer::timeout, this, &StallProbe::onTimeout);
+    }
+
+    void start() {
+        m_clock.start();
+        m_last = 0;
+        m_timer.start();
+    }
+
+    QJsonObject report() const {
+        return QJsonObject{{"total_ms", m_total / 1000.0}, {"max_ms", m_max / 1000.0}, {"stalls", m_stalls}};
+    }
+
+ private:
+    void onTimeout() {
+        qint64 now = m_clock.nsecsElapsed() / 1000;
+        qint64 lateness = now - m_last - m_interval * 1000;
+        m_last = now;
+        // a timer is considered late if it missed at least one full interval
+        if (lateness > m_interval * 1000) {
+            m_total += lateness;
+            m_max = qMax(m_max, lateness);
+            m_stalls++;
+        }
+    }
+
+ private:
+    QTimer        m_timer;
+    QElapsedTimer m_clock;
+    int           m_interval;
+    qint64        m_last;
+    qint64        m_total;
+    qint64        m_max;
+    int           m_stalls;
+};
+
+/**
+ * @brief End-to-end load test of status polling, command bursts and commands during poll bursts against a local mock
+ * device fleet.
+ * @details Not part of `make check`. The load is configured with environment variables:
+ * LOADTEST_DEVICES, LOADTEST_ENTITIES_PER_DEVICE, LOADTEST_CYCLES, LOADTEST_BURSTS, LOADTEST_BURST_SIZE,
+ * LOADTEST_LATENCY_MS, LOADTEST_JITTER_MS, LOADTEST_ERROR_RATE, LOADTEST_GZIP, LOADTEST_SEED and LOADTEST_BUDGET_MS of
+ * the watchdog. The summary is logged and written as JSON to the file in LOADTEST_REPORT if set.
+ */
+class LoadTest : public QObject {
+    Q_OBJECT
+
+ public:
+    LoadTest() : m_pending(0), m_failed(0), m_dropped(0), m_statusReplies(0) {}
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testStatusPolling();
+    void testCommandBursts();
+    void testCommandsDuringPollBursts();
+
+ private:
+    static int    envInt(const char* name, int defaultValue);
+    static double envDouble(const char* name, double defaultValue);
+    static qint64 procStatus(const QByteArray& key);
+
+    QVariantList generateConfig(int entitiesPerDevice) const;
+    void         dispatch(WebhookRequest* request, LatencyStats* stats, bool status);
+    bool         waitIdle(int timeout);
+
+ private:
+    MockDeviceFleet                   m_fleet;
+    MockDeviceProfile                 m_profile;
+    QNetworkAccessManager             m_networkManager;
+    RequestPool                       m_requestPool;
+    QScopedPointer<RequestDispatcher> m_dispatcher;
+    QScopedPointer<LoadHandler>       m_handler;
+    QVector<WebhookEntity*>           m_entities;
+    QVariantMap                       m_placeholders;
+    QRandomGenerator                  m_random;
+    StallProbe                        m_stallProbe;
+    QScopedPointer<StallWatchdog>     m_watchdog;
+    QElapsedTimer                     m_clock;
+
+    int          m_pending;
+    int          m_failed;
+    int          m_dropped;
+    int          m_statusReplies;
+    LatencyStats m_statusLatency;
+    LatencyStats m_commandLatency;
+    LatencyStats m_preemptedLatency;
+    QJsonObject  m_report;
+};
+
+int LoadTest::envInt(const char* name, int defaultValue) {
+    bool ok;
+    int  value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+double LoadTest::envDouble(const char* name, double defaultValue) {
+    bool   ok;
+    double value = qgetenv(name).toDouble(&ok);
+    return ok ? value : defaultValue;
+}
+
+qint64 LoadTest::procStatus(const QByteArray& key) {
+    // Linux only: value in kB, e.g. "VmRSS:     12345 kB"
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith(key + ':')) {
+            return line.mid(key.size() + 1).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+QVariantList LoadTest::generateConfig(int entitiesPerDevice) const {
+    QVariantList entities;
+    for (int i = 0; i < m_fleet.devices().size() * entitiesPerDevice; i++) {
+        const MockDevice* device = m_fleet.devices().at(i / entitiesPerDevice);
+        QString           url = QString("http://127.0.0.1:%1").arg(device->port());
+
+        QVariantMap mappings;
+        QVariantMap commands;
+        if (device->type() == MockDevice::MYSTROM_SWITCH) {
+            commands.insert("ON", url + "/relay?state=1");
+            commands.insert("OFF", url + "/relay?state=0");
+            commands.insert("TOGGLE", url + "/toggle");
+            mappings.insert("state_bool", "relay");
+            mappings.insert("power", "power");
+            mappings.insert("temperature", "temperature");
+            url += "/report";
+        } else {
+            commands.insert("ON", url + "/relay/0?turn=on");
+            commands.insert("OFF", url + "/relay/0?turn=off");
+            commands.insert("TOGGLE", url + "/relay/0?turn=toggle");
+            mappings.insert("state_bool", "relays[0].ison");
+            mappings.insert("power", "meters[0].power");
+            mappings.insert("total", "meters[0].total");
+            url += "/status";
+        }
+
+        QVariantMap response;
+        response.insert("mappings", mappings);
+        QVariantMap status;
+        status.insert("url", url);
+        status.insert("response", response);
+        commands.insert("STATUS_POLLING", status);
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entities.append(entity);
+    }
+    return entities;
+}
+
+void LoadTest::initTestCase() {
+    int devices = envInt("LOADTEST_DEVICES", 20);
+    // more entities per device than connections per host of QNetworkAccessManager (6) queue up status requests
+    int entitiesPerDevice = qMax(1, envInt("LOADTEST_ENTITIES_PER_DEVICE", 8));
+    m_profile.latency = envInt("LOADTEST_LATENCY_MS", 20);
+    m_profile.jitter = envInt("LOADTEST_JITTER_MS", 30);
+    m_profile.errorRate = envDouble("LOADTEST_ERROR_RATE", 0.0);
+    m_profile.gzip = envInt("LOADTEST_GZIP", 0) != 0;
+    quint32 seed = static_cast<quint32>(envInt("LOADTEST_SEED", 42));
+    m_random.seed(seed);
+
+    QVERIFY(m_fleet.start(devices, m_profile, seed));
+
+    m_networkManager.setProxy(QNetworkProxy::NoProxy);
+    m_dispatcher.reset(new RequestDispatcher(&m_networkManager));
+    m_dispatcher->setMaxQueuedPolls(devices * entitiesPerDevice);
+    m_handler.reset(new LoadHandler());
+    m_handler->setRequestPool(&m_requestPool);
+    // the watchdog of the integration, warns at most once per section and run
+    m_watchdog.reset(new StallWatchdog(qRound64(envDouble("LOADTEST_BUDGET_MS", 4) * 1000), 3600000));
+    m_handler->setWatchdog(m_watchdog.data());
+    QCOMPARE(m_handler->readEntities(generateConfig(entitiesPerDevice), QVariantMap()), devices * entitiesPerDevice);
+    for (int i = 0; i < devices * entitiesPerDevice; i++) {
+        m_entities.append(m_handler->webhookEntity(QString("switch.device_%1").arg(i)));
+    }
+
+    m_report.insert("devices", devices);
+    m_report.insert("entities_per_device", entitiesPerDevice);
+    m_report.insert("latency_ms", m_profile.latency);
+    m_report.insert("jitter_ms", m_profile.jitter);
+    m_report.insert("error_rate", m_profile.errorRate);
+    m_report.insert("gzip", m_profile.gzip);
+    m_report.insert("rss_start_kb", procStatus("VmRSS"));
+
+    m_stallProbe.start();
+    m_clock.start();
+}
+
+void LoadTest::cleanupTestCase() {
+    m_report.insert("status_latency", m_statusLatency.report());
+    m_report.insert("command_latency", m_commandLatency.report());
+    m_report.insert("command_latency_during_polls", m_preemptedLatency.report());
+    m_report.insert("failed_requests", m_failed);
+    m_report.insert("dropped_polls", m_dropped);
+    m_report.insert("lanes", QJsonObject::fromVariantMap(m_dispatcher->laneStats()));
+    m_report.insert("device_requests", m_fleet.requestCount());
+    m_report.insert("event_loop_stall", m_stallProbe.report());
+    m_report.insert("watchdog", QJsonObject::fromVariantMap(m_watchdog->stats()));
+    m_report.insert("request_pool", QJsonObject::fromVariantMap(m_requestPool.stats()));
+    m_report.insert("compression", QJsonObject::fromVariantMap(m_dispatcher->compressionStats()));
+    m_report.insert("rss_end_kb", procStatus("VmRSS"));
+    m_report.insert("rss_peak_kb", procStatus("VmHWM"));
+
+    QByteArray json = QJsonDocument(m_report).toJson();
+    qInfo().noquote() << "Load test summary:" << json;
+
+    QString fileName = qEnvironmentVariable("LOADTEST_REPORT");
+    if (!fileName.isEmpty()) {
+        QFile file(fileName);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(json);
+    }
+
+    m_fleet.stop();
+}
+
+void LoadTest::dispatch(WebhookRequest* request, LatencyStats* stats, bool status) {
+    QVERIFY(request);
+
+    // the latency includes the queue wait in the poll lane
+    qint64 started = m_clock.nsecsElapsed();
+    auto   sent = [this, request, started, stats, status](QNetworkReply* reply) {
+        if (!reply) {
+            if (status) {
+                m_dropped++;
+            } else {
+                m_failed++;
+            }
+            m_requestPool.release(request);
+            return;
+        }
+
+        m_pending++;
+        QObject::connect(reply, &QNetworkReply::finished, this, [this, request, reply, started, stats, status] {
+            reply->deleteLater();
+            StallTimer timer(m_watchdog.data(), status ? StallWatchdog::STATUS_REPLY : StallWatchdog::COMMAND_REPLY);
+            m_dispatcher->finish(request, reply);
+            stats->add((m_clock.nsecsElapsed() - started) / 1000);
+
+            if (reply->error() != QNetworkReply::NoError) {
+                m_failed++;
+            } else if (status) {
+                m_statusReplies++;
+                m_handler->statusReply(nullptr, request, reply);
+            }
+
+            m_requestPool.release(request);
+            m_pending--;
+        });
+    };
+
+    if (status) {
+        m_dispatcher->sendPoll(request, sent);
+    } else {
+        sent(m_dispatcher->send(request));
+    }
+}
+
+bool LoadTest::waitIdle(int timeout) {
+    QElapsedTimer timer;
+    timer.start();
+    while (m_pending > 0 && timer.elapsed() < timeout) {
+        // the stall probe timer wakes up the event loop at least every few ms
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return m_pending == 0;
+}
+
+void LoadTest::testStatusPolling() {
+    int cycles = envInt("LOADTEST_CYCLES", 20);
+    int updates = m_handler->updates();
+    int replies = m_statusReplies;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        // one polling cycle of the status timer
+        {
+            StallTimer timer(m_watchdog.data(), StallWatchdog::STATUS_UPDATE);
+            for (WebhookEntity* entity : qAsConst(m_entities)) {
+                dispatch(m_handler->createStatusRequest(entity, m_placeholders), &m_statusLatency, true);
+            }
+        }
+        QVERIFY(waitIdle(30000));
+    }
+    qint64 elapsed = timer.elapsed();
+
+    // every successful status reply must be mapped to an entity update
+    QCOMPARE(m_handler->updates() - updates, m_statusReplies - replies);
+    if (m_profile.errorRate == 0.0) {
+        QCOMPARE(m_statusReplies - replies, cycles * m_entities.size());
+    }
+
+    m_report.insert("status_requests", cycles * m_entities.size());
+    m_report.insert("status_throughput_rps", cycles * m_entities.size() * 1000.0 / qMax(elapsed, qint64(1)));
+}
+
+void LoadTest::testCommandBursts() {
+    int bursts = envInt("LOADTEST_BURSTS", 10);
+    int burstSize = envInt("LOADTEST_BURST_SIZE", 50);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int burst = 0; burst < bursts; burst++) {
+        for (int i = 0; i < burstSize; i++) {
+            WebhookEntity* entity = m_entities.at(m_random.bounded(m_entities.size()));
+            int            command = m_random.bounded(3);  // ON, OFF, TOGGLE
+            dispatch(m_handler->createRequest(entity, command, PlaceholderValues(&m_placeholders)), &m_commandLatency,
+                     false);
+        }
+        QVERIFY(waitIdle(30000));
+    }
+    qint64 elapsed = timer.elapsed();
+
+    m_report.insert("command_requests", bursts * burstSize);
+    m_report.insert("command_throughput_rps", bursts * burstSize * 1000.0 / qMax(elapsed, qint64(1)));
+
+    if (m_profile.errorRate > 0.0) {
+        return;
+    }
+
+    // the devices must end up in the state of the last command
+    for (WebhookEntity* entity : qAsConst(m_entities)) {
+        dispatch(m_handler->createRequest(entity, 0, PlaceholderValues(&m_placeholders)), &m_commandLatency, false);
+    }
+    QVERIFY(waitIdle(30000));
+    for (const MockDevice* device : m_fleet.devices()) {
+        QVERIFY(device->relay());
+    }
+}
+
+void LoadTest::testCommandsDuringPollBursts() {
+    int bursts = envInt("LOADTEST_BURSTS", 10);
+    int burstSize = envInt("LOADTEST_BURST_SIZE", 50);
+
+    for (int burst = 0; burst < bursts; burst++) {
+        // a full polling cycle is queued first, the commands must not wait behind it
+        for (WebhookEntity* entity : qAsConst(m_entities)) {
+            dispatch(m_handler->createStatusRequest(entity, m_placeholders), &m_statusLatency, true);
+        }
+        for (int i = 0; i < burstSize; i++) {
+            WebhookEntity* entity = m_entities.at(m_random.bounded(m_entities.size()));
+            int            command = m_random.bounded(3);  // ON, OFF, TOGGLE
+            dispatch(m_handler->createRequest(entity, command, PlaceholderValues(&m_placeholders)),
+                     &m_preemptedLatency, false);
+        }
+        QVERIFY(waitIdle(30000));
+    }
+
+    QVariantMap commandLane = m_dispatcher->laneStats().value("command").toMap();
+    QCOMPARE(commandLane.value("dropped").toULongLong(), quint64(0));
+}
+
+QTEST_GUILESS_MAIN(LoadTest)
+
+#include "tst_loadtest.moc"
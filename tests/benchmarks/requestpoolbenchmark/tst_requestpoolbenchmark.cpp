@@ -0,0 +1,124 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QtTest>
+
+#include "requestpool.h"
+#include "switchhandler.h"
+
+// Counts all operator new calls of the process. Qt containers allocate with malloc and are not counted!
+static std::atomic<qint64> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/**
+ * @brief Compares individually allocated status polling requests with pooled requests.
+ */
+class RequestPoolBenchmark : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testAllocationsPerCycle();
+
+    void benchmarkPollingCycle_data();
+    void benchmarkPollingCycle();
+
+ private:
+    /**
+     * @brief Creates and releases the status requests of all entities, like Webhook::statusUpdate().
+     */
+    void pollingCycle(RequestPool* pool);
+
+    static const int ENTITY_COUNT = 100;
+
+    SwitchHandler*          m_handler = nullptr;
+    QVector<WebhookEntity*> m_entities;
+    QVariantMap             m_placeholders;
+};
+
+void RequestPoolBenchmark::initTestCase() {
+    QVariantList entities;
+    for (int i = 0; i < ENTITY_COUNT; i++) {
+        QVariantMap commands;
+        commands.insert("ON", "http://${host}/relay/0?turn=on");
+        commands.insert("STATUS_POLLING", QString("http://${host}/status/%1").arg(i));
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("commands", commands);
+        entities.append(entity);
+    }
+
+    m_handler = new SwitchHandler("");
+    QCOMPARE(m_handler->readEntities(entities, QVariantMap()), ENTITY_COUNT);
+    for (WebhookEntity* entity : m_handler->getEntities()) {
+        m_entities.append(entity);
+    }
+    m_placeholders.insert("host", "192.168.1.10");
+}
+
+void RequestPoolBenchmark::cleanupTestCase() { delete m_handler; }
+
+void RequestPoolBenchmark::pollingCycle(RequestPool* pool) {
+    m_handler->setRequestPool(pool);
+    for (WebhookEntity* entity : qAsConst(m_entities)) {
+        WebhookRequest* request = m_handler->createStatusRequest(entity, m_placeholders);
+        if (pool) {
+            pool->release(request);
+        } else {
+            delete request;
+        }
+    }
+}
+
+void RequestPoolBenchmark::testAllocationsPerCycle() {
+    RequestPool pool;
+    // warm up the free-list
+    pollingCycle(&pool);
+
+    qint64 start = g_allocations;
+    pollingCycle(nullptr);
+    qint64 unpooled = g_allocations - start;
+
+    start = g_allocations;
+    pollingCycle(&pool);
+    qint64 pooled = g_allocations - start;
+
+    qInfo("operator new calls per polling cycle of %d entities: new/delete %lld, request pool %lld", ENTITY_COUNT,
+          unpooled, pooled);
+    QVERIFY(pooled < unpooled);
+    QCOMPARE(pool.highWaterMark(), 1);
+}
+
+void RequestPoolBenchmark::benchmarkPollingCycle_data() {
+    QTest::addColumn<bool>("pooled");
+
+    QTest::newRow("new/delete") << false;
+    QTest::newRow("request pool") << true;
+}
+
+void RequestPoolBenchmark::benchmarkPollingCycle() {
+    QFETCH(bool, pooled);
+
+    RequestPool pool;
+    QBENCHMARK { pollingCycle(pooled ? &pool : nullptr); }
+}
+
+QTEST_GUILESS_MAIN(RequestPoolBenchmark)
+
+#include "tst_requestpoolbenchmark.moc"
@@ -0,0 +1,23 @@
+#!/bin/bash
+# Runs all micro-benchmarks and writes the results as QTest XML files for tracking them over time.
+#
+# Usage: run-benchmarks.sh <benchmarks build directory> [output directory]
+#
+# Each benchmark writes <output directory>/<benchmark>.xml. Additional QTest options can be passed with the
+# BENCHMARK_ARGS environment variable, e.g. BENCHMARK_ARGS="-callgrind" or BENCHMARK_ARGS="-minimumvalue 100".
+
+set -e
+
+BUILD_DIR=${1:?"Usage: $0 <benchmarks build directory> [output directory]"}
+OUTPUT_DIR=${2:-benchmark-results/$(date +%Y%m%d-%H%M%S)}
+
+mkdir -p "$OUTPUT_DIR"
+
+for BENCHMARK in $(find "$BUILD_DIR" -type f -perm -u+x -name "tst_*benchmark"); do
+    NAME=$(basename "$BENCHMARK")
+    echo "Running $NAME"
+    # shellcheck disable=SC2086
+    "$BENCHMARK" $BENCHMARK_ARGS -o "$OUTPUT_DIR/$NAME.xml,xml" -o -,txt
+done
+
+echo "Results written to $OUTPUT_DIR"
@@ -0,0 +1,31 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_startupbenchmark
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file" )
+}
+
+include($$PWD/../../webhook-core.pri)
+
+HEADERS += \
+    $$INCDIR/configcache.h \
+    $$INCDIR/switchhandler.h
+
+SOURCES += \
+    tst_startupbenchmark.cpp \
+    $$INCDIR/configcache.cpp \
+    $$INCDIR/switchhandler.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,251 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "configcache.h"
+#include "switchhandler.h"
+#include "yio-interface/entities/switchinterface.h"
+
+/**
+ * @brief Measures reading the entity configuration at integration startup with generated configurations.
+ */
+class StartupBenchmark : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testFootprint_data();
+    void testFootprint();
+
+    void testCacheFootprint_data();
+    void testCacheFootprint();
+
+    void benchmarkReadEntities_data();
+    void benchmarkReadEntities();
+
+    void benchmarkReadCache_data();
+    void benchmarkReadCache();
+
+ private:
+    /**
+     * @brief Generates a configuration of switch entities with a status polling and 3 entity commands each.
+     */
+    static QVariantList generateConfig(int entityCount);
+    static QVariantMap  globalHeaders();
+
+    /**
+     * @brief Returns the allocated heap memory in bytes, or -1 if not supported on this platform.
+     */
+    static qint64 heapUsage();
+
+    /**
+     * @brief Returns a memory value of /proc/self/status in kB, e.g. VmHWM, or -1 if not available.
+     */
+    static qint64 procStatus(const QByteArray& field);
+
+    /**
+     * @brief Resets the peak resident set size VmHWM of the process. Returns false if not supported.
+     */
+    static bool resetPeakRss();
+};
+
+QVariantList StartupBenchmark::generateConfig(int entityCount) {
+    QVariantList entities;
+    for (int i = 0; i < entityCount; i++) {
+        QString host = QString("http://10.%1.%2.%3").arg(i / 62500).arg(i / 250 % 250).arg(i % 250 + 1);
+
+        QVariantMap toggleBody;
+        toggleBody.insert("cmd", "toggle");
+        toggleBody.insert("state", "${state_bool}");
+        QVariantMap toggle;
+        toggle.insert("url", host + "/api/toggle");
+        toggle.insert("method", "POST");
+        toggle.insert("body", toggleBody);
+
+        QVariantMap statusMappings;
+        statusMappings.insert("state_bool", "$.relay.ison");
+        statusMappings.insert("power", "$.meters[0].power");
+        QVariantMap response;
+        response.insert("mappings", statusMappings);
+        QVariantMap status;
+        status.insert("url", host + "/status");
+        status.insert("response", response);
+
+        QVariantMap commands;
+        commands.insert("ON", host + "/relay/0?turn=on");
+        commands.insert("OFF", host + "/relay/0?turn=off");
+        commands.insert("TOGGLE", toggle);
+        commands.insert("STATUS_POLLING", status);
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entities.append(entity);
+    }
+    return entities;
+}
+
+QVariantMap StartupBenchmark::globalHeaders() {
+    QVariantMap headers;
+    headers.insert("Accept", "application/json");
+    headers.insert("User-Agent", "YIO Remote");
+    return headers;
+}
+
+qint64 StartupBenchmark::heapUsage() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<qint64>(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return mallinfo().uordblks;
+#else
+    return -1;
+#endif
+}
+
+qint64 StartupBenchmark::procStatus(const QByteArray& field) {
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    for (const QByteArray& line : file.readAll().split('\n')) {
+        if (line.startsWith(field + ':')) {
+            return line.mid(field.size() + 1).trimmed().split(' ').first().toLongLong();
+        }
+    }
+    return -1;
+}
+
+bool StartupBenchmark::resetPeakRss() {
+    QFile file("/proc/self/clear_refs");
+    return file.open(QIODevice::WriteOnly) && file.write("5") == 1;
+}
+
+void StartupBenchmark::testFootprint_data() {
+    QTest::addColumn<int>("entityCount");
+
+    QTest::newRow("100") << 100;
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+}
+
+void StartupBenchmark::testFootprint() {
+    QFETCH(int, entityCount);
+
+    // the configuration is owned by the app and shared with the integration
+    QVariantList config = generateConfig(entityCount);
+
+    bool   peakAvailable = resetPeakRss();
+    qint64 rssStart = procStatus("VmRSS");
+    qint64 heapStart = heapUsage();
+
+    QElapsedTimer timer;
+    timer.start();
+    SwitchHandler* handler = new SwitchHandler("http://localhost");
+    QCOMPARE(handler->readEntities(config, globalHeaders()), entityCount);
+    qint64 constructionTime = timer.nsecsElapsed();
+
+    qint64 heapBytes = heapUsage() - heapStart;
+    qint64 peakKb = peakAvailable && rssStart >= 0 ? procStatus("VmHWM") - rssStart : -1;
+
+    // first use of all entity commands
+    timer.restart();
+    auto iter = handler->entityIter();
+    while (iter.hasNext()) {
+        iter.next();
+        QVERIFY(handler->entityCommand(iter.value(), SwitchDef::C_ON));
+        QVERIFY(handler->entityCommand(iter.value(), SwitchDef::C_TOGGLE));
+    }
+    qint64 materializeTime = timer.nsecsElapsed();
+
+    qInfo("%d entities: construction %.2f ms, heap %lld kB, peak RSS %lld kB, materializing all commands %.2f ms",
+          entityCount, constructionTime / 1e6, heapStart < 0 ? -1 : heapBytes / 1024, peakKb, materializeTime / 1e6);
+
+    delete handler;
+}
+
+void StartupBenchmark::testCacheFootprint_data() { testFootprint_data(); }
+
+void StartupBenchmark::testCacheFootprint() {
+    QFETCH(int, entityCount);
+
+    QVariantList  config = generateConfig(entityCount);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ConfigCache cache(dir.filePath("webhook.cache"));
+    {
+        SwitchHandler handler("http://localhost");
+        handler.readEntities(config, globalHeaders());
+        QVERIFY(cache.save("key", [&handler](QDataStream& out) { handler.writeCache(out); }));
+    }
+
+    // lazy parse: the command configuration is shared with the app configuration
+    qint64        heapStart = heapUsage();
+    QElapsedTimer timer;
+    timer.start();
+    SwitchHandler* parsed = new SwitchHandler("http://localhost");
+    QCOMPARE(parsed->readEntities(config, globalHeaders()), entityCount);
+    qint64 parseTime = timer.nsecsElapsed();
+    qint64 parseHeap = heapUsage() - heapStart;
+    delete parsed;
+
+    // cache hit: the command configuration of unused commands is deserialized
+    heapStart = heapUsage();
+    timer.restart();
+    SwitchHandler* cached = new SwitchHandler("http://localhost");
+    QDataStream*   in = cache.open("key");
+    QVERIFY(in && cached->readCache(*in));
+    cache.close();
+    qint64 cacheTime = timer.nsecsElapsed();
+    qint64 cacheHeap = heapUsage() - heapStart;
+    QCOMPARE(cached->getEntities().size(), entityCount);
+    delete cached;
+
+    qInfo("%d entities: read config %.2f ms, heap %lld kB; read cache %.2f ms, heap %lld kB", entityCount,
+          parseTime / 1e6, heapStart < 0 ? -1 : parseHeap / 1024, cacheTime / 1e6,
+          heapStart < 0 ? -1 : cacheHeap / 1024);
+}
+
+void StartupBenchmark::benchmarkReadEntities_data() { testFootprint_data(); }
+
+void StartupBenchmark::benchmarkReadEntities() {
+    QFETCH(int, entityCount);
+
+    QVariantList config = generateConfig(entityCount);
+    QVariantMap  headers = globalHeaders();
+
+    QBENCHMARK {
+        SwitchHandler handler("http://localhost");
+        handler.readEntities(config, headers);
+    }
+}
+
+void StartupBenchmark::benchmarkReadCache_data() { testFootprint_data(); }
+
+void StartupBenchmark::benchmarkReadCache() {
+    QFETCH(int, entityCount);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ConfigCache cache(dir.filePath("webhook.cache"));
+    {
+        SwitchHandler handler("http://localhost");
+        handler.readEntities(generateConfig(entityCount), globalHeaders());
+        QVERIFY(cache.save("key", [&handler](QDataStream& out) { handler.writeCache(out); }));
+    }
+
+    QBENCHMARK {
+        SwitchHandler handler("http://localhost");
+        QDataStream*  in = cache.open("key");
+        QVERIFY(in && handler.readCache(*in));
+        cache.close();
+    }
+}
+
+QTEST_GUILESS_MAIN(StartupBenchmark)
+
+#include "tst_startupbenchmark.moc"
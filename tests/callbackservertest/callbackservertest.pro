@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_callbackserver
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/callbackserver.h
+
+SOURCES += \
+    tst_callbackserver.cpp \
+    $$INCDIR/callbackserver.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
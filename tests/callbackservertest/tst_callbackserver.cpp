@@ -0,0 +1,119 @@
+#include <QTcpSocket>
+#include <QtTest>
+
+#include "callbackserver.h"
+
+class TestCallbackServer : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void testGetWithQuery();
+    void testPostJsonBody();
+    void testSplitRequest();
+    void testUnknownPath();
+    void testBodyTooLarge();
+
+ private:
+    QByteArray sendRaw(const QList<QByteArray> &parts);
+
+    CallbackServer *m_server;
+    CallbackRequest m_lastRequest;
+    int             m_requestCount;
+};
+
+void TestCallbackServer::init() {
+    m_server = new CallbackServer(this);
+    m_requestCount = 0;
+    m_lastRequest = CallbackRequest();
+
+    m_server->addRoute("/switch1", [this](const CallbackRequest &request, CallbackResponse *response) {
+        m_requestCount++;
+        m_lastRequest = request;
+        response->contentType = "text/plain";
+        response->body = "done";
+    });
+
+    QVERIFY(m_server->listen(0));
+}
+
+void TestCallbackServer::cleanup() {
+    m_server->close();
+    delete m_server;
+}
+
+void TestCallbackServer::testGetWithQuery() {
+    QByteArray response = sendRaw({"GET /switch1?relay=1&power=12.5 HTTP/1.1\r\nHost: localhost\r\n\r\n"});
+
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(response.endsWith("\r\n\r\ndone"));
+    QCOMPARE(m_requestCount, 1);
+    QCOMPARE(m_lastRequest.method, QByteArray("GET"));
+    QCOMPARE(m_lastRequest.path, QString("/switch1"));
+    QCOMPARE(m_lastRequest.query.queryItemValue("relay"), QString("1"));
+    QCOMPARE(m_lastRequest.query.queryItemValue("power"), QString("12.5"));
+    QVERIFY(m_lastRequest.body.isEmpty());
+}
+
+void TestCallbackServer::testPostJsonBody() {
+    QByteArray body = "{\"relay\":true}";
+    QByteArray response = sendRaw({"POST /switch1 HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: " +
+                                   QByteArray::number(body.size()) + "\r\n\r\n" + body});
+
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    QCOMPARE(m_lastRequest.method, QByteArray("POST"));
+    QCOMPARE(m_lastRequest.contentType, QByteArray("application/json"));
+    QCOMPARE(m_lastRequest.body, body);
+}
+
+void TestCallbackServer::testSplitRequest() {
+    QByteArray response = sendRaw({"POST /switch1 HTTP/1.1\r\nContent-Le", "ngth: 10\r\n\r\n01234", "56789"});
+
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    QCOMPARE(m_requestCount, 1);
+    QCOMPARE(m_lastRequest.body, QByteArray("0123456789"));
+}
+
+void TestCallbackServer::testUnknownPath() {
+    QByteArray response = sendRaw({"GET /foo HTTP/1.1\r\n\r\n"});
+
+    QVERIFY(response.startsWith("HTTP/1.1 404 Not Found\r\n"));
+    QCOMPARE(m_requestCount, 0);
+}
+
+void TestCallbackServer::testBodyTooLarge() {
+    QByteArray response = sendRaw({"POST /switch1 HTTP/1.1\r\nContent-Length: 10000000\r\n\r\n"});
+
+    QVERIFY(response.startsWith("HTTP/1.1 413 "));
+    QCOMPARE(m_requestCount, 0);
+}
+
+QByteArray TestCallbackServer::sendRaw(const QList<QByteArray> &parts) {
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, m_server->port());
+    if (!socket.waitForConnected(2000)) {
+        return QByteArray();
+    }
+
+    for (const QByteArray &part : parts) {
+        socket.write(part);
+        socket.flush();
+        // give the server a chance to process partial data
+        QTest::qWait(20);
+    }
+
+    QByteArray response;
+    QElapsedTimer timer;
+    timer.start();
+    while (socket.state() == QAbstractSocket::ConnectedState && timer.elapsed() < 2000) {
+        QTest::qWait(10);
+        response.append(socket.readAll());
+    }
+    response.append(socket.readAll());
+    return response;
+}
+
+QTEST_GUILESS_MAIN(TestCallbackServer)
+#include "tst_callbackserver.moc"
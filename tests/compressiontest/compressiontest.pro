@@ -0,0 +1,28 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_compression
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/compression.h
+
+SOURCES += \
+    tst_compression.cpp \
+    $$INCDIR/compression.cpp
+
+win32 {
+    INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+} else {
+    LIBS += -lz
+}
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
+
+RESOURCES += \
+    ../jsonpathtest/testfiles.qrc
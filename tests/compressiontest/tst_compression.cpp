@@ -0,0 +1,116 @@
+#include <QFile>
+#include <QtTest>
+
+#include "compression.h"
+
+class TestCompression : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testEncodingFromHeader();
+    void testIdentity();
+    void testGzipRoundTrip();
+    void testGzipChunked_data();
+    void testGzipChunked();
+    void testDeflate();
+    void testInvalidData();
+
+ private:
+    QByteArray load(const QString &resource);
+};
+
+void TestCompression::testEncodingFromHeader() {
+    QCOMPARE(InflateStream::encodingFromHeader("gzip"), InflateStream::GZIP);
+    QCOMPARE(InflateStream::encodingFromHeader(" GZip "), InflateStream::GZIP);
+    QCOMPARE(InflateStream::encodingFromHeader("deflate"), InflateStream::DEFLATE);
+    QCOMPARE(InflateStream::encodingFromHeader(""), InflateStream::IDENTITY);
+    QCOMPARE(InflateStream::encodingFromHeader("br"), InflateStream::IDENTITY);
+}
+
+void TestCompression::testIdentity() {
+    QByteArray    data = load(":/testdata/myStrom-switch-report-response.json");
+    InflateStream stream;
+
+    QVERIFY(stream.begin(InflateStream::IDENTITY));
+    QVERIFY(stream.append(data.left(5)));
+    QVERIFY(stream.append(data.mid(5)));
+
+    QCOMPARE(stream.data(), data);
+    QCOMPARE(stream.wireBytes(), static_cast<qint64>(data.size()));
+}
+
+void TestCompression::testGzipRoundTrip() {
+    QByteArray data = load(":/testdata/JsonPath.json");
+    QByteArray compressed = Compression::gzip(data);
+
+    QVERIFY(!compressed.isEmpty());
+    // gzip magic header
+    QCOMPARE(static_cast<unsigned char>(compressed.at(0)), 0x1f);
+    QCOMPARE(static_cast<unsigned char>(compressed.at(1)), 0x8b);
+
+    InflateStream stream;
+    QVERIFY(stream.begin(InflateStream::GZIP));
+    QVERIFY(stream.append(compressed));
+    QVERIFY(!stream.hasError());
+    QCOMPARE(stream.data(), data);
+    QCOMPARE(stream.wireBytes(), static_cast<qint64>(compressed.size()));
+}
+
+void TestCompression::testGzipChunked_data() {
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("1 byte chunks") << 1;
+    QTest::newRow("7 byte chunks") << 7;
+    QTest::newRow("64 byte chunks") << 64;
+}
+
+void TestCompression::testGzipChunked() {
+    QFETCH(int, chunkSize);
+
+    // large enough to require multiple inflate output buffers
+    QByteArray data = load(":/testdata/JsonPath.json").repeated(500);
+    QByteArray compressed = Compression::gzip(data);
+
+    InflateStream stream;
+    QVERIFY(stream.begin(InflateStream::GZIP));
+    for (int i = 0; i < compressed.size(); i += chunkSize) {
+        QVERIFY(stream.append(compressed.mid(i, chunkSize)));
+    }
+
+    QCOMPARE(stream.data().size(), data.size());
+    QCOMPARE(stream.data(), data);
+}
+
+void TestCompression::testDeflate() {
+    QByteArray data = load(":/testdata/myStrom-bulb-setcolor-response.json");
+    // qCompress creates a zlib stream with a 4 byte length prefix
+    QByteArray compressed = qCompress(data).mid(4);
+
+    InflateStream stream;
+    QVERIFY(stream.begin(InflateStream::DEFLATE));
+    QVERIFY(stream.append(compressed));
+    QCOMPARE(stream.data(), data);
+
+    // raw deflate stream without zlib header and adler32 trailer
+    QByteArray raw = compressed.mid(2, compressed.size() - 6);
+    QVERIFY(stream.begin(InflateStream::DEFLATE));
+    QVERIFY(stream.append(raw));
+    QCOMPARE(stream.data(), data);
+}
+
+void TestCompression::testInvalidData() {
+    InflateStream stream;
+    QVERIFY(stream.begin(InflateStream::GZIP));
+    QVERIFY(!stream.append("this is not gzip compressed"));
+    QVERIFY(stream.hasError());
+    QVERIFY(!stream.append("more data"));
+}
+
+QByteArray TestCompression::load(const QString &resource) {
+    QFile file(resource);
+    file.open(QFile::OpenModeFlag::ReadOnly);
+    return file.readAll();
+}
+
+QTEST_GUILESS_MAIN(TestCompression)
+#include "tst_compression.moc"
@@ -0,0 +1,31 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_configcache
+
+INTG_LIB_PATH = $$(YIO_SRC)
+isEmpty(INTG_LIB_PATH) {
+    INTG_LIB_PATH = $$clean_path($$PWD/../../../integrations.library)
+} else {
+    INTG_LIB_PATH = $$(YIO_SRC)/integrations.library
+}
+
+! include($$INTG_LIB_PATH/yio-plugin-lib.pri) {
+    error( "Cannot find the yio-plugin-lib.pri file" )
+}
+
+include($$PWD/../webhook-core.pri)
+INCLUDEPATH += $$PWD/../entityhandlertest
+
+HEADERS += \
+    $$PWD/../entityhandlertest/entityhandlerimpl.h \
+    $$INCDIR/configcache.h
+
+SOURCES += \
+    tst_configcache.cpp \
+    $$INCDIR/configcache.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
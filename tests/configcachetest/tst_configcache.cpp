@@ -0,0 +1,200 @@
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "configcache.h"
+#include "entityhandlerimpl.h"
+
+class TestConfigCache : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+
+    void testKey();
+    void testMissingCache();
+    void testOutdatedCache();
+    void testRoundTrip();
+    void testCorruptCache();
+
+ private:
+    /**
+     * @brief Generates a configuration of switch entities using the static placeholder `host`.
+     */
+    static QVariantList generateConfig(int entityCount);
+    static QVariantMap  placeholders();
+
+    QScopedPointer<QTemporaryDir> m_dir;
+    QString                       m_fileName;
+};
+
+QVariantList TestConfigCache::generateConfig(int entityCount) {
+    QVariantList entities;
+    for (int i = 0; i < entityCount; i++) {
+        QVariantMap toggleBody;
+        toggleBody.insert("state", "${state_bool}");
+        QVariantMap toggleHeaders;
+        toggleHeaders.insert("Authorization", "Bearer ${token}");
+        QVariantMap toggle;
+        toggle.insert("url", QString("http://${host}/api/%1/toggle").arg(i));
+        toggle.insert("method", "POST");
+        toggle.insert("body", toggleBody);
+        toggle.insert("headers", toggleHeaders);
+
+        QVariantMap statusMappings;
+        statusMappings.insert("state_bool", "$.relay.ison");
+        QVariantMap power;
+        power.insert("path", "$.meters[0].power");
+        power.insert("transform", QVariantMap{{"round", 0}});
+        statusMappings.insert("power", power);
+        QVariantMap response;
+        response.insert("mappings", statusMappings);
+        QVariantMap status;
+        status.insert("url", QString("http://${host}/api/%1/status").arg(i));
+        status.insert("response", response);
+        status.insert("interval", 60);
+
+        QVariantMap commands;
+        commands.insert("ON", QString("http://${host}/api/%1/on").arg(i));
+        commands.insert("TOGGLE", toggle);
+        commands.insert("STATUS_POLLING", status);
+
+        QVariantMap callback;
+        callback.insert("path", QString("/device_%1").arg(i));
+        callback.insert("poll_interval", 300);
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entity.insert("callback", callback);
+        entities.append(entity);
+    }
+    return entities;
+}
+
+QVariantMap TestConfigCache::placeholders() {
+    QVariantMap placeholders;
+    placeholders.insert("host", "10.0.0.1");
+    placeholders.insert("token", "secret");
+    return placeholders;
+}
+
+void TestConfigCache::init() {
+    m_dir.reset(new QTemporaryDir());
+    QVERIFY(m_dir->isValid());
+    m_fileName = m_dir->filePath("webhook.cache");
+}
+
+void TestConfigCache::testKey() {
+    QVariantMap data;
+    data.insert("entities", generateConfig(2));
+    data.insert("placeholders", placeholders());
+
+    QByteArray key = ConfigCache::key(data, "1.0.0");
+    QCOMPARE(ConfigCache::key(data, "1.0.0"), key);
+    QVERIFY(ConfigCache::key(data, "1.0.1") != key);
+
+    data.insert("base_url", "http://localhost");
+    QVERIFY(ConfigCache::key(data, "1.0.0") != key);
+}
+
+void TestConfigCache::testMissingCache() {
+    ConfigCache cache(m_fileName);
+    QVERIFY(!cache.open("key"));
+}
+
+void TestConfigCache::testOutdatedCache() {
+    ConfigCache cache(m_fileName);
+    QVERIFY(cache.save("key", [](QDataStream& out) { out << QString("data"); }));
+
+    QVERIFY(!cache.open("other key"));
+
+    QDataStream* in = cache.open("key");
+    QVERIFY(in);
+    QString data;
+    *in >> data;
+    QCOMPARE(data, QString("data"));
+}
+
+void TestConfigCache::testRoundTrip() {
+    EntityHandlerImpl handler("switch", "");
+    handler.setPlaceholders(placeholders());
+    QCOMPARE(handler.readEntities(generateConfig(10), QVariantMap()), 10);
+    // a command used before writing the cache is cached compiled
+    QVERIFY(handler.entityCommand(handler.webhookEntity("switch.device_5"), 2));
+
+    ConfigCache cache(m_fileName);
+    QVERIFY(cache.save("key", [&handler](QDataStream& out) { handler.writeCache(out); }));
+
+    EntityHandlerImpl cached("switch", "");
+    cached.setPlaceholders(placeholders());
+    QDataStream* in = cache.open("key");
+    QVERIFY(in);
+    QVERIFY(cached.readCache(*in));
+    cache.close();
+
+    QCOMPARE(cached.getEntities().size(), 10);
+    // only the status polling commands and the used command are compiled, the others are materialized on first use
+    QCOMPARE(cached.configStore().commandCount(), 11);
+    WebhookEntity* used = cached.webhookEntity("switch.device_5");
+    QVERIFY(used->commands.value("TOGGLE"));
+    QVERIFY(!used->commands.value("ON"));
+
+    WebhookEntity* entity = cached.webhookEntity("switch.device_3");
+    QVERIFY(entity);
+    QCOMPARE(entity->type, QString("switch"));
+    QCOMPARE(entity->friendlyName, QString("Device 3"));
+    QCOMPARE(entity->callbackPath, QString("/device_3"));
+    QCOMPARE(entity->pollInterval, 300);
+    QCOMPARE(entity->supportedFeatures, QStringList({"ON", "TOGGLE"}));
+    QVERIFY(entity->statusCommand);
+    QCOMPARE(entity->statusCommand->responseMappings.size(), 2);
+
+    // the compiled transforms are index aligned with the mappings and shared by all entities
+    const TransformList& transforms = entity->statusCommand->responseTransforms;
+    QCOMPARE(transforms.size(), 2);
+    QVERIFY(transforms == handler.webhookEntity("switch.device_3")->statusCommand->responseTransforms);
+    QCOMPARE(transforms.at(0).apply(QJsonValue(35.8)), QVariant(36));
+    QVERIFY(transforms.at(1).isEmpty());
+    QCOMPARE(cached.configStore().poolStats().value("transform_lists").toInt(), 1);
+
+    QCOMPARE(entity->statusCommand->urlTemplate.text(), QString("http://10.0.0.1/api/3/status"));
+    QCOMPARE(entity->statusCommand->interval, 60);
+
+    // static placeholders are pre-rendered, dynamic placeholders are kept
+    const WebhookCommand* toggle = cached.entityCommand(entity, 2);
+    QVERIFY(toggle);
+    QCOMPARE(toggle->method, HttpMethod::POST);
+    QCOMPARE(toggle->urlTemplate.text(), QString("http://10.0.0.1/api/3/toggle"));
+    QVERIFY(!toggle->urlTemplate.hasPlaceholders());
+    QCOMPARE(toggle->bodyTemplate.text(), QString("{\"state\":\"${state_bool}\"}"));
+    QCOMPARE(toggle->placeholderMask, Placeholder::bit(Placeholder::STATE_BOOL));
+    QCOMPARE(toggle->headerTemplates.size(), 1);
+    QCOMPARE(toggle->headerTemplates.first().second.text(), QString("Bearer secret"));
+
+    PlaceholderValues values;
+    values.set(Placeholder::STATE_BOOL, true);
+    QCOMPARE(toggle->bodyTemplate.render(values), QString("{\"state\":\"true\"}"));
+
+    const WebhookCommand* on = cached.entityCommand(entity, 0);
+    QVERIFY(on);
+    QCOMPARE(on->url, QString("http://${host}/api/3/on"));
+    QCOMPARE(on->urlTemplate.text(), QString("http://10.0.0.1/api/3/on"));
+    QVERIFY(!cached.entityCommand(entity, 1));
+    QCOMPARE(cached.configStore().commandCount(), 13);
+}
+
+void TestConfigCache::testCorruptCache() {
+    ConfigCache cache(m_fileName);
+    QVERIFY(cache.save("key", [](QDataStream& out) { out << static_cast<qint32>(5) << QString("switch.device_0"); }));
+
+    EntityHandlerImpl handler("switch", "");
+    QDataStream*      in = cache.open("key");
+    QVERIFY(in);
+    QVERIFY(!handler.readCache(*in));
+    QVERIFY(handler.getEntities().isEmpty());
+    QCOMPARE(handler.configStore().entityCount(), 0);
+}
+
+QTEST_GUILESS_MAIN(TestConfigCache)
+#include "tst_configcache.moc"
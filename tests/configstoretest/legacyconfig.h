@@ -0,0 +1,106 @@
+#pragma once
+
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+#include "httpmethod.h"
+
+/**
+ * @brief Replica of the former QObject based command definition, used as memory footprint baseline.
+ */
+class LegacyCommand : public QObject {
+ public:
+    explicit LegacyCommand(QObject* parent) : QObject(parent), method(HttpMethod::GET), compressBody(false) {}
+
+    QString                url;
+    HttpMethod::Enum       method;
+    QVariantMap            headers;
+    QVariant               body;
+    QMap<QString, QString> responseMappings;
+    bool                   compressBody;
+};
+
+/**
+ * @brief Replica of the former QObject based entity definition, used as memory footprint baseline.
+ */
+class LegacyEntity : public QObject {
+ public:
+    explicit LegacyEntity(QObject* parent) : QObject(parent), pollInterval(-1), lastUpdate(0) {}
+
+    QString                       id;
+    QString                       type;
+    QString                       friendlyName;
+    QVariantMap                   attributes;
+    QStringList                   supportedFeatures;
+    QMap<QString, LegacyCommand*> commands;
+    QString                       callbackPath;
+    QMap<QString, QString>        callbackMappings;
+    int                           pollInterval;
+    qint64                        lastUpdate;
+};
+
+/**
+ * @brief Reads the entity configuration like the former EntityHandler::readEntities implementation.
+ */
+class LegacyConfig : public QObject {
+ public:
+    int readEntities(const QVariantList& entityCfgList, const QVariantMap& headers) {
+        for (const QVariant& entityCfg : entityCfgList) {
+            QVariantMap   entityCfgMap = entityCfg.toMap();
+            LegacyEntity* entity = new LegacyEntity(this);
+            entity->id = entityCfgMap.value("entity_id").toString();
+            entity->type = m_entityType;
+            entity->friendlyName = entityCfgMap.value("friendly_name").toString();
+            entity->attributes = entityCfgMap.value("attributes").toMap();
+
+            QMapIterator<QString, QVariant> iter(entityCfgMap.value("commands").toMap());
+            while (iter.hasNext()) {
+                iter.next();
+                entity->supportedFeatures.append(iter.key());
+
+                LegacyCommand* command = new LegacyCommand(this);
+                command->headers = headers;
+                if (iter.value().type() == QVariant::String) {
+                    command->url = iter.value().toString();
+                } else {
+                    QVariantMap attrMap = iter.value().toMap();
+                    command->url = attrMap.value("url").toString();
+                    command->method = attrMap.value("method").toString() == "POST" ? HttpMethod::POST : HttpMethod::GET;
+                    if (command->method != HttpMethod::GET) {
+                        command->body = attrMap.value("body");
+                        QMapIterator<QString, QVariant> headerIter(attrMap.value("headers").toMap());
+                        while (headerIter.hasNext()) {
+                            headerIter.next();
+                            command->headers.insert(headerIter.key(), headerIter.value());
+                        }
+                    }
+                    QMapIterator<QString, QVariant> mappingIter(
+                        attrMap.value("response").toMap().value("mappings").toMap());
+                    while (mappingIter.hasNext()) {
+                        mappingIter.next();
+                        command->responseMappings.insert(mappingIter.key(), mappingIter.value().toString());
+                    }
+                }
+                entity->commands.insert(iter.key(), command);
+            }
+
+            QVariantMap callbackCfg = entityCfgMap.value("callback").toMap();
+            entity->callbackPath = callbackCfg.value("path").toString();
+            QMapIterator<QString, QVariant> mappingIter(callbackCfg.value("mappings").toMap());
+            while (mappingIter.hasNext()) {
+                mappingIter.next();
+                entity->callbackMappings.insert(mappingIter.key(), mappingIter.value().toString());
+            }
+
+            m_entities.insert(entity->id, entity);
+        }
+        return m_entities.size();
+    }
+
+ private:
+    QString                      m_entityType = "switch";
+    QMap<QString, LegacyEntity*> m_entities;
+};
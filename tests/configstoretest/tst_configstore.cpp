@@ -0,0 +1,251 @@
+#include <QScopedPointer>
+#include <QtTest>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "configstore.h"
+#include "entityhandlerimpl.h"
+#include "legacyconfig.h"
+#include "switchconfig.h"
+
+class TestConfigStore : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testRecordArrayStablePointers();
+    void testInternedStrings();
+    void testSharedHeaders();
+    void testSharedMappings();
+    void testReadEntities();
+    void testLazyCommands();
+    void testMemoryFootprint();
+
+ private:
+    /**
+     * @brief Returns the allocated heap memory in bytes, or -1 if not supported on this platform.
+     */
+    static qint64 heapUsage();
+};
+
+QVariantList TestConfigStore::generateSwitchConfig(int entityCount) {
+    QVariantList entities;
+    for (int i = 0; i < entityCount; i++) {
+        // every device has its own host: urls are unique, but mappings and headers are the same for all devices
+        QString host = QString("http://10.0.%1.%2").arg(i / 250).arg(i % 250 + 1);
+
+        QVariantMap toggleBody;
+        toggleBody.insert("cmd", "toggle");
+        QVariantMap toggleHeaders;
+        toggleHeaders.insert("Content-Type", "application/json");
+        QVariantMap toggle;
+        toggle.insert("url", host + "/api/toggle");
+        toggle.insert("method", "POST");
+        toggle.insert("body", toggleBody);
+        toggle.insert("headers", toggleHeaders);
+
+        QVariantMap statusMappings;
+        statusMappings.insert("state_bool", "$.relay.ison");
+        statusMappings.insert("power", "$.meters[0].power");
+        QVariantMap response;
+        response.insert("mappings", statusMappings);
+        QVariantMap status;
+        status.insert("url", host + "/status");
+        status.insert("response", response);
+
+        QVariantMap brightness;
+        brightness.insert("url", host + "/api/brightness");
+        brightness.insert("method", "POST");
+        brightness.insert("body", "${brightness}");
+
+        QVariantMap commands;
+        commands.insert("ON", host + "/relay/0?turn=on");
+        commands.insert("OFF", host + "/relay/0?turn=off");
+        commands.insert("TOGGLE", toggle);
+        commands.insert("BRIGHTNESS", brightness);
+        commands.insert("STATUS_POLLING", status);
+
+        QVariantMap callback;
+        callback.insert("path", QString("/device_%1").arg(i));
+        callback.insert("mappings", statusMappings);
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entity.insert("callback", callback);
+        entities.append(entity);
+    }
+    return entities;
+}
+
+QVariantMap TestConfigStore::globalHeaders() {
+    QVariantMap headers;
+    headers.insert("Accept", "application/json");
+    headers.insert("User-Agent", "YIO Remote");
+    return headers;
+}
+
+qint64 TestConfigStore::heapUsage() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<qint64>(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+    return mallinfo().uordblks;
+#else
+    return -1;
+#endif
+}
+
+void TestConfigStore::testRecordArrayStablePointers() {
+    RecordArray<QString, 4> array;
+    QVector<QString*>       records;
+    for (int i = 0; i < 10; i++) {
+        QString* record = array.append();
+        *record = QString::number(i);
+        records.append(record);
+    }
+
+    QCOMPARE(array.size(), 10);
+    for (int i = 0; i < 10; i++) {
+        QCOMPARE(array.at(i), records.at(i));
+        QCOMPARE(*records.at(i), QString::number(i));
+    }
+
+    array.clear();
+    QCOMPARE(array.size(), 0);
+}
+
+void TestConfigStore::testInternedStrings() {
+    ConfigStore store;
+
+    QString first = store.intern(QString("STATUS_POLLING"));
+    QString second = store.intern(QString("STATUS_POLLING"));
+
+    QCOMPARE(first, second);
+    QCOMPARE(first.constData(), second.constData());
+    QVERIFY(store.intern("").isNull());
+    QCOMPARE(store.poolStats().value("strings").toInt(), 1);
+}
+
+void TestConfigStore::testSharedHeaders() {
+    ConfigStore store;
+
+    QVariantMap first = store.sharedHeaders(globalHeaders());
+    QVariantMap second = store.sharedHeaders(globalHeaders());
+    QVERIFY(first.isSharedWith(second));
+
+    QVariantMap custom = globalHeaders();
+    custom.insert("Content-Type", "application/json");
+    QVariantMap third = store.sharedHeaders(custom);
+    QVERIFY(!third.isSharedWith(first));
+    QCOMPARE(store.poolStats().value("header_blocks").toInt(), 2);
+}
+
+void TestConfigStore::testSharedMappings() {
+    ConfigStore store;
+
+    MappingList mappings;
+    mappings.append(qMakePair(QString("state_bool"), QString("$.relay.ison")));
+    mappings.append(qMakePair(QString("power"), QString("$.meters[0].power")));
+
+    MappingList first = store.sharedMappings(mappings);
+    MappingList second = store.sharedMappings(MappingList(mappings));
+    QCOMPARE(first, mappings);
+    QCOMPARE(first.constData(), second.constData());
+    QVERIFY(store.sharedMappings(MappingList()).isEmpty());
+    QCOMPARE(store.poolStats().value("mapping_lists").toInt(), 1);
+}
+
+void TestConfigStore::testReadEntities() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(10), globalHeaders()), 10);
+
+    const ConfigStore& store = handler.configStore();
+    QCOMPARE(store.entityCount(), 10);
+    // only the status commands are materialized when reading the configuration
+    QCOMPARE(store.commandCount(), 10);
+    QCOMPARE(store.poolStats().value("header_blocks").toInt(), 1);
+    // status and callback mappings are equal
+    QCOMPARE(store.poolStats().value("mapping_lists").toInt(), 1);
+
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+    QVERIFY(entity);
+    QCOMPARE(entity->commands.size(), 5);
+    QVERIFY(entity->commands.contains("STATUS_POLLING"));
+    QVERIFY(!entity->commands.contains("STATUS_SUBSCRIBE"));
+    QVERIFY(entity->statusCommand);
+    QCOMPARE(entity->commands.value("STATUS_POLLING"), entity->statusCommand);
+    QVERIFY(!entity->commands.value("ON"));
+    QCOMPARE(entity->callbackPath, QString("/device_3"));
+    QCOMPARE(entity->callbackMappings.size(), 2);
+
+    WebhookEntity* other = handler.webhookEntity("switch.device_7");
+    QVERIFY(other);
+    QCOMPARE(entity->callbackMappings.constData(), other->callbackMappings.constData());
+    QCOMPARE(entity->commands.nameAt(0).constData(), other->commands.nameAt(0).constData());
+}
+
+void TestConfigStore::testLazyCommands() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(10), globalHeaders()), 10);
+
+    const ConfigStore& store = handler.configStore();
+    WebhookEntity*     entity = handler.webhookEntity("switch.device_3");
+    QVERIFY(entity);
+
+    const WebhookCommand* on = handler.entityCommand(entity, 0);
+    QVERIFY(on);
+    QCOMPARE(on->url, QString("http://10.0.0.4/relay/0?turn=on"));
+    QCOMPARE(entity->commands.value("ON"), on);
+    QVERIFY(!entity->commands.configAt(entity->commands.indexOf("ON")).isValid());
+    QCOMPARE(store.commandCount(), 11);
+
+    // materialized only once
+    QCOMPARE(handler.entityCommand(entity, 0), on);
+    QCOMPARE(store.commandCount(), 11);
+
+    const WebhookCommand* toggle = handler.entityCommand(entity, 2);
+    QVERIFY(toggle);
+    QCOMPARE(toggle->method, HttpMethod::POST);
+    QCOMPARE(toggle->headers.value("Content-Type").toString(), QString("application/json"));
+    // global headers and global headers + content type
+    QCOMPARE(store.poolStats().value("header_blocks").toInt(), 2);
+
+    QVERIFY(!handler.entityCommand(entity, 4));
+    QVERIFY(!handler.entityCommand(entity, -1));
+    QCOMPARE(store.commandCount(), 12);
+}
+
+void TestConfigStore::testMemoryFootprint() {
+    if (heapUsage() < 0) {
+        QSKIP("Heap usage statistics not available on this platform");
+    }
+
+    const int entityCount = 500;
+    // the configuration is owned by the app and shared with the integration
+    QVariantList config = generateSwitchConfig(entityCount);
+
+    qint64 start = heapUsage();
+    LegacyConfig* legacy = new LegacyConfig();
+    legacy->readEntities(config, globalHeaders());
+    qint64 legacyBytes = heapUsage() - start;
+    delete legacy;
+
+    start = heapUsage();
+    EntityHandlerImpl* handler = new EntityHandlerImpl("switch", "");
+    handler->readEntities(config, globalHeaders());
+    qint64 storeBytes = heapUsage() - start;
+    delete handler;
+
+    qInfo("Config footprint of %d entities x 5 commands: QObject layout %lld bytes/entity, config store %lld "
+          "bytes/entity",
+          entityCount, legacyBytes / entityCount, storeBytes / entityCount);
+
+    QVERIFY(storeBytes > 0);
+    QVERIFY(storeBytes < legacyBytes);
+}
+
+QTEST_GUILESS_MAIN(TestConfigStore)
+
+#include "tst_configstore.moc"
@@ -12,9 +12,9 @@ class EntityHandlerImpl : public EntityHandler {
 
     // EntityHandler interface
  public:
-    WebhookRequest *createCommandRequest(const QString &entityId, EntityInterface *entity, int command,
+    WebhookRequest *createCommandRequest(const WebhookEntity *webhookEntity, EntityInterface *entity, int command,
                                    const QVariantMap &placeholders, const QVariant &param) const override {
-        Q_UNUSED(entityId)
+        Q_UNUSED(webhookEntity)
         Q_UNUSED(entity)
         Q_UNUSED(command)
         Q_UNUSED(placeholders)
@@ -22,15 +22,24 @@ class EntityHandlerImpl : public EntityHandler {
         return nullptr;
     }
 
-    void commandReply(int command, EntityInterface *entity, const QVariant &param, const WebhookRequest *request,
-                 QNetworkReply *reply) override {
-        Q_UNUSED(command)
+    int featureToCommand(const QString &feature) const override {
+        static const QStringList commands{"ON", "OFF", "TOGGLE", "BRIGHTNESS"};
+        return commands.indexOf(feature);
+    }
+
+    UndoRecord applyCommandState(int command, EntityInterface *entity, const QVariant &param) override {
         Q_UNUSED(entity)
-        Q_UNUSED(param)
-        Q_UNUSED(request)
-        Q_UNUSED(reply)
+        appliedCommands.append(qMakePair(command, param));
+        return nextUndo;
     }
 
+    /**
+     * @brief Undo record returned by applyCommandState().
+     */
+    UndoRecord                    nextUndo;
+    QVector<QPair<int, QVariant>> appliedCommands;
+    QVector<UndoRecord>           restoredUndos;
+
  protected:
     const QLoggingCategory& logCategory() const override { return CLASS_LC_TEST(); }
 
@@ -39,6 +48,11 @@ class EntityHandlerImpl : public EntityHandler {
         Q_UNUSED(placeholders)
     }
 
+    void restoreEntity(EntityInterface *entity, const UndoRecord &undo) override {
+        Q_UNUSED(entity)
+        restoredUndos.append(undo);
+    }
+
  private:
     friend TestEntityHandler;
 };
@@ -17,21 +17,13 @@ isEmpty(INTG_LIB_PATH) {
     error( "Cannot find the yio-plugin-lib.pri file" )
 }
 
-INCDIR = $$PWD/../../src
-INCLUDEPATH += $$INCDIR
+include($$PWD/../webhook-core.pri)
 
 HEADERS += \
     entityhandlerimpl.h \
-    $$INCDIR/entityhandler.h \
-    $$INCDIR/httpmethod.h \
-    $$INCDIR/jsonpath.h \
-    $$INCDIR/webhookcommand.h \
-    $$INCDIR/webhookentity.h \
-    $$INCDIR/webhookrequest.h
+    switchconfig.h
 
 SOURCES += \
-    tst_entityhandler.cpp \
-    $$INCDIR/entityhandler.cpp \
-    $$INCDIR/jsonpath.cpp
+    tst_entityhandler.cpp
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"
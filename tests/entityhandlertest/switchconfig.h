@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QVariantList>
+#include <QVariantMap>
+
+/**
+ * @brief Generates a configuration of switch entities with 5 commands each and callback mappings.
+ */
+inline QVariantList generateSwitchConfig(int entityCount) {
+    QVariantList entities;
+    for (int i = 0; i < entityCount; i++) {
+        // every device has its own host: urls are unique, but mappings and headers are the same for all devices
+        QString host = QString("http://10.0.%1.%2").arg(i / 250).arg(i % 250 + 1);
+
+        QVariantMap toggleBody;
+        toggleBody.insert("cmd", "toggle");
+        QVariantMap toggleHeaders;
+        toggleHeaders.insert("Content-Type", "application/json");
+        QVariantMap toggle;
+        toggle.insert("url", host + "/api/toggle");
+        toggle.insert("method", "POST");
+        toggle.insert("body", toggleBody);
+        toggle.insert("headers", toggleHeaders);
+
+        QVariantMap statusMappings;
+        statusMappings.insert("state_bool", "$.relay.ison");
+        statusMappings.insert("power", "$.meters[0].power");
+        QVariantMap response;
+        response.insert("mappings", statusMappings);
+        QVariantMap status;
+        status.insert("url", host + "/status");
+        status.insert("response", response);
+
+        QVariantMap brightness;
+        brightness.insert("url", host + "/api/brightness");
+        brightness.insert("method", "POST");
+        brightness.insert("body", "${brightness}");
+
+        QVariantMap commands;
+        commands.insert("ON", host + "/relay/0?turn=on");
+        commands.insert("OFF", host + "/relay/0?turn=off");
+        commands.insert("TOGGLE", toggle);
+        commands.insert("BRIGHTNESS", brightness);
+        commands.insert("STATUS_POLLING", status);
+
+        QVariantMap callback;
+        callback.insert("path", QString("/device_%1").arg(i));
+        callback.insert("mappings", statusMappings);
+
+        QVariantMap entity;
+        entity.insert("entity_id", QString("switch.device_%1").arg(i));
+        entity.insert("friendly_name", QString("Device %1").arg(i));
+        entity.insert("commands", commands);
+        entity.insert("callback", callback);
+        entities.append(entity);
+    }
+    return entities;
+}
+
+inline QVariantMap globalHeaders() {
+    QVariantMap headers;
+    headers.insert("Accept", "application/json");
+    headers.insert("User-Agent", "YIO Remote");
+    return headers;
+}
@@ -1,9 +1,32 @@
 #include <QFile>
 #include <QJsonDocument>
+#include <QScopedPointer>
 #include <QtTest>
 
 #include "entityhandlerimpl.h"
 #include "jsonpath.h"
+#include "switchconfig.h"
+
+/**
+ * @brief Finished reply with the given network error and without response data.
+ */
+class FinishedReply : public QNetworkReply {
+ public:
+    explicit FinishedReply(NetworkError error) {
+        setError(error, error == NoError ? QString() : QStringLiteral("Connection refused"));
+        setFinished(true);
+        open(QIODevice::ReadOnly);
+    }
+
+    void abort() override {}
+
+ protected:
+    qint64 readData(char* data, qint64 maxSize) override {
+        Q_UNUSED(data)
+        Q_UNUSED(maxSize)
+        return -1;
+    }
+};
 
 class TestEntityHandler : public QObject {
     Q_OBJECT
@@ -63,6 +86,24 @@ class TestEntityHandler : public QObject {
         QTest::newRow("not supported float format") << "${PERCENT:%f}" << placeholders << "${PERCENT:%f}";
     }
     void testResolveVariables();
+
+    void testCommandHostsLazy();
+
+    void testReloadUnchanged();
+    void testReloadChangedEntity();
+    void testReloadAddedAndRemoved();
+    void testReloadRecompile();
+    void testReloadPlaceholders();
+
+    void testCommandRollback();
+    void testSupersededCommandReply();
+    void testStatusWhileCommandPending();
+
+ private:
+    /**
+     * @brief Creates an ON command request and applies its intended state like Webhook::sendCommandRequest().
+     */
+    static WebhookRequest* sendCommand(EntityHandlerImpl* handler, WebhookEntity* entity, quint64 sequence);
 };
 
 void TestEntityHandler::testBuildUrl() {
@@ -94,5 +135,241 @@ void TestEntityHandler::testResolveVariables() {
     QCOMPARE(resolvedText, result);
 }
 
+void TestEntityHandler::testCommandHostsLazy() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(3), globalHeaders()), 3);
+    int commandCount = handler.configStore().commandCount();
+
+    QSet<QString> hosts = handler.commandHosts(QVariantMap());
+    QCOMPARE(hosts, QSet<QString>({"10.0.0.1", "10.0.0.2", "10.0.0.3"}));
+    // the host names are read from the configuration of commands which aren't used yet
+    QCOMPARE(handler.configStore().commandCount(), commandCount);
+}
+
+void TestEntityHandler::testReloadUnchanged() {
+    QVariantList      config = generateSwitchConfig(10);
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(config, globalHeaders()), 10);
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+    int            commandCount = handler.configStore().commandCount();
+
+    // a re-parsed configuration isn't shared with the previous one
+    EntityHandler::ReloadResult result =
+        handler.reloadEntities(config, generateSwitchConfig(10), globalHeaders(), false);
+    QCOMPARE(result.unchanged, 10);
+    QVERIFY(result.added.isEmpty());
+    QVERIFY(result.updated.isEmpty());
+    QVERIFY(result.removed.isEmpty());
+    QVERIFY(!result.subscriptionsChanged);
+    QCOMPARE(handler.webhookEntity("switch.device_3"), entity);
+    QCOMPARE(handler.configStore().commandCount(), commandCount);
+}
+
+void TestEntityHandler::testReloadChangedEntity() {
+    QVariantList      config = generateSwitchConfig(10);
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(config, globalHeaders()), 10);
+
+    WebhookEntity*        entity = handler.webhookEntity("switch.device_3");
+    WebhookCommand*       status = entity->statusCommand;
+    const WebhookCommand* on = handler.entityCommand(entity, 0);
+    const WebhookCommand* toggle = handler.entityCommand(entity, 2);
+    entity->lastUpdate = 42;
+    entity->pendingCommands = 1;
+
+    QVariantList changedConfig = config;
+    QVariantMap  entityCfg = changedConfig.at(3).toMap();
+    QVariantMap  commandsCfg = entityCfg.value("commands").toMap();
+    commandsCfg.insert("ON", "http://10.0.0.4/relay/0?turn=on&timer=60");
+    entityCfg.insert("commands", commandsCfg);
+    entityCfg.insert("friendly_name", "Renamed");
+    changedConfig[3] = entityCfg;
+
+    EntityHandler::ReloadResult result = handler.reloadEntities(config, changedConfig, globalHeaders(), false);
+    QCOMPARE(result.unchanged, 9);
+    QCOMPARE(result.updated.size(), 1);
+    QCOMPARE(result.updated.first(), entity);
+    QVERIFY(result.added.isEmpty());
+    QVERIFY(result.removed.isEmpty());
+
+    // updated in place: the runtime state is kept
+    QCOMPARE(handler.webhookEntity("switch.device_3"), entity);
+    QCOMPARE(entity->friendlyName, QString("Renamed"));
+    QCOMPARE(entity->lastUpdate, qint64(42));
+    QCOMPARE(entity->pendingCommands, 1);
+    QCOMPARE(entity->supportedFeatures.size(), 4);
+
+    // only the changed command is read again, the previous command stays valid for in-flight requests
+    QCOMPARE(entity->statusCommand, status);
+    QCOMPARE(handler.entityCommand(entity, 2), toggle);
+    const WebhookCommand* changedOn = handler.entityCommand(entity, 0);
+    QVERIFY(changedOn != on);
+    QCOMPARE(changedOn->url, QString("http://10.0.0.4/relay/0?turn=on&timer=60"));
+    QCOMPARE(on->url, QString("http://10.0.0.4/relay/0?turn=on"));
+}
+
+void TestEntityHandler::testReloadAddedAndRemoved() {
+    QVariantList      config = generateSwitchConfig(10);
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(config, globalHeaders()), 10);
+    WebhookEntity* removed = handler.webhookEntity("switch.device_9");
+
+    QVariantList changedConfig = generateSwitchConfig(11);
+    changedConfig.removeAt(9);
+
+    EntityHandler::ReloadResult result = handler.reloadEntities(config, changedConfig, globalHeaders(), false);
+    QCOMPARE(result.unchanged, 9);
+    QCOMPARE(result.added.size(), 1);
+    QCOMPARE(result.added.first()->id, QString("switch.device_10"));
+    QCOMPARE(result.removed.size(), 1);
+    QCOMPARE(result.removed.first(), removed);
+    QVERIFY(!handler.hasEntity("switch.device_9"));
+    QCOMPARE(handler.webhookEntity("switch.device_10"), result.added.first());
+    QCOMPARE(handler.getEntities().size(), 10);
+
+    // the removed record stays valid until the handler is destroyed
+    QCOMPARE(removed->id, QString("switch.device_9"));
+}
+
+void TestEntityHandler::testReloadRecompile() {
+    QVariantList      config = generateSwitchConfig(10);
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(config, globalHeaders()), 10);
+    WebhookEntity*  entity = handler.webhookEntity("switch.device_3");
+    WebhookCommand* status = entity->statusCommand;
+
+    QVariantMap headers = globalHeaders();
+    headers.insert("Authorization", "Bearer token");
+    EntityHandler::ReloadResult result = handler.reloadEntities(config, config, headers, true);
+    QCOMPARE(result.updated.size(), 10);
+    QCOMPARE(result.unchanged, 0);
+
+    QCOMPARE(handler.webhookEntity("switch.device_3"), entity);
+    QVERIFY(entity->statusCommand != status);
+    QCOMPARE(entity->statusCommand->headers.value("Authorization").toString(), QString("Bearer token"));
+    QCOMPARE(handler.entityCommand(entity, 0)->headers.value("Authorization").toString(), QString("Bearer token"));
+}
+
+void TestEntityHandler::testReloadPlaceholders() {
+    QVariantMap placeholders;
+    placeholders.insert("TOKEN", "secret");
+    QVariantMap headers = globalHeaders();
+    headers.insert("Authorization", "Bearer ${TOKEN}");
+
+    QVariantList      config = generateSwitchConfig(10);
+    EntityHandlerImpl handler("switch", "");
+    handler.setPlaceholders(placeholders);
+    QCOMPARE(handler.readEntities(config, headers), 10);
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+
+    // static placeholders are bound when compiling the templates, not when rendering a request
+    QScopedPointer<WebhookRequest> request(handler.createRequest(entity, 0, PlaceholderValues()));
+    QCOMPARE(request->networkRequest.rawHeader("Authorization"), QByteArray("Bearer secret"));
+
+    // only the token changes: the header block is the same, but its templates must be bound again
+    placeholders.insert("TOKEN", "rotated");
+    handler.setPlaceholders(placeholders);
+    EntityHandler::ReloadResult result = handler.reloadEntities(config, config, headers, true);
+    QCOMPARE(result.updated.size(), 10);
+
+    request.reset(handler.createRequest(entity, 0, PlaceholderValues()));
+    QCOMPARE(request->networkRequest.rawHeader("Authorization"), QByteArray("Bearer rotated"));
+    request.reset(handler.createRequest(entity->statusCommand, PlaceholderValues()));
+    QCOMPARE(request->networkRequest.rawHeader("Authorization"), QByteArray("Bearer rotated"));
+}
+
+WebhookRequest* TestEntityHandler::sendCommand(EntityHandlerImpl* handler, WebhookEntity* entity, quint64 sequence) {
+    WebhookRequest* request = handler->createRequest(entity, 0, PlaceholderValues());
+    request->webhookEntity = entity;
+    request->command = 0;
+    request->sequence = sequence;
+    handler->commandSent(entity, request);
+    return request;
+}
+
+void TestEntityHandler::testCommandRollback() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(10), globalHeaders()), 10);
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+
+    // the intended state is applied when sending, the previous values are kept for a rollback
+    handler.nextUndo.state = 0;
+    handler.nextUndo.saveAttribute(2, 42);
+    QScopedPointer<WebhookRequest> request(sendCommand(&handler, entity, 1));
+    QCOMPARE(handler.appliedCommands.size(), 1);
+    QCOMPARE(handler.appliedCommands.first().first, 0);
+    QVERIFY(request->optimistic);
+    QCOMPARE(request->undo.state, 0);
+    QCOMPARE(entity->pendingCommands, 1);
+    QCOMPARE(entity->commandSequence, quint64(1));
+
+    FinishedReply failed(QNetworkReply::ConnectionRefusedError);
+    QVERIFY(handler.optimisticCommandFinished(entity, request.data(), &failed));
+    QCOMPARE(entity->pendingCommands, 0);
+    QCOMPARE(handler.restoredUndos.size(), 1);
+    QCOMPARE(handler.restoredUndos.first().state, 0);
+    QCOMPARE(handler.restoredUndos.first().attributes.size(), 1);
+    QCOMPARE(handler.restoredUndos.first().attributes.first().first, 2);
+    QCOMPARE(handler.restoredUndos.first().attributes.first().second, QVariant(42));
+
+    // a successful command keeps the intended state
+    request.reset(sendCommand(&handler, entity, 2));
+    FinishedReply succeeded(QNetworkReply::NoError);
+    QVERIFY(handler.optimisticCommandFinished(entity, request.data(), &succeeded));
+    QCOMPARE(entity->pendingCommands, 0);
+    QCOMPARE(handler.restoredUndos.size(), 1);
+}
+
+void TestEntityHandler::testSupersededCommandReply() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(10), globalHeaders()), 10);
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+
+    handler.nextUndo.state = 0;
+    QScopedPointer<WebhookRequest> first(sendCommand(&handler, entity, 1));
+    handler.nextUndo.state = 1;
+    QScopedPointer<WebhookRequest> second(sendCommand(&handler, entity, 2));
+    QCOMPARE(entity->pendingCommands, 2);
+    QCOMPARE(entity->commandSequence, quint64(2));
+
+    // the failed first command must not restore its previous state: the second command has been applied since
+    FinishedReply failed(QNetworkReply::ConnectionRefusedError);
+    QVERIFY(!handler.optimisticCommandFinished(entity, first.data(), &failed));
+    QCOMPARE(entity->pendingCommands, 1);
+    QVERIFY(handler.restoredUndos.isEmpty());
+
+    // the latest command reconciles the entity
+    QVERIFY(handler.optimisticCommandFinished(entity, second.data(), &failed));
+    QCOMPARE(entity->pendingCommands, 0);
+    QCOMPARE(handler.restoredUndos.size(), 1);
+    QCOMPARE(handler.restoredUndos.first().state, 1);
+}
+
+void TestEntityHandler::testStatusWhileCommandPending() {
+    EntityHandlerImpl handler("switch", "");
+    QCOMPARE(handler.readEntities(generateSwitchConfig(10), globalHeaders()), 10);
+    WebhookEntity* entity = handler.webhookEntity("switch.device_3");
+
+    // commands and status requests are numbered in sending order
+    QScopedPointer<WebhookRequest> before(handler.createStatusRequest(entity, QVariantMap()));
+    before->sequence = 1;
+    QVERIFY(EntityHandler::acceptsStatus(entity, before.data()));
+
+    QScopedPointer<WebhookRequest> command(sendCommand(&handler, entity, 2));
+    QScopedPointer<WebhookRequest> during(handler.createStatusRequest(entity, QVariantMap()));
+    during->sequence = 3;
+
+    // the device may still report the previous state while the command is in flight
+    QVERIFY(!EntityHandler::acceptsStatus(entity, before.data()));
+    QVERIFY(!EntityHandler::acceptsStatus(entity, during.data()));
+
+    FinishedReply succeeded(QNetworkReply::NoError);
+    QVERIFY(handler.optimisticCommandFinished(entity, command.data(), &succeeded));
+
+    // a status requested before the command is outdated
+    QVERIFY(!EntityHandler::acceptsStatus(entity, before.data()));
+    QVERIFY(EntityHandler::acceptsStatus(entity, during.data()));
+}
+
 QTEST_GUILESS_MAIN(TestEntityHandler)
 #include "tst_entityhandler.moc"
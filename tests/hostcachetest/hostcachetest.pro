@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_hostcache
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/hostcache.h
+
+SOURCES += \
+    tst_hostcache.cpp \
+    $$INCDIR/hostcache.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,75 @@
+#include <QSignalSpy>
+#include <QtTest>
+
+#include "hostcache.h"
+
+class TestHostCache : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testIpAddressIsIgnored();
+    void testResolveRegisteredHost();
+    void testLookupRegistersUnknownHost();
+    void testInvalidate();
+};
+
+void TestHostCache::testIpAddressIsIgnored() {
+    HostCache cache(300);
+
+    cache.addHost("127.0.0.1");
+    QVERIFY(cache.lookup("127.0.0.1").isNull());
+
+    QVariantMap stats = cache.stats();
+    QCOMPARE(stats.value("hosts").toInt(), 0);
+    QCOMPARE(stats.value("misses").toInt(), 0);
+    QCOMPARE(stats.value("lookups").toInt(), 0);
+}
+
+void TestHostCache::testResolveRegisteredHost() {
+    HostCache  cache(300);
+    QSignalSpy spy(&cache, &HostCache::hostResolved);
+
+    cache.addHost("localhost");
+    QVERIFY(spy.wait(5000));
+
+    QHostAddress address = cache.lookup("localhost");
+    QVERIFY(address.isLoopback());
+
+    QVariantMap stats = cache.stats();
+    QCOMPARE(stats.value("hits").toInt(), 1);
+    QCOMPARE(stats.value("misses").toInt(), 0);
+    QCOMPARE(stats.value("lookups").toInt(), 1);
+}
+
+void TestHostCache::testLookupRegistersUnknownHost() {
+    HostCache  cache(300);
+    QSignalSpy spy(&cache, &HostCache::hostResolved);
+
+    QVERIFY(cache.lookup("localhost").isNull());
+    QVERIFY(spy.wait(5000));
+    QVERIFY(!cache.lookup("localhost").isNull());
+
+    QVariantMap stats = cache.stats();
+    QCOMPARE(stats.value("hits").toInt(), 1);
+    QCOMPARE(stats.value("misses").toInt(), 1);
+    QCOMPARE(stats.value("hit_rate").toDouble(), 0.5);
+}
+
+void TestHostCache::testInvalidate() {
+    HostCache  cache(300);
+    QSignalSpy spy(&cache, &HostCache::hostResolved);
+
+    cache.addHost("localhost");
+    QVERIFY(spy.wait(5000));
+
+    cache.invalidate("localhost");
+    QVERIFY(cache.lookup("localhost").isNull());
+
+    // resolved again in the background
+    QVERIFY(spy.wait(5000));
+    QVERIFY(!cache.lookup("localhost").isNull());
+    QCOMPARE(cache.stats().value("lookups").toInt(), 2);
+}
+
+QTEST_GUILESS_MAIN(TestHostCache)
+#include "tst_hostcache.moc"
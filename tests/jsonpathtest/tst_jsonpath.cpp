@@ -15,6 +15,7 @@ class TestJsonPath : public QObject {
     void testChildObject();
     void testNestedObject();
     void testIndex();
+    void testJsonValue();
 
     void testMyStromBulbColorResponse();
     void testMyStromSwitchReportResponse();
@@ -68,6 +69,15 @@ void TestJsonPath::testIndex() {
     QCOMPARE("Ryzen 9 3950XT", jsonPath.value("store.electronics[1].title"));
 }
 
+void TestJsonPath::testJsonValue() {
+    JsonPath jsonPath(m_jsonDoc);
+
+    QCOMPARE(jsonPath.jsonValue("store.snack.price"), QJsonValue(12.95));
+    QVERIFY(jsonPath.jsonValue("store.electronics[1]").isObject());
+    QVERIFY(jsonPath.jsonValue("store.missing").isUndefined());
+    QVERIFY(jsonPath.jsonValue("store.electronics[99].title").isUndefined());
+}
+
 void TestJsonPath::testMyStromBulbColorResponse() {
     JsonPath jsonPath(load(":/testdata/myStrom-bulb-setcolor-response.json"));
 
@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_metrics
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/metrics.h
+
+SOURCES += \
+    tst_metrics.cpp \
+    $$INCDIR/metrics.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,149 @@
+#include <QtTest>
+
+#include "metrics.h"
+
+class TestMetrics : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testHistogramBuckets();
+    void testHistogramPercentile();
+    void testSeries();
+    void testEntitySeries();
+    void testVariant();
+    void testPrometheus();
+};
+
+void TestMetrics::testHistogramBuckets() {
+    LatencyHistogram histogram;
+    histogram.record(0);
+    histogram.record(100);
+    histogram.record(101);
+    histogram.record(20000000);
+
+    HistogramSnapshot snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.count, quint64(4));
+    QCOMPARE(snapshot.sum, quint64(20000201));
+    QCOMPARE(snapshot.buckets.at(0), quint64(2));
+    QCOMPARE(snapshot.buckets.at(1), quint64(1));
+    QCOMPARE(snapshot.buckets.at(LatencyHistogram::BUCKETS - 1), quint64(1));
+}
+
+void TestMetrics::testHistogramPercentile() {
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.snapshot().percentile(50), 0.0);
+
+    for (int i = 0; i < 90; i++) {
+        histogram.record(3000);
+    }
+    for (int i = 0; i < 10; i++) {
+        histogram.record(80000);
+    }
+
+    HistogramSnapshot snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.percentile(50), 5.0);
+    QCOMPARE(snapshot.percentile(90), 5.0);
+    QCOMPARE(snapshot.percentile(95), 100.0);
+    QCOMPARE(snapshot.percentile(99), 100.0);
+}
+
+void TestMetrics::testSeries() {
+    Metrics         metrics;
+    RequestMetrics* command = metrics.series("10.0.0.1", Metrics::COMMAND);
+    QCOMPARE(metrics.series("10.0.0.1", Metrics::COMMAND), command);
+    QVERIFY(metrics.series("10.0.0.1", Metrics::STATUS) != command);
+    QVERIFY(metrics.series("10.0.0.2", Metrics::COMMAND) != command);
+}
+
+void TestMetrics::testEntitySeries() {
+    Metrics         metrics;
+    RequestMetrics* status = metrics.entitySeries("switch.device_1", Metrics::STATUS);
+    QVERIFY(status);
+    QCOMPARE(metrics.entitySeries("switch.device_1", Metrics::STATUS), status);
+    QVERIFY(metrics.series("switch.device_1", Metrics::STATUS) != status);
+    status->sent.fetchAndAddRelaxed(2);
+    status->timedOut.fetchAndAddRelaxed(1);
+    metrics.series("10.0.0.1", Metrics::STATUS)->sent.fetchAndAddRelaxed(2);
+
+    // the entity series are a breakdown of the host series and not added to the totals
+    QVariantMap map = metrics.toVariant();
+    QVariantMap entity = map.value("entities").toMap().value("switch.device_1").toMap();
+    QCOMPARE(entity.value("status").toMap().value("error_rate").toDouble(), 0.5);
+    QCOMPARE(map.value("types").toMap().value("status").toMap().value("sent").toULongLong(), quint64(2));
+
+    QString text = QString::fromUtf8(metrics.toPrometheus());
+    QVERIFY(text.contains("webhook_requests_sent_total{host=\"10.0.0.1\",type=\"status\"} 2\n"));
+    QVERIFY(text.contains("webhook_entity_requests_timed_out_total{entity=\"switch.device_1\",type=\"status\"} 1\n"));
+    QVERIFY(text.contains("# TYPE webhook_entity_request_duration_seconds histogram\n"));
+
+    metrics.setEntitySeries(false);
+    QVERIFY(!metrics.entitySeries("switch.device_2", Metrics::COMMAND));
+    QVERIFY(!metrics.toVariant().contains("entities"));
+    QVERIFY(!metrics.toPrometheus().contains("webhook_entity_"));
+}
+
+void TestMetrics::testVariant() {
+    Metrics metrics;
+
+    RequestMetrics* command = metrics.series("10.0.0.1", Metrics::COMMAND);
+    command->sent.fetchAndAddRelaxed(4);
+    command->completed.fetchAndAddRelaxed(2);
+    command->failed.fetchAndAddRelaxed(1);
+    command->inFlight.fetchAndAddRelaxed(1);
+    command->total.record(2000);
+
+    RequestMetrics* status = metrics.series("10.0.0.2", Metrics::STATUS);
+    status->sent.fetchAndAddRelaxed(2);
+    status->timedOut.fetchAndAddRelaxed(2);
+
+    metrics.series("10.0.0.2", Metrics::COMMAND)->sent.fetchAndAddRelaxed(1);
+    metrics.parseTime().record(150);
+
+    QVariantMap map = metrics.toVariant();
+    QVariantMap host1 = map.value("hosts").toMap().value("10.0.0.1").toMap();
+    QVERIFY(host1.contains("command"));
+    QVERIFY(!host1.contains("status"));
+    QCOMPARE(host1.value("command").toMap().value("sent").toULongLong(), quint64(4));
+    QCOMPARE(host1.value("command").toMap().value("in_flight").toLongLong(), qint64(1));
+    QCOMPARE(host1.value("command").toMap().value("error_rate").toDouble(), 0.25);
+    QCOMPARE(host1.value("command").toMap().value("total").toMap().value("count").toULongLong(), quint64(1));
+
+    QVariantMap host2 = map.value("hosts").toMap().value("10.0.0.2").toMap();
+    QCOMPARE(host2.value("all").toMap().value("sent").toULongLong(), quint64(3));
+    QCOMPARE(host2.value("status").toMap().value("error_rate").toDouble(), 1.0);
+
+    QVariantMap types = map.value("types").toMap();
+    QCOMPARE(types.value("command").toMap().value("sent").toULongLong(), quint64(5));
+    QCOMPARE(types.value("status").toMap().value("timed_out").toULongLong(), quint64(2));
+
+    QCOMPARE(map.value("parse_time").toMap().value("count").toULongLong(), quint64(1));
+}
+
+void TestMetrics::testPrometheus() {
+    Metrics metrics;
+    metrics.series("unused", Metrics::STATUS);
+
+    RequestMetrics* command = metrics.series("shelly\"1", Metrics::COMMAND);
+    command->sent.fetchAndAddRelaxed(3);
+    command->bytesOut.fetchAndAddRelaxed(42);
+    command->total.record(100);
+    command->total.record(3000);
+
+    QString text = QString::fromUtf8(metrics.toPrometheus());
+    QString labels = "host=\"shelly\\\"1\",type=\"command\"";
+    QVERIFY(text.contains("# TYPE webhook_requests_sent_total counter\n"));
+    QVERIFY(text.contains("webhook_requests_sent_total{" + labels + "} 3\n"));
+    QVERIFY(text.contains("webhook_request_bytes_total{" + labels + "} 42\n"));
+    QVERIFY(!text.contains("unused"));
+
+    // cumulative buckets in seconds
+    QVERIFY(text.contains("webhook_request_duration_seconds_bucket{" + labels + ",le=\"0.0001\"} 1\n"));
+    QVERIFY(text.contains("webhook_request_duration_seconds_bucket{" + labels + ",le=\"0.005\"} 2\n"));
+    QVERIFY(text.contains("webhook_request_duration_seconds_bucket{" + labels + ",le=\"+Inf\"} 2\n"));
+    QVERIFY(text.contains("webhook_request_duration_seconds_count{" + labels + "} 2\n"));
+    QVERIFY(text.contains("webhook_response_parse_seconds_bucket{le=\"+Inf\"} 0\n"));
+    QVERIFY(text.contains("webhook_response_parse_seconds_count 0\n"));
+}
+
+QTEST_GUILESS_MAIN(TestMetrics)
+#include "tst_metrics.moc"
@@ -0,0 +1,21 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network mqtt testlib
+QT     -= gui
+
+TARGET = tst_mqtt
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/mqtttransport.h \
+    $$INCDIR/transportreply.h
+
+SOURCES += \
+    tst_mqtt.cpp \
+    $$INCDIR/mqtttransport.cpp \
+    $$INCDIR/transportreply.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,139 @@
+#include <QSignalSpy>
+#include <QUuid>
+#include <QtTest>
+
+#include "mqtttransport.h"
+
+/**
+ * The broker tests require a local MQTT broker, e.g. mosquitto, and are skipped if no broker is available.
+ * Environment variable MQTT_TEST_HOST overrides the default broker host 'localhost'.
+ */
+class TestMqtt : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testTopicFromUrl();
+    void testTransportReply();
+    void testPublishWithoutConnection();
+    void testPublishAndSubscribe();
+    void testPublishQos1();
+    void testRetainedState();
+
+ private:
+    QVariantMap brokerConfig() const;
+    bool        connectOrSkip(MqttTransport* transport);
+    QString     uniqueTopic(const QString& name) const;
+};
+
+QVariantMap TestMqtt::brokerConfig() const {
+    QVariantMap config;
+    config.insert("host", qEnvironmentVariable("MQTT_TEST_HOST", "localhost"));
+    config.insert("port", 1883);
+    return config;
+}
+
+bool TestMqtt::connectOrSkip(MqttTransport* transport) {
+    transport->connectToBroker();
+    return QTest::qWaitFor([transport] { return transport->isConnected(); }, 3000);
+}
+
+QString TestMqtt::uniqueTopic(const QString& name) const {
+    return "yio/webhook/test/" + QUuid::createUuid().toString(QUuid::WithoutBraces) + "/" + name;
+}
+
+void TestMqtt::testTopicFromUrl() {
+    QCOMPARE(MqttTransport::topicFromUrl(QUrl("mqtt:cmnd/tasmota_1/POWER")), QString("cmnd/tasmota_1/POWER"));
+    QCOMPARE(MqttTransport::topicFromUrl(QUrl("mqtt:zigbee2mqtt/+/state")), QString("zigbee2mqtt/+/state"));
+    QCOMPARE(MqttTransport::topicFromUrl(QUrl("mqtt:zigbee2mqtt/#")), QString("zigbee2mqtt/#"));
+    QCOMPARE(MqttTransport::topicFromUrl(QUrl("mqtt:living%20room/light")), QString("living room/light"));
+}
+
+void TestMqtt::testTransportReply() {
+    TransportReply reply(QNetworkRequest(QUrl("mqtt:test")));
+    QSignalSpy     spy(&reply, &QNetworkReply::finished);
+
+    reply.setResponseData("{\"POWER\":\"ON\"}");
+    reply.finish();
+    QVERIFY(reply.isFinished());
+    QVERIFY(spy.wait(1000));
+
+    QCOMPARE(reply.error(), QNetworkReply::NoError);
+    QCOMPARE(reply.header(QNetworkRequest::ContentTypeHeader).toString(), QString("application/json"));
+    QCOMPARE(reply.readAll(), QByteArray("{\"POWER\":\"ON\"}"));
+}
+
+void TestMqtt::testPublishWithoutConnection() {
+    MqttTransport transport(brokerConfig());
+
+    QScopedPointer<QNetworkReply> reply(transport.publish(QNetworkRequest(QUrl("mqtt:test")), "ON", 0, false));
+    QSignalSpy                    spy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(spy.wait(1000));
+    QVERIFY(reply->error() != QNetworkReply::NoError);
+}
+
+void TestMqtt::testPublishAndSubscribe() {
+    MqttTransport transport(brokerConfig());
+    if (!connectOrSkip(&transport)) {
+        QSKIP("No MQTT broker available");
+    }
+
+    QString    topic = uniqueTopic("POWER");
+    QSignalSpy messageSpy(&transport, &MqttTransport::messageReceived);
+    transport.subscribe(topic);
+    // the broker doesn't confirm QoS 0 subscriptions with a signal: give it some time
+    QTest::qWait(200);
+
+    QScopedPointer<QNetworkReply> reply(
+        transport.publish(QNetworkRequest(QUrl("mqtt:" + topic)), "{\"POWER\":\"ON\"}", 0, false));
+    QSignalSpy finishedSpy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(finishedSpy.wait(1000));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 1, 3000);
+    QCOMPARE(messageSpy.at(0).at(0).toString(), topic);
+    QCOMPARE(messageSpy.at(0).at(1).toByteArray(), QByteArray("{\"POWER\":\"ON\"}"));
+}
+
+void TestMqtt::testPublishQos1() {
+    MqttTransport transport(brokerConfig());
+    if (!connectOrSkip(&transport)) {
+        QSKIP("No MQTT broker available");
+    }
+
+    QScopedPointer<QNetworkReply> reply(
+        transport.publish(QNetworkRequest(QUrl("mqtt:" + uniqueTopic("qos1"))), "ON", 1, false));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+    // finished after the broker acknowledged the message
+    QVERIFY(!reply->isFinished());
+    QVERIFY(spy.wait(3000));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+}
+
+void TestMqtt::testRetainedState() {
+    QString topic = uniqueTopic("STATE");
+
+    MqttTransport publisher(brokerConfig());
+    if (!connectOrSkip(&publisher)) {
+        QSKIP("No MQTT broker available");
+    }
+    QScopedPointer<QNetworkReply> reply(
+        publisher.publish(QNetworkRequest(QUrl("mqtt:" + topic)), "{\"POWER\":\"OFF\"}", 1, true));
+    QSignalSpy finishedSpy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(finishedSpy.wait(3000));
+
+    // a new subscriber immediately gets the last known state
+    MqttTransport subscriber(brokerConfig());
+    QSignalSpy    messageSpy(&subscriber, &MqttTransport::messageReceived);
+    subscriber.subscribe(topic);
+    QVERIFY(connectOrSkip(&subscriber));
+    QTRY_COMPARE_WITH_TIMEOUT(messageSpy.count(), 1, 3000);
+    QCOMPARE(messageSpy.at(0).at(1).toByteArray(), QByteArray("{\"POWER\":\"OFF\"}"));
+
+    // clear the retained message
+    QScopedPointer<QNetworkReply> clear(publisher.publish(QNetworkRequest(QUrl("mqtt:" + topic)), "", 1, true));
+    QSignalSpy                    clearSpy(clear.data(), &QNetworkReply::finished);
+    QVERIFY(clearSpy.wait(3000));
+}
+
+QTEST_GUILESS_MAIN(TestMqtt)
+#include "tst_mqtt.moc"
@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_placeholders
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/placeholders.h
+
+SOURCES += \
+    tst_placeholders.cpp \
+    $$INCDIR/placeholders.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,128 @@
+#include <QtTest>
+
+#include "placeholders.h"
+
+class TestPlaceholders : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testPlaceholderIds();
+    void testStaticPlaceholders();
+    void testDynamicPlaceholders();
+    void testDynamicOverridesStatic();
+    void testNumberFormat();
+    void testUndefinedPlaceholder();
+    void testPlaceholderMask();
+    void testUnusedPlaceholderValues();
+    void testBindStaticPlaceholders();
+};
+
+void TestPlaceholders::testPlaceholderIds() {
+    for (int i = 0; i < Placeholder::COUNT; i++) {
+        QString name = Placeholder::name(static_cast<Placeholder::Enum>(i));
+        QVERIFY(!name.isEmpty());
+        QCOMPARE(Placeholder::fromName(name), i);
+    }
+    QCOMPARE(Placeholder::fromName("color_r"), static_cast<int>(Placeholder::COLOR_R));
+    QCOMPARE(Placeholder::fromName("HOST"), -1);
+}
+
+void TestPlaceholders::testStaticPlaceholders() {
+    QVariantMap placeholders;
+    placeholders.insert("HOST", "localhost");
+    placeholders.insert("ROOT", "api");
+
+    TextTemplate      text("http://${HOST}/${ROOT}/test");
+    PlaceholderValues values(&placeholders);
+
+    QVERIFY(text.hasPlaceholders());
+    QCOMPARE(text.render(values), QString("http://localhost/api/test"));
+}
+
+void TestPlaceholders::testDynamicPlaceholders() {
+    QVariantMap       placeholders;
+    PlaceholderValues values(&placeholders);
+    values.set(Placeholder::STATE_BOOL, true);
+    values.set(Placeholder::BRIGHTNESS_PERCENT, 42);
+
+    TextTemplate text("{\"on\":${state_bool},\"bri\":${brightness_percent}}");
+    QCOMPARE(text.render(values), QString("{\"on\":true,\"bri\":42}"));
+}
+
+void TestPlaceholders::testDynamicOverridesStatic() {
+    QVariantMap placeholders;
+    placeholders.insert("state_bin", 5);
+    TextTemplate text("state=${state_bin}");
+
+    PlaceholderValues staticOnly(&placeholders);
+    QCOMPARE(text.render(staticOnly), QString("state=5"));
+
+    PlaceholderValues values(&placeholders);
+    values.set(Placeholder::STATE_BIN, 1);
+    QCOMPARE(text.render(values), QString("state=1"));
+    QCOMPARE(placeholders.value("state_bin").toInt(), 5);  // static placeholders may not be changed
+}
+
+void TestPlaceholders::testNumberFormat() {
+    PlaceholderValues values;
+    values.set(Placeholder::COLOR_R, 8);
+    values.set(Placeholder::COLOR_G, 15);
+    values.set(Placeholder::COLOR_B, 240);
+
+    QCOMPARE(TextTemplate("#${color_r:%02X}${color_g:%02X}${color_b:%02X}").render(values), QString("#080FF0"));
+    QCOMPARE(TextTemplate("${color_r:%03d},${color_g:%d}").render(values), QString("008,15"));
+}
+
+void TestPlaceholders::testUndefinedPlaceholder() {
+    PlaceholderValues values;
+    values.set(Placeholder::STATE, 1);
+
+    QCOMPARE(TextTemplate("${UNKNOWN}/${state}").render(values), QString("${UNKNOWN}/1"));
+    QCOMPARE(TextTemplate("${color_r}").render(values), QString("${color_r}"));
+
+    TextTemplate plain("no placeholders");
+    QVERIFY(!plain.hasPlaceholders());
+    QCOMPARE(plain.render(values), QString("no placeholders"));
+}
+
+void TestPlaceholders::testPlaceholderMask() {
+    QCOMPARE(TextTemplate().placeholderMask(), 0u);
+    QCOMPARE(TextTemplate("http://${HOST}/api").placeholderMask(), 0u);
+
+    TextTemplate text("${HOST}/light?on=${state_bin}&rgb=${color_r:%02X}${color_g:%02X}${color_b:%02X}");
+    quint32      expected = Placeholder::bit(Placeholder::STATE_BIN) | Placeholder::bit(Placeholder::COLOR_R) |
+                       Placeholder::bit(Placeholder::COLOR_G) | Placeholder::bit(Placeholder::COLOR_B);
+    QCOMPARE(text.placeholderMask(), expected);
+}
+
+void TestPlaceholders::testUnusedPlaceholderValues() {
+    PlaceholderValues values(nullptr, Placeholder::bit(Placeholder::STATE_BIN));
+    values.set(Placeholder::STATE_BIN, 1);
+    values.set(Placeholder::COLOR_H, 120);
+
+    QVERIFY(values.isUsed(Placeholder::STATE_BIN));
+    QVERIFY(!values.isUsed(Placeholder::COLOR_H));
+    QCOMPARE(TextTemplate("${state_bin}/${color_h}").render(values), QString("1/${color_h}"));
+}
+
+void TestPlaceholders::testBindStaticPlaceholders() {
+    QVariantMap placeholders;
+    placeholders.insert("HOST", "10.0.0.1");
+    placeholders.insert("state", "static");
+
+    TextTemplate bound = TextTemplate("http://${HOST}/set?on=${state_bin}&v=${state}&x=${UNKNOWN}").bind(placeholders);
+    QCOMPARE(bound.text(), QString("http://10.0.0.1/set?on=${state_bin}&v=${state}&x=${UNKNOWN}"));
+    QCOMPARE(bound.placeholderMask(), Placeholder::bit(Placeholder::STATE_BIN) | Placeholder::bit(Placeholder::STATE));
+
+    PlaceholderValues values;
+    values.set(Placeholder::STATE_BIN, 1);
+    values.set(Placeholder::STATE, 2);
+    QCOMPARE(bound.render(values), QString("http://10.0.0.1/set?on=1&v=2&x=${UNKNOWN}"));
+
+    TextTemplate plain = TextTemplate("http://${HOST}/").bind(placeholders);
+    QVERIFY(!plain.hasPlaceholders());
+    QCOMPARE(plain.render(values), QString("http://10.0.0.1/"));
+}
+
+QTEST_GUILESS_MAIN(TestPlaceholders)
+#include "tst_placeholders.moc"
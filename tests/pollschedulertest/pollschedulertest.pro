@@ -0,0 +1,29 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_pollscheduler
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/httpmethod.h \
+    $$INCDIR/placeholders.h \
+    $$INCDIR/pollscheduler.h \
+    $$INCDIR/socketframing.h \
+    $$INCDIR/timingwheel.h \
+    $$INCDIR/valuetransform.h \
+    $$INCDIR/webhookcommand.h \
+    $$INCDIR/webhookentity.h
+
+SOURCES += \
+    tst_pollscheduler.cpp \
+    $$INCDIR/placeholders.cpp \
+    $$INCDIR/pollscheduler.cpp \
+    $$INCDIR/timingwheel.cpp \
+    $$INCDIR/valuetransform.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,199 @@
+#include <QtTest>
+
+#include <algorithm>
+
+#include "pollscheduler.h"
+
+static const int     ENTITIES = 4;
+static const qint64  START = 1000000;
+static const quint64 INTERVAL = 10;
+
+class TestPollScheduler : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testPollAllUntilVisibilityReported();
+    void testVisibleFirst();
+    void testHiddenInterval();
+    void testNewlyVisible();
+    void testWakeRefresh();
+    void testRemovedEntity();
+
+ private:
+    /**
+     * @brief Adds the entities with a status polling command of INTERVAL seconds to the scheduler.
+     */
+    static void addEntities(PollScheduler* scheduler, WebhookEntity* entities, WebhookCommand* status);
+
+    /**
+     * @brief Returns the sorted entity indexes: the order of entities due in the same tick is undefined.
+     */
+    static QVector<int> indexes(const QVector<WebhookEntity*>& entities);
+};
+
+void TestPollScheduler::addEntities(PollScheduler* scheduler, WebhookEntity* entities, WebhookCommand* status) {
+    status->interval = static_cast<int>(INTERVAL);
+    scheduler->setInterval(30);
+    scheduler->setPriority(300, 300);
+    for (int i = 0; i < ENTITIES; i++) {
+        entities[i].index = i;
+        entities[i].statusCommand = status;
+        scheduler->addEntity(&entities[i]);
+    }
+    scheduler->scheduleAll();
+}
+
+QVector<int> TestPollScheduler::indexes(const QVector<WebhookEntity*>& entities) {
+    QVector<int> result;
+    for (const WebhookEntity* entity : entities) {
+        result.append(entity->index);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void TestPollScheduler::testPollAllUntilVisibilityReported() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    QVector<WebhookEntity*> poll;
+    scheduler.advance(START, &poll);
+    QCOMPARE(indexes(poll), QVector<int>({0, 1, 2, 3}));
+
+    // polled entities are marked as updated and scheduled at their polling interval
+    for (int i = 0; i < ENTITIES; i++) {
+        QVERIFY(scheduler.isPriorityEntity(&entities[i], START));
+        QCOMPARE(entities[i].lastUpdate, START);
+        QCOMPARE(scheduler.dueIn(i), INTERVAL);
+    }
+}
+
+void TestPollScheduler::testVisibleFirst() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    // entity 3 has been used recently, entity 1 a long time ago
+    entities[3].lastUsed = START - 10000;
+    entities[1].lastUsed = START - 301000;
+
+    QVector<WebhookEntity*> poll;
+    scheduler.setVisibleEntities({2}, START, false, &poll);
+    QVERIFY(poll.isEmpty());
+    QVERIFY(entities[2].visible);
+    QVERIFY(!scheduler.isPriorityEntity(&entities[0], START));
+    QVERIFY(!scheduler.isPriorityEntity(&entities[1], START));
+    QVERIFY(scheduler.isPriorityEntity(&entities[2], START));
+    QVERIFY(scheduler.isPriorityEntity(&entities[3], START));
+
+    // visible and recently used entities are queued before the hidden ones
+    scheduler.advance(START, &poll);
+    QCOMPARE(poll.size(), ENTITIES);
+    QCOMPARE(indexes(poll.mid(0, 2)), QVector<int>({2, 3}));
+    QCOMPARE(indexes(poll.mid(2)), QVector<int>({0, 1}));
+    QCOMPARE(scheduler.dueIn(2), INTERVAL);
+    QCOMPARE(scheduler.dueIn(3), INTERVAL);
+    QCOMPARE(scheduler.dueIn(0), quint64(300));
+    QCOMPARE(scheduler.dueIn(1), quint64(300));
+}
+
+void TestPollScheduler::testHiddenInterval() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    QVector<WebhookEntity*> poll;
+    scheduler.setVisibleEntities({0}, START, false, &poll);
+
+    // one tick per second for 10 minutes
+    QVector<int> polls(ENTITIES);
+    for (int tick = 0; tick <= 600; tick++) {
+        poll.clear();
+        scheduler.advance(START + tick * 1000LL, &poll);
+        for (int index : indexes(poll)) {
+            polls[index]++;
+        }
+    }
+
+    // the visible entity is polled every 10 s, the hidden ones every 300 s
+    QCOMPARE(polls.at(0), 61);
+    QCOMPARE(polls.at(1), 3);
+    QCOMPARE(polls.at(2), 3);
+    QCOMPARE(polls.at(3), 3);
+}
+
+void TestPollScheduler::testNewlyVisible() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    QVector<WebhookEntity*> poll;
+    scheduler.setVisibleEntities({}, START, true, &poll);
+    scheduler.advance(START, &poll);
+    QCOMPARE(poll.size(), ENTITIES);
+    QCOMPARE(scheduler.dueIn(0), quint64(300));
+
+    // a hidden entity becoming visible is polled at its interval instead of the hidden interval
+    poll.clear();
+    scheduler.setVisibleEntities({0}, START + 4000, true, &poll);
+    QVERIFY(poll.isEmpty());
+    QCOMPARE(scheduler.dueIn(0), INTERVAL - 4);
+
+    // or right away if the interval has already elapsed
+    scheduler.setVisibleEntities({1}, START + 12000, true, &poll);
+    QCOMPARE(indexes(poll), QVector<int>({1}));
+    QCOMPARE(entities[1].lastUpdate, START + 12000);
+    QCOMPARE(scheduler.dueIn(1), INTERVAL);
+    QVERIFY(!entities[0].visible);
+}
+
+void TestPollScheduler::testWakeRefresh() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    QVector<WebhookEntity*> poll;
+    scheduler.setVisibleEntities({1, 2}, START, false, &poll);
+    scheduler.advance(START, &poll);
+
+    // entity 2 has pushed state updates and a throttled polling
+    entities[2].pollInterval = 60;
+    entities[2].lastUpdate = START + 100000;
+
+    // the visible entities are polled right after waking up, not with their next scheduled poll
+    poll.clear();
+    scheduler.refreshPriorityEntities(START + 120000, &poll);
+    QCOMPARE(indexes(poll), QVector<int>({1}));
+    QCOMPARE(entities[1].lastUpdate, START + 120000);
+    QCOMPARE(entities[0].lastUpdate, START);
+}
+
+void TestPollScheduler::testRemovedEntity() {
+    PollScheduler  scheduler;
+    WebhookEntity  entities[ENTITIES];
+    WebhookCommand status;
+    addEntities(&scheduler, entities, &status);
+
+    scheduler.removeEntity(1);
+    QVERIFY(!scheduler.isScheduled(1));
+
+    QVector<WebhookEntity*> poll;
+    scheduler.advance(START, &poll);
+    QCOMPARE(indexes(poll), QVector<int>({0, 2, 3}));
+
+    // not scheduled again when adding entities
+    scheduler.scheduleAll();
+    QVERIFY(!scheduler.isScheduled(1));
+    scheduler.refreshPriorityEntities(START + 10000, &poll);
+    QVERIFY(!indexes(poll).contains(1));
+}
+
+QTEST_GUILESS_MAIN(TestPollScheduler)
+
+#include "tst_pollscheduler.moc"
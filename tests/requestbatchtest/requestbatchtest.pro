@@ -0,0 +1,21 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_requestbatch
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/requestbatch.h \
+    $$INCDIR/transportreply.h
+
+SOURCES += \
+    tst_requestbatch.cpp \
+    $$INCDIR/requestbatch.cpp \
+    $$INCDIR/transportreply.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
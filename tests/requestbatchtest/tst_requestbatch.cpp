@@ -0,0 +1,144 @@
+#include <QHash>
+#include <QSignalSpy>
+#include <QTimer>
+#include <QtTest>
+
+#include "requestbatch.h"
+#include "transportreply.h"
+
+class TestRequestBatch : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testEmptyBatch();
+    void testAllHostsInParallel();
+    void testFanOutLimitPerHost();
+    void testFailedRequests();
+    void testReplyHandler();
+
+ private:
+    /**
+     * @brief Returns a start function for a simulated request which finishes after the given delay.
+     */
+    RequestBatch::StartFunction delayedRequest(const QString& host, int delay, bool success = true);
+
+    QHash<QString, int> m_inFlight;
+    QHash<QString, int> m_maxInFlight;
+};
+
+RequestBatch::StartFunction TestRequestBatch::delayedRequest(const QString& host, int delay, bool success) {
+    return [this, host, delay, success]() -> QNetworkReply* {
+        TransportReply* reply = new TransportReply(QNetworkRequest(QUrl("http://" + host)));
+        m_inFlight[host]++;
+        m_maxInFlight[host] = qMax(m_maxInFlight.value(host), m_inFlight.value(host));
+
+        QTimer::singleShot(delay, reply, [this, host, reply, success] {
+            m_inFlight[host]--;
+            if (success) {
+                reply->finish();
+            } else {
+                reply->finishWithError(QNetworkReply::ConnectionRefusedError, "Connection refused");
+            }
+        });
+        return reply;
+    };
+}
+
+void TestRequestBatch::testEmptyBatch() {
+    RequestBatch batch(2);
+    QSignalSpy   spy(&batch, &RequestBatch::finished);
+
+    batch.start();
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(batch.size(), 0);
+    QVERIFY(!batch.isRunning());
+}
+
+void TestRequestBatch::testAllHostsInParallel() {
+    m_inFlight.clear();
+    m_maxInFlight.clear();
+
+    RequestBatch batch(1);
+    QSignalSpy   spy(&batch, &RequestBatch::finished);
+
+    for (int i = 0; i < 30; i++) {
+        QString host = QString("device%1").arg(i);
+        batch.add(host, host, delayedRequest(host, 100));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    batch.start();
+    QVERIFY(spy.wait(5000));
+
+    // one round-trip instead of 30 sequential requests
+    QVERIFY2(timer.elapsed() < 1000, qPrintable(QString::number(timer.elapsed())));
+    QCOMPARE(batch.successCount(), 30);
+}
+
+void TestRequestBatch::testFanOutLimitPerHost() {
+    m_inFlight.clear();
+    m_maxInFlight.clear();
+
+    RequestBatch batch(2);
+    QSignalSpy   spy(&batch, &RequestBatch::finished);
+
+    for (int i = 0; i < 6; i++) {
+        batch.add(QString("hub %1").arg(i), "hub", delayedRequest("hub", 20));
+    }
+    batch.add("lamp", "lamp", delayedRequest("lamp", 20));
+
+    batch.start();
+    QVERIFY(spy.wait(5000));
+
+    QCOMPARE(m_maxInFlight.value("hub"), 2);
+    QCOMPARE(m_maxInFlight.value("lamp"), 1);
+    QCOMPARE(batch.successCount(), 7);
+}
+
+void TestRequestBatch::testFailedRequests() {
+    RequestBatch batch(2);
+    QSignalSpy   spy(&batch, &RequestBatch::finished);
+
+    batch.add("ok", "a", delayedRequest("a", 10));
+    batch.add("refused", "b", delayedRequest("b", 10, false));
+    batch.add("not sent", "c", []() -> QNetworkReply* { return nullptr; });
+    batch.addFailed("unknown", "Unknown entity");
+
+    batch.start();
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(spy.count(), 1);
+
+    QVector<RequestBatch::Result> results = batch.results();
+    QCOMPARE(results.size(), 4);
+    QCOMPARE(results.at(0).id, QString("ok"));
+    QVERIFY(results.at(0).success);
+    QCOMPARE(results.at(1).id, QString("refused"));
+    QVERIFY(!results.at(1).success);
+    QCOMPARE(results.at(1).error, QString("Connection refused"));
+    QVERIFY(!results.at(2).success);
+    QCOMPARE(results.at(3).error, QString("Unknown entity"));
+    QCOMPARE(batch.successCount(), 1);
+
+    QVariantList list = batch.resultList();
+    QCOMPARE(list.size(), 4);
+    QCOMPARE(list.at(1).toMap().value("success").toBool(), false);
+}
+
+void TestRequestBatch::testReplyHandler() {
+    RequestBatch batch(2);
+    QSignalSpy   spy(&batch, &RequestBatch::finished);
+    int          handled = 0;
+
+    batch.add("x", "a", delayedRequest("a", 10), [&handled](QNetworkReply* reply) {
+        QVERIFY(reply->isFinished());
+        handled++;
+    });
+
+    batch.start();
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(handled, 1);
+}
+
+QTEST_GUILESS_MAIN(TestRequestBatch)
+#include "tst_requestbatch.moc"
@@ -0,0 +1,44 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_requestdispatcher
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/compression.h \
+    $$INCDIR/hostcache.h \
+    $$INCDIR/httpmethod.h \
+    $$INCDIR/metrics.h \
+    $$INCDIR/placeholders.h \
+    $$INCDIR/requestdispatcher.h \
+    $$INCDIR/socketframing.h \
+    $$INCDIR/sockettransport.h \
+    $$INCDIR/transportreply.h \
+    $$INCDIR/valuetransform.h \
+    $$INCDIR/webhookcommand.h \
+    $$INCDIR/webhookentity.h \
+    $$INCDIR/webhookrequest.h
+
+SOURCES += \
+    tst_requestdispatcher.cpp \
+    $$INCDIR/compression.cpp \
+    $$INCDIR/hostcache.cpp \
+    $$INCDIR/metrics.cpp \
+    $$INCDIR/placeholders.cpp \
+    $$INCDIR/requestdispatcher.cpp \
+    $$INCDIR/sockettransport.cpp \
+    $$INCDIR/transportreply.cpp \
+    $$INCDIR/valuetransform.cpp
+
+win32 {
+    INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+} else {
+    LIBS += -lz
+}
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,325 @@
+#include <QNetworkAccessManager>
+#include <QScopedPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtTest>
+
+#include "metrics.h"
+#include "requestdispatcher.h"
+#include "webhookentity.h"
+
+class TestRequestDispatcher : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void testPollsPerHost();
+    void testDeferredByCommand();
+    void testDropDuplicatePoll();
+    void testDropWhenQueueFull();
+    void testDropQueuedPolls();
+    void testHungCommandTimeout();
+    void testTimedOutMetrics();
+
+ private:
+    static const int ENTITIES = 4;
+
+    void onNewConnection();
+
+    /**
+     * @brief Answers the held request with the given path.
+     */
+    void respond(const QByteArray& path);
+
+    WebhookRequest* createRequest(const QByteArray& path, WebhookEntity* entity = nullptr);
+    QNetworkReply*  sendCommand(const QByteArray& path);
+    void            sendPoll(const QByteArray& path, WebhookEntity* entity);
+    void            finishOnReply(WebhookRequest* request, QNetworkReply* reply);
+    int             laneStat(const char* lane, const char* stat) const;
+
+    QTcpServer                            m_server;
+    QList<QPair<QByteArray, QTcpSocket*>> m_held;
+    QList<QByteArray>                     m_received;
+    QNetworkAccessManager*                m_networkManager;
+    QScopedPointer<RequestDispatcher>     m_dispatcher;
+    WebhookCommand                        m_command;
+    WebhookEntity                         m_entities[ENTITIES];
+    QList<WebhookRequest*>                m_requests;
+    QList<QByteArray>                     m_sentPolls;
+    QList<QByteArray>                     m_droppedPolls;
+    QList<QByteArray>                     m_finished;
+};
+
+void TestRequestDispatcher::init() {
+    QVERIFY(m_server.listen(QHostAddress::LocalHost));
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, &TestRequestDispatcher::onNewConnection,
+                     Qt::UniqueConnection);
+    m_networkManager = new QNetworkAccessManager(this);
+    m_dispatcher.reset(new RequestDispatcher(m_networkManager));
+}
+
+void TestRequestDispatcher::cleanup() {
+    // the replies are deleted with the network access manager, before the dispatcher handling their finished signal
+    m_dispatcher->dropQueuedPolls();
+    delete m_networkManager;
+    m_dispatcher.reset();
+    m_server.close();
+    for (const auto& held : qAsConst(m_held)) {
+        held.second->abort();
+    }
+    m_held.clear();
+    m_received.clear();
+    qDeleteAll(m_requests);
+    m_requests.clear();
+    m_sentPolls.clear();
+    m_droppedPolls.clear();
+    m_finished.clear();
+}
+
+void TestRequestDispatcher::onNewConnection() {
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        socket->setParent(this);
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+            QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+            int        headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                socket->setProperty("buffer", buffer);
+                return;
+            }
+            socket->setProperty("buffer", QByteArray());
+
+            // hold the request until the test responds: "GET /path HTTP/1.1"
+            QByteArray path = buffer.left(buffer.indexOf("\r\n")).split(' ').value(1);
+            m_received.append(path);
+            m_held.append(qMakePair(path, socket));
+        });
+    }
+}
+
+void TestRequestDispatcher::respond(const QByteArray& path) {
+    for (int i = 0; i < m_held.size(); i++) {
+        if (m_held.at(i).first == path) {
+            QTcpSocket* socket = m_held.takeAt(i).second;
+            socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\n"
+                          "Connection: close\r\n\r\n{}");
+            socket->disconnectFromHost();
+            return;
+        }
+    }
+    QFAIL(qPrintable("No held request: " + path));
+}
+
+WebhookRequest* TestRequestDispatcher::createRequest(const QByteArray& path, WebhookEntity* entity) {
+    auto request = new WebhookRequest();
+    request->webhookCommand = &m_command;
+    request->webhookEntity = entity;
+    request->networkRequest.setUrl(
+        QUrl(QString("http://127.0.0.1:%1%2").arg(m_server.serverPort()).arg(QString::fromLatin1(path))));
+    m_requests.append(request);
+    return request;
+}
+
+QNetworkReply* TestRequestDispatcher::sendCommand(const QByteArray& path) {
+    WebhookRequest* request = createRequest(path);
+    QNetworkReply*  reply = m_dispatcher->send(request);
+    finishOnReply(request, reply);
+    return reply;
+}
+
+void TestRequestDispatcher::sendPoll(const QByteArray& path, WebhookEntity* entity) {
+    WebhookRequest* request = createRequest(path, entity);
+    m_dispatcher->sendPoll(request, [this, request, path](QNetworkReply* reply) {
+        if (reply) {
+            m_sentPolls.append(path);
+            finishOnReply(request, reply);
+        } else {
+            m_droppedPolls.append(path);
+        }
+    });
+}
+
+void TestRequestDispatcher::finishOnReply(WebhookRequest* request, QNetworkReply* reply) {
+    QObject::connect(reply, &QNetworkReply::finished, this, [this, request, reply] {
+        reply->deleteLater();
+        m_finished.append(request->networkRequest.url().path().toLatin1());
+        m_dispatcher->finish(request, reply);
+    });
+}
+
+int TestRequestDispatcher::laneStat(const char* lane, const char* stat) const {
+    return m_dispatcher->laneStats().value(lane).toMap().value(stat).toInt();
+}
+
+void TestRequestDispatcher::testPollsPerHost() {
+    m_dispatcher->setMaxPollsPerHost(2);
+
+    sendPoll("/status/0", &m_entities[0]);
+    sendPoll("/status/1", &m_entities[1]);
+    sendPoll("/status/2", &m_entities[2]);
+
+    // the third poll waits for a free poll slot of the host
+    QCOMPARE(m_sentPolls, QList<QByteArray>({"/status/0", "/status/1"}));
+    QCOMPARE(laneStat("poll", "queued"), 1);
+    QTRY_COMPARE(m_received.size(), 2);
+    QTest::qWait(100);
+    QCOMPARE(m_received.size(), 2);
+
+    // and is sent when a poll of the host has finished
+    respond("/status/1");
+    QTRY_COMPARE(m_sentPolls.size(), 3);
+    QCOMPARE(m_sentPolls.last(), QByteArray("/status/2"));
+    QCOMPARE(m_finished, QList<QByteArray>({"/status/1"}));
+    QCOMPARE(laneStat("poll", "queued"), 0);
+    QTRY_COMPARE(m_received.size(), 3);
+
+    respond("/status/0");
+    respond("/status/2");
+    QTRY_COMPARE(m_finished.size(), 3);
+    QCOMPARE(laneStat("poll", "sent"), 3);
+    QCOMPARE(laneStat("poll", "dropped"), 0);
+}
+
+void TestRequestDispatcher::testDeferredByCommand() {
+    m_dispatcher->setMaxPollsPerHost(2);
+
+    QVERIFY(sendCommand("/relay/on"));
+    sendPoll("/status/0", &m_entities[0]);
+    sendPoll("/status/1", &m_entities[1]);
+    sendPoll("/status/2", &m_entities[2]);
+
+    // no poll is sent while a command to the host is in flight
+    QVERIFY(m_sentPolls.isEmpty());
+    QCOMPARE(laneStat("poll", "queued"), 3);
+    QTRY_COMPARE(m_received.size(), 1);
+    QCOMPARE(m_received.first(), QByteArray("/relay/on"));
+
+    // the finished command drains the queue up to the poll limit of the host
+    respond("/relay/on");
+    QTRY_COMPARE(m_sentPolls.size(), 2);
+    QCOMPARE(m_sentPolls, QList<QByteArray>({"/status/0", "/status/1"}));
+    QCOMPARE(laneStat("poll", "queued"), 1);
+    QCOMPARE(laneStat("command", "sent"), 1);
+
+    // a new command defers polls again, also if the host has a free poll slot
+    QTRY_COMPARE(m_received.size(), 3);
+    respond("/status/0");
+    respond("/status/1");
+    QTRY_COMPARE(m_sentPolls.size(), 3);
+    QTRY_COMPARE(m_finished.size(), 3);
+    QVERIFY(sendCommand("/relay/off"));
+    sendPoll("/status/3", &m_entities[3]);
+    QTRY_COMPARE(m_received.size(), 5);
+    QCOMPARE(m_sentPolls.size(), 3);
+    QCOMPARE(laneStat("poll", "queued"), 1);
+
+    respond("/relay/off");
+    QTRY_COMPARE(m_sentPolls.size(), 4);
+    QCOMPARE(m_sentPolls.last(), QByteArray("/status/3"));
+    QCOMPARE(laneStat("poll", "queued"), 0);
+}
+
+void TestRequestDispatcher::testDropDuplicatePoll() {
+    QVERIFY(sendCommand("/relay/on"));
+    sendPoll("/status/0", &m_entities[0]);
+    sendPoll("/status/1", &m_entities[1]);
+
+    // a queued poll of the same entity will return the same state
+    sendPoll("/status/0-again", &m_entities[0]);
+    QCOMPARE(m_droppedPolls, QList<QByteArray>({"/status/0-again"}));
+    QCOMPARE(laneStat("poll", "queued"), 2);
+    QCOMPARE(laneStat("poll", "dropped"), 1);
+
+    QTRY_COMPARE(m_received.size(), 1);
+    respond("/relay/on");
+    QTRY_COMPARE(m_sentPolls.size(), 2);
+    QCOMPARE(m_sentPolls, QList<QByteArray>({"/status/0", "/status/1"}));
+}
+
+void TestRequestDispatcher::testDropWhenQueueFull() {
+    m_dispatcher->setMaxQueuedPolls(2);
+
+    QVERIFY(sendCommand("/relay/on"));
+    sendPoll("/status/0", &m_entities[0]);
+    sendPoll("/status/1", &m_entities[1]);
+    sendPoll("/status/2", &m_entities[2]);
+
+    QCOMPARE(m_droppedPolls, QList<QByteArray>({"/status/2"}));
+    QCOMPARE(laneStat("poll", "queued"), 2);
+    QCOMPARE(laneStat("poll", "dropped"), 1);
+
+    QTRY_COMPARE(m_received.size(), 1);
+    respond("/relay/on");
+    QTRY_COMPARE(m_sentPolls.size(), 2);
+    QCOMPARE(laneStat("poll", "queued"), 0);
+}
+
+void TestRequestDispatcher::testDropQueuedPolls() {
+    QVERIFY(sendCommand("/relay/on"));
+    sendPoll("/status/0", &m_entities[0]);
+    sendPoll("/status/1", &m_entities[1]);
+
+    m_dispatcher->dropQueuedPolls();
+    QCOMPARE(m_droppedPolls, QList<QByteArray>({"/status/0", "/status/1"}));
+    QCOMPARE(laneStat("poll", "queued"), 0);
+
+    // nothing left to send when the command has finished
+    QTRY_COMPARE(m_received.size(), 1);
+    respond("/relay/on");
+    QTRY_COMPARE(m_finished.size(), 1);
+    QTest::qWait(100);
+    QVERIFY(m_sentPolls.isEmpty());
+    QCOMPARE(m_received.size(), 1);
+}
+
+void TestRequestDispatcher::testHungCommandTimeout() {
+    m_dispatcher->setRequestTimeout(300);
+
+    QNetworkReply* command = sendCommand("/relay/on");
+    QVERIFY(command);
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QObject::connect(command, &QNetworkReply::finished, this, [&error, command] { error = command->error(); });
+    sendPoll("/status/0", &m_entities[0]);
+    QTRY_COMPARE(m_received.size(), 1);
+    QVERIFY(m_sentPolls.isEmpty());
+
+    // the device never answers the command: the aborted command frees the lane of the host
+    QTRY_COMPARE_WITH_TIMEOUT(m_finished, QList<QByteArray>({"/relay/on"}), 2000);
+    QCOMPARE(error, QNetworkReply::OperationCanceledError);
+    QCOMPARE(m_sentPolls, QList<QByteArray>({"/status/0"}));
+    QCOMPARE(laneStat("poll", "queued"), 0);
+
+    QTRY_COMPARE(m_received.size(), 2);
+    respond("/status/0");
+    QTRY_COMPARE(m_finished.size(), 2);
+}
+
+void TestRequestDispatcher::testTimedOutMetrics() {
+    Metrics metrics;
+    m_dispatcher->setMetrics(&metrics);
+    m_dispatcher->setRequestTimeout(300);
+    m_entities[0].id = "switch.device_0";
+
+    sendPoll("/status/0", &m_entities[0]);
+    QTRY_COMPARE(m_received.size(), 1);
+    QTRY_COMPARE_WITH_TIMEOUT(m_finished.size(), 1, 2000);
+
+    // the aborted request counts as timed out for its host and its entity
+    RequestSnapshot host = metrics.series("127.0.0.1", Metrics::STATUS)->snapshot();
+    QCOMPARE(host.sent, quint64(1));
+    QCOMPARE(host.inFlight, qint64(0));
+    QCOMPARE(host.timedOut, quint64(1));
+    QCOMPARE(host.failed, quint64(0));
+    RequestSnapshot entity = metrics.entitySeries("switch.device_0", Metrics::STATUS)->snapshot();
+    QCOMPARE(entity.sent, quint64(1));
+    QCOMPARE(entity.timedOut, quint64(1));
+    QCOMPARE(metrics.toVariant().value("types").toMap().value("status").toMap().value("error_rate").toDouble(), 1.0);
+
+    m_dispatcher->setMetrics(nullptr);
+}
+
+QTEST_GUILESS_MAIN(TestRequestDispatcher)
+
+#include "tst_requestdispatcher.moc"
@@ -0,0 +1,31 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_requestpool
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/compression.h \
+    $$INCDIR/httpmethod.h \
+    $$INCDIR/requestpool.h \
+    $$INCDIR/socketframing.h \
+    $$INCDIR/webhookcommand.h \
+    $$INCDIR/webhookrequest.h
+
+SOURCES += \
+    tst_requestpool.cpp \
+    $$INCDIR/compression.cpp \
+    $$INCDIR/requestpool.cpp
+
+win32 {
+    INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+} else {
+    LIBS += -lz
+}
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,107 @@
+#include <QtTest>
+
+#include "requestpool.h"
+
+class TestRequestPool : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testReuse();
+    void testReset();
+    void testHighWaterMark();
+    void testMaxFree();
+};
+
+void TestRequestPool::testReuse() {
+    RequestPool pool;
+
+    WebhookRequest* first = pool.acquire();
+    pool.release(first);
+    WebhookRequest* second = pool.acquire();
+
+    QCOMPARE(second, first);
+    QCOMPARE(pool.stats().value("allocations").toInt(), 1);
+    QCOMPARE(pool.stats().value("reuses").toInt(), 1);
+    pool.release(second);
+    QCOMPARE(pool.size(), 1);
+}
+
+void TestRequestPool::testReset() {
+    RequestPool     pool;
+    WebhookCommand  command;
+    WebhookRequest* request = pool.acquire();
+
+    request->webhookCommand = &command;
+    request->networkRequest.setUrl(QUrl("http://localhost/test"));
+    request->networkRequest.setRawHeader("X-Test", "1");
+    request->body = "body";
+    request->response.begin(InflateStream::GZIP);
+    request->sequence = 42;
+    request->optimistic = true;
+    request->undo.state = 1;
+    request->command = 3;
+    request->param = 50;
+    pool.release(request);
+
+    request = pool.acquire();
+    QVERIFY(!request->webhookCommand);
+    QVERIFY(request->networkRequest.url().isEmpty());
+    QVERIFY(request->networkRequest.rawHeaderList().isEmpty());
+    QVERIFY(request->body.isEmpty());
+    QVERIFY(!request->response.isActive());
+    QCOMPARE(request->sequence, quint64(0));
+    QVERIFY(!request->optimistic);
+    QVERIFY(request->undo.isEmpty());
+    QVERIFY(!request->webhookEntity);
+    QCOMPARE(request->command, -1);
+    QVERIFY(!request->param.isValid());
+    pool.release(request);
+}
+
+void TestRequestPool::testHighWaterMark() {
+    RequestPool              pool;
+    QVector<WebhookRequest*> requests;
+
+    for (int i = 0; i < 5; i++) {
+        requests.append(pool.acquire());
+    }
+    QCOMPARE(pool.inUse(), 5);
+
+    for (WebhookRequest* request : requests) {
+        pool.release(request);
+    }
+    QCOMPARE(pool.inUse(), 0);
+    QCOMPARE(pool.size(), 5);
+
+    // a second burst is served from the free-list
+    for (int i = 0; i < 3; i++) {
+        requests[i] = pool.acquire();
+    }
+    QCOMPARE(pool.highWaterMark(), 5);
+    QCOMPARE(pool.stats().value("allocations").toInt(), 5);
+    QCOMPARE(pool.stats().value("reuses").toInt(), 3);
+
+    for (int i = 0; i < 3; i++) {
+        pool.release(requests[i]);
+    }
+}
+
+void TestRequestPool::testMaxFree() {
+    RequestPool              pool(2);
+    QVector<WebhookRequest*> requests;
+
+    for (int i = 0; i < 4; i++) {
+        requests.append(pool.acquire());
+    }
+    for (WebhookRequest* request : requests) {
+        pool.release(request);
+    }
+    QCOMPARE(pool.size(), 2);
+
+    pool.setMaxFree(1);
+    QCOMPARE(pool.size(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestRequestPool)
+
+#include "tst_requestpool.moc"
@@ -0,0 +1,22 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network testlib
+QT     -= gui
+
+TARGET = tst_sockettransport
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/socketframing.h \
+    $$INCDIR/sockettransport.h \
+    $$INCDIR/transportreply.h
+
+SOURCES += \
+    tst_sockettransport.cpp \
+    $$INCDIR/sockettransport.cpp \
+    $$INCDIR/transportreply.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,212 @@
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QtEndian>
+#include <QtTest>
+
+#include "sockettransport.h"
+
+class TestSocketTransport : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testIsSocketUrl();
+    void testMissingPort();
+    void testUdpDatagram();
+    void testTcpWithoutFraming();
+    void testTcpLineFraming();
+    void testTcpLengthFraming();
+    void testTcpConnectionIsReused();
+    void testTcpResponseTimeout();
+    void testTcpConnectionRefused();
+
+ private:
+    QTcpSocket* acceptClient(QTcpServer* server);
+    QByteArray  readFromClient(QTcpSocket* client, int size);
+};
+
+// the transport connects and writes in the event loop: blocking socket functions cannot be used
+QTcpSocket* TestSocketTransport::acceptClient(QTcpServer* server) {
+    if (!QTest::qWaitFor([server] { return server->hasPendingConnections(); }, 3000)) {
+        return nullptr;
+    }
+    return server->nextPendingConnection();
+}
+
+QByteArray TestSocketTransport::readFromClient(QTcpSocket* client, int size) {
+    QByteArray data;
+    QTest::qWaitFor(
+        [client, size, &data] {
+            data.append(client->readAll());
+            return data.size() >= size;
+        },
+        3000);
+    return data;
+}
+
+static QNetworkRequest socketRequest(const QString& scheme, quint16 port) {
+    return QNetworkRequest(QUrl(QString("%1://127.0.0.1:%2").arg(scheme).arg(port)));
+}
+
+void TestSocketTransport::testIsSocketUrl() {
+    QVERIFY(SocketTransport::isSocketUrl(QUrl("udp://192.168.1.2:21324")));
+    QVERIFY(SocketTransport::isSocketUrl(QUrl("tcp://projector.local:4352")));
+    QVERIFY(!SocketTransport::isSocketUrl(QUrl("http://192.168.1.2/json")));
+}
+
+void TestSocketTransport::testMissingPort() {
+    SocketTransport transport;
+
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(QNetworkRequest(QUrl("udp://127.0.0.1")), "x", SocketFraming::NONE));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(reply->error(), QNetworkReply::ProtocolInvalidOperationError);
+}
+
+void TestSocketTransport::testUdpDatagram() {
+    QUdpSocket receiver;
+    QVERIFY(receiver.bind(QHostAddress::LocalHost, 0));
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(socketRequest("udp", receiver.localPort()), QByteArray::fromHex("02010aff0000"),
+                       SocketFraming::NONE));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(spy.wait(1000));
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+
+    QTRY_VERIFY_WITH_TIMEOUT(receiver.hasPendingDatagrams(), 3000);
+    QByteArray datagram(static_cast<int>(receiver.pendingDatagramSize()), 0);
+    receiver.readDatagram(datagram.data(), datagram.size());
+    QCOMPARE(datagram, QByteArray::fromHex("02010aff0000"));
+}
+
+void TestSocketTransport::testTcpWithoutFraming() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(socketRequest("tcp", server.serverPort()), "POWR 1\r", SocketFraming::NONE));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+
+    QScopedPointer<QTcpSocket> client(acceptClient(&server));
+    QVERIFY(client);
+    QCOMPARE(readFromClient(client.data(), 7), QByteArray("POWR 1\r"));
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 3000);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+}
+
+void TestSocketTransport::testTcpLineFraming() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(socketRequest("tcp", server.serverPort()), "status\n", SocketFraming::LINE));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+
+    QScopedPointer<QTcpSocket> client(acceptClient(&server));
+    QVERIFY(client);
+    QCOMPARE(readFromClient(client.data(), 7), QByteArray("status\n"));
+
+    // response split over multiple segments
+    client->write("{\"on\":");
+    client->flush();
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 0);
+    client->write("true}\r\n");
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 3000);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->header(QNetworkRequest::ContentTypeHeader).toString(), QString("application/json"));
+    QCOMPARE(reply->readAll(), QByteArray("{\"on\":true}"));
+}
+
+void TestSocketTransport::testTcpLengthFraming() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(socketRequest("tcp", server.serverPort()), "get", SocketFraming::LENGTH));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+
+    QScopedPointer<QTcpSocket> client(acceptClient(&server));
+    QVERIFY(client);
+    QCOMPARE(readFromClient(client.data(), 3), QByteArray("get"));
+
+    QByteArray payload("{\"bri\":128}");
+    QByteArray frame(4, 0);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), frame.data());
+    client->write(frame + payload);
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 1, 3000);
+    QCOMPARE(reply->error(), QNetworkReply::NoError);
+    QCOMPARE(reply->readAll(), payload);
+}
+
+void TestSocketTransport::testTcpConnectionIsReused() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> first(
+        transport.send(socketRequest("tcp", server.serverPort()), "a\n", SocketFraming::LINE));
+    QScopedPointer<QNetworkReply> second(
+        transport.send(socketRequest("tcp", server.serverPort()), "b\n", SocketFraming::LINE));
+    QSignalSpy firstSpy(first.data(), &QNetworkReply::finished);
+    QSignalSpy secondSpy(second.data(), &QNetworkReply::finished);
+
+    QScopedPointer<QTcpSocket> client(acceptClient(&server));
+    QVERIFY(client);
+
+    // the second command is sent after the response of the first
+    QCOMPARE(readFromClient(client.data(), 2), QByteArray("a\n"));
+    client->write("1\n");
+    QCOMPARE(readFromClient(client.data(), 2), QByteArray("b\n"));
+    client->write("2\n");
+
+    QTRY_COMPARE_WITH_TIMEOUT(secondSpy.count(), 1, 3000);
+    QCOMPARE(firstSpy.count(), 1);
+    QCOMPARE(first->readAll(), QByteArray("1"));
+    QCOMPARE(second->readAll(), QByteArray("2"));
+    QVERIFY(!server.hasPendingConnections());
+}
+
+void TestSocketTransport::testTcpResponseTimeout() {
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+
+    SocketTransport transport;
+    transport.setResponseTimeout(100);
+    QScopedPointer<QNetworkReply> reply(
+        transport.send(socketRequest("tcp", server.serverPort()), "x\n", SocketFraming::LINE));
+    QSignalSpy spy(reply.data(), &QNetworkReply::finished);
+
+    QScopedPointer<QTcpSocket> client(acceptClient(&server));
+    QVERIFY(client);
+
+    QVERIFY(spy.wait(3000));
+    QCOMPARE(reply->error(), QNetworkReply::TimeoutError);
+}
+
+void TestSocketTransport::testTcpConnectionRefused() {
+    // get a free port
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost));
+    quint16 port = server.serverPort();
+    server.close();
+
+    SocketTransport               transport;
+    QScopedPointer<QNetworkReply> reply(transport.send(socketRequest("tcp", port), "x", SocketFraming::NONE));
+    QSignalSpy                    spy(reply.data(), &QNetworkReply::finished);
+    QVERIFY(spy.wait(3000));
+    QCOMPARE(reply->error(), QNetworkReply::ConnectionRefusedError);
+}
+
+QTEST_GUILESS_MAIN(TestSocketTransport)
+#include "tst_sockettransport.moc"
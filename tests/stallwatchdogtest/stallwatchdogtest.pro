@@ -0,0 +1,21 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_stallwatchdog
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/metrics.h \
+    $$INCDIR/stallwatchdog.h
+
+SOURCES += \
+    tst_stallwatchdog.cpp \
+    $$INCDIR/metrics.cpp \
+    $$INCDIR/stallwatchdog.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,108 @@
+#include <QRegularExpression>
+#include <QtTest>
+
+#include "stallwatchdog.h"
+
+static const qint64 MS = 1000000;
+
+class TestStallWatchdog : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testWithinBudget();
+    void testOverBudget();
+    void testRollingWindow();
+    void testWarningRateLimit();
+    void testStallTimer();
+    void testStallTimerDisabled();
+};
+
+void TestStallWatchdog::testWithinBudget() {
+    StallWatchdog watchdog(4000, 60000);
+    watchdog.record(StallWatchdog::STATUS_UPDATE, 1 * MS);
+    watchdog.record(StallWatchdog::STATUS_UPDATE, 4 * MS);
+
+    QCOMPARE(watchdog.overBudget(StallWatchdog::STATUS_UPDATE), quint64(0));
+    QVariantMap section = watchdog.stats().value("status_update").toMap();
+    QCOMPARE(section.value("count").toULongLong(), quint64(2));
+    QCOMPARE(section.value("max_ms").toDouble(), 4.0);
+    QCOMPARE(watchdog.stats().value("budget_ms").toDouble(), 4.0);
+}
+
+void TestStallWatchdog::testOverBudget() {
+    StallWatchdog watchdog(4000, 60000);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("blocked for 12.0 ms by update_entity in entity switch.two"));
+    watchdog.record(StallWatchdog::UPDATE_ENTITY, 1 * MS, "switch.one");
+    watchdog.record(StallWatchdog::UPDATE_ENTITY, 12 * MS, "switch.two");
+    watchdog.record(StallWatchdog::UPDATE_ENTITY, 5 * MS, "switch.three");
+
+    QCOMPARE(watchdog.overBudget(StallWatchdog::UPDATE_ENTITY), quint64(2));
+    QCOMPARE(watchdog.overBudget(StallWatchdog::STATUS_REPLY), quint64(0));
+
+    QVariantMap section = watchdog.stats().value("update_entity").toMap();
+    QCOMPARE(section.value("over_budget").toULongLong(), quint64(2));
+    QCOMPARE(section.value("max_ms").toDouble(), 12.0);
+    QCOMPARE(section.value("max_entity").toString(), QString("switch.two"));
+}
+
+void TestStallWatchdog::testRollingWindow() {
+    StallWatchdog watchdog(100000, 60000, 100);
+    for (int i = 1; i <= 100; i++) {
+        watchdog.record(StallWatchdog::STATUS_REPLY, i * MS);
+    }
+
+    QVariantMap section = watchdog.stats().value("status_reply").toMap();
+    QCOMPARE(section.value("p50_ms").toDouble(), 50.0);
+    QCOMPARE(section.value("p95_ms").toDouble(), 95.0);
+    QCOMPARE(section.value("p99_ms").toDouble(), 99.0);
+    QCOMPARE(section.value("window_max_ms").toDouble(), 100.0);
+
+    // the oldest runs are replaced, the overall maximum is kept
+    for (int i = 0; i < 100; i++) {
+        watchdog.record(StallWatchdog::STATUS_REPLY, 1 * MS);
+    }
+    section = watchdog.stats().value("status_reply").toMap();
+    QCOMPARE(section.value("count").toULongLong(), quint64(200));
+    QCOMPARE(section.value("p99_ms").toDouble(), 1.0);
+    QCOMPARE(section.value("window_max_ms").toDouble(), 1.0);
+    QCOMPARE(section.value("max_ms").toDouble(), 100.0);
+}
+
+void TestStallWatchdog::testWarningRateLimit() {
+    StallWatchdog watchdog(4000, 50);
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("blocked for 5.0 ms by command_reply in entity switch.one"));
+    watchdog.record(StallWatchdog::COMMAND_REPLY, 5 * MS, "switch.one");
+    // suppressed within the warning interval, the slowest run is reported with the next warning
+    watchdog.record(StallWatchdog::COMMAND_REPLY, 10 * MS, "switch.two");
+
+    // sections are rate-limited separately
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("blocked for 6.0 ms by status_update \\("));
+    watchdog.record(StallWatchdog::STATUS_UPDATE, 6 * MS);
+
+    QTest::qWait(60);
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression("blocked for 10.0 ms by command_reply in entity switch.two .*2 runs over"));
+    watchdog.record(StallWatchdog::COMMAND_REPLY, 7 * MS, "switch.three");
+    QCOMPARE(watchdog.overBudget(StallWatchdog::COMMAND_REPLY), quint64(3));
+}
+
+void TestStallWatchdog::testStallTimer() {
+    StallWatchdog watchdog(4000, 60000);
+    {
+        StallTimer timer(&watchdog, StallWatchdog::CALLBACK, "switch.one");
+        QTest::qSleep(1);
+    }
+
+    QVariantMap section = watchdog.stats().value("callback").toMap();
+    QCOMPARE(section.value("count").toULongLong(), quint64(1));
+    QVERIFY(section.value("max_ms").toDouble() >= 1.0);
+}
+
+void TestStallWatchdog::testStallTimerDisabled() {
+    StallTimer timer(nullptr, StallWatchdog::CALLBACK, "switch.one");
+    Q_UNUSED(timer)
+}
+
+QTEST_GUILESS_MAIN(TestStallWatchdog)
+
+#include "tst_stallwatchdog.moc"
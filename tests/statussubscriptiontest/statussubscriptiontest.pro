@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core network websockets testlib
+QT     -= gui
+
+TARGET = tst_statussubscription
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/statussubscription.h
+
+SOURCES += \
+    tst_statussubscription.cpp \
+    $$INCDIR/statussubscription.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,214 @@
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtTest>
+
+#include <functional>
+
+#include "statussubscription.h"
+
+class TestStatusSubscription : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void init();
+    void cleanup();
+
+    void testSseEvents();
+    void testSseRetry();
+    void testLongPollImmediateReply();
+    void testLongPollHeldReply();
+    void testReconnectRefused_data();
+    void testReconnectRefused();
+
+ private:
+    /**
+     * @brief A received request of the local test server: request header and time in ms since the test started.
+     */
+    struct Request {
+        QByteArray header;
+        qint64     received;
+    };
+
+    void onNewConnection();
+    void listen(quint16 port = 0);
+
+    QUrl url(const QString& scheme, const QString& path) const;
+    StatusSubscription* createSubscription(StatusSubscription::Transport transport, const QUrl& url);
+
+    static void writeResponse(QTcpSocket* socket, const QByteArray& contentType, const QByteArray& body);
+
+    QTcpServer                       m_server;
+    quint16                          m_port;
+    QVector<Request>                 m_requests;
+    QElapsedTimer                    m_clock;
+    std::function<void(QTcpSocket*)> m_respond;
+    QNetworkAccessManager*           m_networkManager;
+    QList<QByteArray>                m_events;
+};
+
+void TestStatusSubscription::init() {
+    m_requests.clear();
+    m_events.clear();
+    m_respond = nullptr;
+    m_networkManager = new QNetworkAccessManager(this);
+    QObject::connect(&m_server, &QTcpServer::newConnection, this, &TestStatusSubscription::onNewConnection,
+                     Qt::UniqueConnection);
+    m_clock.start();
+}
+
+void TestStatusSubscription::cleanup() {
+    m_server.close();
+    delete m_networkManager;
+}
+
+void TestStatusSubscription::listen(quint16 port) {
+    QVERIFY(m_server.listen(QHostAddress::LocalHost, port));
+    m_port = m_server.serverPort();
+}
+
+void TestStatusSubscription::onNewConnection() {
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        socket->setParent(this);
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket] {
+            // the subscription requests don't have a body
+            QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+            int        headerEnd = buffer.indexOf("\r\n\r\n");
+            socket->setProperty("buffer", headerEnd < 0 ? buffer : buffer.mid(headerEnd + 4));
+            if (headerEnd >= 0) {
+                m_requests.append(Request{buffer.left(headerEnd), m_clock.elapsed()});
+                if (m_respond) {
+                    m_respond(socket);
+                }
+            }
+        });
+    }
+}
+
+QUrl TestStatusSubscription::url(const QString& scheme, const QString& path) const {
+    return QUrl(QString("%1://127.0.0.1:%2%3").arg(scheme).arg(m_port).arg(path));
+}
+
+StatusSubscription* TestStatusSubscription::createSubscription(StatusSubscription::Transport transport,
+                                                               const QUrl& url) {
+    auto subscription = new StatusSubscription(transport, QNetworkRequest(url), QByteArray(), m_networkManager, this);
+    QObject::connect(subscription, &StatusSubscription::eventReceived, this,
+                     [this](const QByteArray& data) { m_events.append(data); });
+    return subscription;
+}
+
+void TestStatusSubscription::writeResponse(QTcpSocket* socket, const QByteArray& contentType,
+                                           const QByteArray& body) {
+    socket->write("HTTP/1.1 200 OK\r\nContent-Type: " + contentType +
+                  "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+    socket->disconnectFromHost();
+}
+
+void TestStatusSubscription::testSseEvents() {
+    listen();
+    m_respond = [](QTcpSocket* socket) {
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n\r\n");
+        // comment, CRLF line endings, multi-line data and a line split over two writes
+        socket->write(": keep-alive\r\n");
+        socket->write("data: first\r\ndata: second\r\n\r\n");
+        socket->flush();
+        socket->write("event: update\ndata: {\"relay\":");
+        socket->flush();
+        socket->write("true}\n\n");
+    };
+
+    QScopedPointer<StatusSubscription> subscription(createSubscription(StatusSubscription::SSE, url("http", "/sse")));
+    subscription->start();
+
+    QTRY_COMPARE(m_events.size(), 2);
+    QCOMPARE(m_events.at(0), QByteArray("first\nsecond"));
+    QCOMPARE(m_events.at(1), QByteArray("{\"relay\":true}"));
+    QVERIFY(m_requests.first().header.contains("Accept: text/event-stream"));
+}
+
+void TestStatusSubscription::testSseRetry() {
+    listen();
+    m_respond = [](QTcpSocket* socket) {
+        socket->write("HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nConnection: close\r\n\r\n");
+        socket->write("retry: 2500\r\nid: 7\r\ndata: x\r\n\r\n");
+        socket->disconnectFromHost();
+    };
+
+    QScopedPointer<StatusSubscription> subscription(createSubscription(StatusSubscription::SSE, url("http", "/sse")));
+    subscription->start();
+
+    // the closed stream is reconnected after the retry time instead of the default backoff of 1 s
+    QTRY_COMPARE_WITH_TIMEOUT(m_requests.size(), 2, 6000);
+    QCOMPARE(m_events.size(), 1);
+    QVERIFY2(m_requests.at(1).received - m_requests.at(0).received >= 2500,
+             qPrintable(QString::number(m_requests.at(1).received - m_requests.at(0).received)));
+    QVERIFY(m_requests.at(1).header.contains("Last-Event-ID: 7"));
+}
+
+void TestStatusSubscription::testLongPollImmediateReply() {
+    listen();
+    m_respond = [](QTcpSocket* socket) { writeResponse(socket, "application/json", "{\"relay\":true}"); };
+
+    QScopedPointer<StatusSubscription> subscription(
+        createSubscription(StatusSubscription::LONG_POLL, url("http", "/poll")));
+    subscription->start();
+
+    // a device which doesn't hold the request is polled at most once per second
+    QTest::qWait(1500);
+    QVERIFY2(m_requests.size() >= 1 && m_requests.size() <= 2, qPrintable(QString::number(m_requests.size())));
+    QVERIFY(!m_events.isEmpty());
+    QCOMPARE(m_events.first(), QByteArray("{\"relay\":true}"));
+}
+
+void TestStatusSubscription::testLongPollHeldReply() {
+    listen();
+    m_respond = [](QTcpSocket* socket) {
+        QTimer::singleShot(1200, socket, [socket] { writeResponse(socket, "application/json", "{\"relay\":true}"); });
+    };
+
+    QScopedPointer<StatusSubscription> subscription(
+        createSubscription(StatusSubscription::LONG_POLL, url("http", "/poll")));
+    subscription->start();
+
+    // the next request is sent right after a held reply
+    QTRY_VERIFY_WITH_TIMEOUT(m_requests.size() >= 2, 5000);
+    QCOMPARE(m_events.size(), 1);
+    qint64 interval = m_requests.at(1).received - m_requests.at(0).received;
+    QVERIFY2(interval >= 1200 && interval < 2000, qPrintable(QString::number(interval)));
+}
+
+void TestStatusSubscription::testReconnectRefused_data() {
+    QTest::addColumn<int>("transport");
+    QTest::addColumn<QString>("scheme");
+
+    QTest::newRow("sse") << static_cast<int>(StatusSubscription::SSE) << "http";
+    QTest::newRow("long_poll") << static_cast<int>(StatusSubscription::LONG_POLL) << "http";
+    QTest::newRow("websocket") << static_cast<int>(StatusSubscription::WEBSOCKET) << "ws";
+}
+
+void TestStatusSubscription::testReconnectRefused() {
+    QFETCH(int, transport);
+    QFETCH(QString, scheme);
+
+    // reserve a free port and close it again: the first connection attempt is refused
+    listen();
+    m_server.close();
+
+    QScopedPointer<StatusSubscription> subscription(
+        createSubscription(static_cast<StatusSubscription::Transport>(transport), url(scheme, "/events")));
+    subscription->start();
+    QTest::qWait(300);
+    QVERIFY(m_requests.isEmpty());
+
+    // the device comes online: the subscription reconnects after the backoff
+    listen(m_port);
+    QTRY_VERIFY_WITH_TIMEOUT(!m_requests.isEmpty(), 5000);
+    QVERIFY(m_requests.first().header.startsWith("GET /events"));
+    QVERIFY(subscription->isActive());
+}
+
+QTEST_GUILESS_MAIN(TestStatusSubscription)
+
+#include "tst_statussubscription.moc"
@@ -2,4 +2,29 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     jsonpathtest \
-    entityhandlertest
+    entityhandlertest \
+    compressiontest \
+    hostcachetest \
+    callbackservertest \
+    configstoretest \
+    sockettransporttest \
+    requestbatchtest \
+    requestpooltest \
+    placeholderstest \
+    configcachetest \
+    metricstest \
+    tracertest \
+    stallwatchdogtest \
+    timingwheeltest \
+    valuetransformtest \
+    statussubscriptiontest \
+    pollschedulertest \
+    requestdispatchertest
+
+# MQTT transport tests require a local MQTT broker, otherwise they are skipped
+qtHaveModule(mqtt) {
+    SUBDIRS += mqtttest
+}
+
+# QBENCHMARK micro-benchmarks, not executed with `make check`
+SUBDIRS += benchmarks
@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_timingwheel
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/timingwheel.h
+
+SOURCES += \
+    tst_timingwheel.cpp \
+    $$INCDIR/timingwheel.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,155 @@
+#include <QRandomGenerator>
+#include <QtTest>
+
+#include "timingwheel.h"
+
+class TestTimingWheel : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testSchedule();
+    void testReschedule();
+    void testCancel();
+    void testCascade_data();
+    void testCascade();
+    void testMaxDelay();
+    void testMixedIntervals();
+    void testClear();
+
+ private:
+    static QVector<int> advance(TimingWheel* wheel, quint64 ticks);
+};
+
+QVector<int> TestTimingWheel::advance(TimingWheel* wheel, quint64 ticks) {
+    QVector<int> due;
+    for (quint64 i = 0; i < ticks; i++) {
+        wheel->advance(&due);
+    }
+    return due;
+}
+
+void TestTimingWheel::testSchedule() {
+    TimingWheel wheel;
+    wheel.schedule(0, 1);
+    wheel.schedule(1, 3);
+    wheel.schedule(2, 3);
+    QCOMPARE(wheel.size(), 3);
+    QVERIFY(wheel.isScheduled(1));
+    QVERIFY(!wheel.isScheduled(3));
+
+    QCOMPARE(advance(&wheel, 1), QVector<int>({0}));
+    QVERIFY(!wheel.isScheduled(0));
+    QVERIFY(advance(&wheel, 1).isEmpty());
+
+    QVector<int> due = advance(&wheel, 1);
+    std::sort(due.begin(), due.end());
+    QCOMPARE(due, QVector<int>({1, 2}));
+    QCOMPARE(wheel.size(), 0);
+    QCOMPARE(wheel.now(), quint64(3));
+}
+
+void TestTimingWheel::testReschedule() {
+    TimingWheel wheel;
+    wheel.schedule(5, 10);
+    wheel.schedule(5, 2);
+    QCOMPARE(wheel.size(), 1);
+    QCOMPARE(wheel.expires(5), quint64(2));
+
+    QCOMPARE(advance(&wheel, 2), QVector<int>({5}));
+    QVERIFY(advance(&wheel, 20).isEmpty());
+
+    // a delay of 0 ticks is due with the next tick
+    wheel.schedule(5, 0);
+    QCOMPARE(advance(&wheel, 1), QVector<int>({5}));
+}
+
+void TestTimingWheel::testCancel() {
+    TimingWheel wheel;
+    wheel.schedule(0, 5);
+    wheel.schedule(1, 5);
+    wheel.schedule(2, 5);
+    wheel.cancel(1);
+    wheel.cancel(7);
+    QCOMPARE(wheel.size(), 2);
+
+    QVector<int> due = advance(&wheel, 5);
+    std::sort(due.begin(), due.end());
+    QCOMPARE(due, QVector<int>({0, 2}));
+}
+
+void TestTimingWheel::testCascade_data() {
+    QTest::addColumn<quint64>("start");
+    QTest::addColumn<quint64>("delay");
+
+    QTest::newRow("level 0") << quint64(0) << quint64(63);
+    QTest::newRow("level 1") << quint64(0) << quint64(64);
+    QTest::newRow("level 1 unaligned") << quint64(37) << quint64(100);
+    QTest::newRow("level 1 last slot") << quint64(63) << quint64(4095);
+    QTest::newRow("level 2") << quint64(10) << quint64(4096 + 77);
+    QTest::newRow("level 3") << quint64(1000) << quint64(300000);
+}
+
+void TestTimingWheel::testCascade() {
+    QFETCH(quint64, start);
+    QFETCH(quint64, delay);
+
+    TimingWheel wheel;
+    advance(&wheel, start);
+    wheel.schedule(0, delay);
+
+    QVERIFY(advance(&wheel, delay - 1).isEmpty());
+    QCOMPARE(advance(&wheel, 1), QVector<int>({0}));
+    QCOMPARE(wheel.now(), start + delay);
+}
+
+void TestTimingWheel::testMaxDelay() {
+    TimingWheel wheel;
+    wheel.schedule(0, TimingWheel::MAX_DELAY + 1000);
+    QCOMPARE(wheel.expires(0), TimingWheel::MAX_DELAY);
+}
+
+void TestTimingWheel::testMixedIntervals() {
+    // periodic ids with mixed intervals must be due exactly at their interval
+    const int        count = 2000;
+    QVector<int>     intervals(count);
+    QVector<int>     polls(count, 0);
+    TimingWheel      wheel;
+    QRandomGenerator random(42);
+    for (int id = 0; id < count; id++) {
+        intervals[id] = static_cast<int>(random.bounded(1, 600));
+        wheel.schedule(id, static_cast<quint64>(intervals.at(id)));
+    }
+
+    QVector<int> due;
+    for (int tick = 1; tick <= 5000; tick++) {
+        due.clear();
+        wheel.advance(&due);
+        for (int id : qAsConst(due)) {
+            QCOMPARE(tick % intervals.at(id), 0);
+            polls[id]++;
+            wheel.schedule(id, static_cast<quint64>(intervals.at(id)));
+        }
+    }
+
+    for (int id = 0; id < count; id++) {
+        QCOMPARE(polls.at(id), 5000 / intervals.at(id));
+    }
+    QCOMPARE(wheel.size(), count);
+}
+
+void TestTimingWheel::testClear() {
+    TimingWheel wheel;
+    wheel.schedule(0, 1);
+    wheel.schedule(1, 100000);
+    wheel.clear();
+    QCOMPARE(wheel.size(), 0);
+    QVERIFY(!wheel.isScheduled(1));
+    QVERIFY(advance(&wheel, 100).isEmpty());
+
+    wheel.schedule(1, 2);
+    QCOMPARE(advance(&wheel, 2), QVector<int>({1}));
+}
+
+QTEST_GUILESS_MAIN(TestTimingWheel)
+
+#include "tst_timingwheel.moc"
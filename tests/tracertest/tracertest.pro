@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_tracer
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/tracer.h
+
+SOURCES += \
+    tst_tracer.cpp \
+    $$INCDIR/tracer.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
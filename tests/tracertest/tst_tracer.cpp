@@ -0,0 +1,116 @@
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtTest>
+
+#include "tracer.h"
+
+class TestTracer : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testAddSpan();
+    void testInvalidSpan();
+    void testRingBuffer();
+    void testClear();
+    void testChromeTrace();
+
+ private:
+    static Tracer::Args args(const QString& entityId);
+    static QJsonArray   events(const Tracer& tracer);
+};
+
+Tracer::Args TestTracer::args(const QString& entityId) {
+    Tracer::Args args;
+    args.entityId = entityId;
+    args.command = "ON";
+    args.url = "http://10.0.0.1/relay?turn=on";
+    args.status = 200;
+    return args;
+}
+
+QJsonArray TestTracer::events(const Tracer& tracer) {
+    QJsonDocument doc = QJsonDocument::fromJson(tracer.toChromeTrace());
+    return doc.object().value("traceEvents").toArray();
+}
+
+void TestTracer::testAddSpan() {
+    Tracer tracer(10);
+    QCOMPARE(tracer.size(), 0);
+    QCOMPARE(tracer.capacity(), 10);
+
+    tracer.addSpan("command", "device", 1, 1000, 5000, args("switch.one"));
+    tracer.addSpan("command", "reply", 1, 5000, 5000, args("switch.one"));
+    QCOMPARE(tracer.size(), 2);
+    QCOMPARE(tracer.dropped(), quint64(0));
+}
+
+void TestTracer::testInvalidSpan() {
+    Tracer tracer(10);
+    // unset timestamps of stages which haven't been recorded
+    tracer.addSpan("command", "create", 1, 0, 5000, args("switch.one"));
+    tracer.addSpan("command", "queue", 1, 5000, 0, args("switch.one"));
+    tracer.addSpan("command", "device", 1, 5000, 4000, args("switch.one"));
+    QCOMPARE(tracer.size(), 0);
+}
+
+void TestTracer::testRingBuffer() {
+    Tracer tracer(3);
+    for (int i = 1; i <= 5; i++) {
+        tracer.addSpan("poll", "device", static_cast<quint64>(i), i * 1000, i * 1000 + 500, args("switch.one"));
+    }
+    QCOMPARE(tracer.size(), 3);
+    QCOMPARE(tracer.dropped(), quint64(2));
+
+    // oldest first
+    QJsonArray trace = events(tracer);
+    QCOMPARE(trace.size(), 6);
+    QCOMPARE(trace.at(0).toObject().value("id").toString(), QString("3"));
+    QCOMPARE(trace.at(2).toObject().value("id").toString(), QString("4"));
+    QCOMPARE(trace.at(4).toObject().value("id").toString(), QString("5"));
+}
+
+void TestTracer::testClear() {
+    Tracer tracer(2);
+    tracer.addSpan("poll", "device", 1, 1000, 2000, args("switch.one"));
+    tracer.addSpan("poll", "device", 2, 1000, 2000, args("switch.one"));
+    tracer.addSpan("poll", "device", 3, 1000, 2000, args("switch.one"));
+
+    tracer.clear();
+    QCOMPARE(tracer.size(), 0);
+    QCOMPARE(tracer.dropped(), quint64(0));
+    QVERIFY(events(tracer).isEmpty());
+}
+
+void TestTracer::testChromeTrace() {
+    Tracer tracer(10);
+    tracer.addSpan("command", "device", 7, 1000000, 3500000, args("switch.one"));
+
+    QJsonDocument doc = QJsonDocument::fromJson(tracer.toChromeTrace());
+    QVERIFY(doc.isObject());
+    QCOMPARE(doc.object().value("displayTimeUnit").toString(), QString("ms"));
+
+    QJsonArray trace = doc.object().value("traceEvents").toArray();
+    QCOMPARE(trace.size(), 2);
+
+    QJsonObject begin = trace.at(0).toObject();
+    QCOMPARE(begin.value("name").toString(), QString("device"));
+    QCOMPARE(begin.value("cat").toString(), QString("command"));
+    QCOMPARE(begin.value("ph").toString(), QString("b"));
+    QCOMPARE(begin.value("id").toString(), QString("7"));
+    QCOMPARE(begin.value("ts").toDouble(), 1000.0);
+    QJsonObject beginArgs = begin.value("args").toObject();
+    QCOMPARE(beginArgs.value("entity_id").toString(), QString("switch.one"));
+    QCOMPARE(beginArgs.value("command").toString(), QString("ON"));
+    QCOMPARE(beginArgs.value("url").toString(), QString("http://10.0.0.1/relay?turn=on"));
+    QCOMPARE(beginArgs.value("status").toInt(), 200);
+
+    QJsonObject end = trace.at(1).toObject();
+    QCOMPARE(end.value("ph").toString(), QString("e"));
+    QCOMPARE(end.value("id").toString(), QString("7"));
+    QCOMPARE(end.value("ts").toDouble(), 3500.0);
+    QVERIFY(!end.contains("args"));
+}
+
+QTEST_GUILESS_MAIN(TestTracer)
+#include "tst_tracer.moc"
@@ -0,0 +1,149 @@
+#include <QtTest>
+
+#include "valuetransform.h"
+
+class TestValueTransform : public QObject {
+    Q_OBJECT
+
+ private slots:
+    void testEmpty();
+    void testApply_data();
+    void testApply();
+    void testLinearFolding();
+    void testInvalidOperation();
+    void testInvalidValue();
+    void testStream();
+};
+
+void TestValueTransform::testEmpty() {
+    ValueTransform transform = ValueTransform::compile(QVariant());
+    QVERIFY(transform.isEmpty());
+    QCOMPARE(transform.apply(QJsonValue(42)), QVariant(42));
+}
+
+void TestValueTransform::testApply_data() {
+    QTest::addColumn<QVariant>("config");
+    QTest::addColumn<QJsonValue>("value");
+    QTest::addColumn<QVariant>("expected");
+
+    QTest::newRow("scale") << QVariant(QVariantMap{{"scale", 2.5}}) << QJsonValue(4) << QVariant(10);
+    QTest::newRow("scale range") << QVariant(QVariantMap{{"scale", QVariantList{0, 255, 0, 100}}})
+                                 << QJsonValue(51) << QVariant(20);
+    QTest::newRow("offset") << QVariant(QVariantMap{{"offset", -1.5}}) << QJsonValue(3) << QVariant(1.5);
+    QTest::newRow("numeric string") << QVariant(QVariantMap{{"offset", 1}}) << QJsonValue("41") << QVariant(42);
+    QTest::newRow("clamp") << QVariant(QVariantMap{{"clamp", QVariantList{0, 100}}}) << QJsonValue(120)
+                           << QVariant(100);
+    QTest::newRow("round") << QVariant(QVariantMap{{"round", 1}}) << QJsonValue(21.46) << QVariant(21.5);
+    QTest::newRow("scale and round") << QVariant(QVariantList{QVariantMap{{"scale", QVariantList{0, 255, 0, 100}}},
+                                                              QVariantMap{{"round", 0}}})
+                                     << QJsonValue(128) << QVariant(50);
+    QTest::newRow("invert number") << QVariant(QVariantMap{{"invert", true}}) << QJsonValue(30) << QVariant(70);
+    QTest::newRow("invert range") << QVariant(QVariantMap{{"invert", QVariantList{0, 255}}}) << QJsonValue(55)
+                                  << QVariant(200);
+    QTest::newRow("invert bool") << QVariant(QVariantMap{{"invert", true}}) << QJsonValue(true) << QVariant(false);
+    QTest::newRow("map") << QVariant(QVariantMap{{"map", QVariantMap{{"on", true}, {"off", false}}}})
+                         << QJsonValue("on") << QVariant(true);
+    QTest::newRow("map number") << QVariant(QVariantMap{{"map", QVariantMap{{"0", "off"}, {"3", "cooling"}}}})
+                                << QJsonValue(3) << QVariant("cooling");
+    QTest::newRow("map unmatched") << QVariant(QVariantMap{{"map", QVariantMap{{"on", 1}}}}) << QJsonValue("auto")
+                                   << QVariant("auto");
+    QTest::newRow("map default") << QVariant(QVariantMap{{"map", QVariantMap{{"on", 1}}}, {"default", 0}})
+                                 << QJsonValue("auto") << QVariant(0);
+    QTest::newRow("fahrenheit") << QVariant(QVariantMap{{"unit", QVariantList{"fahrenheit", "celsius"}}})
+                                << QJsonValue(212) << QVariant(100);
+    QTest::newRow("celsius") << QVariant(QVariantMap{{"unit", QVariantList{"C", "F"}}}) << QJsonValue(-40)
+                             << QVariant(-40);
+    QTest::newRow("kelvin") << QVariant(QVariantMap{{"unit", QVariantList{"kelvin", "celsius"}}})
+                            << QJsonValue(300.15) << QVariant(27);
+    QTest::newRow("color hex") << QVariant(QVariantMap{{"color", "rgb"}}) << QJsonValue("FF8000")
+                               << QVariant("#ff8000");
+    QTest::newRow("color rgb") << QVariant(QVariantMap{{"color", "rgb"}}) << QJsonValue("rgb(8, 15, 240)")
+                               << QVariant("#080ff0");
+    QTest::newRow("color list") << QVariant(QVariantMap{{"color", "rgb"}}) << QJsonValue("255,0,0")
+                                << QVariant("#ff0000");
+    QTest::newRow("color number") << QVariant(QVariantMap{{"color", "rgb"}}) << QJsonValue(255)
+                                  << QVariant("#0000ff");
+}
+
+void TestValueTransform::testApply() {
+    QFETCH(QVariant, config);
+    QFETCH(QJsonValue, value);
+    QFETCH(QVariant, expected);
+
+    QString        error;
+    ValueTransform transform = ValueTransform::compile(config, &error);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+
+    QVariant result = transform.apply(value);
+    if (expected.type() == QVariant::Double || result.type() == QVariant::Double) {
+        QVERIFY(qFuzzyCompare(result.toDouble(), expected.toDouble()));
+    } else {
+        QCOMPARE(result, expected);
+    }
+}
+
+void TestValueTransform::testLinearFolding() {
+    // scale, offset and unit conversions are folded into a single op
+    QVariantList config{QVariantMap{{"unit", QVariantList{"F", "C"}}}, QVariantMap{{"scale", 10}},
+                        QVariantMap{{"offset", 5}}};
+    ValueTransform transform = ValueTransform::compile(config);
+    QCOMPARE(transform.size(), 1);
+    QVERIFY(qFuzzyCompare(transform.apply(QJsonValue(50)).toDouble(), 105.0));
+}
+
+void TestValueTransform::testInvalidOperation() {
+    QString        error;
+    ValueTransform transform = ValueTransform::compile(
+        QVariantList{QVariantMap{{"scale", QVariantList{1, 1, 0, 100}}}, QVariantMap{{"unknown", 1}},
+                     QVariantMap{{"round", 0}}},
+        &error);
+    QVERIFY(!error.isEmpty());
+    // invalid operations are skipped
+    QCOMPARE(transform.size(), 1);
+    QCOMPARE(transform.apply(QJsonValue(1.6)), QVariant(2));
+}
+
+void TestValueTransform::testInvalidValue() {
+    ValueTransform scale = ValueTransform::compile(QVariantMap{{"scale", 2}});
+    QVERIFY(!scale.apply(QJsonValue("on")).isValid());
+    QVERIFY(!scale.apply(QJsonValue(QJsonValue::Null)).isValid());
+    QVERIFY(!scale.apply(QJsonValue(QJsonValue::Undefined)).isValid());
+
+    ValueTransform color = ValueTransform::compile(QVariantMap{{"color", "rgb"}});
+    QVERIFY(!color.apply(QJsonValue("#12345")).isValid());
+    QVERIFY(!color.apply(QJsonValue("256,0,0")).isValid());
+}
+
+void TestValueTransform::testStream() {
+    QVariantList config{QVariantMap{{"map", QVariantMap{{"on", 100}, {"off", 0}}}, {"default", 50}},
+                        QVariantMap{{"invert", true}}, QVariantMap{{"clamp", QVariantList{10, 90}}}};
+    ValueTransform transform = ValueTransform::compile(config);
+
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out << transform;
+    }
+
+    ValueTransform read;
+    QDataStream    in(data);
+    in >> read;
+    QCOMPARE(in.status(), QDataStream::Ok);
+    QVERIFY(read == transform);
+    QCOMPARE(read.apply(QJsonValue("on")), QVariant(10));
+    QCOMPARE(read.apply(QJsonValue("dimmed")), QVariant(50));
+
+    // unknown op type
+    QByteArray corruptData;
+    {
+        QDataStream out(&corruptData, QIODevice::WriteOnly);
+        out << static_cast<qint32>(1) << static_cast<qint32>(99) << 0.0 << 0.0 << static_cast<qint32>(0);
+    }
+    QDataStream corrupt(corruptData);
+    corrupt >> read;
+    QCOMPARE(corrupt.status(), QDataStream::ReadCorruptData);
+}
+
+QTEST_GUILESS_MAIN(TestValueTransform)
+
+#include "tst_valuetransform.moc"
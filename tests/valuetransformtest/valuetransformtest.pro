@@ -0,0 +1,19 @@
+TEMPLATE = app
+
+CONFIG += qt warn_on depend_includepath testcase
+QT     += core testlib
+QT     -= gui
+
+TARGET = tst_valuetransform
+
+INCDIR = $$PWD/../../src
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/valuetransform.h
+
+SOURCES += \
+    tst_valuetransform.cpp \
+    $$INCDIR/valuetransform.cpp
+
+DEFINES += SRCDIR=\\\"$$PWD/\\\"
@@ -0,0 +1,38 @@
+# Core webhook sources shared by the unit tests and benchmarks.
+# Include after yio-plugin-lib.pri; $$INCDIR points to the plugin sources.
+
+INCDIR = $$clean_path($$PWD/../src)
+INCLUDEPATH += $$INCDIR
+
+HEADERS += \
+    $$INCDIR/compression.h \
+    $$INCDIR/configstore.h \
+    $$INCDIR/entityhandler.h \
+    $$INCDIR/httpmethod.h \
+    $$INCDIR/jsonpath.h \
+    $$INCDIR/metrics.h \
+    $$INCDIR/placeholders.h \
+    $$INCDIR/requestpool.h \
+    $$INCDIR/socketframing.h \
+    $$INCDIR/stallwatchdog.h \
+    $$INCDIR/valuetransform.h \
+    $$INCDIR/webhookcommand.h \
+    $$INCDIR/webhookentity.h \
+    $$INCDIR/webhookrequest.h
+
+SOURCES += \
+    $$INCDIR/compression.cpp \
+    $$INCDIR/configstore.cpp \
+    $$INCDIR/entityhandler.cpp \
+    $$INCDIR/jsonpath.cpp \
+    $$INCDIR/metrics.cpp \
+    $$INCDIR/placeholders.cpp \
+    $$INCDIR/requestpool.cpp \
+    $$INCDIR/stallwatchdog.cpp \
+    $$INCDIR/valuetransform.cpp
+
+win32 {
+    INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+} else {
+    LIBS += -lz
+}